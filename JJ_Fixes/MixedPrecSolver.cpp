@@ -0,0 +1,285 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Mixed precision linear solver with iterative refinement. See
+ *  MixedPrecSolver.h for details.
+ *
+ */
+
+#include <jem/base/System.h>
+#include <jem/numeric/algebra/utilities.h>
+#include <jive/algebra/SparseMatrixExtension.h>
+#include <jive/util/utilities.h>
+
+#include "MixedPrecSolver.h"
+
+
+JIVE_BEGIN_PACKAGE( implict )
+
+
+using jem::numeric::norm2;
+using jive::algebra::SparseMatrixExt;
+
+
+//=======================================================================
+//   class MixedPrecSolver
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+MixedPrecSolver::MixedPrecSolver ()
+{
+  precision_ = 1.0e-10;
+  maxIter_   = 10;
+  valid_     = false;
+  failed_    = false;
+  iiter_     = 0;
+  rnorm_     = 0.0;
+}
+
+
+MixedPrecSolver::~MixedPrecSolver ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   solve
+//-----------------------------------------------------------------------
+
+// The solution satisfies the constraints exactly; the equations of the
+// free DOFs are solved up to the relative precision precision_, the
+// residual being measured against the first (zero) guess.
+
+bool MixedPrecSolver::solve
+
+  ( const Vector&       lhs,
+    const Vector&       rhs,
+    AbstractMatrix&     matrix,
+    const Constraints&  cons )
+
+{
+  const idx_t  dofCount = rhs.size ();
+
+  double       rnorm0   = 0.0;
+  double       rprev    = 0.0;
+
+
+  iiter_ = 0;
+  rnorm_ = 0.0;
+
+  if ( failed_ )
+  {
+    return false;
+  }
+
+  // The factor excludes the slave DOFs, so it must be recomputed when
+  // the set of slave DOFs changes, even if their number does not.
+
+  if ( valid_ && ! sameSlaves_( cons ) )
+  {
+    valid_ = false;
+  }
+
+  if ( ! valid_ )
+  {
+    if ( ! factor_( matrix, cons ) )
+    {
+      failed_ = true;
+
+      return false;
+    }
+
+    valid_ = true;
+  }
+
+  res_.resize ( dofCount );
+  tmp_.resize ( dofCount );
+
+  lhs = 0.0;
+
+  jive::util::setSlaveDofs ( lhs, cons );
+
+  while ( true )
+  {
+    matrix.matmul ( tmp_, lhs );
+
+    for ( idx_t i = 0; i < dofCount; i++ )
+    {
+      res_[i] = mask_[i] ? 0.0 : (rhs[i] - tmp_[i]);
+    }
+
+    rnorm_ = norm2 ( res_ );
+
+    if ( iiter_ == 0 )
+    {
+      rnorm0 = rnorm_;
+
+      if ( rnorm0 == 0.0 )
+      {
+        return true;
+      }
+    }
+    else if ( rnorm_ <= precision_ * rnorm0 )
+    {
+      return true;
+    }
+
+    // Give up if the refinement does not converge fast enough: the
+    // single precision factor is then too far off, and it will not do
+    // better for the other right hand sides of this matrix. Skip it
+    // until the matrix changes. The first residual is that of the zero
+    // guess, so the rate is only checked after a correction.
+
+    if ( iiter_ >= maxIter_ ||
+         ( iiter_ > 0 && ! (rnorm_ < 0.5 * rprev) ) )
+    {
+      failed_ = true;
+
+      return false;
+    }
+
+    lu_.solve ( tmp_, res_ );
+
+    lhs   += tmp_;
+    rprev  = rnorm_;
+
+    iiter_++;
+  }
+
+  return false;
+}
+
+
+//-----------------------------------------------------------------------
+//   invalidate
+//-----------------------------------------------------------------------
+
+// Must be called when the values of the matrix have changed.
+
+void MixedPrecSolver::invalidate ()
+{
+  // The structure of the factor is kept; the next factorization
+  // recomputes it only when the sparsity pattern has changed.
+
+  valid_  = false;
+  failed_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   reset
+//-----------------------------------------------------------------------
+
+// Must be called when the DOF space or the constraints have changed.
+
+void MixedPrecSolver::reset ()
+{
+  valid_  = false;
+  failed_ = false;
+
+  lu_.invalidate ();
+}
+
+
+//-----------------------------------------------------------------------
+//   setPrecision
+//-----------------------------------------------------------------------
+
+
+void MixedPrecSolver::setPrecision ( double eps )
+{
+  precision_ = eps;
+}
+
+
+//-----------------------------------------------------------------------
+//   setMaxIter
+//-----------------------------------------------------------------------
+
+
+void MixedPrecSolver::setMaxIter ( idx_t maxIter )
+{
+  maxIter_ = maxIter;
+}
+
+
+//-----------------------------------------------------------------------
+//   sameSlaves_
+//-----------------------------------------------------------------------
+
+
+bool MixedPrecSolver::sameSlaves_ ( const Constraints& cons ) const
+{
+  const idx_t  dofCount = mask_.size ();
+
+  if ( cons.dofCount() != dofCount )
+  {
+    return false;
+  }
+
+  for ( idx_t idof = 0; idof < dofCount; idof++ )
+  {
+    if ( cons.isSlaveDof( idof ) != mask_[idof] )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   factor_
+//-----------------------------------------------------------------------
+
+
+bool MixedPrecSolver::factor_
+
+  ( AbstractMatrix&     matrix,
+    const Constraints&  cons )
+
+{
+  using jem::System;
+
+  SparseMatrixExt*  sx = matrix.getExtension<SparseMatrixExt> ();
+
+  if ( sx == 0 )
+  {
+    System::warn() << "mixed precision solver: matrix does not "
+                   << "support the sparse matrix extension\n";
+
+    return false;
+  }
+
+  const idx_t  dofCount = matrix.size (0);
+
+  mask_.resize ( dofCount );
+
+  mask_ = false;
+
+  for ( idx_t idof = 0; idof < dofCount; idof++ )
+  {
+    if ( cons.isSlaveDof( idof ) )
+    {
+      if ( cons.masterDofCount( idof ) > 0 )
+      {
+        System::warn() << "mixed precision solver: constraints with "
+                       << "master DOFs are not supported\n";
+
+        return false;
+      }
+
+      mask_[idof] = true;
+    }
+  }
+
+  return lu_.factor ( sx->toSparseMatrix(), mask_ );
+}
+
+
+JIVE_END_PACKAGE( implict )
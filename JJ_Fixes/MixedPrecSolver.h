@@ -0,0 +1,162 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class implements a mixed precision linear solver for the Newton
+ *  iterations of the MyNonlinModule. The tangent matrix is factorized in
+ *  single precision and the solution is recovered to double precision by
+ *  iterative refinement against the assembled (double precision) matrix.
+ *
+ *  Only constraints without master DOFs are supported. The solve function
+ *  returns false when the matrix or the constraints are not supported,
+ *  when the factorization breaks down or when the refinement stalls; the
+ *  caller should then fall back to a double precision solver.
+ *
+ */
+
+#ifndef JIVE_IMPLICT_MIXEDPRECSOLVER_H
+#define JIVE_IMPLICT_MIXEDPRECSOLVER_H
+
+#include <jem/base/Object.h>
+#include <jive/Array.h>
+#include <jive/algebra/AbstractMatrix.h>
+#include <jive/util/Constraints.h>
+
+#include "SkylineLU.h"
+
+
+JIVE_BEGIN_PACKAGE( implict )
+
+
+using jive::algebra::AbstractMatrix;
+using jive::util::Constraints;
+
+
+//-----------------------------------------------------------------------
+//   class MixedPrecSolver
+//-----------------------------------------------------------------------
+
+
+class MixedPrecSolver : public jem::Object
+{
+ public:
+
+  typedef jem::Object       Super;
+  typedef MixedPrecSolver   Self;
+
+
+                            MixedPrecSolver ();
+
+  bool                      solve
+
+    ( const Vector&           lhs,
+      const Vector&           rhs,
+      AbstractMatrix&         matrix,
+      const Constraints&      cons );
+
+  void                      invalidate      ();
+  void                      reset           ();
+
+  void                      setPrecision
+
+    ( double                  eps );
+
+  void                      setMaxIter
+
+    ( idx_t                   maxIter );
+
+  inline idx_t              iterCount       () const;
+  inline double             residual        () const;
+  inline bool               isFactored      () const;
+  inline bool               hasFailed       () const;
+
+
+ protected:
+
+  virtual                  ~MixedPrecSolver ();
+
+
+ private:
+
+  bool                      sameSlaves_
+
+    ( const Constraints&      cons )         const;
+
+  bool                      factor_
+
+    ( AbstractMatrix&         matrix,
+      const Constraints&      cons );
+
+
+ private:
+
+  SkylineLU<float>          lu_;
+
+  double                    precision_;
+  idx_t                     maxIter_;
+
+  bool                      valid_;
+
+  // Set when the current matrix can not be handled or the refinement
+  // has stalled; cleared when the matrix is updated.
+
+  bool                      failed_;
+
+  idx_t                     iiter_;
+  double                    rnorm_;
+
+  BoolVector                mask_;
+  Vector                    res_;
+  Vector                    tmp_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   iterCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t MixedPrecSolver::iterCount () const
+{
+  return iiter_;
+}
+
+
+//-----------------------------------------------------------------------
+//   residual
+//-----------------------------------------------------------------------
+
+
+inline double MixedPrecSolver::residual () const
+{
+  return rnorm_;
+}
+
+
+//-----------------------------------------------------------------------
+//   isFactored
+//-----------------------------------------------------------------------
+
+
+inline bool MixedPrecSolver::isFactored () const
+{
+  return valid_;
+}
+
+
+//-----------------------------------------------------------------------
+//   hasFailed
+//-----------------------------------------------------------------------
+
+// Returns true if solve will return false until the next invalidate.
+
+inline bool MixedPrecSolver::hasFailed () const
+{
+  return failed_;
+}
+
+
+JIVE_END_PACKAGE( implict )
+
+#endif
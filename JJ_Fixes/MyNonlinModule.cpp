@@ -30,6 +30,8 @@
  */
 
 
+#include <cmath>
+
 #include <jem/base/limits.h>
 #include <jem/base/Float.h>
 #include <jem/base/System.h>
@@ -55,6 +57,9 @@
 // added by E.C.Simons
 #include <jem/base/System.h>
 #include <MyNonlinModule.h>
+#include "SolverNames.h"
+#include "MixedPrecSolver.h"
+#include "RecycleSolver.h"
 
 JEM_DEFINE_CLASS( jive::implict::MyNonlinModule );
 
@@ -98,6 +103,9 @@ class MyNonlinModule::RunData_ : public NonlinRunData
 
   bool                    validMatrix;
 
+  Ref<MixedPrecSolver>    mixed;
+  Ref<RecycleSolver>      recycle;
+
 
  protected:
 
@@ -134,6 +142,16 @@ void MyNonlinModule::RunData_::dofsChanged_ ()
   else
   {
     validMatrix = false;
+
+    if ( mixed != NIL )
+    {
+      mixed->reset ();
+    }
+
+    if ( recycle != NIL )
+    {
+      recycle->reset ();
+    }
   }
 }
 
@@ -200,11 +218,24 @@ class MyNonlinModule::Work_ : public ConHandler
   double                  rnorm0;
   double                  rnorm1;
 
+  // Data for the divergence detector: the scaled residuals of the last
+  // iterations (a circular buffer), the smallest correction norm, the
+  // number of consecutive iterations in which the correction exceeded
+  // the growth limit and the reason why the iterations were stopped.
+
+  Vector                  rhist;
+  double                  dmin;
+  idx_t                   growCount;
+  double                  contraction;
+  String                  divReason;
+
 
  private:
 
   String                  myName_;
   Function*               updateCond_;
+  MixedPrecSolver*        mixed_;
+  RecycleSolver*          recycle_;
 
 };
 
@@ -234,7 +265,44 @@ MyNonlinModule::Work_::Work_
   rnorm0 = 1.0;
   rnorm1 = 1.0;
 
+  dmin        = -1.0;
+  growCount   = 0;
+  contraction = 0.0;
+
+  rhist.resize ( mod.divWindow_ + 1 );
+
+  rhist = 0.0;
+
   updateCond_ = mod.updateCond_.get ();
+  mixed_      = 0;
+  recycle_    = 0;
+
+  if ( mod.options_ & MIXED_PREC )
+  {
+    if ( rundat.mixed == NIL )
+    {
+      rundat.mixed = newInstance<MixedPrecSolver> ();
+    }
+
+    mixed_ = rundat.mixed.get ();
+
+    mixed_->setPrecision ( mod.refineTol_ );
+    mixed_->setMaxIter   ( mod.maxRefine_ );
+  }
+
+  if ( mod.options_ & RECYCLE )
+  {
+    if ( rundat.recycle == NIL )
+    {
+      rundat.recycle = newInstance<RecycleSolver> ();
+    }
+
+    recycle_ = rundat.recycle.get ();
+
+    recycle_->setPrecision   ( mod.krylovTol_   );
+    recycle_->setMaxIter     ( mod.maxKrylov_   );
+    recycle_->setRecycleSize ( mod.recycleSize_ );
+  }
 
   rundat.updateConstraints ( globdat );
   rundat.dofs->resetEvents ();
@@ -367,6 +435,16 @@ void MyNonlinModule::Work_::updateMatrix
     rundat.updateMatrix ( fint, globdat );
 
     rundat.validMatrix = true;
+
+    if ( rundat.mixed != NIL )
+    {
+      rundat.mixed->invalidate ();
+    }
+
+    if ( rundat.recycle != NIL )
+    {
+      rundat.recycle->invalidate ();
+    }
   }
   else if ( getFint )
   {
@@ -386,7 +464,56 @@ void MyNonlinModule::Work_::calcIncrement ( double maxIncr )
 
   double  dnorm0 = dnorm;
 
-  rundat.solver->solve ( du, r );
+  // Try the recycling Krylov solver and the single precision
+  // factorization first; fall back to the configured solver if they
+  // fail.
+
+  bool    done   = false;
+
+  if ( recycle_ && ! recycle_->hasFailed() )
+  {
+    done = recycle_->solve ( du, r, *rundat.solver->getMatrix(),
+                             *rundat.cons );
+
+    if ( done )
+    {
+      print ( System::debug( myName_ ), rundat.context,
+              " : recycling solver converged in ",
+              recycle_->iterCount(), " iterations (",
+              recycle_->recycleCount(), " recycled vectors)\n" );
+    }
+    else
+    {
+      // A full Krylov run that fails is as expensive as a direct
+      // solve; do not try again in the remaining iterations of this
+      // step, even if the matrix is updated.
+
+      print ( System::info( myName_ ), rundat.context,
+              " : recycling solver failed after ",
+              recycle_->iterCount(), " iterations; using the "
+              "direct solver for the rest of this step\n" );
+
+      recycle_ = 0;
+    }
+  }
+
+  if ( ! done && mixed_ && ! mixed_->hasFailed() )
+  {
+    done = mixed_->solve ( du, r, *rundat.solver->getMatrix(),
+                           *rundat.cons );
+
+    if ( ! done )
+    {
+      print ( System::info( myName_ ), rundat.context,
+              " : mixed precision solve failed after ",
+              mixed_->iterCount(), " refinement steps\n" );
+    }
+  }
+
+  if ( ! done )
+  {
+    rundat.solver->solve ( du, r );
+  }
 
   dnorm = rundat.vspace->norm2 ( du );
 
@@ -488,6 +615,22 @@ const char*  MyNonlinModule::TYPE_NAME   = "MyNonlin";
 
 const int    MyNonlinModule::LINE_SEARCH = 1 << 0;
 const int    MyNonlinModule::DELTA_CONS  = 1 << 1;
+const int    MyNonlinModule::MIXED_PREC  = 1 << 2;
+const int    MyNonlinModule::RECYCLE     = 1 << 3;
+
+const char*  MyNonlinModule::MIXED_PREC_PROP = "mixedPrecision";
+const char*  MyNonlinModule::REFINE_TOL_PROP = "refineTol";
+const char*  MyNonlinModule::MAX_REFINE_PROP = "maxRefine";
+
+const char*  MyNonlinModule::RECYCLE_PROP      = "recycle";
+const char*  MyNonlinModule::RECYCLE_SIZE_PROP = "recycleSize";
+const char*  MyNonlinModule::KRYLOV_TOL_PROP   = "krylovTol";
+const char*  MyNonlinModule::MAX_KRYLOV_PROP   = "maxKrylov";
+
+const char*  MyNonlinModule::DIV_WINDOW_PROP      = "divWindow";
+const char*  MyNonlinModule::MAX_CONTRACTION_PROP = "maxContraction";
+const char*  MyNonlinModule::MAX_INCR_GROWTH_PROP = "maxIncrGrowth";
+const char*  MyNonlinModule::MAX_RESIDUAL_PROP    = "maxResidual";
 
 
 //-----------------------------------------------------------------------
@@ -505,6 +648,17 @@ MyNonlinModule::MyNonlinModule ( const String& name ) :
   tiny_      = jem::Limits<double>::TINY_VALUE;
   precision_ = 1.0e-3;
   maxIncr_   = 10.0;
+  refineTol_ = 1.0e-10;
+  maxRefine_ = 10;
+
+  recycleSize_ = 20;
+  krylovTol_   = 1.0e-8;
+  maxKrylov_   = 50;
+
+  divWindow_      = 4;
+  maxContraction_ = 0.0;
+  maxIncrGrowth_  = 1.0e3;
+  maxResidual_    = 1.0e4;
   
   // ECS: initialize our new parameter
   someValue_ = 123456.789;
@@ -613,6 +767,51 @@ void MyNonlinModule::configure
         options_ &= ~DELTA_CONS;
       }
     }
+
+    if ( myProps.find( option, MIXED_PREC_PROP ) )
+    {
+      if ( option )
+      {
+        options_ |=  MIXED_PREC;
+      }
+      else
+      {
+        options_ &= ~MIXED_PREC;
+      }
+    }
+
+    myProps.find ( refineTol_, REFINE_TOL_PROP,
+                   0.0,        1.0 );
+    myProps.find ( maxRefine_, MAX_REFINE_PROP,
+                   0,          maxOf( maxRefine_ ) );
+
+    if ( myProps.find( option, RECYCLE_PROP ) )
+    {
+      if ( option )
+      {
+        options_ |=  RECYCLE;
+      }
+      else
+      {
+        options_ &= ~RECYCLE;
+      }
+    }
+
+    myProps.find ( recycleSize_, RECYCLE_SIZE_PROP,
+                   0,            maxOf( recycleSize_ ) );
+    myProps.find ( krylovTol_,   KRYLOV_TOL_PROP,
+                   0.0,          1.0 );
+    myProps.find ( maxKrylov_,   MAX_KRYLOV_PROP,
+                   1,            maxOf( maxKrylov_ ) );
+
+    myProps.find ( divWindow_,      DIV_WINDOW_PROP,
+                   1,               maxOf( divWindow_ ) );
+    myProps.find ( maxContraction_, MAX_CONTRACTION_PROP,
+                   0.0,             1.0e20 );
+    myProps.find ( maxIncrGrowth_,  MAX_INCR_GROWTH_PROP,
+                   1.0,             1.0e20 );
+    myProps.find ( maxResidual_,    MAX_RESIDUAL_PROP,
+                   0.0,             1.0e20 );
   }
 
   if ( rundat_ != NIL )
@@ -647,6 +846,24 @@ void MyNonlinModule::getConfig
   myConf.set ( PropNames::DELTA_CONS,
                ((options_ & DELTA_CONS)  != 0)  );
 
+  myConf.set ( MIXED_PREC_PROP,
+               ((options_ & MIXED_PREC)  != 0)  );
+
+  myConf.set ( REFINE_TOL_PROP, refineTol_ );
+  myConf.set ( MAX_REFINE_PROP, maxRefine_ );
+
+  myConf.set ( RECYCLE_PROP,
+               ((options_ & RECYCLE)     != 0)  );
+
+  myConf.set ( RECYCLE_SIZE_PROP, recycleSize_ );
+  myConf.set ( KRYLOV_TOL_PROP,   krylovTol_   );
+  myConf.set ( MAX_KRYLOV_PROP,   maxKrylov_   );
+
+  myConf.set ( DIV_WINDOW_PROP,      divWindow_      );
+  myConf.set ( MAX_CONTRACTION_PROP, maxContraction_ );
+  myConf.set ( MAX_INCR_GROWTH_PROP, maxIncrGrowth_  );
+  myConf.set ( MAX_RESIDUAL_PROP,    maxResidual_    );
+
   FuncUtils::getConfig ( myConf, updateCond_,
                          PropNames::UPDATE_COND );
 
@@ -736,6 +953,14 @@ void MyNonlinModule::solve
   info.set ( SolverInfo::ITER_COUNT, w.iiter );
   info.set ( SolverInfo::RESIDUAL,   w.rnorm );
 
+  info.set ( SolverNames::DIVERGED,    (w.divReason.size() > 0) );
+  info.set ( SolverNames::CONTRACTION, w.contraction );
+
+  if ( w.divReason.size() )
+  {
+    info.set ( SolverNames::DIV_REASON, w.divReason );
+  }
+
   if ( Globdat::hasVariable( myName_, globdat ) )
   {
     Properties  vars = Globdat::getVariables ( myName_, globdat );
@@ -747,6 +972,19 @@ void MyNonlinModule::solve
 
   if ( ! result )
   {
+    if ( w.divReason.size() )
+    {
+      throw Exception (
+        getContext (),
+        String::format (
+          "divergence detected after %d iterations; "
+          "final residual: %e",
+          w.iiter,
+          w.rnorm
+        ) + " (" + w.divReason + ")"
+      );
+    }
+
     throw Exception (
       getContext (),
       String::format (
@@ -917,7 +1155,15 @@ bool MyNonlinModule::solve_
       return false;
     }
 
-    if ( w.rnorm > 1.0e4 )
+    if ( diverged_( w ) )
+    {
+      print ( System::info( myName_ ), d.context,
+              " : divergence detected (", w.divReason, ")\n" );
+
+      return false;
+    }
+
+    if ( w.rnorm > maxResidual_ )
     {
       if ( options_ & LINE_SEARCH )
       {
@@ -931,6 +1177,8 @@ bool MyNonlinModule::solve_
       }
       else
       {
+        w.divReason = "residual too large";
+
         return false;
       }
     }
@@ -1137,4 +1385,89 @@ void MyNonlinModule::lineSearch_
 }
 
 
+//-----------------------------------------------------------------------
+//   diverged_
+//-----------------------------------------------------------------------
+
+// Returns true if the iterations are evidently diverging; the reason is
+// stored in the work object. This function is called once per iteration,
+// after the residual of the current solution has been computed.
+
+bool MyNonlinModule::diverged_ ( Work_& w )
+{
+  const idx_t  window = w.rhist.size() - 1;
+
+  double       fnorm  = w.rundat.vspace->norm2 ( w.fint );
+
+
+  if ( Float::isNaN( fnorm ) || Float::isInfinite( fnorm ) ||
+       Float::isNaN( w.rnorm ) )
+  {
+    w.divReason = "invalid internal force vector";
+
+    return true;
+  }
+
+  // Update the residual history and estimate the contraction rate
+  // over the window. Each iteration is counted once; the predictor
+  // (iteration 1) is not included.
+
+  w.rhist[w.iiter % (window + 1)] = w.rnorm;
+
+  if ( w.iiter > 1 )
+  {
+    idx_t   n  = jem::min ( w.iiter - 1, window );
+    double  r0 = w.rhist[(w.iiter - n) % (window + 1)];
+
+    if ( r0 > 0.0 )
+    {
+      w.contraction = std::pow ( w.rnorm / r0, 1.0 / (double) n );
+    }
+
+    if ( n == window && maxContraction_ > 0.0 &&
+         w.contraction > maxContraction_ )
+    {
+      w.divReason = String::format (
+        "residual contraction %.3f over %d iterations",
+        w.contraction,
+        window
+      );
+
+      return true;
+    }
+  }
+
+  // Check the growth of the solution increments, ignoring the
+  // predictor (which contains the prescribed displacements). A single
+  // large correction is common when the iterations oscillate near the
+  // solution, so the growth must persist for two iterations in a row.
+
+  if ( w.iiter > 1 )
+  {
+    if ( w.dmin < 0.0 || w.dnorm < w.dmin )
+    {
+      w.dmin      = w.dnorm;
+      w.growCount = 0;
+    }
+    else if ( w.dnorm > maxIncrGrowth_ * w.dmin )
+    {
+      w.growCount++;
+    }
+    else
+    {
+      w.growCount = 0;
+    }
+
+    if ( w.growCount >= 2 )
+    {
+      w.divReason = "solution increment growing";
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 JIVE_END_PACKAGE( implict )
@@ -52,6 +52,20 @@ class MyNonlinModule : public SolverModule
   static const char*        TYPE_NAME;
   static const int          LINE_SEARCH;
   static const int          DELTA_CONS;
+  static const int          MIXED_PREC;
+  static const int          RECYCLE;
+
+  static const char*        MIXED_PREC_PROP;
+  static const char*        REFINE_TOL_PROP;
+  static const char*        MAX_REFINE_PROP;
+  static const char*        RECYCLE_PROP;
+  static const char*        RECYCLE_SIZE_PROP;
+  static const char*        KRYLOV_TOL_PROP;
+  static const char*        MAX_KRYLOV_PROP;
+  static const char*        DIV_WINDOW_PROP;
+  static const char*        MAX_CONTRACTION_PROP;
+  static const char*        MAX_INCR_GROWTH_PROP;
+  static const char*        MAX_RESIDUAL_PROP;
 
 
   explicit                  MyNonlinModule
@@ -141,6 +155,10 @@ class MyNonlinModule : public SolverModule
     ( Work_&                  work,
       const Properties&       globdat );
 
+  bool                      diverged_
+
+    ( Work_&                  work );
+
 
  private:
 
@@ -150,6 +168,29 @@ class MyNonlinModule : public SolverModule
   double                    precision_;
   double                    maxIncr_;
 
+  // Parameters of the mixed precision solver; see MixedPrecSolver.h.
+
+  double                    refineTol_;
+  idx_t                     maxRefine_;
+
+  // Parameters of the recycling Krylov solver; see RecycleSolver.h.
+
+  idx_t                     recycleSize_;
+  double                    krylovTol_;
+  idx_t                     maxKrylov_;
+
+  // Parameters of the divergence detector: the residual must decrease
+  // by a factor maxContraction_ (per iteration, on average) over a
+  // window of divWindow_ iterations (not checked if maxContraction_ is
+  // zero, the default), the solution increment may not grow by more
+  // than maxIncrGrowth_ in two consecutive iterations, and the scaled
+  // residual may not exceed maxResidual_.
+
+  idx_t                     divWindow_;
+  double                    maxContraction_;
+  double                    maxIncrGrowth_;
+  double                    maxResidual_;
+
   // ECS: Just some random parameter to check if we can indeed use MyNonlin
   double                    someValue_;
 
@@ -0,0 +1,557 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Krylov solver with subspace recycling. See RecycleSolver.h for
+ *  details.
+ *
+ */
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <jem/base/System.h>
+#include <jem/base/PrecheckException.h>
+#include <jem/base/array/operators.h>
+#include <jem/numeric/algebra/utilities.h>
+#include <jive/SparseMatrix.h>
+#include <jive/algebra/SparseMatrixExtension.h>
+#include <jive/util/utilities.h>
+
+#include "RecycleSolver.h"
+
+
+JIVE_BEGIN_PACKAGE( implict )
+
+
+using jem::numeric::axpy;
+using jem::numeric::dotProduct;
+using jem::numeric::norm2;
+using jive::algebra::SparseMatrixExt;
+
+
+//=======================================================================
+//   class RecycleSolver
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+RecycleSolver::RecycleSolver ()
+{
+  precision_  = 1.0e-8;
+  maxIter_    = 50;
+  maxRecycle_ = 20;
+  ready_      = false;
+  valid_      = false;
+  failed_     = false;
+  iiter_      = 0;
+  rnorm_      = 0.0;
+  slaveCount_ = -1;
+  recCount_   = 0;
+}
+
+
+RecycleSolver::~RecycleSolver ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   solve
+//-----------------------------------------------------------------------
+
+
+bool RecycleSolver::solve
+
+  ( const Vector&       lhs,
+    const Vector&       rhs,
+    AbstractMatrix&     matrix,
+    const Constraints&  cons )
+
+{
+  const idx_t  dofCount = rhs.size ();
+
+  double       rnorm0;
+  double       tol;
+  double       a;
+
+
+  iiter_ = 0;
+  rnorm_ = 0.0;
+
+  if ( failed_ )
+  {
+    return false;
+  }
+
+  if ( cons.slaveDofCount() != slaveCount_ )
+  {
+    ready_ = false;
+  }
+
+  if ( ! ready_ && ! init_( matrix, cons ) )
+  {
+    return false;
+  }
+
+  if ( ! valid_ )
+  {
+    updateSpace_ ( matrix );
+  }
+
+  lhs = 0.0;
+
+  jive::util::setSlaveDofs ( lhs, cons );
+
+  matrix.matmul ( tmp_, lhs );
+
+  for ( idx_t i = 0; i < dofCount; i++ )
+  {
+    res_[i] = mask_[i] ? 0.0 : (rhs[i] - tmp_[i]);
+  }
+
+  rnorm0 = norm2 ( res_ );
+
+  if ( rnorm0 == 0.0 )
+  {
+    return true;
+  }
+
+  tol = precision_ * rnorm0;
+
+  // Remove the components of the residual in the recycled space.
+
+  for ( idx_t i = 0; i < recCount_; i++ )
+  {
+    a = dotProduct ( C_[i], res_ );
+
+    axpy ( lhs,  a, U_[i] );
+    axpy ( res_, -a, C_[i] );
+  }
+
+  rnorm_ = norm2 ( res_ );
+
+  // GCR iterations, orthogonal to the recycled space.
+
+  while ( rnorm_ > tol )
+  {
+    if ( iiter_ >= maxIter_ )
+    {
+      selectSpace_ ( iiter_ );
+
+      failed_ = true;
+
+      return false;
+    }
+
+    Vector  z = Z_[iiter_];
+    Vector  v = V_[iiter_];
+
+    z = res_ * idiag_;
+
+    matmul_ ( matrix, v, z );
+
+    for ( idx_t i = 0; i < recCount_; i++ )
+    {
+      a = dotProduct ( C_[i], v );
+
+      axpy ( v, -a, C_[i] );
+      axpy ( z, -a, U_[i] );
+    }
+
+    for ( idx_t j = 0; j < iiter_; j++ )
+    {
+      a = dotProduct ( V_[j], v );
+
+      axpy ( v, -a, V_[j] );
+      axpy ( z, -a, Z_[j] );
+    }
+
+    a = norm2 ( v );
+
+    // Break down if the new direction is (numerically) contained in
+    // the current search space.
+
+    if ( ! (a > 1.0e-14 * norm2( z )) )
+    {
+      selectSpace_ ( iiter_ );
+
+      failed_ = true;
+
+      return false;
+    }
+
+    v *= 1.0 / a;
+    z *= 1.0 / a;
+
+    a  = dotProduct ( v, res_ );
+
+    axpy ( lhs,  a, z );
+    axpy ( res_, -a, v );
+
+    rnorm_ = norm2 ( res_ );
+
+    iiter_++;
+  }
+
+  selectSpace_ ( iiter_ );
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   invalidate
+//-----------------------------------------------------------------------
+
+// Must be called when the values of the matrix have changed. The
+// recycled directions u_i are kept; only the c_i are recomputed.
+
+void RecycleSolver::invalidate ()
+{
+  ready_  = false;
+  valid_  = false;
+  failed_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   reset
+//-----------------------------------------------------------------------
+
+// Must be called when the DOF space has changed.
+
+void RecycleSolver::reset ()
+{
+  ready_    = false;
+  valid_    = false;
+  failed_   = false;
+  recCount_ = 0;
+}
+
+
+//-----------------------------------------------------------------------
+//   setPrecision
+//-----------------------------------------------------------------------
+
+
+void RecycleSolver::setPrecision ( double eps )
+{
+  precision_ = eps;
+}
+
+
+//-----------------------------------------------------------------------
+//   setMaxIter
+//-----------------------------------------------------------------------
+
+
+void RecycleSolver::setMaxIter ( idx_t maxIter )
+{
+  JEM_PRECHECK ( maxIter > 0 );
+
+  if ( maxIter != maxIter_ )
+  {
+    maxIter_ = maxIter;
+    ready_   = false;
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   setRecycleSize
+//-----------------------------------------------------------------------
+
+
+void RecycleSolver::setRecycleSize ( idx_t size )
+{
+  JEM_PRECHECK ( size >= 0 );
+
+  if ( size != maxRecycle_ )
+  {
+    maxRecycle_ = size;
+
+    reset ();
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   init_
+//-----------------------------------------------------------------------
+
+
+bool RecycleSolver::init_
+
+  ( AbstractMatrix&     matrix,
+    const Constraints&  cons )
+
+{
+  using jem::System;
+
+  SparseMatrixExt*  sx = matrix.getExtension<SparseMatrixExt> ();
+
+  const idx_t       dofCount = matrix.size (0);
+
+
+  if ( sx == 0 )
+  {
+    System::warn() << "recycling solver: matrix does not "
+                   << "support the sparse matrix extension\n";
+
+    return false;
+  }
+
+  if ( dofCount != mask_.size() )
+  {
+    recCount_ = 0;
+
+    mask_ .resize ( dofCount );
+    idiag_.resize ( dofCount );
+    res_  .resize ( dofCount );
+    tmp_  .resize ( dofCount );
+    U_    .resize ( dofCount, maxRecycle_ );
+    C_    .resize ( dofCount, maxRecycle_ );
+    Uw_   .resize ( dofCount, maxRecycle_ );
+    Cw_   .resize ( dofCount, maxRecycle_ );
+  }
+
+  if ( U_.size(1) != maxRecycle_ )
+  {
+    U_ .resize ( dofCount, maxRecycle_ );
+    C_ .resize ( dofCount, maxRecycle_ );
+    Uw_.resize ( dofCount, maxRecycle_ );
+    Cw_.resize ( dofCount, maxRecycle_ );
+  }
+
+  if ( Z_.size(0) != dofCount || Z_.size(1) != maxIter_ )
+  {
+    Z_.resize ( dofCount, maxIter_ );
+    V_.resize ( dofCount, maxIter_ );
+  }
+
+  mask_       = false;
+  slaveCount_ = cons.slaveDofCount ();
+
+  for ( idx_t idof = 0; idof < dofCount; idof++ )
+  {
+    if ( cons.isSlaveDof( idof ) )
+    {
+      if ( cons.masterDofCount( idof ) > 0 )
+      {
+        System::warn() << "recycling solver: constraints with "
+                       << "master DOFs are not supported\n";
+
+        return false;
+      }
+
+      mask_[idof] = true;
+    }
+  }
+
+  // Jacobi preconditioner; rows without a (positive) diagonal entry
+  // are left unscaled.
+
+  SparseMatrix     sm      = sx->toSparseMatrix ();
+
+  const IdxVector  offsets = sm.getRowOffsets    ();
+  const IdxVector  indices = sm.getColumnIndices ();
+  const Vector     values  = sm.getValues        ();
+
+  idiag_ = 1.0;
+
+  for ( idx_t irow = 0; irow < dofCount; irow++ )
+  {
+    if ( mask_[irow] )
+    {
+      idiag_[irow] = 0.0;
+      continue;
+    }
+
+    for ( idx_t k = offsets[irow]; k < offsets[irow + 1]; k++ )
+    {
+      if ( indices[k] == irow && values[k] > 0.0 )
+      {
+        idiag_[irow] = 1.0 / values[k];
+      }
+    }
+  }
+
+  // The recycled directions must vanish at the slave DOFs.
+
+  for ( idx_t i = 0; i < recCount_; i++ )
+  {
+    Vector  u = U_[i];
+
+    for ( idx_t idof = 0; idof < dofCount; idof++ )
+    {
+      if ( mask_[idof] )
+      {
+        u[idof] = 0.0;
+      }
+    }
+  }
+
+  ready_ = true;
+  valid_ = false;
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   updateSpace_
+//-----------------------------------------------------------------------
+
+// Recomputes c_i = A u_i and orthonormalizes the c_i with the modified
+// Gram-Schmidt method, applying the same operations to the u_i.
+// Directions that have become dependent are dropped.
+
+void RecycleSolver::updateSpace_ ( AbstractMatrix& matrix )
+{
+  idx_t  j = 0;
+
+
+  for ( idx_t i = 0; i < recCount_; i++ )
+  {
+    Vector  u = U_[j];
+    Vector  c = C_[j];
+
+    double  a, cnorm;
+
+    if ( i != j )
+    {
+      u = U_[i];
+    }
+
+    matmul_ ( matrix, c, u );
+
+    cnorm = norm2 ( c );
+
+    for ( idx_t k = 0; k < j; k++ )
+    {
+      a = dotProduct ( C_[k], c );
+
+      axpy ( c, -a, C_[k] );
+      axpy ( u, -a, U_[k] );
+    }
+
+    a = norm2 ( c );
+
+    if ( a > 1.0e-10 * cnorm )
+    {
+      c *= 1.0 / a;
+      u *= 1.0 / a;
+
+      j++;
+    }
+  }
+
+  recCount_ = j;
+  valid_    = true;
+}
+
+
+//-----------------------------------------------------------------------
+//   matmul_
+//-----------------------------------------------------------------------
+
+// Computes lhs = A * rhs for the free DOFs; rhs must vanish at the
+// slave DOFs.
+
+void RecycleSolver::matmul_
+
+  ( AbstractMatrix&  matrix,
+    const Vector&    lhs,
+    const Vector&    rhs )
+
+{
+  const idx_t  dofCount = lhs.size ();
+
+  matrix.matmul ( lhs, rhs );
+
+  for ( idx_t i = 0; i < dofCount; i++ )
+  {
+    if ( mask_[i] )
+    {
+      lhs[i] = 0.0;
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   selectSpace_
+//-----------------------------------------------------------------------
+
+// Selects the new recycled space from the old one and the newCount
+// search directions of the last solve. Since all c_i are orthonormal,
+// the selected set is orthonormal too. The selection is copied into
+// the work matrices Uw_ and Cw_, which are then swapped with U_ and
+// C_, so that no memory is allocated.
+
+void RecycleSolver::selectSpace_ ( idx_t newCount )
+{
+  typedef std::pair<double,idx_t>  Score;
+
+  const idx_t  candCount = recCount_ + newCount;
+  const idx_t  keepCount = jem::min ( candCount, maxRecycle_ );
+
+  if ( keepCount == 0 )
+  {
+    recCount_ = 0;
+    return;
+  }
+
+  std::vector<Score>  scores ( (size_t) candCount );
+
+  for ( idx_t i = 0; i < recCount_; i++ )
+  {
+    scores[i] = Score ( norm2( U_[i] ), i );
+  }
+
+  for ( idx_t j = 0; j < newCount; j++ )
+  {
+    scores[recCount_ + j] = Score ( norm2( Z_[j] ), recCount_ + j );
+  }
+
+  std::partial_sort ( scores.begin(),
+                      scores.begin() + keepCount,
+                      scores.end(),
+                      std::greater<Score>() );
+
+  for ( idx_t i = 0; i < keepCount; i++ )
+  {
+    idx_t  k = scores[i].second;
+
+    if ( k < recCount_ )
+    {
+      Uw_[i] = U_[k];
+      Cw_[i] = C_[k];
+    }
+    else
+    {
+      Uw_[i] = Z_[k - recCount_];
+      Cw_[i] = V_[k - recCount_];
+    }
+  }
+
+  Matrix  tmp;
+
+  tmp.ref ( U_ );
+  U_ .ref ( Uw_ );
+  Uw_.ref ( tmp );
+
+  tmp.ref ( C_ );
+  C_ .ref ( Cw_ );
+  Cw_.ref ( tmp );
+
+  recCount_ = keepCount;
+}
+
+
+JIVE_END_PACKAGE( implict )
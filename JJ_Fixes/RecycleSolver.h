@@ -0,0 +1,201 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class implements a Krylov solver (GCR with a Jacobi
+ *  preconditioner) that recycles a small subspace across linear solves.
+ *  It is meant for the Newton iterations of the MyNonlinModule, where
+ *  successive tangent matrices differ only slightly.
+ *
+ *  The recycled subspace is stored as pairs (u_i, c_i), with c_i = A u_i
+ *  and the c_i orthonormal. Each solve first projects the residual on
+ *  the c_i and then continues with GCR iterations that are kept
+ *  orthogonal to them (as in GCRO). After a solve, the directions with
+ *  the largest |u_i| (that is, the best approximations of the
+ *  eigenvectors with the smallest eigenvalues) are kept. When the matrix
+ *  changes, the c_i are recomputed and orthonormalized again.
+ *
+ *  The solver needs 2 (maxIter + maxRecycle) work vectors of the size
+ *  of the DOF space, which is why the default maximum number of
+ *  iterations is small (50).
+ *
+ *  Like the MixedPrecSolver, this class only supports constraints
+ *  without master DOFs, and the solve function returns false when the
+ *  caller should fall back to another solver.
+ *
+ */
+
+#ifndef JIVE_IMPLICT_RECYCLESOLVER_H
+#define JIVE_IMPLICT_RECYCLESOLVER_H
+
+#include <jem/base/Object.h>
+#include <jive/Array.h>
+#include <jive/algebra/AbstractMatrix.h>
+#include <jive/util/Constraints.h>
+
+
+JIVE_BEGIN_PACKAGE( implict )
+
+
+using jive::algebra::AbstractMatrix;
+using jive::util::Constraints;
+
+
+//-----------------------------------------------------------------------
+//   class RecycleSolver
+//-----------------------------------------------------------------------
+
+
+class RecycleSolver : public jem::Object
+{
+ public:
+
+  typedef jem::Object       Super;
+  typedef RecycleSolver     Self;
+
+
+                            RecycleSolver   ();
+
+  bool                      solve
+
+    ( const Vector&           lhs,
+      const Vector&           rhs,
+      AbstractMatrix&         matrix,
+      const Constraints&      cons );
+
+  void                      invalidate      ();
+  void                      reset           ();
+
+  void                      setPrecision
+
+    ( double                  eps );
+
+  void                      setMaxIter
+
+    ( idx_t                   maxIter );
+
+  void                      setRecycleSize
+
+    ( idx_t                   size );
+
+  inline idx_t              iterCount       () const;
+  inline idx_t              recycleCount    () const;
+  inline double             residual        () const;
+  inline bool               hasFailed       () const;
+
+
+ protected:
+
+  virtual                  ~RecycleSolver   ();
+
+
+ private:
+
+  bool                      init_
+
+    ( AbstractMatrix&         matrix,
+      const Constraints&      cons );
+
+  void                      updateSpace_
+
+    ( AbstractMatrix&         matrix );
+
+  void                      matmul_
+
+    ( AbstractMatrix&         matrix,
+      const Vector&           lhs,
+      const Vector&           rhs );
+
+  void                      selectSpace_
+
+    ( idx_t                   newCount );
+
+
+ private:
+
+  double                    precision_;
+  idx_t                     maxIter_;
+  idx_t                     maxRecycle_;
+
+  // ready_ is false when the mask and the preconditioner must be
+  // recomputed; valid_ is false when the c_i are out of date.
+
+  bool                      ready_;
+  bool                      valid_;
+
+  // Set when a solve has failed; cleared when the matrix is updated.
+
+  bool                      failed_;
+
+  idx_t                     iiter_;
+  double                    rnorm_;
+
+  idx_t                     slaveCount_;
+  BoolVector                mask_;
+  Vector                    idiag_;
+
+  // The recycled pairs are stored in the first recCount_ columns of
+  // U_ and C_; the search directions of the current solve in Z_ and V_.
+  // Uw_ and Cw_ are work space for selectSpace_.
+
+  idx_t                     recCount_;
+  Matrix                    U_;
+  Matrix                    C_;
+  Matrix                    Uw_;
+  Matrix                    Cw_;
+  Matrix                    Z_;
+  Matrix                    V_;
+
+  Vector                    res_;
+  Vector                    tmp_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   iterCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t RecycleSolver::iterCount () const
+{
+  return iiter_;
+}
+
+
+//-----------------------------------------------------------------------
+//   recycleCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t RecycleSolver::recycleCount () const
+{
+  return recCount_;
+}
+
+
+//-----------------------------------------------------------------------
+//   residual
+//-----------------------------------------------------------------------
+
+
+inline double RecycleSolver::residual () const
+{
+  return rnorm_;
+}
+
+
+//-----------------------------------------------------------------------
+//   hasFailed
+//-----------------------------------------------------------------------
+
+
+inline bool RecycleSolver::hasFailed () const
+{
+  return failed_;
+}
+
+
+JIVE_END_PACKAGE( implict )
+
+#endif
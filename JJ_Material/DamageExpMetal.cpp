@@ -40,6 +40,7 @@
 
 #include "utilities.h"
 #include "utilitiesTuple.h"
+#include "HistoryBuffers.h"
 #include "DamageExpMetal.h"
 
 using namespace jem;
@@ -397,6 +398,47 @@ void DamageExpMetal::commit ()
   latestHist_ = &preHist_;
 }
 
+//-----------------------------------------------------------------------
+//   cancel
+//-----------------------------------------------------------------------
+
+void DamageExpMetal::cancel ()
+
+{
+  cancelHistory ( newHist_, preHist_ );
+
+  latestHist_ = &preHist_;
+}
+
+//-----------------------------------------------------------------------
+//   historyBytes
+//-----------------------------------------------------------------------
+
+idx_t DamageExpMetal::historyBytes () const
+{
+  return historyByteCount ( preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   saveHistory
+//-----------------------------------------------------------------------
+
+void DamageExpMetal::saveHistory ( void* buf ) const
+{
+  storeHistory ( buf, preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   loadHistory
+//-----------------------------------------------------------------------
+
+void DamageExpMetal::loadHistory ( const void* buf )
+{
+  restoreHistory ( preHist_, newHist_, buf );
+
+  latestHist_ = &preHist_;
+}
+
 //-----------------------------------------------------------------------
 //   deviatoric
 //-----------------------------------------------------------------------
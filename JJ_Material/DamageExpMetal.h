@@ -66,6 +66,11 @@ class DamageExpMetal : public HookeMaterial,
       idx_t                 ipoint );
       
   void                    commit ();
+  void                    cancel ();
+
+  idx_t                   historyBytes    () const;
+  void                    saveHistory     ( void* buf ) const;
+  void                    loadHistory     ( const void* buf );
   
   // History related functions
 
@@ -111,6 +116,8 @@ class DamageExpMetal : public HookeMaterial,
   inline virtual idx_t    isLoading         ( idx_t point  ) const;
 
   inline virtual idx_t    wasLoading        ( idx_t point  ) const;
+
+  inline virtual bool     isLinear          () const;
   
   // Stress related operations
 
@@ -236,4 +243,9 @@ inline idx_t DamageExpMetal::wasLoading ( idx_t ipoint ) const
   return preHist_[ipoint].loading;
 }
 
+inline bool DamageExpMetal::isLinear () const
+{
+  return false;
+}
+
 #endif 
@@ -41,6 +41,7 @@
 
 #include "utilities.h"
 #include "utilitiesTuple.h"
+#include "HistoryBuffers.h"
 #include "Drucker.h"
 
 using namespace jem;
@@ -663,6 +664,47 @@ void Drucker::commit ()
   latestHist_ = &preHist_;
 }
 
+//-----------------------------------------------------------------------
+//   cancel
+//-----------------------------------------------------------------------
+
+void Drucker::cancel ()
+
+{
+  cancelHistory ( newHist_, preHist_ );
+
+  latestHist_ = &preHist_;
+}
+
+
+//-----------------------------------------------------------------------
+//   historyBytes
+//-----------------------------------------------------------------------
+
+idx_t Drucker::historyBytes () const
+{
+  return historyByteCount ( preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   saveHistory
+//-----------------------------------------------------------------------
+
+void Drucker::saveHistory ( void* buf ) const
+{
+  storeHistory ( buf, preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   loadHistory
+//-----------------------------------------------------------------------
+
+void Drucker::loadHistory ( const void* buf )
+{
+  restoreHistory ( preHist_, newHist_, buf );
+
+  latestHist_ = &preHist_;
+}
 
 //-----------------------------------------------------------------------
 //   Yield
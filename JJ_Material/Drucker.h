@@ -72,6 +72,11 @@ class Drucker : public HookeMaterial,
       idx_t                 ipoint );
 
   void                    commit ();
+  void                    cancel ();
+
+  idx_t                   historyBytes    () const;
+  void                    saveHistory     ( void* buf ) const;
+  void                    loadHistory     ( const void* buf );
   
   
   //********** HISTORY RELATED FUNCTIONS **********//
@@ -116,6 +121,8 @@ class Drucker : public HookeMaterial,
   inline virtual idx_t    isLoading         ( idx_t point  ) const;
 
   inline virtual idx_t    wasLoading        ( idx_t point  ) const;
+
+  inline virtual bool     isLinear          () const;
     
     
  //********** MATERIAL RELATED FUNCTIONS **********//
@@ -221,4 +228,9 @@ inline idx_t Drucker::wasLoading ( idx_t ipoint ) const
 }
 
 
+inline bool Drucker::isLinear () const
+{
+  return false;
+}
+
 #endif 
@@ -0,0 +1,97 @@
+/*
+ *  Helpers for materials that keep their integration point history in
+ *  a pair of buffers: preHist_ holds the committed history and newHist_
+ *  the trial history of the current step.
+ */
+
+#ifndef HISTORY_BUFFERS_H
+#define HISTORY_BUFFERS_H
+
+#include <jem/base/utilities.h>
+#include <jem/util/Flex.h>
+
+using jem::idx_t;
+using jem::util::Flex;
+
+//-----------------------------------------------------------------------
+//   cancelHistory
+//-----------------------------------------------------------------------
+
+// The trial history is reset to the committed history, so that a commit
+// without a new update of every point (for instance after a replayed
+// assembly in SolidModel) does not commit the rejected trial. This costs
+// a copy of all points; the materials do not track which points changed.
+
+template <class Hist>
+
+  void                    cancelHistory
+
+  (       Flex<Hist>&       newHist,
+    const Flex<Hist>&       preHist )
+
+{
+  for ( idx_t ip = 0; ip < newHist.size(); ip++ )
+  {
+    newHist[ip] = preHist[ip];
+  }
+}
+
+//-----------------------------------------------------------------------
+//   historyByteCount
+//-----------------------------------------------------------------------
+
+template <class Hist>
+
+  inline idx_t            historyByteCount
+
+  ( const Flex<Hist>&       preHist )
+
+{
+  return preHist.size() * (idx_t) sizeof(Hist);
+}
+
+//-----------------------------------------------------------------------
+//   storeHistory
+//-----------------------------------------------------------------------
+
+template <class Hist>
+
+  void                    storeHistory
+
+  ( void*                   buf,
+    const Flex<Hist>&       preHist )
+
+{
+  Hist*  hist = (Hist*) buf;
+
+  for ( idx_t ip = 0; ip < preHist.size(); ip++ )
+  {
+    hist[ip] = preHist[ip];
+  }
+}
+
+//-----------------------------------------------------------------------
+//   restoreHistory
+//-----------------------------------------------------------------------
+
+// Both the committed and the trial history are set from the buffer.
+
+template <class Hist>
+
+  void                    restoreHistory
+
+  ( Flex<Hist>&             preHist,
+    Flex<Hist>&             newHist,
+    const void*             buf )
+
+{
+  const Hist*  hist = (const Hist*) buf;
+
+  for ( idx_t ip = 0; ip < preHist.size(); ip++ )
+  {
+    preHist[ip] = hist[ip];
+    newHist[ip] = hist[ip];
+  }
+}
+
+#endif
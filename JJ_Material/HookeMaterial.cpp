@@ -25,6 +25,7 @@
 #include <jem/base/System.h>
 
 #include "utilities.h"
+#include "HistoryBuffers.h"
 #include "HookeMaterial.h"
 
 using namespace jem;
@@ -191,6 +192,37 @@ Matrix HookeMaterial::getStiffMat() const
   return stiffMat_;
 }
   
+//-----------------------------------------------------------------------
+//   giveWaveModulus
+//-----------------------------------------------------------------------
+
+// Returns the modulus of the dilatational wave speed c = sqrt(M/rho):
+// the largest normal stiffness term of the elastic stiffness matrix (the
+// P-wave modulus in plane strain and 3D, E/(1-nu^2) in plane stress).
+// The elastic stiffness is also used for the nonlinear materials, since
+// their tangent is softer but an unloading point returns to it.
+
+double HookeMaterial::giveWaveModulus ( const idx_t point ) const
+{
+  if ( rank_ == 1 )
+  {
+    return young_;
+  }
+
+  return max ( stiffMat_(0,0), stiffMat_(1,1) );
+}
+
+//-----------------------------------------------------------------------
+//   isLinear
+//-----------------------------------------------------------------------
+
+// The derived (inelastic) materials override this again.
+
+bool HookeMaterial::isLinear () const
+{
+  return true;
+}
+
 //-----------------------------------------------------------------------
 //   computeStiffMat_
 //-----------------------------------------------------------------------
@@ -567,6 +599,47 @@ void HookeMaterial::commit ()
   latestHist_ = &preHist_;
 }
 
+//-----------------------------------------------------------------------
+//   cancel
+//-----------------------------------------------------------------------
+
+void HookeMaterial::cancel ()
+
+{
+  cancelHistory ( newHist_, preHist_ );
+
+  latestHist_ = &preHist_;
+}
+
+//-----------------------------------------------------------------------
+//   historyBytes
+//-----------------------------------------------------------------------
+
+idx_t HookeMaterial::historyBytes () const
+{
+  return historyByteCount ( preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   saveHistory
+//-----------------------------------------------------------------------
+
+void HookeMaterial::saveHistory ( void* buf ) const
+{
+  storeHistory ( buf, preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   loadHistory
+//-----------------------------------------------------------------------
+
+void HookeMaterial::loadHistory ( const void* buf )
+{
+  restoreHistory ( preHist_, newHist_, buf );
+
+  latestHist_ = &preHist_;
+}
+
 //-----------------------------------------------------------------------
 //   Hist_ constructor
 //-----------------------------------------------------------------------
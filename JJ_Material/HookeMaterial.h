@@ -65,6 +65,17 @@ class HookeMaterial : public Material
       idx_t                 ipoint );
 
   virtual void            commit ();
+  virtual void            cancel ();
+
+  virtual idx_t           historyBytes    () const;
+
+  virtual void            saveHistory
+
+    ( void*                 buf )        const;
+
+  virtual void            loadHistory
+
+    ( const void*           buf );
 
   virtual void            getHistory
 
@@ -87,6 +98,10 @@ class HookeMaterial : public Material
 
   Matrix                  getStiffMat     () const;
 
+  virtual double          giveWaveModulus ( const idx_t point ) const;
+
+  virtual bool            isLinear        () const;
+
   inline double           giveYoung       () const;
   inline double           givePoisson     () const;
   inline double           giveRho         () const;
@@ -34,6 +34,7 @@
 
 #include "utilities.h"
 #include "utilitiesTuple.h"
+#include "HistoryBuffers.h"
 #include "LinHardPlast.h"
 
 using namespace jem;
@@ -497,6 +498,47 @@ void LinHardPlast::commit ()
   latestHist_ = &preHist_;
 }
 
+//-----------------------------------------------------------------------
+//   cancel
+//-----------------------------------------------------------------------
+
+void LinHardPlast::cancel ()
+
+{
+  cancelHistory ( newHist_, preHist_ );
+
+  latestHist_ = &preHist_;
+}
+
+//-----------------------------------------------------------------------
+//   historyBytes
+//-----------------------------------------------------------------------
+
+idx_t LinHardPlast::historyBytes () const
+{
+  return historyByteCount ( preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   saveHistory
+//-----------------------------------------------------------------------
+
+void LinHardPlast::saveHistory ( void* buf ) const
+{
+  storeHistory ( buf, preHist_ );
+}
+
+//-----------------------------------------------------------------------
+//   loadHistory
+//-----------------------------------------------------------------------
+
+void LinHardPlast::loadHistory ( const void* buf )
+{
+  restoreHistory ( preHist_, newHist_, buf );
+
+  latestHist_ = &preHist_;
+}
+
 //-----------------------------------------------------------------------
 //   deviatoric
 //-----------------------------------------------------------------------
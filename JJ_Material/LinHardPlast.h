@@ -56,6 +56,11 @@ class LinHardPlast : public HookeMaterial,
       idx_t                 ipoint );
       
   void                    commit ();
+  void                    cancel ();
+
+  idx_t                   historyBytes    () const;
+  void                    saveHistory     ( void* buf ) const;
+  void                    loadHistory     ( const void* buf );
   
   // History related functions
 
@@ -101,6 +106,8 @@ class LinHardPlast : public HookeMaterial,
   inline virtual idx_t    isLoading         ( idx_t point  ) const;
 
   inline virtual idx_t    wasLoading        ( idx_t point  ) const;
+
+  inline virtual bool     isLinear          () const;
   
   // Stress related operations
 
@@ -222,4 +229,9 @@ inline idx_t LinHardPlast::wasLoading ( idx_t ipoint ) const
   return preHist_[ipoint].loading;
 }
 
+inline bool LinHardPlast::isLinear () const
+{
+  return false;
+}
+
 #endif 
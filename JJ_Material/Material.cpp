@@ -95,6 +95,29 @@ void Material::allocPoints
 void Material::deallocPoints ( const idx_t count )
 {}
 
+//--------------------------------------------------------------------
+//   historyBytes
+//--------------------------------------------------------------------
+
+idx_t Material::historyBytes () const
+{
+  return 0;
+}
+
+//--------------------------------------------------------------------
+//   saveHistory
+//--------------------------------------------------------------------
+
+void Material::saveHistory ( void* buf ) const
+{}
+
+//--------------------------------------------------------------------
+//   loadHistory
+//--------------------------------------------------------------------
+
+void Material::loadHistory ( const void* buf )
+{}
+
 //--------------------------------------------------------------------
 //   despair
 //--------------------------------------------------------------------
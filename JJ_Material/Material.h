@@ -82,6 +82,19 @@ class Material : public Object
     
     ( const idx_t           count );
 
+  // Checkpointing of the committed history. The history is stored as
+  // raw bytes, so a checkpoint can only be read by the same build.
+
+  virtual idx_t           historyBytes      () const;
+
+  virtual void            saveHistory
+
+    ( void*                 buf )          const;
+
+  virtual void            loadHistory
+
+    ( const void*           buf );
+
   idx_t                   getHistoryCount   () const;
 
   StringVector            getHistoryNames   () const;
@@ -116,6 +129,8 @@ class Material : public Object
   inline virtual double   giveDissipation   ( const idx_t point  ) const;
   inline virtual double   giveTheta   ()    const;
   inline virtual double   givePoisson ()    const;
+  inline virtual double   giveWaveModulus   ( const idx_t point  ) const;
+  inline virtual bool     isLinear    ()    const;
   inline virtual String   findState   ()    const;
   
   
@@ -253,6 +268,18 @@ inline double Material::givePoisson () const
   return 0.;
 }
 
+inline double Material::giveWaveModulus ( const idx_t ipoint ) const
+{
+  // default implementation: unknown (no stable time step estimate)
+  return 0.;
+}
+
+inline bool Material::isLinear () const
+{
+  // default implementation: the stress depends on the history
+  return false;
+}
+
 inline String Material::findState () const
 {
   return "None!\n";
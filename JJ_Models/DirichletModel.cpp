@@ -12,8 +12,6 @@
 #include <jem/base/System.h>
 #include <jem/base/Float.h>
 #include <jem/numeric/utilities.h>
-#include <jem/io/PrintWriter.h>
-#include <jem/io/FileWriter.h>
 #include <jive/fem/NodeGroup.h>
 #include <jive/model/Actions.h>
 #include <jive/model/ModelFactory.h>
@@ -21,12 +19,11 @@
 
 #include "DirichletModel.h"
 #include "SolverNames.h"
+#include "Checkpoint.h"
 
 using jem::io::endl;
 
 
-using jem::io::PrintWriter;
-using jem::io::FileWriter;
 using jive::fem::NodeGroup;
 using jive::model::Actions;
 using jive::util::XDofSpace;
@@ -80,6 +77,13 @@ DirichletModel::DirichletModel
   turnBool_    = false;
   unloadBool_  = false;
   method_      = INCREMENT;
+  arclMode_    = false;
+
+  snapScale0_  = 0.;
+  snapIncr_    = 0.;
+  snapIncr0_   = 0.;
+  snapTurn_    = false;
+  snapUnload_  = false;
 
 }
 
@@ -156,27 +160,112 @@ bool DirichletModel::takeAction
     setDT_ ( params );
   }
   
-  if ( action == "WRITE_RESTART" )
+  // switch between displacement control and arc-length control
+
+  if ( action == SolverNames::TO_ARCL )
   {
-    // then write new files
-    Ref<PrintWriter> oFile = newInstance<PrintWriter> (newInstance<FileWriter> ( "Diri.restart" ));
-    oFile->nformat.setScientific(true);
-    oFile->nformat.setFractionDigits (15);
-    oFile->setPageWidth(10000);
+    arclMode_  = true;
+    dispScale_ = dispScale0_;
 
-    *oFile << dispScale_ << endl;
-    
-    oFile->close();
-    
-    system("mkdir NewRestart");
-    system("cp *.restart NewRestart");
-    
-    system("mkdir Restart");
-    system("mv *.restart Restart/");
-    
+    return true;
   }
-  
-  
+
+  if ( action == SolverNames::TO_DISP )
+  {
+    arclMode_  = false;
+
+    return true;
+  }
+
+  // communicate the load scale with an arc-length solver
+
+  if ( action == SolverNames::GET_UNIT_DISP )
+  {
+    getUnitDisp_ ( params, globdat );
+
+    return true;
+  }
+
+  if ( action == SolverNames::GET_LOAD_SCALE )
+  {
+    params.set ( SolverNames::LOAD_SCALE,   dispScale_  );
+    params.set ( SolverNames::LOAD_SCALE_0, dispScale0_ );
+
+    return true;
+  }
+
+  if ( action == SolverNames::SET_LOAD_SCALE )
+  {
+    params.get ( dispScale_, SolverNames::LOAD_SCALE );
+
+    return true;
+  }
+
+  if ( action == SolverNames::GET_STEP_SIZE )
+  {
+    params.set ( SolverNames::STEP_SIZE,   dispIncr_  );
+    params.set ( SolverNames::STEP_SIZE_0, dispIncr0_ );
+
+    return true;
+  }
+
+  // save or roll back the state at the start of the step
+
+  if ( action == SolverNames::STORE_SNAPSHOT )
+  {
+    storeSnapshot_ ();
+
+    return true;
+  }
+
+  if ( action == SolverNames::RESTORE_SNAPSHOT )
+  {
+    restoreSnapshot_ ();
+
+    return true;
+  }
+
+  // store or restore the load state in a checkpoint
+
+  if ( action == SolverNames::WRITE_CHECKPOINT )
+  {
+    Ref<Checkpoint>  ckpt;
+    Vector           state ( 6 );
+
+    params.get ( ckpt, SolverNames::CHECKPOINT );
+
+    state[0] = dispScale_;
+    state[1] = dispScale0_;
+    state[2] = dispIncr_;
+    state[3] = dispIncr0_;
+    state[4] = turnBool_   ? 1.0 : 0.0;
+    state[5] = unloadBool_ ? 1.0 : 0.0;
+
+    ckpt->add ( myName_ + ".state", state );
+
+    return true;
+  }
+
+  if ( action == SolverNames::READ_CHECKPOINT )
+  {
+    Ref<Checkpoint>  ckpt;
+    Vector           state ( 6 );
+
+    params.get ( ckpt, SolverNames::CHECKPOINT );
+
+    if ( ckpt->find( state, myName_ + ".state" ) )
+    {
+      dispScale_  = state[0];
+      dispScale0_ = state[1];
+      dispIncr_   = state[2];
+      dispIncr0_  = state[3];
+      turnBool_   = ( state[4] != 0.0 );
+      unloadBool_ = ( state[5] != 0.0 );
+    }
+
+    return true;
+  }
+
   return false;
 }
 
@@ -205,17 +294,7 @@ void DirichletModel::configure
   else
   {
     myProps.find ( initDisp_,  INIT_DISP_PROP );
-    
-    //
-    int out = system("ls Diri.restart");
-    if ( out == 0 )
-    {
-      Ref<FileReader> iFile = newInstance<FileReader> ( "Diri.restart" );
-      initDisp_ = iFile->parseFloat();
-    }
-    //
-    
-    
+
     myProps.get ( dispIncr0_, DISP_INCR_PROP );
 
     method_     = INCREMENT;
@@ -348,6 +427,15 @@ void DirichletModel::advance_
       << " It seems the time increment has not been set." << endl;
   }
 
+  if ( arclMode_ )
+  {
+    // the solver determines the new load scale
+
+    dispScale_ = dispScale0_;
+
+    return;
+  }
+
   dispScale_   = dispScale0_ + dispIncr_;
   
   // Added by Erik
@@ -416,6 +504,40 @@ void DirichletModel::applyConstraints_
   cons_->compress();
 }
 
+//-----------------------------------------------------------------------
+//   getUnitDisp_
+//-----------------------------------------------------------------------
+
+// Fills the vector UNIT_DISP with the prescribed displacements for a
+// unit load scale. The other entries are not touched.
+
+void DirichletModel::getUnitDisp_
+
+  ( const Properties&  params,
+    const Properties&  globdat )
+
+{
+  Vector                u;
+  Assignable<NodeGroup> group;
+  IdxVector             inodes;
+  String                context;
+
+  params.get ( u, SolverNames::UNIT_DISP );
+
+  for ( idx_t ig = 0; ig < ngroups_; ig++ )
+  {
+    group  = NodeGroup::get ( nodeGroups_[ig], nodes_, globdat, context );
+    inodes . ref ( group.getIndices () );
+
+    idx_t itype  = dofs_->findType ( dofTypes_[ig] );
+
+    for ( idx_t in = 0; in < inodes.size(); in++ )
+    {
+      u[dofs_->getDofIndex ( inodes[in], itype )] = factors_[ig];
+    }
+  }
+}
+
 //-----------------------------------------------------------------------
 //   checkCommit_
 //-----------------------------------------------------------------------
@@ -463,6 +585,36 @@ void DirichletModel::commit_
   dispScale0_  = dispScale_;
 }
 
+//-----------------------------------------------------------------------
+//   storeSnapshot_
+//-----------------------------------------------------------------------
+
+void DirichletModel::storeSnapshot_ ()
+{
+  snapScale0_  = dispScale0_;
+  snapIncr_    = dispIncr_;
+  snapIncr0_   = dispIncr0_;
+  snapTurn_    = turnBool_;
+  snapUnload_  = unloadBool_;
+}
+
+//-----------------------------------------------------------------------
+//   restoreSnapshot_
+//-----------------------------------------------------------------------
+
+// advance_ may have flipped the increment and set the turn/unload flags
+// for the discarded step; these are reset as well.
+
+void DirichletModel::restoreSnapshot_ ()
+{
+  dispScale0_  = snapScale0_;
+  dispScale_   = snapScale0_;
+  dispIncr_    = snapIncr_;
+  dispIncr0_   = snapIncr0_;
+  turnBool_    = snapTurn_;
+  unloadBool_  = snapUnload_;
+}
+
 //-----------------------------------------------------------------------
 //   setDT_
 //-----------------------------------------------------------------------
@@ -137,6 +137,15 @@ class DirichletModel : public Model
     ( const Properties&       params,
       const Properties&       globdat );
 
+  void                      getUnitDisp_
+
+    ( const Properties&       params,
+      const Properties&       globdat );
+
+  void                      storeSnapshot_ ();
+
+  void                      restoreSnapshot_ ();
+
   void                      setDT_
 
     ( const Properties&       params );
@@ -189,6 +198,19 @@ class DirichletModel : public Model
   bool                      turnBool_;
   bool                      unloadBool_;
 
+  // in arc-length mode (see TO_ARCL) the load scale is not incremented
+  // by advance_ but set by the solver with SET_LOAD_SCALE
+
+  bool                      arclMode_;
+
+  // state at the start of the step (see STORE_SNAPSHOT)
+
+  double                    snapScale0_;
+  double                    snapIncr_;
+  double                    snapIncr0_;
+  bool                      snapTurn_;
+  bool                      snapUnload_;
+
 };
 
 #endif
@@ -1,22 +1,27 @@
 //=======================================================================
 //
-// Model that prints load-displacement data for nodegroup to file:
+// Model that prints load-displacement data for nodegroups to file:
 // The sum of the nodal loads and the average of the nodal displacements
 //
-// Adapted from: MonitorModel, 
+// Adapted from: MonitorModel,
 // FPM, 29-1-2008
-// 
+//
+// The node groups are given with 'group', 'groups' and/or 'nodes'.
+// Their DOF indices are stored in one array, which is only rebuilt
+// when the DOF space changes, so that the loads and displacements of
+// all groups are computed in a single pass over that array.
+//
 // Data is computed in GET_MATRIX0 and GET_INT_VECTOR
-//         and optionally written to file in COMMIT
-//         (rather using the SampleModule to write to file recommended)
+//         and stored in globdat in COMMIT, so only converged values
+//         are recorded (rather using the SampleModule to write to
+//         file recommended). The first group is stored as load and
+//         disp, each group also as <group>.load and <group>.disp.
 //
 //=======================================================================
 
-#include <jem/io/PrintWriter.h>
-#include <jem/io/FileWriter.h>
-#include <jem/base/array/select.h>
-#include <jem/base/array/utilities.h>
-#include <jem/base/System.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/util/Event.h>
+#include <jem/util/Flex.h>
 #include <jem/util/Properties.h>
 #include <jive/util/Globdat.h>
 #include <jive/util/ItemSet.h>
@@ -33,14 +38,12 @@
 
 
 using namespace jem;
-using jem::io::endl;
 
+using jem::util::Flex;
 using jem::util::Properties;
-using jem::io::PrintWriter;
-using jem::io::FileWriter;
 using jive::Vector;
+using jive::Matrix;
 using jive::IntVector;
-using jive::IntMatrix;
 using jive::StringVector;
 using jive::util::DofSpace;
 using jive::util::Assignable;
@@ -58,8 +61,11 @@ class LoadDispModel : public Model
 {
  public:
 
+  typedef LoadDispModel     Self;
+
   static const char*        NODES_PROP;
   static const char*        GROUP_PROP;
+  static const char*        GROUPS_PROP;
   static const char*        TYPES_PROP;
 
                             LoadDispModel
@@ -85,31 +91,49 @@ class LoadDispModel : public Model
       const Properties&       params,
       const Properties&       globdat );
 
-  void                      updateIDofs_
-
-    ();
-
 
  protected:
 
   virtual                  ~LoadDispModel  ();
 
 
+ private:
+
+  void                      updateIDofs_
+
+    ( const Properties&       globdat );
+
+  void                      invalidate_     ();
+
+
  private:
 
   Ref<DofSpace>             dofs_;
   Assignable<ElementSet>    elems_;
   Assignable<NodeSet>       nodes_;
 
-  IntVector                 inodes_;
-  IntMatrix                 idofs_;
-  int                       nn_;
   int                       rank_;
+  IntVector                 nodeIDs_;
   String                    groupName_;
-  Assignable<NodeGroup>     ngroup_;
-  int                       typeCount_;
+  StringVector              groupNames_;
   IntVector                 types_;
   StringVector              typeNames_;
+
+  // Names of all groups (the nodes given by ID are called "nodes")
+  // and the DOF indices of group i and type j: idofs_[k] for k from
+  // offsets_[i * types_.size() + j] up to the next offset.
+
+  StringVector              names_;
+  IntVector                 idofs_;
+  IntVector                 offsets_;
+  bool                      valid_;
+
+  // Loads and displacements (one column per group) of the last
+  // GET_INT_VECTOR or GET_MATRIX0; stored in globdat in COMMIT.
+
+  Matrix                    loads_;
+  Matrix                    disps_;
+  bool                      computed_;
 };
 
 
@@ -120,6 +144,7 @@ class LoadDispModel : public Model
 
 const char*  LoadDispModel::NODES_PROP     = "nodes";
 const char*  LoadDispModel::GROUP_PROP     = "group";
+const char*  LoadDispModel::GROUPS_PROP    = "groups";
 const char*  LoadDispModel::TYPES_PROP     = "types";
 
 
@@ -138,15 +163,20 @@ LoadDispModel::LoadDispModel
     Model ( name )
 
 {
+  using jem::util::connect;
+
   const String       context = getContext ();
 
   elems_ = ElementSet::get ( globdat, context );
   nodes_ = elems_.getNodes ();
   dofs_  = DofSpace::get ( nodes_.getData(), globdat, context );
-  nn_ = -1;
   rank_ = nodes_.rank();
-  typeCount_ = dofs_->typeCount();
   groupName_ = "";
+  valid_ = false;
+  computed_ = false;
+
+  connect ( dofs_->newSizeEvent,  this, &Self::invalidate_ );
+  connect ( dofs_->newOrderEvent, this, &Self::invalidate_ );
 }
 
 
@@ -165,43 +195,12 @@ void LoadDispModel::configure
     const Properties&  globdat )
 
 {
-  using jive::util::Globdat;
-
   Properties    myProps = props.findProps ( myName_ );
 
-  const String  context = getContext ();
-
-  IntVector     nodeIDs;
+  myProps.find ( nodeIDs_,    NODES_PROP  );
+  myProps.find ( groupName_,  GROUP_PROP  );
+  myProps.find ( groupNames_, GROUPS_PROP );
 
-  Properties    myVars = Globdat::getVariables ( myName_, globdat );
-
-  if ( myProps.find( nodeIDs, NODES_PROP ) )
-  {
-    // Get node and dof numbers specified with 'nodes = IntVector'
-    
-    nn_ = nodeIDs.size();
-
-    inodes_.resize ( nn_ );
-    idofs_.resize ( nn_ , types_.size() );
-
-    for ( int i = 0; i < nn_; i++ )
-    {
-      inodes_[i] = nodes_.findNode ( nodeIDs[i] );
-
-      for ( int j = 0; j < types_.size(); ++j )
-      {
-        idofs_(i,j) = dofs_->getDofIndex ( inodes_[i], types_[j] );
-      }
-    }
-  }
-
-  if ( myProps.find( groupName_, GROUP_PROP ) )
-  {
-    // Get node and dof numbers specified with 'group = String'
-    
-    ngroup_ = NodeGroup::get ( groupName_, nodes_, globdat, context );
-  }
-  
   if ( myProps.find( typeNames_, TYPES_PROP ) )
   {
     types_.resize ( typeNames_.size() );
@@ -221,34 +220,131 @@ void LoadDispModel::configure
   {
     types_[i] = dofs_->getTypeIndex ( typeNames_[i] );
   }
+
+  // Collect the names of the groups; the DOFs are looked up in the
+  // first action.
+
+  Flex<String>  names;
+
+  if ( nodeIDs_.size() > 0 )
+  {
+    names.pushBack ( "nodes" );
+  }
+
+  if ( groupName_.size() > 0 )
+  {
+    names.pushBack ( groupName_ );
+  }
+
+  for ( int i = 0; i < groupNames_.size(); i++ )
+  {
+    names.pushBack ( groupNames_[i] );
+  }
+
+  names_.resize ( names.size() );
+
+  for ( int i = 0; i < names_.size(); i++ )
+  {
+    names_[i] = names[i];
+  }
+
+  valid_    = false;
+  computed_ = false;
 }
 
 //-----------------------------------------------------------------------
 //   updateIDofs_
 //-----------------------------------------------------------------------
 
+// Looks up the DOF indices of all groups. This is done once and again
+// when the DOF space has changed.
 
 void LoadDispModel::updateIDofs_
 
-  ()
+  ( const Properties&  globdat )
 
 {
-  nn_ = ngroup_.size();
+  const String  context    = getContext ();
+  const int     typeCount  = types_.size ();
+  const int     groupCount = names_.size ();
+
+  Flex<int>     idofs;
+  IntVector     inodes;
 
-  inodes_.resize ( nn_ );
-  idofs_ .resize ( nn_ , types_.size() );
+  offsets_.resize ( groupCount * typeCount + 1 );
 
-  inodes_ = ngroup_.getIndices();
+  offsets_[0] = 0;
 
-  for ( int i = 0; i < nn_; i++ )
+  for ( int ig = 0; ig < groupCount; ig++ )
   {
-    for ( int j = 0; j < types_.size(); ++j )
+    if ( ig == 0 && nodeIDs_.size() > 0 )
+    {
+      inodes.resize ( nodeIDs_.size() );
+
+      for ( int i = 0; i < nodeIDs_.size(); i++ )
+      {
+        inodes[i] = nodes_.findNode ( nodeIDs_[i] );
+
+        if ( inodes[i] < 0 )
+        {
+          throw IllegalInputException (
+            context,
+            String::format ( "unknown node ID: %d", nodeIDs_[i] )
+          );
+        }
+      }
+    }
+    else
     {
-      idofs_(i,j) = dofs_->findDofIndex ( inodes_[i], types_[j] );
+      NodeGroup  group = NodeGroup::get ( names_[ig], nodes_,
+                                          globdat, context );
+
+      inodes.ref ( group.getIndices() );
+    }
+
+    for ( int j = 0; j < typeCount; j++ )
+    {
+      for ( int i = 0; i < inodes.size(); i++ )
+      {
+        const int  idof = dofs_->findDofIndex ( inodes[i], types_[j] );
+
+        if ( idof >= 0 )
+        {
+          idofs.pushBack ( idof );
+        }
+      }
+
+      offsets_[ig * typeCount + j + 1] = idofs.size ();
     }
   }
+
+  idofs_.resize ( idofs.size() );
+
+  for ( int k = 0; k < idofs_.size(); k++ )
+  {
+    idofs_[k] = idofs[k];
+  }
+
+  loads_.resize ( typeCount, groupCount );
+  disps_.resize ( typeCount, groupCount );
+
+  loads_ = 0.0;
+  disps_ = 0.0;
+
+  valid_ = true;
 }
-  
+
+
+//-----------------------------------------------------------------------
+//   invalidate_
+//-----------------------------------------------------------------------
+
+
+void LoadDispModel::invalidate_ ()
+{
+  valid_ = false;
+}
+
 
 //-----------------------------------------------------------------------
 //   getConfig
@@ -263,10 +359,12 @@ void LoadDispModel::getConfig
 {
   Properties  myConf = conf.makeProps ( myName_ );
 
-  myConf.set ( NODES_PROP, inodes_ );
+  myConf.set ( NODES_PROP, nodeIDs_ );
 
   myConf.set ( GROUP_PROP, groupName_ );
 
+  myConf.set ( GROUPS_PROP, groupNames_ );
+
   myConf.set ( TYPES_PROP, typeNames_ );
 }
 
@@ -288,46 +386,88 @@ bool LoadDispModel::takeAction
   using jive::model::ActionParams;
   using jive::model::StateVector;
 
-  if ( nn_ < 0 && nodes_ == NIL )
+  if ( names_.size() == 0 )
   {
     return false;
   }
 
-  Vector      load ( types_.size() ) ;
-  Vector      disp ( types_.size() ) ;
-
   if ( action == Actions::GET_MATRIX0 ||
        action == Actions::GET_INT_VECTOR )
   {
-    System::out() << "LoadDisp: get_matrix0 or get_int_vector\n";
-    // get global data
-    
-    Properties  myVars = Globdat::getVariables ( myName_, globdat );
-
     // get internal force and solution vector
-    
+
     Vector      fint;
     Vector      state;
 
     params.get ( fint, ActionParams::INT_VECTOR );
     StateVector::get ( state, dofs_, globdat );
-    updateIDofs_();
 
+    if ( ! valid_ )
+    {
+      updateIDofs_ ( globdat );
+    }
+
+    // compute cumulative load and average displacement of all groups
+    // in one pass
+
+    const int  typeCount = types_.size ();
+    const int  segCount  = offsets_.size() - 1;
+
+    for ( int is = 0; is < segCount; is++ )
+    {
+      const int  first = offsets_[is];
+      const int  last  = offsets_[is + 1];
+
+      double     load  = 0.0;
+      double     disp  = 0.0;
+
+      for ( int k = first; k < last; k++ )
+      {
+        load += fint [idofs_[k]];
+        disp += state[idofs_[k]];
+      }
+
+      if ( last > first )
+      {
+        disp /= (double) (last - first);
+      }
+
+      loads_(is % typeCount,is / typeCount) = load;
+      disps_(is % typeCount,is / typeCount) = disp;
+    }
+
+    computed_ = true;
 
-    // compute cumulative load and average displacement
-    for ( int i = 0; i < types_.size(); i++ )
+    return true;
+  }
+
+  if ( action == Actions::COMMIT )
+  {
+    if ( ! computed_ )
     {
-      load[i] = sum ( select ( fint , idofs_(ALL,i) ) );
-      disp[i] = sum ( select ( state , idofs_(ALL,i) ) ) / nn_;
+      return true;
     }
 
     // store in globdat
 
-    myVars.set ( "load" , load );
-    myVars.set ( "disp" , disp );
+    Properties  myVars = Globdat::getVariables ( myName_, globdat );
+
+    myVars.set ( "load" , Vector( loads_(ALL,0).clone() ) );
+    myVars.set ( "disp" , Vector( disps_(ALL,0).clone() ) );
+
+    for ( int ig = 0; ig < names_.size(); ig++ )
+    {
+      Properties  groupVars = myVars.makeProps ( names_[ig] );
+
+      groupVars.set ( "load" , Vector( loads_(ALL,ig).clone() ) );
+      groupVars.set ( "disp" , Vector( disps_(ALL,ig).clone() ) );
+    }
+
+    computed_ = false;
 
     return true;
   }
+
   return false;
 }
 
@@ -1,5 +1,10 @@
 
+#include <time.h>
+#include <cmath>
+
 #include <jem/base/Array.h>
+#include <jem/base/array/logical.h>
+#include <jem/base/Float.h>
 #include <jem/base/IllegalInputException.h>
 #include <jem/base/System.h>
 #include <jem/numeric/algebra/LUSolver.h>
@@ -19,6 +24,11 @@
 
 #include "models.h"
 #include "SolidModel.h"
+#include "SolverNames.h"
+#include "Checkpoint.h"
+#include "OutputFrame.h"
+#include "ProbeSet.h"
+#include "Plasticity.h"
 
 using jem::io::PrintWriter;
 using jem::io::FileWriter;
@@ -44,6 +54,9 @@ const char*  SolidModel::INTEL_PROP      = "ischeme_element";
 const char*  SolidModel::INTBC_PROP      = "ischeme_boundary";
 const char*  SolidModel::STRAIN_PROP     = "Large_strain";
 const char*  SolidModel::OPPL_PROP       = "op_plot";
+const char*  SolidModel::RECOVERY_PROP   = "recovery";
+const char*  SolidModel::RECOVERY_THREADS_PROP = "recoveryThreads";
+const char*  SolidModel::SNAPSHOT_CACHE_PROP   = "snapshotCache";
 
 const char*  SolidModel::DOF_TYPE_NAME_1 = "u";
 const char*  SolidModel::DOF_TYPE_NAME_2 = "v";
@@ -84,12 +97,35 @@ SolidModel::SolidModel
   myConf .set ( INTBC_PROP, intbc_ );
   
   oppl_ = 0;
+
+  snapCache_  = false;
+  cacheNext_  = false;
+  cacheValid_ = false;
+  replayNext_ = false;
   myProps.find ( oppl_, OPPL_PROP );
   myConf .set  ( OPPL_PROP, oppl_     );
+  myProps.find ( snapCache_, SNAPSHOT_CACHE_PROP );
+  myConf .set  ( SNAPSHOT_CACHE_PROP, snapCache_ );
   
   strainForm_ = false;
   myProps.find ( strainForm_, STRAIN_PROP );
   myConf .set ( STRAIN_PROP, strainForm_ );
+
+  // The method used to average the integration point values to the
+  // nodes (average, l2 or spr).
+
+  String  recovery = "average";
+
+  recThreads_ = 1;
+
+  myProps.find ( recovery,    RECOVERY_PROP );
+  myProps.find ( recThreads_, RECOVERY_THREADS_PROP, 1, 256 );
+
+  recMethod_ = StressRecovery::getMethod ( recovery, context );
+
+  myConf .set  ( RECOVERY_PROP,
+                 StressRecovery::getMethodName( recMethod_ ) );
+  myConf .set  ( RECOVERY_THREADS_PROP, recThreads_ );
   
   // Get the elements and the nodes from the global database.
   egroup_ = ElementGroup::get ( myConf, myProps, globdat, context );
@@ -146,6 +182,20 @@ SolidModel::SolidModel
 
   items->addItems ( elems_.size() * shape_->ipointCount() );
   items->store ( globdat );
+
+  // Map the element indices to their position in the group, so that
+  // the op_plot element and the probes are found without a search.
+
+  IdxVector  ielems = egroup_.getIndices ();
+
+  ielemMap_.resize ( elems_.size() );
+
+  ielemMap_ = -1;
+
+  for ( idx_t ie = 0; ie < ielems.size(); ie++ )
+  {
+    ielemMap_[ielems[ie]] = ie;
+  }
   
 }
 
@@ -176,9 +226,15 @@ bool SolidModel::takeAction
 
     Vector  fint;
 
+    // Only the active elements are assembled when subcycling.
+
+    params.find ( activeElems_, SolverNames::ACTIVE_ELEMS );
+
     params.get  ( fint, ActionParams::INT_VECTOR );
     getMatrix0_ ( NIL,  fint, globdat );
 
+    activeElems_.ref ( BoolVector() );
+
     return true;
   }
 
@@ -215,11 +271,193 @@ bool SolidModel::takeAction
   {
     // Commit and save history variables for next step
     System::out() << "Solid: commit\n";
+
+    // Report the number of points that started loading in this step;
+    // the counts of all models are added up.
+
+    using jive::util::Globdat;
+
+    Properties  vars       = Globdat::getVariables ( globdat );
+    idx_t       np         = material_->pointCount ();
+    idx_t       newLoading = 0;
+    idx_t       count      = 0;
+
+    for ( idx_t ip = 0; ip < np; ip++ )
+    {
+      if ( material_->isLoading( ip ) && ! material_->wasLoading( ip ) )
+      {
+        newLoading++;
+      }
+    }
+
+    vars.find ( count, SolverNames::NEW_LOADING );
+    vars.set  ( SolverNames::NEW_LOADING, count + newLoading );
+
+    count = 0;
+
+    vars.find ( count, SolverNames::POINT_COUNT );
+    vars.set  ( SolverNames::POINT_COUNT, count + np );
+
     material_->commit ();
+
+    cacheNext_  = false;
+    cacheValid_ = false;
+    replayNext_ = false;
     
     return true;
   }
 
+  if ( action == SolverNames::GET_DISS_FORCE )
+  {
+    // Assemble the dissipation force vector for the dissipation
+    // based arc-length method.
+
+    Vector  fdiss;
+
+    params.get    ( fdiss, SolverNames::DISSIPATION_FORCE );
+    getDissForce_ ( fdiss, globdat );
+
+    return true;
+  }
+
+  if ( action == SolverNames::GET_CRIT_TIME_STEP )
+  {
+    // Return the smallest stable time step of all models, and the
+    // stable time step per element if requested.
+
+    double  dt = jem::Float::MAX_VALUE;
+    Vector  elemSteps;
+
+    params.find ( dt,        SolverNames::CRIT_TIME_STEP );
+    params.find ( elemSteps, SolverNames::ELEM_CRIT_STEP );
+    params.set  ( SolverNames::CRIT_TIME_STEP,
+                  jem::min( dt, getCritTimeStep_( elemSteps ) ) );
+
+    return true;
+  }
+
+  if ( action == SolverNames::CHECK_LINEAR )
+  {
+    // The model is linear if all materials are; a single nonlinear
+    // model makes the whole model nonlinear.
+
+    bool  linear = true;
+
+    params.find ( linear, SolverNames::LINEAR );
+    params.set  ( SolverNames::LINEAR, linear && material_->isLinear() );
+
+    return true;
+  }
+
+  if ( action == SolverNames::GET_OUTPUT_FRAME )
+  {
+    Ref<OutputFrame>  frame;
+
+    params.get ( frame, SolverNames::OUTPUT_FRAME );
+
+    getOutputFrame_ ( *frame );
+
+    return true;
+  }
+
+  if ( action == SolverNames::RESOLVE_PROBES )
+  {
+    Ref<ProbeSet>  probes;
+
+    params.get ( probes, SolverNames::PROBE_SET );
+
+    resolveProbes_ ( *probes );
+
+    return true;
+  }
+
+  if ( action == SolverNames::GET_PROBES )
+  {
+    Ref<ProbeSet>  probes;
+
+    params.get ( probes, SolverNames::PROBE_SET );
+
+    getProbes_ ( *probes );
+
+    return true;
+  }
+
+  if ( action == SolverNames::TIME_MATERIAL )
+  {
+    timeMaterial_ ( params, globdat );
+
+    return true;
+  }
+
+  if ( action == SolverNames::WRITE_CHECKPOINT )
+  {
+    Ref<Checkpoint>  ckpt;
+    const idx_t      bytes = material_->historyBytes ();
+
+    params.get ( ckpt, SolverNames::CHECKPOINT );
+
+    if ( bytes > 0 )
+    {
+      material_->saveHistory (
+        ckpt->alloc ( myName_ + ".history", bytes )
+      );
+    }
+
+    return true;
+  }
+
+  if ( action == SolverNames::READ_CHECKPOINT )
+  {
+    Ref<Checkpoint>  ckpt;
+    idx_t            bytes;
+
+    params.get ( ckpt, SolverNames::CHECKPOINT );
+
+    const void*  hist = ckpt->find ( bytes, myName_ + ".history" );
+
+    if ( hist == 0 )
+    {
+      return true;
+    }
+
+    if ( bytes != material_->historyBytes() )
+    {
+      throw IllegalInputException (
+        getContext (),
+        "material history in the checkpoint does not match the model"
+      );
+    }
+
+    material_->loadHistory ( hist );
+
+    return true;
+  }
+
+  if ( action == SolverNames::STORE_SNAPSHOT )
+  {
+    // The next assembly is done at the state of the snapshot; cache
+    // its element data. Rate dependent materials are skipped since
+    // their tangent depends on the step size.
+
+    cacheNext_  = snapCache_ && ! material_->isViscous ();
+    cacheValid_ = false;
+    replayNext_ = false;
+
+    return true;
+  }
+
+  if ( action == SolverNames::RESTORE_SNAPSHOT )
+  {
+    // The trial history is reset to the committed one, which is also
+    // the history that belongs to the replayed element data.
+
+    material_->cancel ();
+
+    replayNext_ = cacheValid_;
+
+    return true;
+  }
+
   if ( action == Actions::GET_TABLE )
   { 
     // Write to table for output
@@ -355,10 +593,52 @@ void SolidModel::getMatrix0_
 
   StateVector::get ( state, dofs_, globdat );
 
+  // Replay the cached element data after a rollback. The material
+  // points are not updated: the state is the committed one, for which
+  // the trial history equals the committed history (see cancel).
+
+  if ( replayNext_ && mbld != NIL )
+  {
+    replayNext_ = false;
+
+    if ( cacheState_.size() == state.size() &&
+         testall ( cacheState_ == state ) )
+    {
+      for ( int ie = 0; ie < ielemCount; ie++ )
+      {
+        elems_.getElemNodes  ( inodes, ielems[ie] );
+        dofs_->getDofIndices ( idofs, inodes, dofTypes_ );
+
+        select ( fint, idofs ) += elforceCache_[ie];
+
+        mbld->addBlock ( idofs, idofs, elmatCache_(ALL,ALL,ie) );
+      }
+
+      return;
+    }
+  }
+
+  const bool  record = ( cacheNext_ && mbld != NIL );
+
+  if ( record )
+  {
+    elmatCache_  .resize ( dofCount_, dofCount_, ielemCount );
+    elforceCache_.resize ( dofCount_, ielemCount );
+    cacheState_  .resize ( state.size() );
+
+    cacheState_ = state;
+  }
+
   for ( int ie = 0; ie < ielemCount; ie++ )
   {
     // Get the global element index.
     int  ielem = ielems[ie];
+
+    if ( activeElems_.size() > 0 && ! activeElems_[ielem] )
+    {
+      ipoint += ipCount_;
+      continue;
+    }
     
     // Get the nodes and coordinates of this element.
 
@@ -403,11 +683,195 @@ void SolidModel::getMatrix0_
       mbld->addBlock ( idofs, idofs, elmat );
     }
 
+    if ( record )
+    {
+      elmatCache_(ALL,ALL,ie) = elmat;
+      elforceCache_[ie]       = elforce;
+    }
+
+  }
+
+  if ( record )
+  {
+    cacheNext_  = false;
+    cacheValid_ = true;
   }
   
   
   
 
+}
+
+//-----------------------------------------------------------------------
+//   getDissForce_
+//-----------------------------------------------------------------------
+
+// Adds the integral of B^T (sig - s*) to fdiss, with s* the dissipation
+// stress of the material. The product of this vector with a
+// displacement increment is the (linearized) energy dissipated in that
+// increment. Must be called after COMMIT since the material evaluates
+// s* at the committed state. Materials without permanent deformation
+// do not dissipate and are skipped.
+
+void SolidModel::getDissForce_
+
+  ( const Vector&      fdiss,
+    const Properties&  globdat )
+
+{
+  using jem::numeric::matmul;
+
+  const Plasticity*  plas = dynamic_cast<Plasticity*> ( material_.get() );
+
+  if ( plas == 0 )
+  {
+    return;
+  }
+
+  IntVector   ielems     = egroup_.getIndices  ();
+  const int   ielemCount = ielems.size         ();
+
+  Matrix      B       ( strCount_, dofTypes_.size() * ndCount_ );
+  Vector      stress  ( strCount_ );
+  Vector      sstar   ( strCount_ );
+  Vector      strain  ( strCount_ );
+
+  Cubix       grads   ( rank_,    ndCount_, ipCount_ );
+  Matrix      coords  ( rank_,    ndCount_ );
+  Vector      elvec   ( dofCount_ );
+  Vector      elforce ( dofCount_ );
+  Vector      weights ( ipCount_ );
+  IntVector   inodes  ( ndCount_ );
+  IntVector   idofs   ( dofCount_ );
+
+  Vector      state;
+
+  idx_t       ipoint = 0;
+
+  B = 0.0;
+
+  StateVector::get ( state, dofs_, globdat );
+
+  for ( int ie = 0; ie < ielemCount; ie++ )
+  {
+    elems_.getElemNodes  ( inodes, ielems[ie] );
+    nodes_.getSomeCoords ( coords, inodes );
+    dofs_->getDofIndices ( idofs, inodes, dofTypes_ );
+
+    shape_->getShapeGradients ( grads, weights, coords );
+
+    elforce = 0.0;
+    elvec   = select ( state, idofs );
+
+    for ( int ip = 0; ip < ipCount_; ip++ )
+    {
+      getShapeGrads_ ( B, grads(ALL,ALL,ip) );
+      strain = matmul( B, elvec );
+
+      material_->getStress       ( stress, ipoint );
+      plas->getDissipationStress ( sstar, strain, ipoint++ );
+
+      elforce += matmul ( B.transpose(), stress - sstar ) * weights[ip];
+    }
+
+    select ( fdiss, idofs ) += elforce;
+  }
+}
+
+//-----------------------------------------------------------------------
+//   getCritTimeStep_
+//-----------------------------------------------------------------------
+
+// Returns the smallest element estimate L / c of the stable time step
+// of the central difference scheme. The characteristic length L is the
+// smallest height of a triangle and the area divided by the longest
+// side of a quad; c is the dilatational wave speed. The estimates are
+// also stored in elemSteps (indexed by element) if it is not empty.
+//
+// The estimate is only valid for two-dimensional Triangle3 and Quad4
+// elements, whose nodes are the corners of the element in order. For
+// other meshes no estimate is made: MAX_VALUE is returned and elemSteps
+// is left unchanged.
+
+double SolidModel::getCritTimeStep_ ( const Vector& elemSteps ) const
+{
+  IntVector   ielems     = egroup_.getIndices ();
+  const int   ielemCount = ielems.size        ();
+
+  Matrix      coords  ( rank_, 4 );
+  IntVector   inodes  ( 4 );
+
+  double      dtmin   = jem::Float::MAX_VALUE;
+
+  idx_t       ipoint  = 0;
+
+  if ( rank_ != 2 )
+  {
+    return dtmin;
+  }
+
+  for ( int ie = 0; ie < ielemCount; ie++ )
+  {
+    const int  nodeCount = elems_.getElemNodeCount ( ielems[ie] );
+
+    if ( nodeCount != 3 && nodeCount != 4 )
+    {
+      return dtmin;
+    }
+  }
+
+  for ( int ie = 0; ie < ielemCount; ie++ )
+  {
+    const int  ielem     = ielems[ie];
+    const int  nodeCount = elems_.getElemNodeCount ( ielem );
+
+    double     area      = 0.0;
+    double     lmax      = 0.0;
+    double     wmod      = 0.0;
+
+    IntVector  enodes  = inodes[slice(BEGIN,nodeCount)];
+    Matrix     ecoords = coords(ALL,slice(BEGIN,nodeCount));
+
+    elems_.getElemNodes  ( enodes,  ielem );
+    nodes_.getSomeCoords ( ecoords, enodes );
+
+    for ( int in = 0; in < nodeCount; in++ )
+    {
+      const int     jn = (in + 1) % nodeCount;
+
+      const double  dx = ecoords(0,jn) - ecoords(0,in);
+      const double  dy = ecoords(1,jn) - ecoords(1,in);
+
+      area += ecoords(0,in) * ecoords(1,jn) -
+              ecoords(0,jn) * ecoords(1,in);
+      lmax  = jem::max ( lmax, dx * dx + dy * dy );
+    }
+
+    area = 0.5 * std::fabs ( area );
+    lmax = std::sqrt ( lmax );
+
+    for ( int ip = 0; ip < ipCount_; ip++ )
+    {
+      wmod = jem::max ( wmod, material_->giveWaveModulus( ipoint++ ) );
+    }
+
+    if ( wmod <= 0.0 || lmax <= 0.0 )
+    {
+      continue;
+    }
+
+    const double  len = ( nodeCount == 3 ? 2.0 : 1.0 ) * area / lmax;
+    const double  dt  = len / std::sqrt ( wmod / rho_ );
+
+    if ( elemSteps.size() > 0 )
+    {
+      elemSteps[ielem] = jem::min ( elemSteps[ielem], dt );
+    }
+
+    dtmin = jem::min ( dtmin, dt );
+  }
+
+  return dtmin;
 }
 
 //-----------------------------------------------------------------------
@@ -575,62 +1039,56 @@ void SolidModel::getStress_
     const Properties&  globdat )
 
 {
-  // Initiate some variables
-  IntVector   ielems     = egroup_.getIndices  ();
-  const int   ielemCount = ielems.size         ();
-  IntVector   inodes   ( ndCount_ );
-  Matrix      elstrss  ( ndCount_, strCount_+3 );
-  Vector Hist(10);
-  int ipoint = 0;
-  
+  // The history values written to the table.
+
+  static const int    HIST_COLS[6] = { 0, 1, 3, 8, 6, 9 };
+
+  StressRecovery&     rec         = getRecovery_ ();
+  const IdxVector&    inodes      = rec.getNodes  ();
+  const Vector&       counts      = rec.getCounts ();
+  const idx_t         nodeCount   = rec.nodeCount ();
+  const idx_t         ipointCount = egroup_.size () * ipCount_;
+
+  Matrix              ipvals ( ipointCount, 6 );
+  Matrix              nodal  ( nodeCount,   6 );
+  Vector              hist   ( 10 );
+  IdxVector           jcols  ( 6 );
+
   // Add columns to the table.
-  IntVector   jcols;
-  jcols.resize ( strCount_+3 );
+
   jcols[0] = table.addColumn ( "sigma_xx" );
   jcols[1] = table.addColumn ( "sigma_yy" );
   jcols[2] = table.addColumn ( "sigma_xy" );
   jcols[3] = table.addColumn ( "sigma_eq" );
   jcols[4] = table.addColumn ( "epspeq" );
   jcols[5] = table.addColumn ( "pressure" );
-  
-  // Loop over elements and integration point to obtain data. 
-  for ( int ie = 0; ie < ielemCount; ie++ )
-  { 
-    // Get the global element index.
-    int  ielem = ielems[ie];
-    
-    // Get the nodes of this element.
-    elems_.getElemNodes  ( inodes, ielem );
-    
-    // zero fill element nodal stress array
-    elstrss = 0.0;
-    
-    for ( int ip = 0; ip < ipCount_; ip++ )
+
+  for ( idx_t ip = 0; ip < ipointCount; ip++ )
+  {
+    hist = 0.0;
+
+    material_->getHistory ( hist, ip );
+
+    for ( idx_t j = 0; j < 6; j++ )
     {
-      ipoint = ie * ipCount_ + ip;
-      Hist = 0.0;
-      material_->getHistory( Hist, ipoint );
-  
-      for ( int inode = 0; inode < ndCount_; inode++ )
-      {
-        elstrss(inode,0) += Hist[0]/ipCount_;
-        elstrss(inode,1) += Hist[1]/ipCount_;
-        elstrss(inode,2) += Hist[3]/ipCount_;
-        elstrss(inode,3) += Hist[8]/ipCount_;
-        elstrss(inode,4) += Hist[6]/ipCount_;
-        elstrss(inode,5) += Hist[9]/ipCount_;
-      }
-  
+      ipvals(ip,j) = hist[HIST_COLS[j]];
     }
-    
-    // Add internal variables to table
-    table.addBlock ( inodes, jcols, elstrss );
-    
-    // Increment the table weights associated with the element nodes.
-    select ( weights, inodes ) += 1.0;
-    
   }
 
+  rec.recover ( nodal, ipvals, recThreads_ );
+
+  // The table rows are divided by the weights. A node is weighted with
+  // its number of elements, so that nodes shared with other models get
+  // the same mean as when the elements were added one by one.
+
+  for ( idx_t in = 0; in < nodeCount; in++ )
+  {
+    nodal(in,ALL) *= counts[in];
+  }
+
+  table.addBlock ( inodes, jcols, nodal );
+
+  select ( weights, inodes ) += counts;
 }
 
 
@@ -745,17 +1203,19 @@ void SolidModel::getStressStrain_
   using jive::util::Globdat;
   Properties  myVars = Globdat::getVariables ( myName_, globdat );
   
-  // Initiate some variables
-  IntVector   ielems     = egroup_.getIndices  ();
-  const int   ielemCount = ielems.size         ();
+  // Find the element; nothing is done if it is not in this model.
+  if ( oppl_ < 0 || oppl_ >= ielemMap_.size() || ielemMap_[oppl_] < 0 )
+  {
+    return;
+  }
+
+  const int   ie       = ielemMap_[oppl_];
+  const int   ielem    = oppl_;
   IntVector   inodes   ( ndCount_ );
   
   Vector      elstrss    ( 6 );
   Vector      elstrn     ( 6 );
   Vector      internal   ( 3 );
-  elstrss     = 0.0;
-  elstrn      = 0.0;
-  internal    = 0.0;
   
   Vector Hist(10);
   Vector Hist_strain(6);
@@ -766,66 +1226,394 @@ void SolidModel::getStressStrain_
   int i = 0.0;
   globdat.get ( i, Globdat::TIME_STEP );
   
-  // Loop over elements and integration point to obtain data. 
-  for ( int ie = 0; ie < ielemCount; ie++ )
-  { 
-    // Get the global element index.
-    int  ielem = ielems[ie];
+  // Get the nodes of this element.
+  elems_.getElemNodes  ( inodes, ielem );
+  
+  // zero fill element nodal stress array
+  elstrss   = 0.0;
+  elstrn    = 0.0;
+  internal  = 0.0;
+  
+  // Loop over integration points
+  for ( int ip = 0; ip < ipCount_; ip++ )
+  {
+    ipoint = ie * ipCount_ + ip;
+    Hist = 0.0;
+    Hist_strain = 0.0;
+    material_->getHistory( Hist, ipoint );
+    material_->getStrain(Hist_strain, ipoint );
+    
+    // stresses
+    elstrss[0] += Hist[0]/ipCount_;
+    elstrss[1] += Hist[1]/ipCount_;
+    elstrss[2] += Hist[2]/ipCount_;
+    elstrss[3] += Hist[3]/ipCount_;
+    elstrss[4] += Hist[4]/ipCount_;
+    elstrss[5] += Hist[5]/ipCount_;
     
-    // Check if current element 
-    if ( ielem != oppl_ )  
+    // strain
+    elstrn[0]  += Hist_strain[0]/ipCount_;
+    elstrn[1]  += Hist_strain[1]/ipCount_;
+    elstrn[2]  += Hist_strain[2]/ipCount_;//0.0;
+    elstrn[3]  += Hist_strain[3]/ipCount_;
+    elstrn[4]  += Hist_strain[4]/ipCount_;//0.0;
+    elstrn[5]  += Hist_strain[5]/ipCount_;//0.0;
+    
+    // other values
+    internal[0] += Hist[8]/ipCount_;
+    internal[1] += Hist[6]/ipCount_;
+    internal[2] += Hist[9]/ipCount_;
+  }
+  
+  // Add internal variables to globdat. These can be stored through 
+  // a SampleModule
+  myVars.set ( "time" , i );
+  myVars.set ( "stress"   , elstrss );
+  myVars.set ( "strain"   , elstrn  );
+  myVars.set ( "internal" , internal );
+  
+}
+
+
+//-----------------------------------------------------------------------
+//   getOutputFrame_
+//-----------------------------------------------------------------------
+
+// Copies the history of all integration points to a block of the
+// frame. If requested, the integration point coordinates and
+// the history recovered at the nodes are added as well, with the same
+// method as in getStress_.
+
+void SolidModel::getOutputFrame_ ( OutputFrame& frame )
+{
+  static const char*  COORD_COLS[3] = { "x", "y", "z" };
+
+  IdxVector     ielems      = egroup_.getIndices ();
+  const idx_t   ielemCount  = ielems.size ();
+  const idx_t   ipointCount = ielemCount * ipCount_;
+
+  StringVector  names       = getHistoryNames_ ();
+
+  const idx_t    colCount = names.size ();
+  const Matrix&  block    = frame.getBlock ( myName_, ipointCount, names );
+
+  Vector         hist     ( colCount );
+
+  for ( idx_t ip = 0; ip < ipointCount; ip++ )
+  {
+    hist = 0.0;
+
+    material_->getHistory ( hist, ip );
+
+    block(ip,ALL) = hist;
+  }
+
+  if ( frame.ipCoords )
+  {
+    StringVector   cnames ( rank_ );
+    IdxVector      inodes ( ndCount_ );
+    Matrix         coords ( rank_, ndCount_ );
+    Matrix         ipx    ( rank_, ipCount_ );
+
+    for ( idx_t j = 0; j < rank_; j++ )
+    {
+      cnames[j] = COORD_COLS[j];
+    }
+
+    const Matrix&  xblock = frame.getBlock ( myName_ + ".ipCoords",
+                                             ipointCount, cnames );
+
+    for ( idx_t ie = 0; ie < ielemCount; ie++ )
+    {
+      elems_.getElemNodes  ( inodes, ielems[ie] );
+      nodes_.getSomeCoords ( coords, inodes );
+
+      shape_->getGlobalIntegrationPoints ( ipx, coords );
+
+      for ( idx_t ip = 0; ip < ipCount_; ip++ )
+      {
+        xblock(ie * ipCount_ + ip,ALL) = ipx(ALL,ip);
+      }
+    }
+  }
+
+  if ( frame.nodalAverage )
+  {
+    StressRecovery&   rec    = getRecovery_ ();
+    const IdxVector&  inodes = rec.getNodes ();
+
+    Matrix            nodal  ( rec.nodeCount(), colCount );
+
+    const Matrix&     nblock = frame.getBlock ( myName_ + ".nodal",
+                                                nodes_.size(), names );
+
+    rec.recover ( nodal, block, recThreads_ );
+
+    nblock = 0.0;
+
+    for ( idx_t in = 0; in < inodes.size(); in++ )
+    {
+      nblock(inodes[in],ALL) = nodal(in,ALL);
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getHistoryNames_
+//-----------------------------------------------------------------------
+
+// Returns the names of the history values of an integration point.
+// Materials without history names get the columns of the stress table.
+
+StringVector SolidModel::getHistoryNames_ () const
+{
+  static const char*  STRESS_COLS[10] =
+  {
+    "sigma_xx", "sigma_yy", "sigma_zz", "sigma_xy", "sigma_yz",
+    "sigma_zx", "epspeq",   "diss",     "sigma_eq", "pressure"
+  };
+
+  StringVector  names = material_->getHistoryNames ();
+
+  if ( names.size() == 0 )
+  {
+    names.ref ( StringVector( 10 ) );
+
+    for ( idx_t j = 0; j < 10; j++ )
+    {
+      names[j] = STRESS_COLS[j];
+    }
+  }
+
+  return names;
+}
+
+
+//-----------------------------------------------------------------------
+//   getRecovery_
+//-----------------------------------------------------------------------
+
+// Returns the nodal recovery operator, built from the reference
+// geometry of the elements when it is first needed.
+
+StressRecovery& SolidModel::getRecovery_ ()
+{
+  if ( recovery_ != NIL )
+  {
+    return *recovery_;
+  }
+
+  IdxVector  ielems  = egroup_.getIndices ();
+  IdxVector  inodes  ( ndCount_ );
+  Matrix     coords  ( rank_, ndCount_ );
+  Matrix     ipx     ( rank_, ipCount_ );
+  Vector     weights ( ipCount_ );
+  Matrix     sfuncs  = shape_->getShapeFunctions ();
+
+  recovery_ = newInstance<StressRecovery> ( recMethod_, ipCount_ );
+
+  for ( idx_t ie = 0; ie < ielems.size(); ie++ )
+  {
+    elems_.getElemNodes  ( inodes, ielems[ie] );
+    nodes_.getSomeCoords ( coords, inodes );
+
+    shape_->getGlobalIntegrationPoints ( ipx,     coords );
+    shape_->getIntegrationWeights      ( weights, coords );
+
+    recovery_->addElement ( inodes, coords, ipx, weights, sfuncs );
+  }
+
+  recovery_->finish ();
+
+  return *recovery_;
+}
+
+
+//-----------------------------------------------------------------------
+//   resolveProbes_
+//-----------------------------------------------------------------------
+
+// Claims the probes on elements of this model and stores the points
+// they need, so that getProbes_ does not have to search.
+
+void SolidModel::resolveProbes_ ( ProbeSet& probes )
+{
+  const StringVector  names = getHistoryNames_ ();
+
+  probeIds_   .clear ();
+  probeFirst_ .clear ();
+  probeCounts_.clear ();
+
+  for ( idx_t i = 0; i < probes.probeCount(); i++ )
+  {
+    const idx_t  ielem  = probes.getElement ( i );
+    const idx_t  ipoint = probes.getPoint   ( i );
+
+    if ( probes.isClaimed( i ) ||
+         ielem < 0 || ielem >= ielemMap_.size() || ielemMap_[ielem] < 0 )
     {
       continue;
     }
-    
-    // Get the nodes of this element.
-    elems_.getElemNodes  ( inodes, ielem );
-    
-    // zero fill element nodal stress array
-    elstrss   = 0.0;
-    elstrn    = 0.0;
-    internal  = 0.0;
-    
-    // Loop over integration points
-    for ( int ip = 0; ip < ipCount_; ip++ )
+
+    if ( ipoint >= ipCount_ )
     {
-      ipoint = ie * ipCount_ + ip;
-      Hist = 0.0;
-      Hist_strain = 0.0;
-      material_->getHistory( Hist, ipoint );
-      material_->getStrain(Hist_strain, ipoint );
-      
-      // stresses
-      elstrss[0] += Hist[0]/ipCount_;
-      elstrss[1] += Hist[1]/ipCount_;
-      elstrss[2] += Hist[2]/ipCount_;
-      elstrss[3] += Hist[3]/ipCount_;
-      elstrss[4] += Hist[4]/ipCount_;
-      elstrss[5] += Hist[5]/ipCount_;
-      
-      // strain
-      elstrn[0]  += Hist_strain[0]/ipCount_;
-      elstrn[1]  += Hist_strain[1]/ipCount_;
-      elstrn[2]  += Hist_strain[2]/ipCount_;//0.0;
-      elstrn[3]  += Hist_strain[3]/ipCount_;
-      elstrn[4]  += Hist_strain[4]/ipCount_;//0.0;
-      elstrn[5]  += Hist_strain[5]/ipCount_;//0.0;
-      
-      // other values
-      internal[0] += Hist[8]/ipCount_;
-      internal[1] += Hist[6]/ipCount_;
-      internal[2] += Hist[9]/ipCount_;
+      throw IllegalInputException (
+        getContext (),
+        String::format ( "invalid probe point %d for element %d "
+                         "(element has %d points)",
+                         ipoint, ielem, ipCount_ )
+      );
+    }
+
+    const idx_t  ie = ielemMap_[ielem];
+
+    probes.claim ( i, names );
+
+    probeIds_.pushBack ( i );
+
+    if ( ipoint < 0 )
+    {
+      probeFirst_ .pushBack ( ie * ipCount_ );
+      probeCounts_.pushBack ( ipCount_ );
+    }
+    else
+    {
+      probeFirst_ .pushBack ( ie * ipCount_ + ipoint );
+      probeCounts_.pushBack ( 1 );
     }
-    
-    // Add internal variables to globdat. These can be stored through 
-    // a SampleModule
-    myVars.set ( "time" , i );
-    myVars.set ( "stress"   , elstrss );
-    myVars.set ( "strain"   , elstrn  );
-    myVars.set ( "internal" , internal );
-    
   }
-  
+}
+
+
+//-----------------------------------------------------------------------
+//   getProbes_
+//-----------------------------------------------------------------------
+
+// Writes the history of the probes claimed by this model to the row of
+// the probe set; a probe on a whole element gets the point average.
+
+void SolidModel::getProbes_ ( ProbeSet& probes )
+{
+  const idx_t  probeCount = probeIds_.size ();
+
+  if ( probeCount == 0 )
+  {
+    return;
+  }
+
+  Vector  hist;
+
+  for ( idx_t k = 0; k < probeCount; k++ )
+  {
+    Vector  values = probes.getValues ( probeIds_[k] );
+
+    if ( hist.size() != values.size() )
+    {
+      hist.resize ( values.size() );
+    }
+
+    values = 0.0;
+
+    for ( idx_t ip = 0; ip < probeCounts_[k]; ip++ )
+    {
+      hist = 0.0;
+
+      material_->getHistory ( hist, probeFirst_[k] + ip );
+
+      values += hist;
+    }
+
+    values /= (double) probeCounts_[k];
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   timeMaterial_
+//-----------------------------------------------------------------------
+
+// Measures the material update alone: the strains of all points are
+// computed once from the current state, after which all points are
+// updated REPEAT_COUNT times. The elapsed time and the number of
+// updates are added to ELAPSED_TIME and POINT_COUNT. The committed
+// history is not changed.
+
+void SolidModel::timeMaterial_
+
+  ( const Properties&  params,
+    const Properties&  globdat )
+
+{
+  using jem::numeric::matmul;
+  using jive::model::StateVector;
+
+  IdxVector   ielems      = egroup_.getIndices ();
+  const idx_t ielemCount  = ielems.size ();
+  const idx_t ipointCount = ielemCount * ipCount_;
+
+  Matrix      B       ( strCount_, dofTypes_.size() * ndCount_ );
+  Matrix      C       ( strCount_, strCount_ );
+  Vector      stress  ( strCount_ );
+  Matrix      strains ( strCount_, ipointCount );
+
+  Cubix       grads   ( rank_, ndCount_, ipCount_ );
+  Matrix      coords  ( rank_, ndCount_ );
+  Vector      weights ( ipCount_ );
+  IntVector   inodes  ( ndCount_ );
+  IntVector   idofs   ( dofCount_ );
+  Vector      elvec   ( dofCount_ );
+  Vector      state;
+
+  idx_t       repeat  = 1;
+  double      elapsed = 0.0;
+  idx_t       count   = 0;
+
+  params.find ( repeat,  SolverNames::REPEAT_COUNT );
+  params.find ( elapsed, SolverNames::ELAPSED_TIME );
+  params.find ( count,   SolverNames::POINT_COUNT  );
+
+  StateVector::get ( state, dofs_, globdat );
+
+  B = 0.0;
+
+  for ( idx_t ie = 0; ie < ielemCount; ie++ )
+  {
+    elems_.getElemNodes  ( inodes, ielems[ie] );
+    nodes_.getSomeCoords ( coords, inodes );
+    dofs_->getDofIndices ( idofs, inodes, dofTypes_ );
+
+    shape_->getShapeGradients ( grads, weights, coords );
+
+    elvec = select ( state, idofs );
+
+    for ( idx_t ip = 0; ip < ipCount_; ip++ )
+    {
+      getShapeGrads_ ( B, grads(ALL,ALL,ip) );
+
+      strains(ALL,ie * ipCount_ + ip) = matmul ( B, elvec );
+    }
+  }
+
+  struct timespec  t0, t1;
+
+  clock_gettime ( CLOCK_MONOTONIC, &t0 );
+
+  for ( idx_t r = 0; r < repeat; r++ )
+  {
+    for ( idx_t ip = 0; ip < ipointCount; ip++ )
+    {
+      material_->update ( stress, C, strains(ALL,ip), ip );
+    }
+  }
+
+  clock_gettime ( CLOCK_MONOTONIC, &t1 );
+
+  elapsed += (double) (t1.tv_sec - t0.tv_sec) +
+             1.0e-9 * (double) (t1.tv_nsec - t0.tv_nsec);
+
+  params.set ( SolverNames::ELAPSED_TIME, elapsed );
+  params.set ( SolverNames::POINT_COUNT,  count + repeat * ipointCount );
 }
 
 //=======================================================================
@@ -1,6 +1,7 @@
 #ifndef SOLID_MODEL_H
 #define SOLID_MODEL_H
 
+#include <jem/util/Flex.h>
 #include <jive/algebra/MatrixBuilder.h>
 #include <jive/fem/ElementGroup.h>
 #include <jive/fem/ElementSet.h>
@@ -14,9 +15,14 @@
 #include "Material.h"
 #include "utilities.h"
 #include "utilitiesLarge.h"
+#include "StressRecovery.h"
+
+class OutputFrame;
+class ProbeSet;
 
 using namespace jem;
 
+using jem::util::Flex;
 using jem::util::Properties;
 using jive::util::XTable;
 using jive::util::XDofSpace;
@@ -47,6 +53,9 @@ class SolidModel : public Model
   static const char*      ELSET_PROP;
   static const char*      STRAIN_PROP;
   static const char*      OPPL_PROP;
+  static const char*      RECOVERY_PROP;
+  static const char*      RECOVERY_THREADS_PROP;
+  static const char*      SNAPSHOT_CACHE_PROP;
 
 
                           SolidModel
@@ -87,6 +96,15 @@ class SolidModel : public Model
     ( Ref<MBuilder>         mbld,
       const Properties&     globdat );
 
+  void                    getDissForce_
+
+    ( const Vector&         fdiss,
+      const Properties&     globdat );
+
+  double                  getCritTimeStep_
+
+    ( const Vector&         elemSteps )   const;
+
   bool                    getTable_
 
   ( const Properties&  params,
@@ -108,6 +126,27 @@ class SolidModel : public Model
 
   ( const Properties&  globdat );
 
+  void                    getOutputFrame_
+
+  ( OutputFrame&       frame );
+
+  StringVector            getHistoryNames_ () const;
+
+  StressRecovery&         getRecovery_     ();
+
+  void                    resolveProbes_
+
+  ( ProbeSet&          probes );
+
+  void                    getProbes_
+
+  ( ProbeSet&          probes );
+
+  void                    timeMaterial_
+
+  ( const Properties&  params,
+    const Properties&  globdat );
+
 
  private:
 
@@ -139,6 +178,42 @@ class SolidModel : public Model
   String                  state_;
   
   int                     oppl_;
+
+  // Position of each element in the element group (-1 if not in it).
+
+  IdxVector               ielemMap_;
+
+  // Nodal recovery of the integration point values; the operator is
+  // built when it is first needed.
+
+  StressRecovery::Method  recMethod_;
+  idx_t                   recThreads_;
+  Ref<StressRecovery>     recovery_;
+
+  // Probes claimed by this model: the probe index, the first point
+  // and the number of points averaged.
+
+  Flex<idx_t>             probeIds_;
+  Flex<idx_t>             probeFirst_;
+  Flex<idx_t>             probeCounts_;
+
+  // Element matrices and forces of the first assembly after a
+  // snapshot; they are replayed for the first assembly after a
+  // rollback when the state is unchanged. Only with snapshotCache,
+  // since the cache holds dofCount_^2 doubles per element.
+
+  bool                    snapCache_;
+  bool                    cacheNext_;
+  bool                    cacheValid_;
+  bool                    replayNext_;
+  Vector                  cacheState_;
+  Cubix                   elmatCache_;
+  Matrix                  elforceCache_;
+
+  // Elements included in the next internal force assembly (all if
+  // empty); see ACTIVE_ELEMS.
+
+  BoolVector              activeElems_;
 };
 
 
@@ -23,10 +23,16 @@
  *  Date  : 2016
  *
  */
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <jem/base/limits.h>
 #include <jem/base/System.h>
 #include <jem/base/Exception.h>
 #include <jem/base/IllegalOperationException.h>
+#include <jem/base/IllegalInputException.h>
 #include <jem/io/FileWriter.h>
 #include <jem/util/Properties.h>
 #include <jem/util/StringUtils.h>
@@ -34,16 +40,20 @@
 #include <jive/util/Globdat.h>
 #include <jive/util/utilities.h>
 #include <jive/util/DofSpace.h>
+#include <jive/util/Constraints.h>
 #include <jive/implict/SolverInfo.h>
 #include <jive/implict/SolverModule.h>
 #include <jive/app/ModuleFactory.h>
 #include <jive/model/Actions.h>
+#include <jive/model/StateVector.h>
 
 #include "AdaptiveStepGeneralModule.h"
 #include "SolverNames.h"
+#include "ProcessUtils.h"
 
 
 using jem::IllegalOperationException;
+using jem::IllegalInputException;
 using jem::System;
 using jem::max;
 using jem::maxOf;
@@ -52,10 +62,12 @@ using jem::io::endl;
 using jem::io::FileWriter;
 using jem::util::StringUtils;
 using jive::Vector;
+using jive::IdxVector;
 using jive::implict::SolverInfo;
 using jive::util::Globdat;
 using jive::util::joinNames;
 using jive::util::DofSpace;
+using jive::util::Constraints;
 using jive::implict::newSolverModule;
 
 
@@ -76,6 +88,34 @@ const char* AdaptiveStepGeneralModule::MAX_INCR_PROP   = "maxIncr";
 const char* AdaptiveStepGeneralModule::START_INCR_PROP = "startIncr";
 const char* AdaptiveStepGeneralModule::REDUCTION_PROP  = "reduction";
 const char* AdaptiveStepGeneralModule::STRICT_PROP     = "strict";
+const char* AdaptiveStepGeneralModule::CONTROLLER_PROP = "controller";
+const char* AdaptiveStepGeneralModule::KI_PROP         = "kI";
+const char* AdaptiveStepGeneralModule::KP_PROP         = "kP";
+const char* AdaptiveStepGeneralModule::TARGET_CONTR_PROP    = "targetContraction";
+const char* AdaptiveStepGeneralModule::MAX_NEW_LOADING_PROP = "maxNewLoading";
+const char* AdaptiveStepGeneralModule::SNAPSHOT_PROP   = "snapshot";
+const char* AdaptiveStepGeneralModule::TRIALS_PROP     = "parallelTrials";
+
+
+//=======================================================================
+//   class TrialSlot_
+//=======================================================================
+
+// Header of the shared memory slot of a forked trial; the state vector
+// follows the header.
+
+class TrialSlot_
+{
+ public:
+
+  static const int          RUNNING   = 0;
+  static const int          CONVERGED = 1;
+  static const int          FAILED    = 2;
+
+  int                       status;
+  idx_t                     iterCount;
+  double                    padding[6];
+};
 
 //-----------------------------------------------------------------------
 //   constructor & destructor
@@ -102,6 +142,8 @@ AdaptiveStepGeneralModule::AdaptiveStepGeneralModule
   nIterTotal_     = 0;
   nCancCont_      = 0;
   nCommTotal_     = 0;
+  nTrialTotal_    = 0;
+  nTrialIter_     = 0;
 
   startIncr_      = 1.;
   minIncr_        = 1.e-5;
@@ -117,6 +159,18 @@ AdaptiveStepGeneralModule::AdaptiveStepGeneralModule
   writeStats_     = false;
   triedSmall_     = false;
   strict_         = false;
+
+  usePI_          = false;
+  kI_             = 0.3;
+  kP_             = 0.4;
+  targetContr_    = 0.5;
+  maxNewLoading_  = 0.;
+  contraction_    = 0.;
+  effort0_        = 1.;
+  rejected_       = false;
+  snapshot_       = false;
+  nTrials_        = 0;
+  haveGuess_      = false;
 }
 
 AdaptiveStepGeneralModule::~AdaptiveStepGeneralModule ()
@@ -135,10 +189,20 @@ Module::Status AdaptiveStepGeneralModule::init
     const Properties&  globdat )
 
 {
+  int  i = 0;
+
   model_ = Model::get ( globdat, getContext() );
-  istep_ = istep0_ = 0;
 
-  globdat.set ( Globdat::TIME_STEP, istep_ );
+  // Keep the step number of a restarted simulation (see
+  // CheckpointModule).
+
+  if ( ! globdat.find( i, Globdat::TIME_STEP ) )
+  {
+    globdat.set ( Globdat::TIME_STEP, i );
+  }
+
+  istep_ = istep0_ = i;
+
   globdat.set ( "var.accepted", false );
 
   solver_->init ( conf, props, globdat );
@@ -171,8 +235,43 @@ Module::Status AdaptiveStepGeneralModule::run ( const Properties& globdat )
 
   setStepSize_( globdat );
 
+  // save the state at the start of the step (not for retries)
+
+  if ( snapshot_ && nCancels_ == 0 && nContinues_ == 0 )
+  {
+    storeSnapshot_ ( globdat );
+  }
+
   solver_->advance ( globdat );
 
+  // use the converged state of a parallel trial as initial guess; the
+  // prescribed DOFs are left to the solver, which may add an increment
+  // to them (deltaCons)
+
+  if ( haveGuess_ )
+  {
+    using jive::model::StateVector;
+
+    Ref<DofSpace>     dofs = DofSpace::get     ( globdat, getContext() );
+    Ref<Constraints>  cons = Constraints::get  ( dofs, globdat );
+    Vector            state;
+
+    StateVector::get ( state, dofs, globdat );
+
+    if ( state.size() == guess_.size() )
+    {
+      for ( idx_t idof = 0; idof < state.size(); idof++ )
+      {
+        if ( ! cons->isSlaveDof( idof ) )
+        {
+          state[idof] = guess_[idof];
+        }
+      }
+    }
+
+    haveGuess_ = false;
+  }
+
   // Store maximum values of increment tried in this time step
 
   if ( nContinues_ == 0 )
@@ -208,12 +307,24 @@ Module::Status AdaptiveStepGeneralModule::run ( const Properties& globdat )
     discard    = true;
   }
 
+  // the solver may have stopped early because the iterations diverged
+
+  String         divReason;
+
+  if ( info.find ( divReason, SolverNames::DIV_REASON ) )
+  {
+    System::out() << "Iterations stopped early: " << divReason << "\n";
+  }
+
   // get # of iterations, NB: not set when error thrown by solver
   
   idx_t          iterCount = 0; 
   info.find   (  iterCount , SolverInfo::ITER_COUNT );
 
   maxNIter_    = max ( maxNIter_, iterCount );
+
+  contraction_ = 0.;
+  info.find   (  contraction_, SolverNames::CONTRACTION );
   nIterTotal_ += iterCount;
 
   if ( nContinues_ > 0 ) nIterCont_ += iterCount;
@@ -271,9 +382,17 @@ Module::Status AdaptiveStepGeneralModule::run ( const Properties& globdat )
 
     // 2. find proper strategy to try again
    
+    // try several reduced step sizes at once
+
+    if ( nTrials_ > 1 && parallelTrials_ ( globdat ) )
+    {
+      System::out() << "Returning to the same load step "
+                    << "with step from parallel trials\n";
+    }
+
     // try to reduce the step size
 
-    if ( reduceStep_ ( globdat ) )
+    else if ( reduceStep_ ( globdat ) )
     {
       System::out() << "Returning to the same load step "
                     << "with reduced step\n";
@@ -335,6 +454,8 @@ void AdaptiveStepGeneralModule::shutdown ( const Properties& globdat )
     << "\n..."
     << "\n... total # of iterations: " << nIterTotal_
     << "\n-------  ( of which " << nIterCont_ << " after continue.)"
+    << "\n... # of parallel trials: " << nTrialTotal_
+    << "\n-------  ( with " << nTrialIter_ << " iterations.)"
     << endl;
 }
 
@@ -391,6 +512,43 @@ void AdaptiveStepGeneralModule::configure
   myProps.find ( optIter_,   OPT_ITER_PROP   );
   
   myProps.find ( strict_ ,   STRICT_PROP      );
+
+  String controller;
+
+  if ( myProps.find ( controller, CONTROLLER_PROP ) )
+  {
+    if      ( controller == "PI" )
+    {
+      usePI_ = true;
+    }
+    else if ( controller == "classic" )
+    {
+      usePI_ = false;
+    }
+    else
+    {
+      throw IllegalInputException ( JEM_FUNC,
+        "unknown controller: " + controller +
+        ", should be \"classic\" or \"PI\"" );
+    }
+  }
+
+  myProps.find ( kI_,            KI_PROP,              0., 1. );
+  myProps.find ( kP_,            KP_PROP,              0., 1. );
+  myProps.find ( targetContr_,   TARGET_CONTR_PROP,    0., 1. );
+  myProps.find ( maxNewLoading_, MAX_NEW_LOADING_PROP, 0., 1. );
+
+  myProps.find ( snapshot_, SNAPSHOT_PROP );
+  myProps.find ( nTrials_,  TRIALS_PROP, 0, 16 );
+
+  if ( nTrials_ == 1 )
+  {
+    myProps.propertyError (
+      TRIALS_PROP,
+      "one parallel trial is not possible; use 0 to disable the "
+      "parallel trials or at least 2 to enable them"
+    );
+  }
 }
 
 
@@ -420,6 +578,14 @@ void AdaptiveStepGeneralModule::getConfig
   myConf.set ( OPT_ITER_PROP  , optIter_    );
   myConf.set ( STRICT_PROP    , strict_     );
 
+  myConf.set ( CONTROLLER_PROP, usePI_ ? "PI" : "classic" );
+  myConf.set ( KI_PROP        , kI_         );
+  myConf.set ( KP_PROP        , kP_         );
+  myConf.set ( TARGET_CONTR_PROP   , targetContr_   );
+  myConf.set ( MAX_NEW_LOADING_PROP, maxNewLoading_ );
+  myConf.set ( SNAPSHOT_PROP  , snapshot_   );
+  myConf.set ( TRIALS_PROP    , nTrials_    );
+
   solver_->getConfig ( conf, globdat );
 }
 
@@ -435,17 +601,34 @@ void AdaptiveStepGeneralModule::commit_
   // store this solution and proceed with next time step
   // model->takeAction(COMMIT) is called by solver!
 
+  // the models add their counts of (newly) loading points on commit
+
+  Properties  vars = Globdat::getVariables ( globdat );
+
+  vars.set ( SolverNames::NEW_LOADING, (idx_t) 0 );
+  vars.set ( SolverNames::POINT_COUNT, (idx_t) 0 );
+
   solver_->commit ( globdat );
 
   ++nCommTotal_;
 
-  // do something to time step size comaring nIter4Adapt with optIter
+  if ( usePI_ )
+  {
+    increment_ *= piFactor_ ( globdat );
 
-  double fac  = ( maxNIter_ - optIter_ ) / 4.0; 
-  if ( ( maxNIter_ > optIter_ && increment_ > minIncr_ ) || 
-       ( maxNIter_ < optIter_ && increment_ < maxIncr_ ) )
+    increment_  = jem::min ( increment_, maxIncr_ );
+    increment_  = jem::max ( increment_, minIncr_ );
+  }
+  else
   {
-    increment_ *= ::pow ( 0.5, fac );
+    // do something to time step size comaring nIter4Adapt with optIter
+
+    double fac  = ( maxNIter_ - optIter_ ) / 4.0; 
+    if ( ( maxNIter_ > optIter_ && increment_ > minIncr_ ) || 
+         ( maxNIter_ < optIter_ && increment_ < maxIncr_ ) )
+    {
+      increment_ *= ::pow ( 0.5, fac );
+    }
   }
   
   // set step size for particular range of times
@@ -540,6 +723,11 @@ void AdaptiveStepGeneralModule::cancel_
 
   solver_->cancel ( globdat );
 
+  if ( snapshot_ )
+  {
+    restoreSnapshot_ ( globdat );
+  }
+
   istep_ = istep0_;
 
   globdat.set ( Globdat::TIME_STEP, istep_ );
@@ -557,6 +745,7 @@ bool AdaptiveStepGeneralModule::reduceStep_
   if ( !triedSmall_ && increment_ > minIncr_ )
   {
     increment_ *= reduction_;
+    rejected_   = true;
 
     return true;
   }
@@ -589,6 +778,317 @@ bool AdaptiveStepGeneralModule::increaseStep_
   }
 }
 
+//-----------------------------------------------------------------------
+//   piFactor_
+//-----------------------------------------------------------------------
+
+// Returns the factor for the next step size after a converged step.
+// The effort of the step is 1 when the solver needed optIter_
+// iterations (and when the other indicators are on target). After a
+// rejected step, the step size is not increased.
+
+double AdaptiveStepGeneralModule::piFactor_
+
+  ( const Properties&       globdat )
+
+{
+  Properties  vars       = Globdat::getVariables ( globdat );
+
+  idx_t       newLoading = 0;
+  idx_t       pointCount = 0;
+
+  double      effort     = (double) maxNIter_ / (double) max ( optIter_, (idx_t) 1 );
+  double      fac;
+
+
+  if ( targetContr_ > 0. && contraction_ > 0. )
+  {
+    effort = max ( effort, contraction_ / targetContr_ );
+  }
+
+  vars.find ( newLoading, SolverNames::NEW_LOADING );
+  vars.find ( pointCount, SolverNames::POINT_COUNT );
+
+  if ( maxNewLoading_ > 0. && pointCount > 0 )
+  {
+    effort = max ( effort, (double) newLoading /
+                           ( (double) pointCount * maxNewLoading_ ) );
+  }
+
+  effort = max ( effort, 1.e-3 );
+
+  fac    = ::pow ( 1. / effort,       kI_ ) *
+           ::pow ( effort0_ / effort, kP_ );
+
+  if ( rejected_ )
+  {
+    fac = jem::min ( fac, 1. );
+  }
+
+  fac    = jem::min ( fac, 1. / reduction_ );
+  fac    = jem::max ( fac, reduction_ );
+
+  System::info( myName_ ) << myName_ << " : PI controller: effort "
+                          << effort << " (" << maxNIter_
+                          << " iterations, contraction " << contraction_
+                          << ", " << newLoading << " newly loading "
+                          << "points), step factor " << fac << "\n";
+
+  effort0_  = effort;
+  rejected_ = false;
+
+  return fac;
+}
+
+//-----------------------------------------------------------------------
+//   storeSnapshot_
+//-----------------------------------------------------------------------
+
+// The state vector needs no copy: the solver restores it itself when
+// the step is cancelled. Only the models are told to save their state.
+
+void AdaptiveStepGeneralModule::storeSnapshot_
+
+  ( const Properties&       globdat )
+
+{
+  Properties  params;
+
+  model_->takeAction ( SolverNames::STORE_SNAPSHOT, params, globdat );
+}
+
+//-----------------------------------------------------------------------
+//   restoreSnapshot_
+//-----------------------------------------------------------------------
+
+void AdaptiveStepGeneralModule::restoreSnapshot_
+
+  ( const Properties&       globdat )
+
+{
+  Properties  params;
+
+  model_->takeAction ( SolverNames::RESTORE_SNAPSHOT, params, globdat );
+}
+
+//-----------------------------------------------------------------------
+//   parallelTrials_
+//-----------------------------------------------------------------------
+
+// Called after a discarded step. Forks one process per candidate
+// increment (the next reductions of the current increment) and waits
+// for all of them. The largest increment that converged is adopted, and
+// its state is kept as initial guess for the next solve, which then
+// converges immediately. If all trials fail, the increment is reduced
+// below the smallest candidate. Returns false if no trial is possible.
+//
+// The children only run the solver and leave with _exit(). Their
+// standard output and error are sent to /dev/null, since the solver
+// and the models print during the solve; files opened by other modules
+// are not redirected, so output modules should not run in the solver.
+//
+// The trials are disabled when the process has more than one thread
+// (see ProcessUtils.h). Short-lived worker threads, such as those of
+// the stress recovery in SolidModel, have exited by now.
+
+bool AdaptiveStepGeneralModule::parallelTrials_
+
+  ( const Properties&       globdat )
+
+{
+  using jive::model::StateVector;
+
+  if ( triedSmall_ || increment_ <= minIncr_ )
+  {
+    return false;
+  }
+
+  if ( threadCount() > 1 )
+  {
+    System::warn() << myName_ << " : parallel trials disabled because "
+                   << "the process runs other threads\n";
+
+    nTrials_ = 0;
+
+    return false;
+  }
+
+  Ref<DofSpace>  dofs      = DofSpace::get ( globdat, getContext() );
+  const idx_t    dofCount  = dofs->dofCount ();
+
+  Vector         cand      ( nTrials_ );
+  idx_t          n         = 0;
+  double         incr      = increment_;
+
+  // The candidates are the next reductions of the increment; the last
+  // one is clamped to the minimum increment.
+
+  while ( n < nTrials_ )
+  {
+    incr *= reduction_;
+
+    if ( incr <= minIncr_ )
+    {
+      cand[n++] = minIncr_;
+      break;
+    }
+
+    cand[n++] = incr;
+  }
+
+  const size_t   slotSize  = sizeof(TrialSlot_) +
+                             (size_t) dofCount * sizeof(double);
+
+  void*          shared    = ::mmap ( 0, (size_t) n * slotSize,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS,
+                                      -1, 0 );
+
+  if ( shared == MAP_FAILED )
+  {
+    System::warn() << myName_ << " : could not allocate shared memory "
+                   << "for parallel trials\n";
+    return false;
+  }
+
+  char*          base      = (char*) shared;
+  IdxVector      pids      ( n );
+
+  System::out() << "Starting " << n << " parallel trials with "
+                << "increments";
+
+  for ( idx_t k = 0; k < n; k++ )
+  {
+    System::out() << ' ' << cand[k];
+  }
+
+  System::out() << "\n";
+  System::out().flush ();
+
+  for ( idx_t k = 0; k < n; k++ )
+  {
+    TrialSlot_*  slot = (TrialSlot_*) (base + k * slotSize);
+
+    slot->status    = TrialSlot_::RUNNING;
+    slot->iterCount = 0;
+
+    pids[k] = ::fork ();
+
+    if ( pids[k] == 0 )
+    {
+      // child process: solve with the candidate increment, without
+      // output
+
+      int  fd = ::open ( "/dev/null", O_WRONLY );
+
+      if ( fd >= 0 )
+      {
+        ::dup2  ( fd, 1 );
+        ::dup2  ( fd, 2 );
+        ::close ( fd );
+      }
+
+      Properties  info = SolverInfo::get ( globdat );
+      Vector      state;
+      int         status = TrialSlot_::FAILED;
+
+      info.clear ();
+
+      increment_ = cand[k];
+
+      try
+      {
+        setStepSize_     ( globdat );
+        solver_->advance ( globdat );
+        solver_->solve   ( info, globdat );
+
+        StateVector::get ( state, dofs, globdat );
+
+        double*  data = (double*) (slot + 1);
+
+        for ( idx_t i = 0; i < dofCount; i++ )
+        {
+          data[i] = state[i];
+        }
+
+        status = TrialSlot_::CONVERGED;
+      }
+      catch ( const jem::Exception& )
+      {}
+
+      info.find ( slot->iterCount, SolverInfo::ITER_COUNT );
+
+      slot->status = status;
+
+      ::_exit ( 0 );
+    }
+  }
+
+  // wait for all children; a failed fork counts as a failed trial
+
+  for ( idx_t k = 0; k < n; k++ )
+  {
+    TrialSlot_*  slot = (TrialSlot_*) (base + k * slotSize);
+
+    if ( pids[k] > 0 )
+    {
+      int  wstat;
+
+      ::waitpid ( (pid_t) pids[k], &wstat, 0 );
+    }
+
+    if ( slot->status == TrialSlot_::RUNNING )
+    {
+      slot->status = TrialSlot_::FAILED;
+    }
+
+    nTrialTotal_++;
+    nTrialIter_ += slot->iterCount;
+  }
+
+  // adopt the largest successful increment
+
+  bool  found = false;
+
+  for ( idx_t k = 0; k < n && ! found; k++ )
+  {
+    TrialSlot_*  slot = (TrialSlot_*) (base + k * slotSize);
+
+    if ( slot->status == TrialSlot_::CONVERGED )
+    {
+      const double*  data = (const double*) (slot + 1);
+
+      guess_.resize ( dofCount );
+
+      for ( idx_t i = 0; i < dofCount; i++ )
+      {
+        guess_[i] = data[i];
+      }
+
+      System::out() << "Parallel trial " << k << " converged in "
+                    << slot->iterCount << " iterations\n";
+
+      increment_ = cand[k];
+      haveGuess_ = true;
+      rejected_  = true;
+      found      = true;
+    }
+  }
+
+  ::munmap ( shared, (size_t) n * slotSize );
+
+  if ( found )
+  {
+    return true;
+  }
+
+  // all trials failed: continue below the smallest candidate
+
+  increment_ = cand[n - 1];
+
+  return reduceStep_ ( globdat );
+}
+
 //-----------------------------------------------------------------------
 //   setStepSize()
 //-----------------------------------------------------------------------
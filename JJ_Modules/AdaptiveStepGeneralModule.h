@@ -66,6 +66,13 @@ class AdaptiveStepGeneralModule : public Module
   static const char*        REDUCTION_PROP;
   static const char*        OPT_ITER_PROP;
   static const char*        STRICT_PROP;
+  static const char*        CONTROLLER_PROP;
+  static const char*        KI_PROP;
+  static const char*        KP_PROP;
+  static const char*        TARGET_CONTR_PROP;
+  static const char*        MAX_NEW_LOADING_PROP;
+  static const char*        SNAPSHOT_PROP;
+  static const char*        TRIALS_PROP;
 
   explicit                  AdaptiveStepGeneralModule
 
@@ -134,6 +141,22 @@ class AdaptiveStepGeneralModule : public Module
 
     ( const Properties&       globdat ) const;
 
+  double                    piFactor_
+
+    ( const Properties&       globdat );
+
+  void                      storeSnapshot_
+
+    ( const Properties&       globdat );
+
+  void                      restoreSnapshot_
+
+    ( const Properties&       globdat );
+
+  bool                      parallelTrials_
+
+    ( const Properties&       globdat );
+
  private:
 
   Ref<SolverModule>         solver_;
@@ -171,6 +194,35 @@ class AdaptiveStepGeneralModule : public Module
   // new stuff by ECS
   bool                      strict_;
 
+  // PI step size controller: the step effort e (iterations relative to
+  // optIter_, or the contraction rate and the fraction of newly loading
+  // points relative to their targets) drives the step size with
+  // (1/e)^kI * (e0/e)^kP.
+
+  bool                      usePI_;
+  double                    kI_;
+  double                    kP_;
+  double                    targetContr_;
+  double                    maxNewLoading_;
+  double                    contraction_;
+  double                    effort0_;
+  bool                      rejected_;
+
+  // let the models roll back their own state (load scale, material,
+  // element cache) to the start of the step; the solver restores the
+  // state vector
+
+  bool                      snapshot_;
+
+  // speculative trials with reduced increments in forked processes;
+  // the converged free DOFs of the adopted trial are the initial guess
+  // for the next solve (0 or at least 2; not used while other threads
+  // run, see parallelTrials_)
+
+  idx_t                     nTrials_;
+  bool                      haveGuess_;
+  jive::Vector              guess_;
+
   // cumulative counters (for shutdown statistics)
 
   idx_t                     nRunTotal_;
@@ -180,6 +232,8 @@ class AdaptiveStepGeneralModule : public Module
   idx_t                     nIterCont_;
   idx_t                     nCommTotal_;
   idx_t                     nCancCont_;      // canceled continues
+  idx_t                     nTrialTotal_;
+  idx_t                     nTrialIter_;
 
   CPUTimer                  cpuTimer_;
 };
@@ -0,0 +1,463 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Output module with a background writer thread. See
+ *  AsyncOutputModule.h for details.
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/limits.h>
+#include <jem/base/RuntimeException.h>
+#include <jem/io/IOException.h>
+#include <jive/util/Globdat.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "AsyncOutputModule.h"
+#include "OutputScheduleModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::newInstance;
+using jem::RuntimeException;
+using jem::io::IOException;
+using jive::util::Globdat;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class AsyncOutputModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  AsyncOutputModule::TYPE_NAME        = "AsyncOutput";
+const char*  AsyncOutputModule::FILE_PROP        = "file";
+const char*  AsyncOutputModule::INTERVAL_PROP    = "interval";
+const char*  AsyncOutputModule::QUEUE_SIZE_PROP  = "queueSize";
+const char*  AsyncOutputModule::WRITE_STATE_PROP = "writeState";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+AsyncOutputModule::AsyncOutputModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  fileName_   = "output.dat";
+  interval_   = 1;
+  queueSize_  = 4;
+  writeState_ = true;
+  runCount_   = 0;
+  head_       = 0;
+  count_      = 0;
+  file_       = 0;
+  running_    = false;
+  done_       = false;
+  failed_     = false;
+
+  pthread_mutex_init ( &mutex_, 0 );
+  pthread_cond_init  ( &cond_,  0 );
+}
+
+
+AsyncOutputModule::~AsyncOutputModule ()
+{
+  stop_ ();
+
+  pthread_cond_destroy  ( &cond_  );
+  pthread_mutex_destroy ( &mutex_ );
+}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status AsyncOutputModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_ = Model   ::get ( globdat, context );
+  dofs_  = DofSpace::get ( globdat, context );
+
+  stop_ ();
+
+  frames_.clear ();
+
+  for ( idx_t i = 0; i < queueSize_; i++ )
+  {
+    frames_.pushBack ( newInstance<OutputFrame>() );
+  }
+
+  file_ = std::fopen ( fileName_.addr(), "w" );
+
+  if ( ! file_ )
+  {
+    throw IOException (
+      context,
+      String::format ( "can not open %s: %s", fileName_,
+                       std::strerror( errno ) )
+    );
+  }
+
+  runCount_ = 0;
+  head_     = 0;
+  count_    = 0;
+  done_     = false;
+  failed_   = false;
+
+  if ( pthread_create( &thread_, 0, & writerMain_, this ) != 0 )
+  {
+    std::fclose ( file_ );
+
+    file_ = 0;
+
+    throw RuntimeException (
+      context,
+      "failed to start the writer thread"
+    );
+  }
+
+  running_ = true;
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status AsyncOutputModule::run ( const Properties& globdat )
+{
+  using jive::model::STATE0;
+
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  runCount_++;
+
+  if ( ! OutputScheduleModule::isDue( runCount_, interval_, globdat ) )
+  {
+    return OK;
+  }
+
+  // Wait for a free frame.
+
+  pthread_mutex_lock ( &mutex_ );
+
+  while ( count_ == queueSize_ && ! failed_ )
+  {
+    pthread_cond_wait ( &cond_, &mutex_ );
+  }
+
+  const bool   failed = failed_;
+  const idx_t  itail  = (head_ + count_) % queueSize_;
+
+  pthread_mutex_unlock ( &mutex_ );
+
+  if ( failed )
+  {
+    throw IOException (
+      getContext (),
+      String::format ( "error writing %s", fileName_ )
+    );
+  }
+
+  // The frame is not in the queue, so the writer does not touch it.
+
+  OutputFrame&  frame = * frames_[itail];
+  Properties    params;
+
+  frame.clear ();
+
+  globdat.find ( frame.time, Globdat::TIME );
+  globdat.find ( frame.step, Globdat::TIME_STEP );
+
+  if ( writeState_ )
+  {
+    Vector  state;
+
+    StateVector::get ( state, STATE0, dofs_, globdat );
+
+    if ( frame.state.size() != state.size() )
+    {
+      frame.state.ref ( Vector( state.size() ) );
+    }
+
+    frame.state = state;
+  }
+
+  params.set ( SolverNames::OUTPUT_FRAME, frames_[itail] );
+
+  model_->takeAction ( SolverNames::GET_OUTPUT_FRAME, params, globdat );
+
+  pthread_mutex_lock     ( &mutex_ );
+  count_++;
+  pthread_cond_broadcast ( &cond_  );
+  pthread_mutex_unlock   ( &mutex_ );
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void AsyncOutputModule::shutdown ( const Properties& globdat )
+{
+  stop_ ();
+
+  model_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void AsyncOutputModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( fileName_,   FILE_PROP );
+    myProps.find ( interval_,   INTERVAL_PROP,
+                   1, maxOf( interval_ ) );
+    myProps.find ( queueSize_,  QUEUE_SIZE_PROP,
+                   1, maxOf( queueSize_ ) );
+    myProps.find ( writeState_, WRITE_STATE_PROP );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void AsyncOutputModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( FILE_PROP,        fileName_   );
+  myConf.set ( INTERVAL_PROP,    interval_   );
+  myConf.set ( QUEUE_SIZE_PROP,  queueSize_  );
+  myConf.set ( WRITE_STATE_PROP, writeState_ );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> AsyncOutputModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   writerMain_
+//-----------------------------------------------------------------------
+
+
+void* AsyncOutputModule::writerMain_ ( void* self )
+{
+  ((Self*) self)->writeLoop_ ();
+
+  return 0;
+}
+
+
+//-----------------------------------------------------------------------
+//   writeLoop_
+//-----------------------------------------------------------------------
+
+// Runs in the writer thread: writes the frames in the queue until the
+// queue is empty and stop_ has been called. After a write error the
+// remaining frames are dropped and run() throws an exception.
+
+void AsyncOutputModule::writeLoop_ ()
+{
+  pthread_mutex_lock ( &mutex_ );
+
+  while ( true )
+  {
+    while ( count_ == 0 && ! done_ )
+    {
+      pthread_cond_wait ( &cond_, &mutex_ );
+    }
+
+    if ( count_ == 0 )
+    {
+      break;
+    }
+
+    const OutputFrame&  frame = * frames_[head_];
+
+    pthread_mutex_unlock ( &mutex_ );
+
+    if ( ! failed_ )
+    {
+      writeFrame_ ( frame );
+    }
+
+    const bool  failed = ( std::fflush( file_ ) != 0 ||
+                           std::ferror( file_ ) );
+
+    pthread_mutex_lock ( &mutex_ );
+
+    failed_ = failed_ || failed;
+    head_   = (head_ + 1) % queueSize_;
+    count_--;
+
+    pthread_cond_broadcast ( &cond_ );
+  }
+
+  pthread_mutex_unlock ( &mutex_ );
+}
+
+
+//-----------------------------------------------------------------------
+//   writeFrame_
+//-----------------------------------------------------------------------
+
+
+void AsyncOutputModule::writeFrame_ ( const OutputFrame& frame )
+{
+  std::FILE*  f = file_;
+
+  std::fprintf ( f, "frame %d %.10e\n", frame.step, frame.time );
+
+  if ( writeState_ )
+  {
+    const idx_t  n = frame.state.size ();
+
+    std::fprintf ( f, "state %ld\n", (long) n );
+
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      std::fprintf ( f, "  %.10e\n", frame.state[i] );
+    }
+  }
+
+  for ( idx_t ib = 0; ib < frame.blockCount(); ib++ )
+  {
+    const String&        name  = frame.getBlockName ( ib );
+    const StringVector&  cols  = frame.getColNames  ( ib );
+    const Matrix&        block = frame.getBlock     ( ib );
+
+    std::fprintf ( f, "block %.*s %ld %ld\n",
+                   (int) name.size(), name.addr(),
+                   (long) block.size(0), (long) block.size(1) );
+
+    for ( idx_t j = 0; j < cols.size(); j++ )
+    {
+      std::fprintf ( f, " %.*s", (int) cols[j].size(), cols[j].addr() );
+    }
+
+    std::fputc ( '\n', f );
+
+    for ( idx_t i = 0; i < block.size(0); i++ )
+    {
+      for ( idx_t j = 0; j < block.size(1); j++ )
+      {
+        std::fprintf ( f, " %.6e", block(i,j) );
+      }
+
+      std::fputc ( '\n', f );
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   stop_
+//-----------------------------------------------------------------------
+
+// Writes the frames left in the queue and stops the writer thread.
+
+void AsyncOutputModule::stop_ ()
+{
+  if ( running_ )
+  {
+    pthread_mutex_lock     ( &mutex_ );
+    done_ = true;
+    pthread_cond_broadcast ( &cond_  );
+    pthread_mutex_unlock   ( &mutex_ );
+
+    pthread_join ( thread_, 0 );
+
+    running_ = false;
+  }
+
+  if ( file_ )
+  {
+    std::fclose ( file_ );
+
+    file_ = 0;
+  }
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareAsyncOutputModule
+//-----------------------------------------------------------------------
+
+
+void declareAsyncOutputModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( AsyncOutputModule::TYPE_NAME,
+                         & AsyncOutputModule::makeNew );
+}
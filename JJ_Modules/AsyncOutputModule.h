@@ -0,0 +1,153 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module writes the state vector and the integration point
+ *  history of the models in a background thread, so that the solver
+ *  does not wait for the output to be formatted and written.
+ *
+ *  Every interval runs the module copies the data into a frame (see
+ *  OutputFrame.h) from a fixed queue of queueSize frames and hands it
+ *  to the writer thread. The frames are allocated once; if all of them
+ *  are waiting to be written the module blocks until the writer has
+ *  caught up. The writer thread only reads the frames, it never calls
+ *  the model. If an OutputSchedule module is used, the frames are
+ *  taken when it says so instead of every interval runs.
+ *
+ *  The output is a text file with one section per frame:
+ *
+ *    frame <step> <time>
+ *    state <size>
+ *      <values>
+ *    block <name> <points> <columns>
+ *      <column names>
+ *      <values, one line per point>
+ *
+ */
+
+#ifndef ASYNC_OUTPUT_MODULE_H
+#define ASYNC_OUTPUT_MODULE_H
+
+#include <pthread.h>
+#include <cstdio>
+
+#include <jem/util/Flex.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+
+#include "OutputFrame.h"
+
+using jem::Ref;
+using jem::String;
+using jem::util::Flex;
+using jem::util::Properties;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+
+
+//-----------------------------------------------------------------------
+//   class AsyncOutputModule
+//-----------------------------------------------------------------------
+
+
+class AsyncOutputModule : public Module
+{
+ public:
+
+  typedef AsyncOutputModule Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        FILE_PROP;
+  static const char*        INTERVAL_PROP;
+  static const char*        QUEUE_SIZE_PROP;
+  static const char*        WRITE_STATE_PROP;
+
+  explicit                  AsyncOutputModule
+
+    ( const String&           name = "asyncOutput" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~AsyncOutputModule ();
+
+
+ private:
+
+  static void*              writerMain_
+
+    ( void*                   self );
+
+  void                      writeLoop_    ();
+
+  void                      writeFrame_
+
+    ( const OutputFrame&      frame );
+
+  void                      stop_         ();
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+
+  String                    fileName_;
+  idx_t                     interval_;
+  idx_t                     queueSize_;
+  bool                      writeState_;
+  idx_t                     runCount_;
+
+  // The queue: count_ frames starting at head_ are waiting to be
+  // written. The solver thread fills the frame after them.
+
+  Flex< Ref<OutputFrame> >  frames_;
+  idx_t                     head_;
+  idx_t                     count_;
+
+  std::FILE*                file_;
+  pthread_t                 thread_;
+  pthread_mutex_t           mutex_;
+  pthread_cond_t            cond_;
+  bool                      running_;
+  bool                      done_;
+  bool                      failed_;
+
+};
+
+
+#endif
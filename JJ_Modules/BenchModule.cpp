@@ -0,0 +1,499 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Performance measurements. See BenchModule.h for details.
+ *
+ */
+
+#include <time.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <jem/base/limits.h>
+#include <jem/base/System.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/io/IOException.h>
+#include <jive/algebra/LumpedMatrixBuilder.h>
+#include <jive/algebra/SparseMatrixBuilder.h>
+#include <jive/fem/NodeSet.h>
+#include <jive/fem/ElementSet.h>
+#include <jive/model/Actions.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "BenchModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::newInstance;
+using jem::System;
+using jem::IllegalInputException;
+using jem::io::IOException;
+using jive::fem::NodeSet;
+using jive::fem::ElementSet;
+using jive::model::Actions;
+using jive::model::ActionParams;
+
+
+//=======================================================================
+//   class BenchModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  BenchModule::TYPE_NAME    = "Bench";
+const char*  BenchModule::FILE_PROP    = "file";
+const char*  BenchModule::CASE_PROP    = "case";
+const char*  BenchModule::KERNELS_PROP = "kernels";
+const char*  BenchModule::REPEAT_PROP  = "repeat";
+const char*  BenchModule::WARMUP_PROP  = "warmup";
+const char*  BenchModule::STEPS_PROP   = "steps";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+BenchModule::BenchModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  fileName_   = "bench.json";
+  case_       = name;
+  repeat_     = 5;
+  warmup_     = 1;
+  steps_      = 0;
+
+  kernels_.resize ( 4 );
+
+  kernels_[0] = "matrix0";
+  kernels_[1] = "intVector";
+  kernels_[2] = "matrix2";
+  kernels_[3] = "material";
+
+  elemCount_  = 0;
+  nodeCount_  = 0;
+  pointCount_ = 0;
+  runCount_   = 0;
+  lastTime_   = 0.0;
+  written_    = false;
+}
+
+
+BenchModule::~BenchModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status BenchModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_ = Model   ::get ( globdat, context );
+  dofs_  = DofSpace::get ( globdat, context );
+
+  elemCount_  = ElementSet::get(globdat, context).size ();
+  nodeCount_  = NodeSet   ::get(globdat, context).size ();
+  pointCount_ = 0;
+
+  kernelTimes_.clear ();
+  stepTimes_  .clear ();
+
+  runCount_   = 0;
+  written_    = false;
+  lastTime_   = wallTime_ ();
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status BenchModule::run ( const Properties& globdat )
+{
+  if ( model_ == NIL || written_ )
+  {
+    return DONE;
+  }
+
+  const double  now = wallTime_ ();
+
+  runCount_++;
+
+  if ( steps_ > 0 )
+  {
+    stepTimes_.pushBack ( now - lastTime_ );
+  }
+
+  if ( runCount_ == 1 )
+  {
+    timeKernels_ ( globdat );
+  }
+
+  if ( stepTimes_.size() >= steps_ )
+  {
+    write_ ();
+
+    return EXIT;
+  }
+
+  lastTime_ = wallTime_ ();
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void BenchModule::shutdown ( const Properties& globdat )
+{
+  // Write what has been measured if the run stopped early.
+
+  if ( model_ != NIL && ! written_ && runCount_ > 0 )
+  {
+    write_ ();
+  }
+
+  model_    = NIL;
+  dofs_     = NIL;
+  kbuilder_ = NIL;
+  mbuilder_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void BenchModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( fileName_, FILE_PROP );
+    myProps.find ( case_,     CASE_PROP );
+    myProps.find ( kernels_,  KERNELS_PROP );
+    myProps.find ( repeat_,   REPEAT_PROP,
+                   1, maxOf( repeat_ ) );
+    myProps.find ( warmup_,   WARMUP_PROP,
+                   0, maxOf( warmup_ ) );
+    myProps.find ( steps_,    STEPS_PROP,
+                   0, maxOf( steps_ ) );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void BenchModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( FILE_PROP,    fileName_ );
+  myConf.set ( CASE_PROP,    case_     );
+  myConf.set ( KERNELS_PROP, kernels_  );
+  myConf.set ( REPEAT_PROP,  repeat_   );
+  myConf.set ( WARMUP_PROP,  warmup_   );
+  myConf.set ( STEPS_PROP,   steps_    );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> BenchModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   timeKernels_
+//-----------------------------------------------------------------------
+
+
+void BenchModule::timeKernels_ ( const Properties& globdat )
+{
+  using jive::algebra::LumpedMatrixBuilder;
+  using jive::algebra::SparseMatrixBuilder;
+
+  const idx_t  dofCount = dofs_->dofCount ();
+
+  Ref<LumpedMatrixBuilder>  lumped = newInstance<LumpedMatrixBuilder> ();
+
+  lumped->setOptions ( 0 );
+  lumped->setSize    ( dofCount );
+
+  kbuilder_ = newInstance<SparseMatrixBuilder> ( "stiffness" );
+  mbuilder_ = lumped;
+
+  fint_.resize ( dofCount );
+
+  kernelTimes_.resize ( kernels_.size() * repeat_ );
+
+  for ( idx_t k = 0; k < kernels_.size(); k++ )
+  {
+    for ( idx_t i = 0; i < warmup_; i++ )
+    {
+      timeKernel_ ( kernels_[k], globdat );
+    }
+
+    for ( idx_t i = 0; i < repeat_; i++ )
+    {
+      kernelTimes_[k * repeat_ + i] = timeKernel_ ( kernels_[k], globdat );
+    }
+
+    System::info( myName_ ) << myName_ << " : timed " << kernels_[k]
+                            << '\n';
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   timeKernel_
+//-----------------------------------------------------------------------
+
+// Calls a kernel once and returns its wall time in seconds.
+
+double BenchModule::timeKernel_
+
+  ( const String&      kernel,
+    const Properties&  globdat )
+
+{
+  Properties  params;
+  double      t0 = wallTime_ ();
+
+  if ( kernel == "matrix0" )
+  {
+    kbuilder_->setToZero ();
+
+    fint_ = 0.0;
+
+    params.set ( ActionParams::MATRIX0,    kbuilder_ );
+    params.set ( ActionParams::INT_VECTOR, fint_     );
+
+    model_   ->takeAction   ( Actions::GET_MATRIX0, params, globdat );
+    kbuilder_->updateMatrix ();
+  }
+  else if ( kernel == "intVector" )
+  {
+    fint_ = 0.0;
+
+    params.set ( ActionParams::INT_VECTOR, fint_ );
+
+    model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+  }
+  else if ( kernel == "matrix2" )
+  {
+    mbuilder_->clear ();
+
+    params.set ( ActionParams::MATRIX2, mbuilder_ );
+
+    model_   ->takeAction   ( Actions::GET_MATRIX2, params, globdat );
+    mbuilder_->updateMatrix ();
+  }
+  else if ( kernel == "material" )
+  {
+    // The model measures the updates itself, without the strains.
+
+    double  elapsed = 0.0;
+    idx_t   count   = 0;
+
+    params.set ( SolverNames::REPEAT_COUNT, (idx_t) 1 );
+
+    model_->takeAction ( SolverNames::TIME_MATERIAL, params, globdat );
+
+    params.find ( elapsed, SolverNames::ELAPSED_TIME );
+    params.find ( count,   SolverNames::POINT_COUNT  );
+
+    pointCount_ = count;
+
+    return elapsed;
+  }
+  else
+  {
+    throw IllegalInputException (
+      getContext (),
+      String::format ( "unknown kernel: %s (expected matrix0, "
+                       "intVector, matrix2 or material)", kernel )
+    );
+  }
+
+  return wallTime_() - t0;
+}
+
+
+//-----------------------------------------------------------------------
+//   write_
+//-----------------------------------------------------------------------
+
+// Writes the results as one JSON object. Times are in seconds.
+
+void BenchModule::write_ ()
+{
+  std::FILE*  file = std::fopen ( fileName_.addr(), "w" );
+
+  if ( ! file )
+  {
+    throw IOException (
+      getContext (),
+      String::format ( "can not open %s: %s", fileName_,
+                       std::strerror( errno ) )
+    );
+  }
+
+  std::fprintf ( file, "{\n  \"case\": \"%s\",\n", case_.addr() );
+  std::fprintf ( file, "  \"elements\": %ld,\n  \"nodes\": %ld,\n"
+                       "  \"dofs\": %ld,\n  \"points\": %ld,\n",
+                 (long) elemCount_, (long) nodeCount_,
+                 (long) dofs_->dofCount(), (long) pointCount_ );
+
+  std::fprintf ( file, "  \"kernels\": {" );
+
+  for ( idx_t k = 0; k < kernels_.size() &&
+                     kernelTimes_.size() > 0; k++ )
+  {
+    const double*  t    = kernelTimes_.addr() + k * repeat_;
+    double         tmin = t[0];
+    double         tmax = t[0];
+    double         sum  = 0.0;
+
+    for ( idx_t i = 0; i < repeat_; i++ )
+    {
+      tmin = jem::min ( tmin, t[i] );
+      tmax = jem::max ( tmax, t[i] );
+      sum += t[i];
+    }
+
+    std::fprintf ( file, "%s\n    \"%s\": { \"repeat\": %ld, "
+                         "\"min\": %.6e, \"mean\": %.6e, \"max\": %.6e",
+                   ( k > 0 ? "," : "" ), kernels_[k].addr(),
+                   (long) repeat_, tmin, sum / (double) repeat_, tmax );
+
+    if ( kernels_[k] == "material" && tmin > 0.0 )
+    {
+      std::fprintf ( file, ", \"updatesPerSecond\": %.6e",
+                     (double) pointCount_ * (double) repeat_ / sum );
+    }
+
+    std::fprintf ( file, " }" );
+  }
+
+  std::fprintf ( file, "\n  },\n  \"steps\": { \"count\": %ld",
+                 (long) stepTimes_.size() );
+
+  if ( stepTimes_.size() > 0 )
+  {
+    double  tmin = stepTimes_[0];
+    double  tmax = stepTimes_[0];
+    double  sum  = 0.0;
+
+    for ( idx_t i = 0; i < stepTimes_.size(); i++ )
+    {
+      tmin = jem::min ( tmin, stepTimes_[i] );
+      tmax = jem::max ( tmax, stepTimes_[i] );
+      sum += stepTimes_[i];
+    }
+
+    std::fprintf ( file, ", \"min\": %.6e, \"mean\": %.6e, "
+                         "\"max\": %.6e, \"total\": %.6e",
+                   tmin, sum / (double) stepTimes_.size(), tmax, sum );
+  }
+
+  std::fprintf ( file, " }\n}\n" );
+
+  const bool  failed = ( std::ferror( file ) != 0 );
+
+  if ( std::fclose( file ) != 0 || failed )
+  {
+    throw IOException (
+      getContext (),
+      String::format ( "error writing %s", fileName_ )
+    );
+  }
+
+  written_ = true;
+
+  System::info( myName_ ) << myName_ << " : results written to "
+                          << fileName_ << '\n';
+}
+
+
+//-----------------------------------------------------------------------
+//   wallTime_
+//-----------------------------------------------------------------------
+
+
+double BenchModule::wallTime_ ()
+{
+  struct timespec  ts;
+
+  clock_gettime ( CLOCK_MONOTONIC, &ts );
+
+  return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareBenchModule
+//-----------------------------------------------------------------------
+
+
+void declareBenchModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( BenchModule::TYPE_NAME,
+                         & BenchModule::makeNew );
+}
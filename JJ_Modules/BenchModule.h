@@ -0,0 +1,159 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module measures the performance of the model and the solver
+ *  and writes the results to a JSON file. In its first run it times
+ *  the following kernels, each repeat times after warmup untimed
+ *  calls:
+ *
+ *    matrix0    stiffness matrix and internal force (GET_MATRIX0)
+ *    intVector  internal force only (GET_INT_VECTOR)
+ *    matrix2    lumped mass matrix (GET_MATRIX2)
+ *    material   material updates alone (TIME_MATERIAL)
+ *
+ *  The kernels are timed at the state after the first step, so that
+ *  nonlinear materials are not all in their elastic branch.
+ *
+ *  If steps is larger than zero, the module also records the wall
+ *  time between its runs, which is the time of one step of the
+ *  solver module in front of it (an explicit or a Newton step), and
+ *  stops the program after that many steps. For a clean measurement
+ *  the module should directly follow the solver module, without
+ *  output modules in between.
+ *
+ *  The benchmark drivers in bench/ use this module; see bench/Makefile.
+ *
+ */
+
+#ifndef BENCH_MODULE_H
+#define BENCH_MODULE_H
+
+#include <jem/util/Flex.h>
+#include <jive/app/Module.h>
+#include <jive/algebra/MatrixBuilder.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+
+#include "Array.h"
+
+using jem::Ref;
+using jem::String;
+using jem::idx_t;
+using jem::util::Flex;
+using jem::util::Properties;
+using jive::app::Module;
+using jive::algebra::MBuilder;
+using jive::model::Model;
+using jive::util::DofSpace;
+
+
+//-----------------------------------------------------------------------
+//   class BenchModule
+//-----------------------------------------------------------------------
+
+
+class BenchModule : public Module
+{
+ public:
+
+  typedef BenchModule       Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        FILE_PROP;
+  static const char*        CASE_PROP;
+  static const char*        KERNELS_PROP;
+  static const char*        REPEAT_PROP;
+  static const char*        WARMUP_PROP;
+  static const char*        STEPS_PROP;
+
+  explicit                  BenchModule
+
+    ( const String&           name = "bench" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~BenchModule ();
+
+
+ private:
+
+  void                      timeKernels_
+
+    ( const Properties&       globdat );
+
+  double                    timeKernel_
+
+    ( const String&           kernel,
+      const Properties&       globdat );
+
+  void                      write_        ();
+
+  static double             wallTime_     ();
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<MBuilder>             kbuilder_;
+  Ref<MBuilder>             mbuilder_;
+  Vector                    fint_;
+
+  String                    fileName_;
+  String                    case_;
+  StringVector              kernels_;
+  idx_t                     repeat_;
+  idx_t                     warmup_;
+  idx_t                     steps_;
+
+  idx_t                     elemCount_;
+  idx_t                     nodeCount_;
+  idx_t                     pointCount_;
+
+  // per kernel: repeat_ timings; the step timings
+
+  Flex<double>              kernelTimes_;
+  Flex<double>              stepTimes_;
+
+  idx_t                     runCount_;
+  double                    lastTime_;
+  bool                      written_;
+
+};
+
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Binary mesh reader. See BinMeshModule.h for details.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/System.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/io/IOException.h>
+#include <jive/fem/XNodeSet.h>
+#include <jive/fem/XElementSet.h>
+#include <jive/fem/NodeGroup.h>
+#include <jive/fem/ElementGroup.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "BinMeshModule.h"
+#include "BinMeshFormat.h"
+
+
+using jem::idx_t;
+using jem::System;
+using jem::newInstance;
+using jem::IllegalInputException;
+using jem::io::endl;
+using jem::io::IOException;
+using jive::Vector;
+using jive::IdxVector;
+using jive::fem::XNodeSet;
+using jive::fem::XElementSet;
+
+
+//=======================================================================
+//   class BinMeshModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  BinMeshModule::TYPE_NAME = "BinMesh";
+const char*  BinMeshModule::FILE_PROP = "file";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+BinMeshModule::BinMeshModule ( const String& name ) :
+
+  Super ( name )
+
+{}
+
+
+BinMeshModule::~BinMeshModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status BinMeshModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  struct stat   st;
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  if ( fileName_.size() == 0 )
+  {
+    return DONE;
+  }
+
+  int  fd = ::open ( fileName_.addr(), O_RDONLY );
+
+  if ( fd < 0 || ::fstat( fd, &st ) != 0 )
+  {
+    const int  err = errno;
+
+    if ( fd >= 0 )
+    {
+      ::close ( fd );
+    }
+
+    throw IOException (
+      context,
+      String::format ( "can not open %s: %s", fileName_,
+                       ::strerror( err ) )
+    );
+  }
+
+  void*  addr = ::mmap ( 0, (size_t) st.st_size, PROT_READ,
+                         MAP_PRIVATE, fd, 0 );
+
+  ::close ( fd );
+
+  if ( addr == MAP_FAILED )
+  {
+    throw IOException (
+      context,
+      String::format ( "can not map %s: %s", fileName_,
+                       ::strerror( errno ) )
+    );
+  }
+
+  try
+  {
+    read_ ( (const char*) addr, (idx_t) st.st_size, globdat );
+  }
+  catch ( ... )
+  {
+    ::munmap ( addr, (size_t) st.st_size );
+    throw;
+  }
+
+  ::munmap ( addr, (size_t) st.st_size );
+
+  return DONE;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void BinMeshModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( fileName_, FILE_PROP );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void BinMeshModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( FILE_PROP, fileName_ );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> BinMeshModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   read_
+//-----------------------------------------------------------------------
+
+// Creates the node set, element set and groups from the mapped file.
+// All sizes and indices are checked before they are used, so that a
+// damaged file gives an error instead of a crash.
+
+void BinMeshModule::read_
+
+  ( const char*        data,
+    idx_t              size,
+    const Properties&  globdat )
+
+{
+  using jive::fem::newXNodeSet;
+  using jive::fem::newXElementSet;
+  using jive::fem::newNodeGroup;
+  using jive::fem::newElementGroup;
+
+  typedef BinMeshFormat            Format;
+
+  const String           context = getContext ();
+  const Format::Header*  head    = (const Format::Header*) data;
+
+  if ( size < (idx_t) sizeof(Format::Header) ||
+       std::memcmp( head->magic, Format::magic(), 8 ) != 0 )
+  {
+    throw IllegalInputException (
+      context,
+      fileName_ + " is not a binary mesh file"
+    );
+  }
+
+  if ( head->version != Format::VERSION )
+  {
+    throw IllegalInputException (
+      context,
+      String::format ( "%s has version %d instead of %d", fileName_,
+                       (int) head->version, (int) Format::VERSION )
+    );
+  }
+
+  const idx_t  rank      = head->rank;
+  const idx_t  nodeCount = (idx_t) head->nodeCount;
+  const idx_t  elemCount = (idx_t) head->elemCount;
+  const idx_t  connSize  = (idx_t) head->connSize;
+
+  if ( rank < 1 || rank > 3 || nodeCount < 0 || elemCount < 0 ||
+       connSize < 0 ||
+       (idx_t) sizeof(Format::Header) + 8 * ( nodeCount * (rank + 1) +
+                    elemCount * 2 + 1 + connSize ) > size )
+  {
+    throw IllegalInputException (
+      context,
+      fileName_ + " is truncated"
+    );
+  }
+
+  const int64_t*  nodeIDs  = (const int64_t*) (head + 1);
+  const double*   coords   = (const double*)  (nodeIDs + nodeCount);
+  const int64_t*  elemIDs  = (const int64_t*) (coords  + nodeCount * rank);
+  const int64_t*  offsets  = elemIDs + elemCount;
+  const int64_t*  inodes   = offsets + elemCount + 1;
+  const char*     pos      = (const char*) (inodes + connSize);
+
+  XNodeSet        nodes    = newXNodeSet    ();
+  XElementSet     elems    = newXElementSet ( nodes );
+
+  Vector          x        ( rank );
+  IdxVector       enodes;
+
+
+  nodes.reserve ( nodeCount );
+
+  for ( idx_t in = 0; in < nodeCount; in++ )
+  {
+    for ( idx_t i = 0; i < rank; i++ )
+    {
+      x[i] = coords[in * rank + i];
+    }
+
+    nodes.addNode ( (idx_t) nodeIDs[in], x );
+  }
+
+  elems.reserve ( elemCount );
+
+  for ( idx_t ie = 0; ie < elemCount; ie++ )
+  {
+    const idx_t  first = (idx_t) offsets[ie];
+    const idx_t  n     = (idx_t) offsets[ie + 1] - first;
+
+    if ( first < 0 || n < 0 || first + n > connSize )
+    {
+      throw IllegalInputException (
+        context,
+        fileName_ + " has invalid element offsets"
+      );
+    }
+
+    enodes.resize ( n );
+
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      enodes[j] = (idx_t) inodes[first + j];
+
+      if ( enodes[j] < 0 || enodes[j] >= nodeCount )
+      {
+        throw IllegalInputException (
+          context,
+          fileName_ + " has an invalid element node"
+        );
+      }
+    }
+
+    elems.addElement ( (idx_t) elemIDs[ie], enodes );
+  }
+
+  nodes.store ( globdat );
+  elems.store ( globdat );
+
+  // Read the groups.
+
+  for ( int64_t ig = 0; ig < head->groupCount; ig++ )
+  {
+    const Format::GroupHeader*  gh = (const Format::GroupHeader*) pos;
+
+    if ( pos + sizeof(*gh) > data + size )
+    {
+      throw IllegalInputException ( context, fileName_ + " is truncated" );
+    }
+
+    const idx_t     len     = (idx_t) gh->nameLength;
+    const idx_t     n       = (idx_t) gh->size;
+    const char*     name    = (const char*) (gh + 1);
+    const int64_t*  members = (const int64_t*)
+
+      (name + Format::padded( len ));
+
+    const idx_t     count   = ( gh->kind == Format::NODE_GROUP ) ?
+                              nodeCount : elemCount;
+
+    if ( len < 0 || n < 0 ||
+         (const char*) (members + n) > data + size )
+    {
+      throw IllegalInputException ( context, fileName_ + " is truncated" );
+    }
+
+    IdxVector  items ( n );
+
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      items[i] = (idx_t) members[i];
+
+      if ( items[i] < 0 || items[i] >= count )
+      {
+        throw IllegalInputException (
+          context,
+          fileName_ + " has an invalid group member"
+        );
+      }
+    }
+
+    const String  gname ( name, name + len );
+
+    if ( gh->kind == Format::NODE_GROUP )
+    {
+      newNodeGroup    ( items, nodes ).store ( gname, globdat );
+    }
+    else
+    {
+      newElementGroup ( items, elems ).store ( gname, globdat );
+    }
+
+    pos = (const char*) (members + n);
+  }
+
+  System::info() << myName_ << " : read " << nodeCount << " nodes, "
+                 << elemCount << " elements and " << head->groupCount
+                 << " groups from " << fileName_ << endl;
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareBinMeshModule
+//-----------------------------------------------------------------------
+
+
+void declareBinMeshModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( BinMeshModule::TYPE_NAME,
+                         & BinMeshModule::makeNew );
+}
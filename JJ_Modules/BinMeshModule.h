@@ -0,0 +1,92 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module reads a binary mesh file written by tools/mesh2bin (see
+ *  BinMeshFormat.h) and stores the nodes, elements and groups in the
+ *  global database, as the input module does for a text mesh. The
+ *  file is mapped into memory, so there is nothing to parse.
+ *
+ *  The module sits before the input module in the main chain and does
+ *  nothing if no file is given. Data that are not part of the mesh
+ *  (constraints, loads) can still be read by the input module from a
+ *  text file without nodes and elements.
+ *
+ */
+
+#ifndef BIN_MESH_MODULE_H
+#define BIN_MESH_MODULE_H
+
+#include <jive/app/Module.h>
+
+using jem::Ref;
+using jem::String;
+using jem::util::Properties;
+using jive::app::Module;
+
+
+//-----------------------------------------------------------------------
+//   class BinMeshModule
+//-----------------------------------------------------------------------
+
+
+class BinMeshModule : public Module
+{
+ public:
+
+  typedef BinMeshModule     Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        FILE_PROP;
+
+  explicit                  BinMeshModule
+
+    ( const String&           name = "binMesh" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~BinMeshModule ();
+
+
+ private:
+
+  void                      read_
+
+    ( const char*             data,
+      jem::idx_t              size,
+      const Properties&       globdat );
+
+
+ private:
+
+  String                    fileName_;
+
+};
+
+
+#endif
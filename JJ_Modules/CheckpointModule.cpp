@@ -0,0 +1,313 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Checkpoint/restart module. See CheckpointModule.h for details.
+ *
+ */
+
+#include <jem/base/limits.h>
+#include <jem/base/System.h>
+#include <jive/util/Globdat.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "CheckpointModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::newInstance;
+using jem::System;
+using jem::io::endl;
+using jive::util::Globdat;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class CheckpointModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  CheckpointModule::TYPE_NAME       = "Checkpoint";
+const char*  CheckpointModule::FILE_PROP       = "file";
+const char*  CheckpointModule::FINAL_FILE_PROP = "finalFile";
+const char*  CheckpointModule::INTERVAL_PROP   = "interval";
+const char*  CheckpointModule::RESTART_PROP    = "restart";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+CheckpointModule::CheckpointModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  fileName_  = "checkpoint.bin";
+  finalFile_ = fileName_ + ".final";
+  interval_  = 100;
+  runCount_  = 0;
+  restart_   = false;
+}
+
+
+CheckpointModule::~CheckpointModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status CheckpointModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_    = Model   ::get ( globdat, context );
+  dofs_     = DofSpace::get ( globdat, context );
+  ckpt_     = newInstance<Checkpoint> ();
+  runCount_ = 0;
+
+  if ( restart_ && read_( globdat ) )
+  {
+    System::info() << myName_ << " : restarted from "
+                   << fileName_ << endl;
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status CheckpointModule::run ( const Properties& globdat )
+{
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  runCount_++;
+
+  if ( runCount_ % interval_ == 0 )
+  {
+    write_ ( fileName_, globdat );
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+// The final state is not necessarily a good one, so it goes to a file
+// of its own.
+
+void CheckpointModule::shutdown ( const Properties& globdat )
+{
+  if ( model_ != NIL && finalFile_.size() > 0 )
+  {
+    write_ ( finalFile_, globdat );
+  }
+
+  model_ = NIL;
+  ckpt_  = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void CheckpointModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    if ( myProps.find( fileName_, FILE_PROP ) )
+    {
+      finalFile_ = fileName_ + ".final";
+    }
+
+    myProps.find ( finalFile_, FINAL_FILE_PROP );
+    myProps.find ( interval_,  INTERVAL_PROP, 1, maxOf( interval_ ) );
+    myProps.find ( restart_,   RESTART_PROP );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void CheckpointModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( FILE_PROP,       fileName_  );
+  myConf.set ( FINAL_FILE_PROP, finalFile_ );
+  myConf.set ( INTERVAL_PROP,   interval_  );
+  myConf.set ( RESTART_PROP,    restart_   );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> CheckpointModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   write_
+//-----------------------------------------------------------------------
+
+
+void CheckpointModule::write_
+
+  ( const String&      fileName,
+    const Properties&  globdat )
+
+{
+  using jive::model::STATE0;
+  using jive::model::STATE1;
+  using jive::model::STATE2;
+
+  Properties  params;
+  Vector      vec;
+  double      t = 0.0;
+  int         i = 0;
+
+  globdat.find ( t, Globdat::TIME );
+  globdat.find ( i, Globdat::TIME_STEP );
+
+  ckpt_->clear ();
+  ckpt_->add   ( "time", t );
+  ckpt_->add   ( "step", (double) i );
+
+  StateVector::get    ( vec, STATE0, dofs_, globdat );
+  ckpt_->add          ( "state0",    vec );
+  StateVector::getOld ( vec, STATE0, dofs_, globdat );
+  ckpt_->add          ( "oldState0", vec );
+  StateVector::get    ( vec, STATE1, dofs_, globdat );
+  ckpt_->add          ( "state1",    vec );
+  StateVector::get    ( vec, STATE2, dofs_, globdat );
+  ckpt_->add          ( "state2",    vec );
+
+  params.set ( SolverNames::CHECKPOINT, ckpt_ );
+
+  model_->takeAction ( SolverNames::WRITE_CHECKPOINT, params, globdat );
+
+  ckpt_->write ( fileName );
+  ckpt_->clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   read_
+//-----------------------------------------------------------------------
+
+// Restores the state from the checkpoint file. Returns false if there
+// is no such file.
+
+bool CheckpointModule::read_ ( const Properties& globdat )
+{
+  using jive::model::STATE0;
+  using jive::model::STATE1;
+  using jive::model::STATE2;
+
+  Properties  params;
+  Vector      vec;
+  double      t = 0.0;
+  double      i = 0.0;
+
+  if ( ! ckpt_->open( fileName_ ) )
+  {
+    return false;
+  }
+
+  ckpt_->find ( t, "time" );
+  ckpt_->find ( i, "step" );
+
+  globdat.set ( Globdat::TIME,          t );
+  globdat.set ( Globdat::OLD_TIME,      t );
+  globdat.set ( Globdat::TIME_STEP,     (int) i );
+  globdat.set ( Globdat::OLD_TIME_STEP, (int) i );
+
+  StateVector::get    ( vec, STATE0, dofs_, globdat );
+  ckpt_->find         ( vec, "state0" );
+  StateVector::getOld ( vec, STATE0, dofs_, globdat );
+  ckpt_->find         ( vec, "oldState0" );
+  StateVector::get    ( vec, STATE1, dofs_, globdat );
+  ckpt_->find         ( vec, "state1" );
+  StateVector::get    ( vec, STATE2, dofs_, globdat );
+  ckpt_->find         ( vec, "state2" );
+
+  params.set ( SolverNames::CHECKPOINT, ckpt_ );
+
+  model_->takeAction ( SolverNames::READ_CHECKPOINT, params, globdat );
+
+  ckpt_->close ();
+
+  return true;
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareCheckpointModule
+//-----------------------------------------------------------------------
+
+
+void declareCheckpointModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( CheckpointModule::TYPE_NAME,
+                         & CheckpointModule::makeNew );
+}
@@ -0,0 +1,129 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module writes a checkpoint of the simulation state every
+ *  interval runs, and restarts from the checkpoint if restart is set
+ *  and the file exists. The module runs before the solver (see below),
+ *  so a checkpoint holds the state committed by the previous run, not
+ *  the step solved in the same run.
+ *
+ *  When the program stops, the state is written to finalFile instead
+ *  (file with ".final" appended by default; no file if empty): the
+ *  program may stop because the solution diverged, and such a state
+ *  must not replace the last good checkpoint.
+ *
+ *  A checkpoint contains the time and step number, the state vectors
+ *  and whatever the models add on WRITE_CHECKPOINT (the load scale of
+ *  the Dirichlet models and the history of the materials). See
+ *  Checkpoint.h for the file format.
+ *
+ *  The state is restored in init, so the module must come after the
+ *  module that creates the model and before the solver module.
+ *
+ */
+
+#ifndef CHECKPOINT_MODULE_H
+#define CHECKPOINT_MODULE_H
+
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+
+#include "Checkpoint.h"
+
+using jem::Ref;
+using jem::String;
+using jem::util::Properties;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+
+
+//-----------------------------------------------------------------------
+//   class CheckpointModule
+//-----------------------------------------------------------------------
+
+
+class CheckpointModule : public Module
+{
+ public:
+
+  typedef CheckpointModule  Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        FILE_PROP;
+  static const char*        FINAL_FILE_PROP;
+  static const char*        INTERVAL_PROP;
+  static const char*        RESTART_PROP;
+
+  explicit                  CheckpointModule
+
+    ( const String&           name = "checkpoint" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~CheckpointModule ();
+
+
+ private:
+
+  void                      write_
+
+    ( const String&           fileName,
+      const Properties&       globdat );
+
+  bool                      read_
+
+    ( const Properties&       globdat );
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<Checkpoint>           ckpt_;
+
+  String                    fileName_;
+  String                    finalFile_;
+  idx_t                     interval_;
+  idx_t                     runCount_;
+  bool                      restart_;
+
+};
+
+
+#endif
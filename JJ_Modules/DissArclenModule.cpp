@@ -0,0 +1,789 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Solver module for the dissipation based arc-length method. See
+ *  DissArclenModule.h for details.
+ *
+ */
+
+#include <cmath>
+
+#include <jem/base/limits.h>
+#include <jem/base/Float.h>
+#include <jem/base/System.h>
+#include <jem/base/Exception.h>
+#include <jem/base/PrecheckException.h>
+#include <jem/base/array/operators.h>
+#include <jem/base/array/select.h>
+#include <jem/io/Writer.h>
+#include <jem/numeric/algebra/utilities.h>
+#include <jive/util/utilities.h>
+#include <jive/algebra/VectorSpace.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+#include <jive/implict/Names.h>
+#include <jive/implict/ConHandler.h>
+#include <jive/implict/SolverInfo.h>
+
+#include "DissArclenModule.h"
+#include "SolverNames.h"
+
+
+using jem::max;
+using jem::maxOf;
+using jem::newInstance;
+using jem::Float;
+using jem::System;
+using jem::Exception;
+using jem::io::endl;
+using jem::numeric::axpy;
+using jive::IdxVector;
+using jive::util::joinNames;
+using jive::model::StateVector;
+using jive::implict::ConHandler;
+using jive::implict::PropNames;
+using jive::implict::SolverInfo;
+
+
+//=======================================================================
+//   class DissArclenModule::Work_
+//=======================================================================
+
+
+class DissArclenModule::Work_ : public ConHandler
+{
+ public:
+
+                          Work_
+
+    ( DissArclenModule&     module,
+      const Properties&     globdat );
+
+  inline                 ~Work_             ();
+
+  void                    updateRscale      ();
+
+  void                    updateResidual    ();
+
+  void                    setUnitConstraints ();
+
+  void                    setLoadScale
+
+    ( double                lambda,
+      const Properties&     globdat );
+
+  inline void             reportProgress    ();
+
+
+ public:
+
+  NonlinRunData&          rundat;
+
+  Vector                  u;
+  Vector                  u0;
+  Vector                  du;
+  Vector                  a;
+  Vector                  b;
+  Vector                  z;
+  Vector                  fext;
+  Vector                  fint;
+  Vector                  r;
+  Vector                  h;
+  Vector                  uhat;
+
+  IdxVector               slaveDofs;
+
+  idx_t                   iiter;
+  double                  rscale;
+  double                  rnorm;
+  double                  lambda;
+  bool                    noDiss;
+
+
+ private:
+
+  String                  myName_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+DissArclenModule::Work_::Work_
+
+  ( DissArclenModule&  mod,
+    const Properties&  globdat ) :
+
+    rundat  ( *mod.rundat_ ),
+    myName_ (  mod.getName() )
+
+{
+  Properties  params;
+  idx_t       dofCount;
+
+
+  iiter  = 0;
+  rscale = 0.0;
+  rnorm  = 1.0;
+  noDiss = false;
+
+  rundat.updateConstraints ( globdat );
+  rundat.dofs->resetEvents ();
+
+  rundat.frozen = true;
+  dofCount      = rundat.dofs->dofCount ();
+
+  StateVector::get ( u, rundat.dofs, globdat );
+
+  u0  .resize ( dofCount );
+  du  .resize ( dofCount );
+  a   .resize ( dofCount );
+  b   .resize ( dofCount );
+  z   .resize ( dofCount );
+  fext.resize ( dofCount );
+  fint.resize ( dofCount );
+  r   .resize ( dofCount );
+  h   .resize ( dofCount );
+  uhat.resize ( dofCount );
+
+  u0   = u;
+  z    = 0.0;
+  h    = 0.0;
+  uhat = 0.0;
+
+  // The load scale after advance.
+
+  lambda = 0.0;
+
+  rundat.model->takeAction ( SolverNames::GET_LOAD_SCALE,
+                             params, globdat );
+
+  params.find ( lambda, SolverNames::LOAD_SCALE );
+
+  // The prescribed displacements for a unit load scale, and the
+  // dissipation force vector at the committed state.
+
+  params.set ( SolverNames::UNIT_DISP, uhat );
+
+  rundat.model->takeAction ( SolverNames::GET_UNIT_DISP,
+                             params, globdat );
+
+  params.set ( SolverNames::DISSIPATION_FORCE, h );
+
+  rundat.model->takeAction ( SolverNames::GET_DISS_FORCE,
+                             params, globdat );
+
+  slaveDofs.ref ( rundat.cons->getSlaveDofs() );
+
+  saveConstraints ( *rundat.cons );
+}
+
+
+inline DissArclenModule::Work_::~Work_ ()
+{
+  rundat.frozen = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   updateRscale
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::Work_::updateRscale ()
+{
+  double  rtmp;
+
+  axpy ( r, fext, -1.0, fint );
+
+  select ( r, slaveDofs ) = 0.0;
+
+  rtmp   = std::sqrt( Float::EPSILON ) *
+
+    max ( rundat.vspace->norm2( fext ),
+          rundat.vspace->norm2( fint ) );
+
+  rtmp   = max ( rtmp, rundat.vspace->norm2( r ) );
+  rscale = max ( rtmp, rscale );
+}
+
+
+//-----------------------------------------------------------------------
+//   updateResidual
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::Work_::updateResidual ()
+{
+  axpy ( r, fext, -1.0, fint );
+
+  select ( r, slaveDofs ) = 0.0;
+
+  rnorm = rundat.vspace->norm2 ( r );
+
+  if ( rscale > 0.0 )
+  {
+    rnorm /= rscale;
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   setUnitConstraints
+//-----------------------------------------------------------------------
+
+// Prescribes the displacements of a unit load scale; the other
+// constraints are homogeneous.
+
+void DissArclenModule::Work_::setUnitConstraints ()
+{
+  for ( idx_t i = 0; i < slaveDofs.size(); i++ )
+  {
+    idx_t  idof = slaveDofs[i];
+
+    rundat.cons->addConstraint ( idof, uhat[idof] );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   setLoadScale
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::Work_::setLoadScale
+
+  ( double             scale,
+    const Properties&  globdat )
+
+{
+  Properties  params;
+
+  lambda = scale;
+
+  params.set ( SolverNames::LOAD_SCALE, lambda );
+
+  rundat.model->takeAction ( SolverNames::SET_LOAD_SCALE,
+                             params, globdat );
+}
+
+
+//-----------------------------------------------------------------------
+//   reportProgress
+//-----------------------------------------------------------------------
+
+
+inline void DissArclenModule::Work_::reportProgress ()
+{
+  print ( System::info( myName_ ), rundat.context,
+          " : iter = "          , iiter,
+          ", scaled residual = ", rundat.nformat.print( rnorm ),
+          ", load scale = "     , rundat.nformat.print( lambda ),
+          endl );
+
+  System::info( myName_ ).flush ();
+}
+
+
+//=======================================================================
+//   class DissArclenModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  DissArclenModule::TYPE_NAME          = "DissArclen";
+const char*  DissArclenModule::MAX_ITER_PROP      = "maxIter";
+const char*  DissArclenModule::PRECISION_PROP     = "precision";
+const char*  DissArclenModule::SWITCH_ENERGY_PROP = "switchEnergy";
+const char*  DissArclenModule::DISS_INCR_PROP     = "dissIncr";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+DissArclenModule::DissArclenModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  maxIter_      = 20;
+  precision_    = 1.0e-3;
+  switchEnergy_ = 0.0;
+  dissIncr_     = 0.0;
+  arcl_         = false;
+  dtau_         = 0.0;
+  lastDiss_     = 0.0;
+}
+
+
+DissArclenModule::~DissArclenModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status DissArclenModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  rundat_ = NIL;
+
+  Ref<NonlinRunData>  newdat = newInstance<NonlinRunData> ( getContext() );
+  String              name   = joinNames ( myName_, PropNames::SOLVER );
+
+  // The switch energy has no sensible default (zero would switch at
+  // the first plastic step), so it must be given.
+
+  props.getProps( myName_ ).get ( switchEnergy_, SWITCH_ENERGY_PROP,
+                                  0.0,           Float::MAX_VALUE );
+
+  configure ( props, globdat );
+
+  newdat->init       ( globdat );
+  newdat->initSolver ( name, precision_, conf, props, globdat );
+
+  rundat_.swap ( newdat );
+
+  arcl_     = false;
+  lastDiss_ = 0.0;
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::shutdown ( const Properties& globdat )
+{
+  rundat_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( maxIter_,      MAX_ITER_PROP,
+                   1,             maxOf( maxIter_ ) );
+    myProps.find ( precision_,    PRECISION_PROP,
+                   0.0,           1.0e20 );
+    myProps.find ( switchEnergy_, SWITCH_ENERGY_PROP,
+                   0.0,           Float::MAX_VALUE );
+    myProps.find ( dissIncr_,     DISS_INCR_PROP,
+                   0.0,           Float::MAX_VALUE );
+  }
+
+  if ( rundat_ != NIL )
+  {
+    rundat_->solver->configure ( props );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( MAX_ITER_PROP,      maxIter_      );
+  myConf.set ( PRECISION_PROP,     precision_    );
+  myConf.set ( SWITCH_ENERGY_PROP, switchEnergy_ );
+  myConf.set ( DISS_INCR_PROP,     dissIncr_     );
+
+  if ( rundat_ != NIL )
+  {
+    rundat_->solver->getConfig ( conf );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   advance
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::advance ( const Properties& globdat )
+{
+  if ( rundat_ == NIL )
+  {
+    notAliveError ( JEM_FUNC );
+  }
+
+  rundat_->advance ( globdat );
+}
+
+
+//-----------------------------------------------------------------------
+//   solve
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::solve
+
+  ( const Properties&  info,
+    const Properties&  globdat )
+
+{
+  if ( rundat_ == NIL )
+  {
+    notAliveError ( JEM_FUNC );
+  }
+
+  NonlinRunData&  d = * rundat_;
+
+  Work_           w ( *this, globdat );
+
+  bool            result;
+
+
+  print ( System::info( myName_ ),
+          "Starting the arc-length solver `", myName_, "\' in ",
+          ( arcl_ ? "dissipation" : "displacement" ), " control ...\n" );
+
+  d.getExtVector  ( w.fext, globdat );
+  d.updateMatrix  ( w.fint, globdat );
+  w.updateRscale  ();
+
+  result = solve_ ( w, globdat );
+
+  w.restoreConstraints ( *d.cons );
+
+  lastDiss_ = d.vspace->product ( w.h, w.u ) -
+              d.vspace->product ( w.h, w.u0 );
+
+  info.set ( SolverInfo::CONVERGED,  result   );
+  info.set ( SolverInfo::ITER_COUNT, w.iiter  );
+  info.set ( SolverInfo::RESIDUAL,   w.rnorm  );
+  info.set ( SolverNames::LOAD_SCALE, w.lambda );
+
+  if ( ! result )
+  {
+    if ( w.noDiss )
+    {
+      // Nothing left to dissipate: try again in displacement control.
+
+      setMode_ ( false, globdat );
+
+      throw Exception (
+        getContext (),
+        "no dissipation in dissipation control; "
+        "switching to displacement control"
+      );
+    }
+
+    throw Exception (
+      getContext (),
+      String::format (
+        "no convergence achieved in %d iterations; "
+        "final residual: %e",
+        w.iiter,
+        w.rnorm
+      )
+    );
+  }
+
+  print ( System::info( myName_ ),
+          "The arc-length solver converged in ", w.iiter,
+          " iterations; dissipated energy = ",
+          d.nformat.print( lastDiss_ ), "\n\n" );
+}
+
+
+//-----------------------------------------------------------------------
+//   cancel
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::cancel ( const Properties& globdat )
+{
+  if ( rundat_ == NIL )
+  {
+    notAliveError ( JEM_FUNC );
+  }
+
+  rundat_->cancel ( globdat );
+}
+
+
+//-----------------------------------------------------------------------
+//   commit
+//-----------------------------------------------------------------------
+
+
+bool DissArclenModule::commit ( const Properties& globdat )
+{
+  if ( rundat_ == NIL )
+  {
+    notAliveError ( JEM_FUNC );
+  }
+
+  bool  result = rundat_->commit ( globdat );
+
+  if ( result && ! arcl_ && lastDiss_ > switchEnergy_ )
+  {
+    // The dissipation increment is defined for the initial step size.
+
+    dtau_ = dissIncr_;
+
+    if ( dtau_ <= 0.0 )
+    {
+      dtau_ = lastDiss_ / stepRatio_( globdat );
+    }
+
+    setMode_ ( true, globdat );
+  }
+
+  return result;
+}
+
+
+//-----------------------------------------------------------------------
+//   setPrecision
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::setPrecision ( double eps )
+{
+  JEM_PRECHECK ( eps > 0.0 );
+
+  precision_ = eps;
+}
+
+
+//-----------------------------------------------------------------------
+//   getPrecision
+//-----------------------------------------------------------------------
+
+
+double DissArclenModule::getPrecision () const
+{
+  return precision_;
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> DissArclenModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   solve_
+//-----------------------------------------------------------------------
+
+
+bool DissArclenModule::solve_
+
+  ( Work_&             w,
+    const Properties&  globdat )
+
+{
+  NonlinRunData&  d = w.rundat;
+
+  const double    dtau = dtau_ * stepRatio_( globdat );
+
+
+  do
+  {
+    if ( arcl_ )
+    {
+      // Solve the bordered system for the displacement increment and
+      // the load scale increment.
+
+      double  hb, dl;
+
+      w.zeroConstraints    ( *d.cons );
+      d.solver->solve      ( w.a, w.r );
+
+      w.setUnitConstraints ();
+      d.solver->solve      ( w.b, w.z );
+
+      hb = d.vspace->product ( w.h, w.b );
+
+      if ( ! (std::fabs( hb ) > Float::EPSILON *
+              d.vspace->norm2( w.h ) * d.vspace->norm2( w.b )) )
+      {
+        print ( System::info( myName_ ), d.context,
+                " : no dissipating mechanism found\n" );
+
+        w.noDiss = true;
+
+        return false;
+      }
+
+      dl = -( d.vspace->product( w.h, w.u  ) -
+              d.vspace->product( w.h, w.u0 ) - dtau +
+              d.vspace->product( w.h, w.a  ) ) / hb;
+
+      w.du = w.a + dl * w.b;
+
+      w.setLoadScale ( w.lambda + dl, globdat );
+    }
+    else
+    {
+      // The first iteration applies the prescribed displacement
+      // increment.
+
+      if ( w.iiter == 0 )
+      {
+        w.adjustConstraints ( *d.cons, w.u );
+      }
+      else
+      {
+        w.zeroConstraints   ( *d.cons );
+      }
+
+      d.solver->solve ( w.du, w.r );
+    }
+
+    axpy ( w.u, 1.0, w.du );
+
+    w.iiter++;
+
+    d.updateModel    ( globdat );
+    d.updateMatrix   ( w.fint, globdat );
+    w.updateRscale   ();
+    w.updateResidual ();
+    w.reportProgress ();
+
+    if ( w.rnorm <= precision_ )
+    {
+      return true;
+    }
+
+    if ( w.iiter >= maxIter_ || ! (w.rnorm == w.rnorm) )
+    {
+      return false;
+    }
+  }
+  while ( true );
+
+  return false;
+}
+
+
+//-----------------------------------------------------------------------
+//   setMode_
+//-----------------------------------------------------------------------
+
+
+void DissArclenModule::setMode_
+
+  ( bool               arcl,
+    const Properties&  globdat )
+
+{
+  Properties  params;
+
+  arcl_ = arcl;
+
+  if ( arcl_ )
+  {
+    print ( System::info( myName_ ), getContext(),
+            " : switching to dissipation control, dissipation "
+            "increment = ", rundat_->nformat.print( dtau_ ), endl );
+
+    rundat_->model->takeAction ( SolverNames::TO_ARCL, params, globdat );
+  }
+  else
+  {
+    print ( System::info( myName_ ), getContext(),
+            " : switching to displacement control\n" );
+
+    rundat_->model->takeAction ( SolverNames::TO_DISP, params, globdat );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   stepRatio_
+//-----------------------------------------------------------------------
+
+// Returns the current step size relative to the initial one, as set by
+// AdaptiveStepGeneral through SET_STEP_SIZE.
+
+double DissArclenModule::stepRatio_ ( const Properties& globdat ) const
+{
+  Properties  params;
+  double      incr  = 1.0;
+  double      incr0 = 1.0;
+
+  rundat_->model->takeAction ( SolverNames::GET_STEP_SIZE,
+                               params, globdat );
+
+  params.find ( incr,  SolverNames::STEP_SIZE   );
+  params.find ( incr0, SolverNames::STEP_SIZE_0 );
+
+  if ( incr0 == 0.0 || incr == 0.0 )
+  {
+    return 1.0;
+  }
+
+  return std::fabs ( incr / incr0 );
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareDissArclenModule
+//-----------------------------------------------------------------------
+
+
+void declareDissArclenModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( DissArclenModule::TYPE_NAME,
+                         & DissArclenModule::makeNew );
+}
@@ -0,0 +1,174 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class implements a solver module that switches between
+ *  displacement control and dissipation control (the dissipation
+ *  based arc-length method of Verhoosel et al., in the form of
+ *  Van der Meer for plasticity).
+ *
+ *  The load scale lambda of the DirichletModel is an extra unknown in
+ *  dissipation control. The constraint equation
+ *
+ *    h^T (u - u0) = dtau
+ *
+ *  prescribes the energy dissipated in the step, with h the
+ *  dissipation force vector assembled at the start of the step (see
+ *  GET_DISS_FORCE in SolidModel). The bordered system is solved with
+ *  two solves per iteration:
+ *
+ *    K a = r          (homogeneous constraints)
+ *    K b = 0          (constraints with unit load scale)
+ *
+ *    dlambda = -(h^T (u - u0) - dtau + h^T a) / h^T b
+ *    du      = a + dlambda b
+ *
+ *  The module starts in displacement control and switches to
+ *  dissipation control once the energy dissipated in a step exceeds
+ *  switchEnergy, which must be given in the input. If no dissipating
+ *  mechanism is left (h^T b vanishes) it falls back to displacement
+ *  control.
+ *
+ *  The module can be used as the solver of AdaptiveStepGeneral; the
+ *  dissipation increment then scales with the step size.
+ *
+ */
+
+#ifndef DISS_ARCLEN_MODULE_H
+#define DISS_ARCLEN_MODULE_H
+
+#include <jive/Array.h>
+#include <jive/implict/SolverModule.h>
+#include <jive/implict/NonlinRunData.h>
+
+using jem::Ref;
+using jem::String;
+using jem::idx_t;
+using jem::util::Properties;
+using jive::Vector;
+using jive::app::Module;
+using jive::implict::SolverModule;
+using jive::implict::NonlinRunData;
+
+
+//-----------------------------------------------------------------------
+//   class DissArclenModule
+//-----------------------------------------------------------------------
+
+
+class DissArclenModule : public SolverModule
+{
+ public:
+
+  typedef DissArclenModule  Self;
+  typedef SolverModule      Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        MAX_ITER_PROP;
+  static const char*        PRECISION_PROP;
+  static const char*        SWITCH_ENERGY_PROP;
+  static const char*        DISS_INCR_PROP;
+
+  explicit                  DissArclenModule
+
+    ( const String&           name = "dissArclen" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  virtual void              advance
+
+    ( const Properties&       globdat );
+
+  virtual void              solve
+
+    ( const Properties&       info,
+      const Properties&       globdat );
+
+  virtual void              cancel
+
+    ( const Properties&       globdat );
+
+  virtual bool              commit
+
+    ( const Properties&       globdat );
+
+  virtual void              setPrecision
+
+    ( double                  eps );
+
+  virtual double            getPrecision  () const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~DissArclenModule  ();
+
+
+ private:
+
+  class                     Work_;
+
+  friend class              Work_;
+
+  bool                      solve_
+
+    ( Work_&                  work,
+      const Properties&       globdat );
+
+  void                      setMode_
+
+    ( bool                    arcl,
+      const Properties&       globdat );
+
+  double                    stepRatio_
+
+    ( const Properties&       globdat )      const;
+
+
+ private:
+
+  Ref<NonlinRunData>        rundat_;
+
+  idx_t                     maxIter_;
+  double                    precision_;
+
+  // switchEnergy_: dissipation in a step that triggers the switch to
+  // dissipation control; dissIncr_: dissipation per step at the
+  // initial step size (the dissipation of the switching step if zero)
+
+  double                    switchEnergy_;
+  double                    dissIncr_;
+
+  bool                      arcl_;
+  double                    dtau_;
+  double                    lastDiss_;
+
+};
+
+
+#endif
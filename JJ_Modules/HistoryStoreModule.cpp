@@ -0,0 +1,276 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Integration point history output in column stores. See
+ *  HistoryStoreModule.h for details.
+ *
+ */
+
+#include <jem/base/limits.h>
+#include <jive/util/Globdat.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "HistoryStoreModule.h"
+#include "OutputScheduleModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::newInstance;
+using jive::util::Globdat;
+
+
+//=======================================================================
+//   class HistoryStoreModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  HistoryStoreModule::TYPE_NAME       = "HistoryStore";
+const char*  HistoryStoreModule::PREFIX_PROP     = "prefix";
+const char*  HistoryStoreModule::INTERVAL_PROP   = "interval";
+const char*  HistoryStoreModule::CHUNK_SIZE_PROP = "chunkSize";
+const char*  HistoryStoreModule::COMPRESS_PROP   = "compress";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+HistoryStoreModule::HistoryStoreModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  prefix_    = "history";
+  interval_  = 1;
+  chunkSize_ = 1 << 20;
+  compress_  = false;
+  runCount_  = 0;
+}
+
+
+HistoryStoreModule::~HistoryStoreModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status HistoryStoreModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  close_ ();
+
+  model_    = Model::get ( globdat, getContext() );
+  frame_    = newInstance<OutputFrame> ();
+  runCount_ = 0;
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status HistoryStoreModule::run ( const Properties& globdat )
+{
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  runCount_++;
+
+  if ( ! OutputScheduleModule::isDue( runCount_, interval_, globdat ) )
+  {
+    return OK;
+  }
+
+  Properties  params;
+  double      t = 0.0;
+  int         i = 0;
+
+  globdat.find ( t, Globdat::TIME );
+  globdat.find ( i, Globdat::TIME_STEP );
+
+  frame_->clear ();
+
+  params.set ( SolverNames::OUTPUT_FRAME, frame_ );
+
+  model_->takeAction ( SolverNames::GET_OUTPUT_FRAME, params, globdat );
+
+  for ( idx_t ib = 0; ib < frame_->blockCount(); ib++ )
+  {
+    // Skip the extra blocks (coordinates, nodal averages).
+
+    if ( frame_->getBlockName(ib).find( '.' ) >= 0 )
+    {
+      continue;
+    }
+
+    getWriter_(ib).append ( i, t, frame_->getBlock( ib ) );
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void HistoryStoreModule::shutdown ( const Properties& globdat )
+{
+  close_ ();
+
+  model_ = NIL;
+  frame_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void HistoryStoreModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( prefix_,    PREFIX_PROP );
+    myProps.find ( interval_,  INTERVAL_PROP,
+                   1, maxOf( interval_ ) );
+    myProps.find ( chunkSize_, CHUNK_SIZE_PROP,
+                   1, maxOf( chunkSize_ ) );
+    myProps.find ( compress_,  COMPRESS_PROP );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void HistoryStoreModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( PREFIX_PROP,     prefix_    );
+  myConf.set ( INTERVAL_PROP,   interval_  );
+  myConf.set ( CHUNK_SIZE_PROP, chunkSize_ );
+  myConf.set ( COMPRESS_PROP,   compress_  );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> HistoryStoreModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   getWriter_
+//-----------------------------------------------------------------------
+
+// Returns the writer for a block of the frame; the file is created
+// when the model is seen for the first time.
+
+ColumnWriter& HistoryStoreModule::getWriter_ ( idx_t iblock )
+{
+  const String&  name = frame_->getBlockName ( iblock );
+
+  for ( idx_t i = 0; i < names_.size(); i++ )
+  {
+    if ( names_[i] == name )
+    {
+      return *writers_[i];
+    }
+  }
+
+  Ref<ColumnWriter>  w = newInstance<ColumnWriter> ();
+
+  w->open ( prefix_ + "_" + name + ".jjc",
+            frame_->getColNames ( iblock ),
+            frame_->getBlock    ( iblock ).size(0),
+            chunkSize_, compress_ );
+
+  names_  .pushBack ( name );
+  writers_.pushBack ( w    );
+
+  return *w;
+}
+
+
+//-----------------------------------------------------------------------
+//   close_
+//-----------------------------------------------------------------------
+
+
+void HistoryStoreModule::close_ ()
+{
+  for ( idx_t i = 0; i < writers_.size(); i++ )
+  {
+    writers_[i]->close ();
+  }
+
+  names_  .clear ();
+  writers_.clear ();
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareHistoryStoreModule
+//-----------------------------------------------------------------------
+
+
+void declareHistoryStoreModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( HistoryStoreModule::TYPE_NAME,
+                         & HistoryStoreModule::makeNew );
+}
@@ -0,0 +1,119 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module stores the integration point history of the models in
+ *  column stores (see ColumnStore.h), one file per model called
+ *  <prefix>_<model>.jjc, every interval runs. Each history variable is
+ *  a column, so one variable can be read over all steps without
+ *  reading the rest of the file.
+ *
+ *  The index of a file is written when the module shuts down. With an
+ *  OutputSchedule module only the steps it selects are stored.
+ *
+ */
+
+#ifndef HISTORY_STORE_MODULE_H
+#define HISTORY_STORE_MODULE_H
+
+#include <jem/util/Flex.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+
+#include "OutputFrame.h"
+#include "ColumnStore.h"
+
+using jem::Ref;
+using jem::String;
+using jem::util::Flex;
+using jem::util::Properties;
+using jive::app::Module;
+using jive::model::Model;
+
+
+//-----------------------------------------------------------------------
+//   class HistoryStoreModule
+//-----------------------------------------------------------------------
+
+
+class HistoryStoreModule : public Module
+{
+ public:
+
+  typedef HistoryStoreModule  Self;
+  typedef Module              Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        PREFIX_PROP;
+  static const char*        INTERVAL_PROP;
+  static const char*        CHUNK_SIZE_PROP;
+  static const char*        COMPRESS_PROP;
+
+  explicit                  HistoryStoreModule
+
+    ( const String&           name = "historyStore" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~HistoryStoreModule ();
+
+
+ private:
+
+  ColumnWriter&             getWriter_
+
+    ( idx_t                   iblock );
+
+  void                      close_        ();
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<OutputFrame>          frame_;
+
+  Flex<String>              names_;
+  Flex< Ref<ColumnWriter> > writers_;
+
+  String                    prefix_;
+  idx_t                     interval_;
+  idx_t                     chunkSize_;
+  bool                      compress_;
+  idx_t                     runCount_;
+
+};
+
+
+#endif
@@ -0,0 +1,707 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Implicit dynamics module for linear models. See LinDynModule.h for
+ *  details.
+ *
+ */
+
+#include <jem/base/limits.h>
+#include <jem/base/System.h>
+#include <jem/base/ArithmeticException.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/base/array/operators.h>
+#include <jem/util/Event.h>
+#include <jem/numeric/algebra/utilities.h>
+#include <jive/util/Globdat.h>
+#include <jive/util/utilities.h>
+#include <jive/algebra/DiagMatrixObject.h>
+#include <jive/algebra/LumpedMatrixBuilder.h>
+#include <jive/algebra/SparseMatrixBuilder.h>
+#include <jive/algebra/SparseMatrixExtension.h>
+#include <jive/model/Actions.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "LinDynModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::isTiny;
+using jem::newInstance;
+using jem::System;
+using jem::ArithmeticException;
+using jem::IllegalInputException;
+using jive::SparseMatrix;
+using jive::util::Globdat;
+using jive::algebra::SparseMatrixExt;
+using jive::model::Actions;
+using jive::model::ActionParams;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class LinDynModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  LinDynModule::TYPE_NAME           = "LinDyn";
+const char*  LinDynModule::DTIME_PROP          = "dtime";
+const char*  LinDynModule::BETA_PROP           = "beta";
+const char*  LinDynModule::GAMMA_PROP          = "gamma";
+const char*  LinDynModule::RHO_INF_PROP        = "rhoInf";
+const char*  LinDynModule::CHECK_INTERVAL_PROP = "checkInterval";
+const char*  LinDynModule::LIN_TOL_PROP        = "linTol";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+LinDynModule::LinDynModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  dtime_         = 1.0;
+  beta_          = 0.25;
+  gamma_         = 0.5;
+  rhoInf_        = -1.0;
+  checkInterval_ = 100;
+  linTol_        = 1.0e-6;
+  slaveCount_    = 0;
+  newSlaves_     = true;
+  dtFactor_      = 0.0;
+  cmass_         = 0.0;
+  cstiff_        = 0.0;
+  valid_         = false;
+
+  setScheme_ ();
+}
+
+
+LinDynModule::~LinDynModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status LinDynModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  using jem::util::connect;
+
+  const String  context = getContext ();
+
+  double        t = 0.0;
+  int           i = 0;
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_ = Model   ::get ( globdat, context );
+  dofs_  = DofSpace::get ( globdat, context );
+
+  valid_ = false;
+
+  connect ( dofs_->newSizeEvent,  this, &Self::invalidate_ );
+  connect ( dofs_->newOrderEvent, this, &Self::invalidate_ );
+
+  // The matrix must be factorized again when the set of prescribed
+  // DOFs changes.
+
+  cons_      = Constraints::get ( dofs_, globdat );
+  newSlaves_ = true;
+
+  connect ( cons_->newStructEvent, this, &Self::slavesChanged_ );
+
+  if ( ! globdat.find( t, Globdat::TIME ) )
+  {
+    globdat.set ( Globdat::TIME, t );
+  }
+
+  if ( ! globdat.find( i, Globdat::TIME_STEP ) )
+  {
+    globdat.set ( Globdat::TIME_STEP, i );
+  }
+
+  globdat.set ( Globdat::OLD_TIME,      t );
+  globdat.set ( Globdat::OLD_TIME_STEP, i );
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+// One step of the generalized-alpha method. With the predictor
+//
+//   up = u0 + dt v0 + dt^2 (0.5 - beta) a0
+//
+// the new displacements follow from
+//
+//   Keff u = (1 - alphaF) f + alphaF (f0 - K u0)
+//            + M (cmass up - alphaM a0)
+//
+// with Keff = cmass M + (1 - alphaF) K and cmass = (1 - alphaM) /
+// (beta dt^2); the accelerations and velocities are then updated with
+// the Newmark formulas.
+
+Module::Status LinDynModule::run ( const Properties& globdat )
+{
+  using jive::util::setSlaveDofs;
+  using jive::model::STATE0;
+  using jive::model::STATE1;
+  using jive::model::STATE2;
+
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  if ( ! valid_ )
+  {
+    restart_ ( globdat );
+  }
+
+  const idx_t   dofCount = mass_.size ();
+  const double  dt       = dtime_;
+  const double  rbdt2    = 1.0 / (newBeta_ * dt * dt);
+
+  Vector        u0, u1, v0, a0;
+
+  double        t;
+  int           i;
+
+
+  globdat.get ( t, Globdat::TIME );
+  globdat.get ( i, Globdat::TIME_STEP );
+
+  globdat.set ( Globdat::OLD_TIME,      t );
+  globdat.set ( Globdat::OLD_TIME_STEP, i );
+  globdat.set ( Globdat::TIME,          t + dt );
+  globdat.set ( Globdat::TIME_STEP,     i + 1 );
+
+  // Get the prescribed values and the external forces at the end of
+  // the step.
+
+  model_->takeAction ( Actions::GET_CONSTRAINTS, params_, globdat );
+
+  if ( dt != dtFactor_ || newSlaves_ )
+  {
+    factor_ ();
+  }
+
+  fext_ = 0.0;
+
+  model_->takeAction ( Actions::GET_EXT_VECTOR, params_, globdat );
+
+  StateVector::get    ( u0, STATE0, dofs_, globdat );
+  StateVector::getOld ( u1, STATE0, dofs_, globdat );
+  StateVector::get    ( v0, STATE1, dofs_, globdat );
+  StateVector::get    ( a0, STATE2, dofs_, globdat );
+
+  // Assemble the right hand side; tmp_ holds K u0, then the
+  // prescribed values.
+
+  stiff_->matmul ( tmp_, u0 );
+
+  u1 = u0 + dt * v0 + (dt * dt * (0.5 - newBeta_)) * a0;
+
+  rhs_ = (1.0 - alphaF_) * fext_ + alphaF_ * (fext0_ - tmp_) +
+         mass_ * (cmass_ * u1 - alphaM_ * a0);
+
+  // Move the contribution of the prescribed DOFs to the right hand
+  // side.
+
+  if ( slaveCount_ > 0 )
+  {
+    Vector  kw ( dofCount );
+
+    tmp_ = 0.0;
+
+    setSlaveDofs ( tmp_, *cons_ );
+
+    stiff_->matmul ( kw, tmp_ );
+
+    rhs_ -= cstiff_ * kw + cmass_ * mass_ * tmp_;
+  }
+
+  fext0_ = fext_;
+
+  // Solve and update; u1 still holds the predictor. The old state
+  // vector gets the displacements at the start of the step.
+
+  lu_.solve    ( tmp_, rhs_ );
+  setSlaveDofs ( tmp_, *cons_ );
+
+  rhs_ = a0;
+  a0   = (tmp_ - u1) * rbdt2;
+  v0  += dt * ((1.0 - newGamma_) * rhs_ + newGamma_ * a0);
+  u1   = u0;
+  u0   = tmp_;
+
+  if ( checkInterval_ > 0 && (i + 1) % checkInterval_ == 0 )
+  {
+    checkLinear_ ( globdat );
+  }
+
+  model_->takeAction ( Actions::COMMIT, params_, globdat );
+
+  System::out() << "on time: " << t << " in step: " << i << "\n\n";
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void LinDynModule::shutdown ( const Properties& globdat )
+{
+  model_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void LinDynModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( dtime_,  DTIME_PROP,   1.0e-20, 1.0e20 );
+    myProps.find ( beta_,   BETA_PROP,    1.0e-20, 0.5    );
+    myProps.find ( gamma_,  GAMMA_PROP,   0.0,     1.0    );
+    myProps.find ( rhoInf_, RHO_INF_PROP, 0.0,     1.0    );
+
+    myProps.find ( checkInterval_, CHECK_INTERVAL_PROP,
+                   0,              maxOf( checkInterval_ ) );
+    myProps.find ( linTol_,        LIN_TOL_PROP, 0.0, 1.0 );
+
+    setScheme_ ();
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void LinDynModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( DTIME_PROP, dtime_ );
+  myConf.set ( BETA_PROP,  beta_  );
+  myConf.set ( GAMMA_PROP, gamma_ );
+
+  myConf.set ( CHECK_INTERVAL_PROP, checkInterval_ );
+  myConf.set ( LIN_TOL_PROP,        linTol_        );
+
+  if ( rhoInf_ >= 0.0 )
+  {
+    myConf.set ( RHO_INF_PROP, rhoInf_ );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> LinDynModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   restart_
+//-----------------------------------------------------------------------
+
+// Checks that the model is linear, assembles the stiffness matrix and
+// the lumped mass matrix, and computes the initial accelerations.
+
+void LinDynModule::restart_ ( const Properties& globdat )
+{
+  using jive::algebra::LumpedMatrixBuilder;
+  using jive::algebra::SparseMatrixBuilder;
+  using jive::model::STATE0;
+  using jive::model::STATE2;
+
+  const String  context  = getContext      ();
+  const idx_t   dofCount = dofs_->dofCount ();
+
+  Ref<SparseMatrixBuilder>  kbuilder;
+  Ref<LumpedMatrixBuilder>  mbuilder;
+
+  Properties    params;
+  Vector        u0, a0;
+
+  bool          linear   = true;
+
+
+  params.set ( SolverNames::LINEAR, linear );
+
+  if ( ! model_->takeAction( SolverNames::CHECK_LINEAR, params, globdat ) )
+  {
+    linear = false;
+  }
+  else
+  {
+    params.get ( linear, SolverNames::LINEAR );
+  }
+
+  if ( ! linear )
+  {
+    throw IllegalInputException (
+      context,
+      "the model is not linear; use an iterative dynamics module"
+    );
+  }
+
+  fext0_.resize ( dofCount );
+  fext_ .resize ( dofCount );
+  rhs_  .resize ( dofCount );
+  tmp_  .resize ( dofCount );
+
+  // Assemble the stiffness matrix; the internal force vector is not
+  // used.
+
+  kbuilder = newInstance<SparseMatrixBuilder> ( "stiffness" );
+
+  kbuilder->setToZero ();
+
+  params.clear ();
+  params.set   ( ActionParams::MATRIX0,    kbuilder );
+  params.set   ( ActionParams::INT_VECTOR, rhs_     );
+
+  rhs_ = 0.0;
+
+  model_->takeAction ( Actions::GET_MATRIX0, params, globdat );
+
+  kbuilder->updateMatrix ();
+
+  stiff_ = kbuilder->getMatrix ();
+
+  // Assemble the lumped mass matrix.
+
+  mbuilder = newInstance<LumpedMatrixBuilder> ();
+
+  mbuilder->setOptions ( 0 );
+  mbuilder->setSize    ( dofCount );
+  mbuilder->clear      ();
+
+  params.clear ();
+  params.set   ( ActionParams::MATRIX2, mbuilder );
+
+  model_->takeAction ( Actions::GET_MATRIX2, params, globdat );
+
+  mbuilder->updateMatrix ();
+
+  mass_.resize ( dofCount );
+
+  mass_ = mbuilder->getDiagMatrix()->getValues ();
+
+  for ( idx_t i = 0; i < dofCount; i++ )
+  {
+    if ( isTiny( mass_[i] ) )
+    {
+      throw ArithmeticException (
+        context,
+        "singular mass matrix"
+      );
+    }
+  }
+
+  // Get the constraints and the external forces at the current time.
+
+  params_.clear ();
+  params_.set   ( ActionParams::CONSTRAINTS, cons_ );
+  params_.set   ( ActionParams::EXT_VECTOR,  fext_ );
+
+  model_->takeAction ( Actions::GET_CONSTRAINTS, params_, globdat );
+
+  fext_ = 0.0;
+
+  model_->takeAction ( Actions::GET_EXT_VECTOR, params_, globdat );
+
+  fext0_ = fext_;
+
+  // Initial accelerations from equilibrium; they are zero at the
+  // prescribed DOFs.
+
+  StateVector::get ( u0, STATE0, dofs_, globdat );
+  StateVector::get ( a0, STATE2, dofs_, globdat );
+
+  stiff_->matmul ( tmp_, u0 );
+
+  a0 = (fext0_ - tmp_) / mass_;
+
+  IdxVector  slaves = cons_->getSlaveDofs ();
+
+  for ( idx_t i = 0; i < slaves.size(); i++ )
+  {
+    a0[slaves[i]] = 0.0;
+  }
+
+  dtFactor_ = 0.0;
+  valid_    = true;
+}
+
+
+//-----------------------------------------------------------------------
+//   invalidate_
+//-----------------------------------------------------------------------
+
+
+void LinDynModule::invalidate_ ()
+{
+  valid_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   slavesChanged_
+//-----------------------------------------------------------------------
+
+
+void LinDynModule::slavesChanged_ ()
+{
+  newSlaves_ = true;
+}
+
+
+//-----------------------------------------------------------------------
+//   setScheme_
+//-----------------------------------------------------------------------
+
+// Sets the parameters of the generalized-alpha method from rhoInf, or
+// those of the Newmark method (alphaM = alphaF = 0) if rhoInf is not
+// given.
+
+void LinDynModule::setScheme_ ()
+{
+  if ( rhoInf_ >= 0.0 )
+  {
+    const double  g = 1.0 / (rhoInf_ + 1.0);
+
+    alphaM_   = (2.0 * rhoInf_ - 1.0) * g;
+    alphaF_   = rhoInf_ * g;
+    newGamma_ = 0.5 - alphaM_ + alphaF_;
+    newBeta_  = 0.25 * (1.0 - alphaM_ + alphaF_) *
+                       (1.0 - alphaM_ + alphaF_);
+  }
+  else
+  {
+    alphaM_   = 0.0;
+    alphaF_   = 0.0;
+    newBeta_  = beta_;
+    newGamma_ = gamma_;
+  }
+
+  dtFactor_ = 0.0;
+}
+
+
+//-----------------------------------------------------------------------
+//   factor_
+//-----------------------------------------------------------------------
+
+// Factorizes the effective stiffness matrix for the current time step
+// and constraints; the prescribed DOFs are excluded.
+
+void LinDynModule::factor_ ()
+{
+  const String  context  = getContext ();
+  const double  dt       = dtime_;
+
+  SparseMatrixExt*  sx   = stiff_->getExtension<SparseMatrixExt> ();
+
+  if ( sx == 0 )
+  {
+    throw IllegalInputException (
+      context,
+      "stiffness matrix does not support the sparse matrix extension"
+    );
+  }
+
+  SparseMatrix  keff     = sx->toSparseMatrix().clone ();
+
+  IdxVector     offsets  = keff.getRowOffsets    ();
+  IdxVector     indices  = keff.getColumnIndices ();
+  Vector        values   = keff.getValues        ();
+
+  const idx_t   dofCount = keff.size (0);
+
+
+  cmass_  = (1.0 - alphaM_) / (newBeta_ * dt * dt);
+  cstiff_ = 1.0 - alphaF_;
+
+  values *= cstiff_;
+
+  for ( idx_t i = 0; i < dofCount; i++ )
+  {
+    idx_t  j = offsets[i];
+
+    while ( j < offsets[i + 1] && indices[j] != i )
+    {
+      j++;
+    }
+
+    if ( j == offsets[i + 1] )
+    {
+      throw ArithmeticException (
+        context,
+        "stiffness matrix has no diagonal entry"
+      );
+    }
+
+    values[j] += cmass_ * mass_[i];
+  }
+
+  // Mask the prescribed DOFs.
+
+  mask_.resize ( dofCount );
+
+  mask_       = false;
+  slaveCount_ = cons_->slaveDofCount ();
+  newSlaves_  = false;
+
+  for ( idx_t idof = 0; idof < dofCount; idof++ )
+  {
+    if ( cons_->isSlaveDof( idof ) )
+    {
+      if ( cons_->masterDofCount( idof ) > 0 )
+      {
+        throw IllegalInputException (
+          context,
+          "constraints with master DOFs are not supported"
+        );
+      }
+
+      mask_[idof] = true;
+    }
+  }
+
+  if ( ! lu_.factor( keff, mask_ ) )
+  {
+    throw ArithmeticException (
+      context,
+      "factorization of the effective stiffness matrix failed"
+    );
+  }
+
+  dtFactor_ = dt;
+
+  System::info( myName_ ) << myName_ << " : factorized the effective "
+                          << "stiffness matrix for dtime = " << dt
+                          << " (profile size " << lu_.profileSize()
+                          << ")\n";
+}
+
+
+//-----------------------------------------------------------------------
+//   checkLinear_
+//-----------------------------------------------------------------------
+
+// Compares the internal forces of the model for the displacements in
+// the state vector with K u. A model that does not answer CHECK_LINEAR
+// is only caught here.
+
+void LinDynModule::checkLinear_ ( const Properties& globdat )
+{
+  using jem::numeric::norm2;
+  using jive::model::STATE0;
+
+  const idx_t   dofCount = mass_.size ();
+
+  Properties    params;
+
+  Vector        u0;
+  Vector        fint ( dofCount );
+  Vector        ku   ( dofCount );
+
+
+  StateVector::get ( u0, STATE0, dofs_, globdat );
+
+  fint = 0.0;
+
+  params.set ( ActionParams::INT_VECTOR, fint );
+
+  model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+
+  stiff_->matmul ( ku, u0 );
+
+  const double  scale = jem::max ( norm2( fint ), norm2( ku ) );
+  const double  error = norm2 ( fint - ku );
+
+  if ( scale > 0.0 && error > linTol_ * scale )
+  {
+    throw IllegalInputException (
+      getContext (),
+      String::format (
+        "the internal forces differ from K u by %.2e (relative); the "
+        "model is not linear, use an iterative dynamics module",
+        error / scale
+      )
+    );
+  }
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareLinDynModule
+//-----------------------------------------------------------------------
+
+
+void declareLinDynModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( LinDynModule::TYPE_NAME,
+                         & LinDynModule::makeNew );
+}
@@ -0,0 +1,185 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module implements implicit time integration for linear models
+ *  with the generalized-alpha method (Chung and Hulbert), which contains
+ *  the Newmark method as a special case. For a linear model the
+ *  effective stiffness matrix
+ *
+ *    (1 - alphaM) / (beta dt^2) M + (1 - alphaF) K
+ *
+ *  only changes with the time step, so it is factorized once and every
+ *  step is one right hand side and one back substitution. The matrix is
+ *  factorized again when the time step or the set of constrained DOFs
+ *  changes (the newStructEvent of the constraints).
+ *
+ *  The module asks the model if it is linear (CHECK_LINEAR); nonlinear
+ *  models should use an iterative dynamics module instead. A model
+ *  that does not answer CHECK_LINEAR, for instance next to a SolidModel
+ *  in a MultiModel, passes this test. Every checkInterval steps the
+ *  internal forces of the model are therefore compared with K u, and
+ *  the module stops if they differ by more than the relative tolerance
+ *  linTol. The check costs one assembly; checkInterval = 0 disables it.
+ *
+ *  The mass matrix is lumped, as in the explicit modules, and the
+ *  constraints may not have master DOFs.
+ *
+ *  With rhoInf (the spectral radius at infinite frequency, 0 to 1) the
+ *  generalized-alpha parameters are set for optimal dissipation;
+ *  without it the Newmark method with beta and gamma is used.
+ *
+ */
+
+#ifndef LIN_DYN_MODULE_H
+#define LIN_DYN_MODULE_H
+
+#include <jive/Array.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+#include <jive/util/Constraints.h>
+#include <jive/algebra/AbstractMatrix.h>
+
+#include "SkylineLU.h"
+
+using jem::Ref;
+using jem::String;
+using jem::idx_t;
+using jem::util::Properties;
+using jive::Vector;
+using jive::BoolVector;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+using jive::util::Constraints;
+using jive::algebra::AbstractMatrix;
+
+
+//-----------------------------------------------------------------------
+//   class LinDynModule
+//-----------------------------------------------------------------------
+
+
+class LinDynModule : public Module
+{
+ public:
+
+  typedef LinDynModule      Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        DTIME_PROP;
+  static const char*        BETA_PROP;
+  static const char*        GAMMA_PROP;
+  static const char*        RHO_INF_PROP;
+  static const char*        CHECK_INTERVAL_PROP;
+  static const char*        LIN_TOL_PROP;
+
+  explicit                  LinDynModule
+
+    ( const String&           name = "linDyn" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~LinDynModule    ();
+
+
+ private:
+
+  void                      restart_
+
+    ( const Properties&       globdat );
+
+  void                      invalidate_     ();
+
+  void                      slavesChanged_  ();
+
+  void                      setScheme_      ();
+
+  void                      factor_         ();
+
+  void                      checkLinear_
+
+    ( const Properties&       globdat );
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<Constraints>          cons_;
+
+  // stiffness matrix, lumped mass and the factor of the effective
+  // stiffness matrix for the time step dtFactor_ (zero if none)
+
+  Ref<AbstractMatrix>       stiff_;
+  Vector                    mass_;
+  SkylineLU<double>         lu_;
+  BoolVector                mask_;
+  idx_t                     slaveCount_;
+  bool                      newSlaves_;
+  double                    dtFactor_;
+  double                    cmass_;
+  double                    cstiff_;
+
+  // external force vector of the previous step and work vectors
+
+  Vector                    fext0_;
+  Vector                    fext_;
+  Vector                    rhs_;
+  Vector                    tmp_;
+  Properties                params_;
+
+  double                    dtime_;
+  double                    beta_;
+  double                    gamma_;
+  double                    rhoInf_;
+  int                       checkInterval_;
+  double                    linTol_;
+
+  // parameters of the scheme used (see setScheme_)
+
+  double                    alphaM_;
+  double                    alphaF_;
+  double                    newBeta_;
+  double                    newGamma_;
+
+  bool                      valid_;
+
+};
+
+
+#endif
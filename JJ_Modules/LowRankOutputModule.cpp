@@ -0,0 +1,378 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Low-rank snapshot output. See LowRankOutputModule.h for details.
+ *
+ */
+
+#include <jem/base/limits.h>
+#include <jem/base/System.h>
+#include <jem/base/IllegalInputException.h>
+#include <jive/util/Globdat.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "LowRankOutputModule.h"
+#include "OutputScheduleModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::ALL;
+using jem::newInstance;
+using jem::System;
+using jem::IllegalInputException;
+using jive::util::Globdat;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class LowRankOutputModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  LowRankOutputModule::TYPE_NAME           = "LowRankOutput";
+const char*  LowRankOutputModule::FILE_PROP           = "file";
+const char*  LowRankOutputModule::INTERVAL_PROP       = "interval";
+const char*  LowRankOutputModule::FLUSH_INTERVAL_PROP = "flushInterval";
+const char*  LowRankOutputModule::TOLERANCE_PROP      = "tolerance";
+const char*  LowRankOutputModule::MAX_RANK_PROP       = "maxRank";
+const char*  LowRankOutputModule::HISTORY_PROP        = "history";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+LowRankOutputModule::LowRankOutputModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  fileName_      = "snapshots.jjl";
+  interval_      = 1;
+  flushInterval_ = 10;
+  tol_           = 1.0e-6;
+  maxRank_       = 100;
+  history_       = false;
+  runCount_      = 0;
+  frameCount_    = 0;
+}
+
+
+LowRankOutputModule::~LowRankOutputModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status LowRankOutputModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_  = Model   ::get ( globdat, context );
+  dofs_   = DofSpace::get ( globdat, context );
+  frame_  = newInstance<OutputFrame>   ();
+  writer_ = newInstance<LowRankWriter> ();
+
+  names_ .clear ();
+  fields_.clear ();
+
+  runCount_   = 0;
+  frameCount_ = 0;
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status LowRankOutputModule::run ( const Properties& globdat )
+{
+  using jive::model::STATE0;
+
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  runCount_++;
+
+  if ( ! OutputScheduleModule::isDue( runCount_, interval_, globdat ) )
+  {
+    return OK;
+  }
+
+  double  t = 0.0;
+  int     i = 0;
+  Vector  state;
+
+  globdat.find ( t, Globdat::TIME );
+  globdat.find ( i, Globdat::TIME_STEP );
+
+  StateVector::get ( state, STATE0, dofs_, globdat );
+
+  addSnapshot_ ( "state", state );
+
+  if ( history_ )
+  {
+    Properties  params;
+
+    frame_->clear ();
+
+    params.set ( SolverNames::OUTPUT_FRAME, frame_ );
+
+    model_->takeAction ( SolverNames::GET_OUTPUT_FRAME, params, globdat );
+
+    for ( idx_t ib = 0; ib < frame_->blockCount(); ib++ )
+    {
+      const String&  name = frame_->getBlockName ( ib );
+
+      // Skip the extra blocks (coordinates, nodal averages).
+
+      if ( name.find( '.' ) >= 0 )
+      {
+        continue;
+      }
+
+      const Matrix&        block    = frame_->getBlock    ( ib );
+      const StringVector&  colNames = frame_->getColNames ( ib );
+
+      // Each history variable gets its own decomposition; in a common
+      // one the variables with small values (strains next to stresses)
+      // would be truncated away.
+
+      for ( idx_t j = 0; j < block.size(1); j++ )
+      {
+        addSnapshot_ ( name + "." + colNames[j], block(ALL,j) );
+      }
+    }
+  }
+
+  writer_->addFrame ( i, t );
+
+  frameCount_++;
+
+  if ( flushInterval_ > 0 && frameCount_ % flushInterval_ == 0 )
+  {
+    write_ ();
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void LowRankOutputModule::shutdown ( const Properties& globdat )
+{
+  // Skip the write if the last frame has just been flushed.
+
+  if ( writer_ != NIL && ( flushInterval_ == 0 ||
+                           frameCount_ % flushInterval_ != 0 ) )
+  {
+    write_ ();
+  }
+
+  model_  = NIL;
+  dofs_   = NIL;
+  frame_  = NIL;
+  writer_ = NIL;
+
+  names_ .clear ();
+  fields_.clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void LowRankOutputModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( fileName_,      FILE_PROP );
+    myProps.find ( interval_,      INTERVAL_PROP,
+                   1, maxOf( interval_ ) );
+    myProps.find ( flushInterval_, FLUSH_INTERVAL_PROP,
+                   0, maxOf( flushInterval_ ) );
+    myProps.find ( tol_,           TOLERANCE_PROP,
+                   0.0, 1.0 );
+    myProps.find ( maxRank_,       MAX_RANK_PROP,
+                   1, maxOf( maxRank_ ) );
+    myProps.find ( history_,       HISTORY_PROP );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void LowRankOutputModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( FILE_PROP,           fileName_      );
+  myConf.set ( INTERVAL_PROP,       interval_      );
+  myConf.set ( FLUSH_INTERVAL_PROP, flushInterval_ );
+  myConf.set ( TOLERANCE_PROP,      tol_           );
+  myConf.set ( MAX_RANK_PROP,       maxRank_       );
+  myConf.set ( HISTORY_PROP,        history_       );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> LowRankOutputModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   addSnapshot_
+//-----------------------------------------------------------------------
+
+// Adds the values of a field in the current frame to its SVD. A field
+// is created, and passed to the writer, in the first frame; all fields
+// must be present, with the same size, in every frame.
+
+void LowRankOutputModule::addSnapshot_
+
+  ( const String&  name,
+    const Vector&  values )
+
+{
+  idx_t  k = 0;
+
+  for ( ; k < names_.size(); k++ )
+  {
+    if ( names_[k] == name )
+    {
+      break;
+    }
+  }
+
+  if ( k == names_.size() )
+  {
+    if ( frameCount_ > 0 )
+    {
+      throw IllegalInputException (
+        getContext (),
+        String::format ( "field %s appeared after the first frame",
+                         name )
+      );
+    }
+
+    names_ .pushBack ( name );
+    fields_.pushBack (
+      newInstance<IncrementalSVD> ( values.size(), tol_, maxRank_ )
+    );
+
+    writer_->addField ( name, 1, fields_[k] );
+  }
+
+  if ( values.size() != fields_[k]->rowCount() ||
+       fields_[k]->columnCount() != frameCount_ )
+  {
+    throw IllegalInputException (
+      getContext (),
+      String::format ( "the size of field %s has changed", name )
+    );
+  }
+
+  fields_[k]->addColumn ( values );
+}
+
+
+//-----------------------------------------------------------------------
+//   write_
+//-----------------------------------------------------------------------
+
+// Writes the frames so far. The writer replaces the file only when the
+// new one is complete, so a file is always readable.
+
+void LowRankOutputModule::write_ ()
+{
+  idx_t  full   = 0;
+  idx_t  stored = 0;
+
+  for ( idx_t k = 0; k < fields_.size(); k++ )
+  {
+    const IncrementalSVD&  svd  = *fields_[k];
+    const idx_t            rank = svd.rank ();
+
+    full   += svd.rowCount() * frameCount_;
+    stored += rank * (1 + svd.rowCount() + frameCount_);
+  }
+
+  writer_->write ( fileName_ );
+
+  System::info( myName_ ) << myName_ << " : wrote " << frameCount_
+                          << " frames to " << fileName_ << ", "
+                          << stored << " of " << full << " values\n";
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareLowRankOutputModule
+//-----------------------------------------------------------------------
+
+
+void declareLowRankOutputModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( LowRankOutputModule::TYPE_NAME,
+                         & LowRankOutputModule::makeNew );
+}
@@ -0,0 +1,139 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module stores the state vector and, optionally, the
+ *  integration point history of the models as low-rank snapshots (see
+ *  LowRankStore.h). Every interval runs (or when the OutputSchedule
+ *  module asks for a frame) each field is added to an incremental SVD,
+ *  so only a basis and a few coefficients per frame are kept. Since
+ *  the steps of a quasi-static run are strongly correlated, the rank
+ *  stays small and the file is much smaller than the full snapshots.
+ *  Each history variable is a field of its own, <model>.<variable>, so
+ *  that the variables are truncated relative to their own magnitude.
+ *
+ *  Singular values below tolerance times the largest are dropped, so
+ *  tolerance is roughly the relative error of a reconstructed frame.
+ *  The rank is also limited to maxRank. The file is written every
+ *  flushInterval frames (only at the end if zero) and when the module
+ *  shuts down; each write replaces the whole file, as the basis
+ *  changes with every frame. The number of DOFs and integration points
+ *  must not change during the run.
+ *
+ */
+
+#ifndef LOW_RANK_OUTPUT_MODULE_H
+#define LOW_RANK_OUTPUT_MODULE_H
+
+#include <jem/util/Flex.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+
+#include "OutputFrame.h"
+#include "IncrementalSVD.h"
+#include "LowRankStore.h"
+
+using jem::Ref;
+using jem::String;
+using jem::util::Flex;
+using jem::util::Properties;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+
+
+//-----------------------------------------------------------------------
+//   class LowRankOutputModule
+//-----------------------------------------------------------------------
+
+
+class LowRankOutputModule : public Module
+{
+ public:
+
+  typedef LowRankOutputModule  Self;
+  typedef Module               Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        FILE_PROP;
+  static const char*        INTERVAL_PROP;
+  static const char*        FLUSH_INTERVAL_PROP;
+  static const char*        TOLERANCE_PROP;
+  static const char*        MAX_RANK_PROP;
+  static const char*        HISTORY_PROP;
+
+  explicit                  LowRankOutputModule
+
+    ( const String&           name = "lowRankOutput" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~LowRankOutputModule ();
+
+
+ private:
+
+  void                      addSnapshot_
+
+    ( const String&           name,
+      const Vector&           values );
+
+  void                      write_        ();
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<OutputFrame>          frame_;
+  Ref<LowRankWriter>        writer_;
+
+  Flex<String>              names_;
+  Flex< Ref<IncrementalSVD> >  fields_;
+
+  String                    fileName_;
+  idx_t                     interval_;
+  idx_t                     flushInterval_;
+  double                    tol_;
+  idx_t                     maxRank_;
+  bool                      history_;
+  idx_t                     runCount_;
+  idx_t                     frameCount_;
+
+};
+
+
+#endif
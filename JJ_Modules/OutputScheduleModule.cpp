@@ -0,0 +1,369 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Event driven output scheduling. See OutputScheduleModule.h for
+ *  details.
+ *
+ */
+
+#include <time.h>
+#include <cmath>
+
+#include <jem/base/limits.h>
+#include <jem/base/System.h>
+#include <jem/numeric/algebra/utilities.h>
+#include <jive/Array.h>
+#include <jive/util/Globdat.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "OutputScheduleModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::newInstance;
+using jem::System;
+using jem::numeric::norm2;
+using jive::Vector;
+using jive::util::Globdat;
+
+
+//=======================================================================
+//   class OutputScheduleModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  OutputScheduleModule::TYPE_NAME            = "OutputSchedule";
+const char*  OutputScheduleModule::INTERVAL_PROP        = "interval";
+const char*  OutputScheduleModule::LOAD_SCALE_STEP_PROP = "loadScaleStep";
+const char*  OutputScheduleModule::NEW_LOADING_PROP     = "newLoading";
+const char*  OutputScheduleModule::LOAD_DISP_PROP       = "loadDisp";
+const char*  OutputScheduleModule::WALL_INTERVAL_PROP   = "wallInterval";
+const char*  OutputScheduleModule::DENSE_STEPS_PROP     = "denseSteps";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+OutputScheduleModule::OutputScheduleModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  interval_      = 0;
+  loadScaleStep_ = 0.0;
+  newLoading_    = 0;
+  wallInterval_  = 0.0;
+  denseSteps_    = 0;
+
+  runCount_      = 0;
+  denseLeft_     = 0;
+  lastScale_     = 0.0;
+  lastWall_      = 0.0;
+  prevLoad_      = 0.0;
+  rising_        = false;
+}
+
+
+OutputScheduleModule::~OutputScheduleModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status OutputScheduleModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_ = Model::get ( globdat, getContext() );
+
+  runCount_  = 0;
+  denseLeft_ = 0;
+  lastScale_ = 0.0;
+  lastWall_  = wallTime_ ();
+  prevLoad_  = 0.0;
+  rising_    = false;
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status OutputScheduleModule::run ( const Properties& globdat )
+{
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  Properties   vars   = Globdat::getVariables ( globdat );
+  double       scale  = 0.0;
+  const double now    = wallTime_ ();
+  const char*  reason = checkEvents_ ( globdat );
+
+  runCount_++;
+
+  if ( loadScaleStep_ > 0.0 )
+  {
+    Properties  params;
+
+    model_->takeAction ( SolverNames::GET_LOAD_SCALE, params, globdat );
+    params .find       ( scale, SolverNames::LOAD_SCALE );
+  }
+
+  if ( reason )
+  {
+    denseLeft_ = denseSteps_;
+  }
+  else if ( runCount_ == 1 )
+  {
+    reason = "first step";
+  }
+  else if ( denseLeft_ > 0 )
+  {
+    reason = "after event";
+
+    denseLeft_--;
+  }
+  else if ( interval_ > 0 && runCount_ % interval_ == 0 )
+  {
+    reason = "interval";
+  }
+  else if ( loadScaleStep_ > 0.0 &&
+            std::fabs( scale - lastScale_ ) >= loadScaleStep_ )
+  {
+    reason = "load scale";
+  }
+  else if ( wallInterval_ > 0.0 && now - lastWall_ >= wallInterval_ )
+  {
+    reason = "wall time";
+  }
+
+  vars.set ( SolverNames::WRITE_OUTPUT, reason != 0 );
+
+  if ( reason )
+  {
+    lastScale_ = scale;
+    lastWall_  = now;
+
+    System::info( myName_ ) << myName_ << " : output at run "
+                            << runCount_ << " (" << reason << ")\n";
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void OutputScheduleModule::shutdown ( const Properties& globdat )
+{
+  model_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void OutputScheduleModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( interval_,      INTERVAL_PROP,
+                   0, maxOf( interval_ ) );
+    myProps.find ( loadScaleStep_, LOAD_SCALE_STEP_PROP,
+                   0.0, maxOf( loadScaleStep_ ) );
+    myProps.find ( newLoading_,    NEW_LOADING_PROP,
+                   0, maxOf( newLoading_ ) );
+    myProps.find ( loadDisp_,      LOAD_DISP_PROP );
+    myProps.find ( wallInterval_,  WALL_INTERVAL_PROP,
+                   0.0, maxOf( wallInterval_ ) );
+    myProps.find ( denseSteps_,    DENSE_STEPS_PROP,
+                   0, maxOf( denseSteps_ ) );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void OutputScheduleModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( INTERVAL_PROP,        interval_      );
+  myConf.set ( LOAD_SCALE_STEP_PROP, loadScaleStep_ );
+  myConf.set ( NEW_LOADING_PROP,     newLoading_    );
+  myConf.set ( LOAD_DISP_PROP,       loadDisp_      );
+  myConf.set ( WALL_INTERVAL_PROP,   wallInterval_  );
+  myConf.set ( DENSE_STEPS_PROP,     denseSteps_    );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> OutputScheduleModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   isDue
+//-----------------------------------------------------------------------
+
+// Returns true if an output module should write in this run: the
+// decision of the schedule if there is one, and otherwise every
+// interval runs.
+
+bool OutputScheduleModule::isDue
+
+  ( idx_t              runCount,
+    idx_t              interval,
+    const Properties&  globdat )
+
+{
+  Properties  vars  = Globdat::getVariables ( globdat );
+  bool        write = false;
+
+  if ( vars.find( write, SolverNames::WRITE_OUTPUT ) )
+  {
+    return write;
+  }
+
+  return ( runCount % interval == 0 );
+}
+
+
+//-----------------------------------------------------------------------
+//   checkEvents_
+//-----------------------------------------------------------------------
+
+// Checks the criteria that trigger dense output and returns the reason
+// for a frame, or zero. All criteria are checked in every run to keep
+// their state up to date.
+
+const char* OutputScheduleModule::checkEvents_
+
+  ( const Properties&  globdat )
+
+{
+  const char*  reason = 0;
+
+  if ( newLoading_ > 0 )
+  {
+    // The models add to the count on commit; it is reset here so that
+    // it covers one step.
+
+    Properties  vars  = Globdat::getVariables ( globdat );
+    idx_t       count = 0;
+
+    vars.find ( count, SolverNames::NEW_LOADING );
+    vars.set  ( SolverNames::NEW_LOADING, (idx_t) 0 );
+
+    if ( count >= newLoading_ )
+    {
+      reason = "new loading points";
+    }
+  }
+
+  if ( loadDisp_.size() > 0 )
+  {
+    Properties  ldVars = Globdat::getVariables ( loadDisp_, globdat );
+    Vector      load;
+
+    if ( ldVars.find( load, "load" ) )
+    {
+      const double  f = norm2 ( load );
+
+      if ( rising_ && f < prevLoad_ && ! reason )
+      {
+        reason = "load peak";
+      }
+
+      rising_   = ( f > prevLoad_ );
+      prevLoad_ = f;
+    }
+  }
+
+  return reason;
+}
+
+
+//-----------------------------------------------------------------------
+//   wallTime_
+//-----------------------------------------------------------------------
+
+
+double OutputScheduleModule::wallTime_ ()
+{
+  struct timespec  ts;
+
+  clock_gettime ( CLOCK_MONOTONIC, &ts );
+
+  return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareOutputScheduleModule
+//-----------------------------------------------------------------------
+
+
+void declareOutputScheduleModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( OutputScheduleModule::TYPE_NAME,
+                         & OutputScheduleModule::makeNew );
+}
@@ -0,0 +1,144 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module decides after each step if the output modules should
+ *  write a frame, so that the output is dense around the events of
+ *  interest and sparse elsewhere. A frame is written in the first run
+ *  and when one of the following criteria is met (each is disabled
+ *  when zero or empty):
+ *
+ *    interval       every interval runs
+ *    loadScaleStep  the load scale (GET_LOAD_SCALE) has changed by
+ *                   this much since the last frame
+ *    newLoading     at least this many integration points started
+ *                   loading (yielding or damaging) in the step, as
+ *                   reported by the models on commit (NEW_LOADING)
+ *    loadDisp       name of a LoadDisp model: a frame is written when
+ *                   the norm of its load has passed a maximum
+ *    wallInterval   this many seconds have passed since the last frame
+ *
+ *  After a frame triggered by new loading points or a load peak, the
+ *  next denseSteps runs are written as well.
+ *
+ *  The decision is stored in the global variables as WRITE_OUTPUT; the
+ *  output modules use it instead of their own interval when it is set
+ *  (see isDue). The module must therefore come after the solver module
+ *  and before the output modules.
+ *
+ */
+
+#ifndef OUTPUT_SCHEDULE_MODULE_H
+#define OUTPUT_SCHEDULE_MODULE_H
+
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+
+using jem::Ref;
+using jem::String;
+using jem::idx_t;
+using jem::util::Properties;
+using jive::app::Module;
+using jive::model::Model;
+
+
+//-----------------------------------------------------------------------
+//   class OutputScheduleModule
+//-----------------------------------------------------------------------
+
+
+class OutputScheduleModule : public Module
+{
+ public:
+
+  typedef OutputScheduleModule  Self;
+  typedef Module                Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        INTERVAL_PROP;
+  static const char*        LOAD_SCALE_STEP_PROP;
+  static const char*        NEW_LOADING_PROP;
+  static const char*        LOAD_DISP_PROP;
+  static const char*        WALL_INTERVAL_PROP;
+  static const char*        DENSE_STEPS_PROP;
+
+  explicit                  OutputScheduleModule
+
+    ( const String&           name = "outputSchedule" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  static bool               isDue
+
+    ( idx_t                   runCount,
+      idx_t                   interval,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~OutputScheduleModule ();
+
+
+ private:
+
+  const char*               checkEvents_
+
+    ( const Properties&       globdat );
+
+  static double             wallTime_       ();
+
+
+ private:
+
+  Ref<Model>                model_;
+
+  idx_t                     interval_;
+  double                    loadScaleStep_;
+  idx_t                     newLoading_;
+  String                    loadDisp_;
+  double                    wallInterval_;
+  idx_t                     denseSteps_;
+
+  // state at the last frame and of the peak detection
+
+  idx_t                     runCount_;
+  idx_t                     denseLeft_;
+  double                    lastScale_;
+  double                    lastWall_;
+  double                    prevLoad_;
+  bool                      rising_;
+
+};
+
+
+#endif
@@ -0,0 +1,881 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Parareal driver for explicit dynamics. See PararealModule.h for
+ *  details.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cmath>
+
+#include <jem/base/limits.h>
+#include <jem/base/Float.h>
+#include <jem/base/System.h>
+#include <jem/base/Exception.h>
+#include <jem/base/ArithmeticException.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/base/array/operators.h>
+#include <jem/util/Event.h>
+#include <jem/numeric/algebra/utilities.h>
+#include <jive/util/Globdat.h>
+#include <jive/util/utilities.h>
+#include <jive/algebra/DiagMatrixObject.h>
+#include <jive/algebra/LumpedMatrixBuilder.h>
+#include <jive/model/Actions.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "PararealModule.h"
+#include "TimeStepModule.h"
+#include "SolverNames.h"
+#include "ProcessUtils.h"
+
+
+using jem::max;
+using jem::min;
+using jem::maxOf;
+using jem::isTiny;
+using jem::newInstance;
+using jem::Float;
+using jem::System;
+using jem::Exception;
+using jem::ArithmeticException;
+using jem::IllegalInputException;
+using jem::numeric::dotProduct;
+using jive::util::Globdat;
+using jive::model::Actions;
+using jive::model::ActionParams;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class SliceSlot_
+//=======================================================================
+
+// Header of the shared memory slot of a slice propagated in a forked
+// process; the displacements and velocities at the end of the slice
+// follow the header.
+
+class SliceSlot_
+{
+ public:
+
+  static const int          RUNNING = 0;
+  static const int          DONE    = 1;
+  static const int          FAILED  = 2;
+
+  int                       status;
+  double                    padding[7];
+};
+
+
+//=======================================================================
+//   class PararealModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  PararealModule::TYPE_NAME         = "Parareal";
+const char*  PararealModule::DTIME_PROP        = "dtime";
+const char*  PararealModule::SLICE_COUNT_PROP  = "sliceCount";
+const char*  PararealModule::SLICE_STEPS_PROP  = "sliceSteps";
+const char*  PararealModule::COARSE_RATIO_PROP = "coarseRatio";
+const char*  PararealModule::SAFETY_PROP       = "safety";
+const char*  PararealModule::MAX_ITER_PROP     = "maxIter";
+const char*  PararealModule::PRECISION_PROP    = "precision";
+const char*  PararealModule::PROC_COUNT_PROP   = "processes";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+PararealModule::PararealModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  dtime_       = 1.0;
+  dtCoarse_    = 1.0;
+  coarseRatio_ = 10.0;
+  safety_      = 0.9;
+  precision_   = 1.0e-6;
+  sliceCount_  = 4;
+  sliceSteps_  = 100;
+  maxIter_     = 0;
+  procCount_   = 0;
+  valid_       = false;
+}
+
+
+PararealModule::~PararealModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status PararealModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  using jem::util::connect;
+
+  const String  context = getContext ();
+
+  double        t = 0.0;
+  int           i = 0;
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_ = Model   ::get ( globdat, context );
+  dofs_  = DofSpace::get ( globdat, context );
+
+  valid_ = false;
+
+  connect ( dofs_->newSizeEvent,  this, &Self::invalidate_ );
+  connect ( dofs_->newOrderEvent, this, &Self::invalidate_ );
+
+  if ( ! globdat.find( t, Globdat::TIME ) )
+  {
+    globdat.set ( Globdat::TIME, t );
+  }
+
+  if ( ! globdat.find( i, Globdat::TIME_STEP ) )
+  {
+    globdat.set ( Globdat::TIME_STEP, i );
+  }
+
+  globdat.set ( Globdat::OLD_TIME,      t );
+  globdat.set ( Globdat::OLD_TIME_STEP, i );
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status PararealModule::run ( const Properties& globdat )
+{
+  using jive::model::STATE0;
+  using jive::model::STATE1;
+  using jive::model::STATE2;
+
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  if ( ! valid_ )
+  {
+    restart_ ( globdat );
+  }
+
+  const idx_t   dofCount    = rmass_.size ();
+  const idx_t   n           = sliceCount_;
+  const double  sliceTime   = dtime_ * (double) sliceSteps_;
+  const idx_t   coarseSteps =
+
+    max ( (idx_t) 1, (idx_t) std::ceil( sliceTime / dtCoarse_ - 1.0e-8 ) );
+
+  const double  dtc         = sliceTime / (double) coarseSteps;
+  const idx_t   iterCount   = ( maxIter_ > 0 ) ? min( maxIter_, n ) : n;
+
+  Matrix        uu ( dofCount, n + 1 );
+  Matrix        uv ( dofCount, n + 1 );
+  Matrix        gu ( dofCount, n );
+  Matrix        gv ( dofCount, n );
+  Matrix        fu ( dofCount, n );
+  Matrix        fv ( dofCount, n );
+
+  Vector        u  ( dofCount );
+  Vector        v  ( dofCount );
+  Vector        du ( dofCount );
+  Vector        dv ( dofCount );
+  Vector        u0, v0, a0;
+
+  double        t0;
+  int           i0;
+  idx_t         iter;
+
+
+  globdat.get ( t0, Globdat::TIME );
+  globdat.get ( i0, Globdat::TIME_STEP );
+
+  // Get the prescribed values for this window.
+
+  cons_ = Constraints::find ( dofs_, globdat );
+
+  if ( cons_ != NIL )
+  {
+    params_.set ( ActionParams::CONSTRAINTS, cons_ );
+
+    model_->takeAction ( Actions::GET_CONSTRAINTS, params_, globdat );
+
+    slaveDofs_.ref ( cons_->getSlaveDofs() );
+  }
+  else
+  {
+    slaveDofs_.resize ( 0 );
+  }
+
+  StateVector::get ( u0, STATE0, dofs_, globdat );
+  StateVector::get ( v0, STATE1, dofs_, globdat );
+  StateVector::get ( a0, STATE2, dofs_, globdat );
+
+  uu[0] = u0;
+  uv[0] = v0;
+
+  // Initial prediction with the coarse propagator.
+
+  for ( idx_t is = 0; is < n; is++ )
+  {
+    u = uu[is];
+    v = uv[is];
+
+    propagate_ ( u, v, t0 + is * sliceTime, dtc, coarseSteps, globdat );
+
+    gu[is]     = u;
+    gv[is]     = v;
+    uu[is + 1] = u;
+    uv[is + 1] = v;
+  }
+
+  // Parareal iterations; in iteration k the slices k..n-1 are
+  // propagated with the fine propagator and corrected serially.
+
+  for ( iter = 0; iter < iterCount; )
+  {
+    double  diff  = 0.0;
+    double  scale = 0.0;
+
+    fineSweep_ ( fu, fv, uu, uv, iter, t0, globdat );
+
+    for ( idx_t is = iter; is < n; is++ )
+    {
+      if ( is == iter )
+      {
+        u = fu[is];
+        v = fv[is];
+      }
+      else
+      {
+        u = uu[is];
+        v = uv[is];
+
+        propagate_ ( u, v, t0 + is * sliceTime, dtc, coarseSteps, globdat );
+
+        Vector  gun ( u.clone() );
+        Vector  gvn ( v.clone() );
+
+        u += fu[is] - gu[is];
+        v += fv[is] - gv[is];
+
+        gu[is] = gun;
+        gv[is] = gvn;
+      }
+
+      du = u - uu[is + 1];
+      dv = v - uv[is + 1];
+
+      diff  = max ( diff,  dotProduct( du, du ) + dotProduct( dv, dv ) );
+      scale = max ( scale, dotProduct( u,  u  ) + dotProduct( v,  v  ) );
+
+      uu[is + 1] = u;
+      uv[is + 1] = v;
+    }
+
+    iter++;
+
+    diff = std::sqrt ( diff / max( scale, Float::EPSILON ) );
+
+    System::info( myName_ ) << myName_ << " : iteration " << iter
+                            << ", relative correction = " << diff << "\n";
+
+    if ( diff <= precision_ )
+    {
+      break;
+    }
+  }
+
+  // Store the state at the end of the window and commit.
+
+  u0 = uu[n];
+  v0 = uv[n];
+
+  getAccel_ ( a0, t0 + n * sliceTime, globdat );
+
+  globdat.set ( Globdat::OLD_TIME,      t0 );
+  globdat.set ( Globdat::OLD_TIME_STEP, i0 );
+  globdat.set ( Globdat::TIME,          t0 + n * sliceTime );
+  globdat.set ( Globdat::TIME_STEP,     (int) (i0 + n * sliceSteps_) );
+
+  model_->takeAction ( Actions::COMMIT, params_, globdat );
+
+  System::out() << "on time: " << t0 + n * sliceTime << " in step: "
+                << i0 + n * sliceSteps_ << " (" << n << " slices, "
+                << iter << " parareal iterations)\n\n";
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void PararealModule::shutdown ( const Properties& globdat )
+{
+  model_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void PararealModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( dtime_,       DTIME_PROP,
+                   1.0e-20,      1.0e20 );
+    myProps.find ( sliceCount_,  SLICE_COUNT_PROP,
+                   1,            maxOf( sliceCount_ ) );
+    myProps.find ( sliceSteps_,  SLICE_STEPS_PROP,
+                   1,            maxOf( sliceSteps_ ) );
+    myProps.find ( coarseRatio_, COARSE_RATIO_PROP,
+                   1.0,          1.0e20 );
+    myProps.find ( safety_,      SAFETY_PROP,
+                   0.0,          1.0 );
+    myProps.find ( maxIter_,     MAX_ITER_PROP,
+                   0,            maxOf( maxIter_ ) );
+    myProps.find ( precision_,   PRECISION_PROP,
+                   0.0,          1.0e20 );
+    myProps.find ( procCount_,   PROC_COUNT_PROP,
+                   0,            maxOf( procCount_ ) );
+  }
+
+  valid_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void PararealModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( DTIME_PROP,        dtime_       );
+  myConf.set ( SLICE_COUNT_PROP,  sliceCount_  );
+  myConf.set ( SLICE_STEPS_PROP,  sliceSteps_  );
+  myConf.set ( COARSE_RATIO_PROP, coarseRatio_ );
+  myConf.set ( SAFETY_PROP,       safety_      );
+  myConf.set ( MAX_ITER_PROP,     maxIter_     );
+  myConf.set ( PRECISION_PROP,    precision_   );
+  myConf.set ( PROC_COUNT_PROP,   procCount_   );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> PararealModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   restart_
+//-----------------------------------------------------------------------
+
+// Checks that the model has no history, assembles the lumped mass
+// matrix and sets the coarse time step: coarseRatio times dtime, but
+// not more than safety times the stable time step of the model, as the
+// coarse propagator is explicit too.
+
+void PararealModule::restart_ ( const Properties& globdat )
+{
+  using jive::algebra::LumpedMatrixBuilder;
+
+  Ref<LumpedMatrixBuilder>  mbuilder;
+
+  const String  context  = getContext      ();
+  const idx_t   dofCount = dofs_->dofCount ();
+
+  Properties    params;
+
+  double        dtcrit   = Float::MAX_VALUE;
+  bool          linear   = true;
+
+
+  // The slices of a window all start from the committed history, so
+  // the result is only correct for a model without history.
+
+  params.set ( SolverNames::LINEAR, linear );
+
+  if ( ! model_->takeAction( SolverNames::CHECK_LINEAR, params, globdat ) )
+  {
+    linear = false;
+  }
+  else
+  {
+    params.get ( linear, SolverNames::LINEAR );
+  }
+
+  if ( ! linear )
+  {
+    throw IllegalInputException (
+      context,
+      "the model is not linear; parareal requires a model without "
+      "history"
+    );
+  }
+
+  params.clear ();
+
+  mbuilder = newInstance<LumpedMatrixBuilder> ();
+
+  mbuilder->setOptions ( 0 );
+  mbuilder->setSize    ( dofCount );
+  mbuilder->clear      ();
+
+  params.set ( ActionParams::MATRIX2, mbuilder );
+
+  model_->takeAction ( Actions::GET_MATRIX2, params, globdat );
+
+  mbuilder->updateMatrix ();
+
+  rmass_.resize ( dofCount );
+
+  rmass_ = mbuilder->getDiagMatrix()->getValues ();
+
+  for ( idx_t i = 0; i < dofCount; i++ )
+  {
+    if ( isTiny( rmass_[i] ) )
+    {
+      throw ArithmeticException (
+        context,
+        "singular mass matrix"
+      );
+    }
+
+    rmass_[i] = 1.0 / rmass_[i];
+  }
+
+  fint_.resize ( dofCount );
+  fext_.resize ( dofCount );
+
+  params_.set ( ActionParams::INT_VECTOR, fint_ );
+  params_.set ( ActionParams::EXT_VECTOR, fext_ );
+
+  // Set the coarse time step. It is only limited if the model gives an
+  // estimate of the critical time step (SolidModel does not for all
+  // meshes).
+
+  params.clear ();
+  params.set   ( SolverNames::CRIT_TIME_STEP, dtcrit );
+
+  model_->takeAction ( SolverNames::GET_CRIT_TIME_STEP, params, globdat );
+
+  params.get ( dtcrit, SolverNames::CRIT_TIME_STEP );
+
+  dtCoarse_ = coarseRatio_ * dtime_;
+
+  if ( dtcrit < Float::MAX_VALUE && dtCoarse_ > safety_ * dtcrit )
+  {
+    dtCoarse_ = max ( dtime_, safety_ * dtcrit );
+
+    System::info( myName_ ) << myName_ << " : coarse time step limited "
+                            << "to " << dtCoarse_ << " by the critical "
+                            << "time step " << dtcrit << "\n";
+  }
+
+  // With a coarse step close to the fine one G is as expensive as F,
+  // and the iterations only add work to a serial run.
+
+  if ( dtCoarse_ < 2.0 * dtime_ )
+  {
+    System::warn() << myName_ << " : the effective coarse ratio is "
+                   << dtCoarse_ / dtime_ << "; parareal will be slower "
+                   << "than a serial run (reduce dtime)\n";
+  }
+
+  if ( dtcrit < Float::MAX_VALUE && dtime_ > dtcrit )
+  {
+    System::warn() << myName_ << " : dtime = " << dtime_
+                   << " exceeds the critical time step " << dtcrit
+                   << "; the solution will be unstable\n";
+  }
+
+  valid_ = true;
+}
+
+
+//-----------------------------------------------------------------------
+//   invalidate_
+//-----------------------------------------------------------------------
+
+
+void PararealModule::invalidate_ ()
+{
+  valid_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   propagate_
+//-----------------------------------------------------------------------
+
+// Advances the displacements u and the velocities v (both updated in
+// place) from time t over stepCount steps of dt, with the central
+// difference step of TimeStepModule. The displacements one step back
+// and the velocities at the end follow from
+//
+//   u_n-1 = u_n - dt v_n + 0.5 dt^2 a_n
+//
+// which is exact for the central difference scheme. The prescribed
+// DOFs get their prescribed values, and a velocity that matches the
+// change of these values.
+
+void PararealModule::propagate_
+
+  ( const Vector&      u,
+    const Vector&      v,
+    double             t,
+    double             dt,
+    idx_t              stepCount,
+    const Properties&  globdat )
+
+{
+  using jive::util::setSlaveDofs;
+  using jive::model::STATE0;
+
+  const idx_t   dofCount = rmass_.size ();
+  const double  hdt2     = 0.5 * dt * dt;
+
+  Vector        a  ( dofCount );
+  Vector        w  ( dofCount );
+  Vector        u1 ( dofCount );
+  Vector        u0;
+
+
+  StateVector::get ( u0, STATE0, dofs_, globdat );
+
+  u0 = u;
+
+  getAccel_ ( a, t, globdat );
+
+  u1 = u0 - dt * v + hdt2 * a;
+
+  for ( idx_t is = 0; is < stepCount; is++ )
+  {
+    if ( is > 0 )
+    {
+      getForces_ ( t, globdat );
+    }
+
+    TimeStepModule::centralStep ( w, u0, u1, fint_, fext_,
+                                  rmass_, dt, dt );
+
+    if ( cons_ != NIL )
+    {
+      setSlaveDofs ( u0, *cons_ );
+    }
+
+    t += dt;
+  }
+
+  getAccel_ ( a, t, globdat );
+
+  v = (u0 - u1) / dt + (0.5 * dt) * a;
+  u = u0;
+}
+
+
+//-----------------------------------------------------------------------
+//   getForces_
+//-----------------------------------------------------------------------
+
+// Computes the internal and external forces in fint_ and fext_ at time
+// t for the displacements in the state vector. The global time is set
+// to t for the time dependent loads; run() sets it to the end of the
+// window.
+
+void PararealModule::getForces_
+
+  ( double             t,
+    const Properties&  globdat )
+
+{
+  fint_ = 0.0;
+  fext_ = 0.0;
+
+  globdat.set ( Globdat::TIME, t );
+
+  model_->takeAction ( Actions::GET_INT_VECTOR, params_, globdat );
+  model_->takeAction ( Actions::GET_EXT_VECTOR, params_, globdat );
+}
+
+
+//-----------------------------------------------------------------------
+//   getAccel_
+//-----------------------------------------------------------------------
+
+// Computes the forces (see getForces_) and the accelerations at time t;
+// the accelerations are zero at the prescribed DOFs.
+
+void PararealModule::getAccel_
+
+  ( const Vector&      a,
+    double             t,
+    const Properties&  globdat )
+
+{
+  const idx_t  slaveCount = slaveDofs_.size ();
+
+  getForces_ ( t, globdat );
+
+  a = (fext_ - fint_) * rmass_;
+
+  for ( idx_t k = 0; k < slaveCount; k++ )
+  {
+    a[slaveDofs_[k]] = 0.0;
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   fineSweep_
+//-----------------------------------------------------------------------
+
+// Propagates the slices first..n-1 from the states in (uu, uv) with the
+// fine time step and stores the end states in (fu, fv). Each slice runs
+// in a forked process, at most procCount_ at a time (all if zero); the
+// results are passed back through shared memory. If a process can not
+// be created, or if this process runs other threads (see
+// ProcessUtils.h), the slice is propagated in this process.
+//
+// The children only propagate and leave with _exit(), so they do not
+// flush buffers of the parent. They do change their copy of globdat
+// (the time) and the models print, so their standard output and error
+// are sent to /dev/null; files opened by other modules are not
+// redirected.
+
+void PararealModule::fineSweep_
+
+  ( const Matrix&      fu,
+    const Matrix&      fv,
+    const Matrix&      uu,
+    const Matrix&      uv,
+    idx_t              first,
+    double             t0,
+    const Properties&  globdat )
+
+{
+  const idx_t   dofCount  = rmass_.size ();
+  const idx_t   n         = sliceCount_;
+  const idx_t   count     = n - first;
+  const idx_t   batch     = ( procCount_ > 0 ) ? procCount_ : count;
+  const double  sliceTime = dtime_ * (double) sliceSteps_;
+
+  const size_t  slotSize  = sizeof(SliceSlot_) +
+                            2 * (size_t) dofCount * sizeof(double);
+
+  Vector        u ( dofCount );
+  Vector        v ( dofCount );
+
+
+  void*  shared = ::mmap ( 0, (size_t) count * slotSize,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS,
+                           -1, 0 );
+
+  if ( shared == MAP_FAILED )
+  {
+    throw Exception (
+      getContext (),
+      "could not allocate shared memory for the fine propagators"
+    );
+  }
+
+  char*      base   = (char*) shared;
+  IdxVector  pids   ( count );
+  bool       serial = ( threadCount() > 1 );
+
+  if ( serial )
+  {
+    System::warn() << myName_ << " : the process runs other threads, "
+                   << "so the slices are propagated serially\n";
+  }
+
+  System::out().flush ();
+
+  for ( idx_t ib = 0; ib < count; ib += batch )
+  {
+    const idx_t  ie = min ( count, ib + batch );
+
+    for ( idx_t k = ib; k < ie; k++ )
+    {
+      const idx_t  is   = first + k;
+      SliceSlot_*  slot = (SliceSlot_*) (base + k * slotSize);
+      double*      data = (double*) (slot + 1);
+
+      slot->status = SliceSlot_::RUNNING;
+
+      pids[k] = serial ? -1 : ::fork ();
+
+      if ( pids[k] > 0 )
+      {
+        continue;
+      }
+
+      // child process, or the parent if there was no fork
+
+      int  status = SliceSlot_::FAILED;
+
+      if ( pids[k] == 0 )
+      {
+        int  fd = ::open ( "/dev/null", O_WRONLY );
+
+        if ( fd >= 0 )
+        {
+          ::dup2  ( fd, 1 );
+          ::dup2  ( fd, 2 );
+          ::close ( fd );
+        }
+      }
+
+      try
+      {
+        u = uu[is];
+        v = uv[is];
+
+        propagate_ ( u, v, t0 + is * sliceTime, dtime_,
+                     sliceSteps_, globdat );
+
+        for ( idx_t i = 0; i < dofCount; i++ )
+        {
+          data[i]            = u[i];
+          data[dofCount + i] = v[i];
+        }
+
+        status = SliceSlot_::DONE;
+      }
+      catch ( const Exception& )
+      {
+        if ( pids[k] < 0 )
+        {
+          ::munmap ( shared, (size_t) count * slotSize );
+          throw;
+        }
+      }
+
+      slot->status = status;
+
+      if ( pids[k] == 0 )
+      {
+        ::_exit ( 0 );
+      }
+    }
+
+    for ( idx_t k = ib; k < ie; k++ )
+    {
+      if ( pids[k] > 0 )
+      {
+        int  wstat;
+
+        ::waitpid ( (pid_t) pids[k], &wstat, 0 );
+      }
+    }
+  }
+
+  // collect the results
+
+  for ( idx_t k = 0; k < count; k++ )
+  {
+    const idx_t    is   = first + k;
+    SliceSlot_*    slot = (SliceSlot_*) (base + k * slotSize);
+    const double*  data = (const double*) (slot + 1);
+
+    if ( slot->status != SliceSlot_::DONE )
+    {
+      ::munmap ( shared, (size_t) count * slotSize );
+
+      throw Exception (
+        getContext (),
+        String::format ( "fine propagation of slice %d failed",
+                         (int) is )
+      );
+    }
+
+    for ( idx_t i = 0; i < dofCount; i++ )
+    {
+      fu(i,is) = data[i];
+      fv(i,is) = data[dofCount + i];
+    }
+  }
+
+  ::munmap ( shared, (size_t) count * slotSize );
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declarePararealModule
+//-----------------------------------------------------------------------
+
+
+void declarePararealModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( PararealModule::TYPE_NAME,
+                         & PararealModule::makeNew );
+}
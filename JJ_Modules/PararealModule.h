@@ -0,0 +1,187 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module implements the parareal method for explicit dynamics.
+ *  Each run advances a window of slices, each of sliceSteps steps of
+ *  dtime. The states (u, v) at the slice boundaries are found with
+ *
+ *    U_n+1^k+1 = G(U_n^k+1) + F(U_n^k) - G(U_n^k)
+ *
+ *  with F the fine propagator (the central difference step of
+ *  TimeStepModule with dtime) and G the coarse propagator (the same
+ *  step with coarseRatio times dtime). The fine propagations of the
+ *  slices are independent and run in forked processes; the coarse
+ *  corrections run in the parent; if the process runs other threads,
+ *  the slices are propagated one after the other instead (see
+ *  ProcessUtils.h). The iterations stop when the
+ *  relative correction of the boundary states is below precision;
+ *  after k iterations the first k slices are exact, so the method
+ *  converges in at most sliceCount iterations.
+ *
+ *  The coarse propagator is explicit as well, so its time step is
+ *  limited to safety times the stable time step of the model. If dtime
+ *  is close to the stable time step, G is then (nearly) the same as F
+ *  and the method is slower than a serial run; a warning is printed
+ *  when the effective coarse ratio is below 2.
+ *
+ *  The slices start from the material history at the start of the
+ *  window (the model is committed once per window), so the module
+ *  only accepts a model without history: a model that reports to be
+ *  linear through CHECK_LINEAR.
+ *
+ */
+
+#ifndef PARAREAL_MODULE_H
+#define PARAREAL_MODULE_H
+
+#include <jive/Array.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+#include <jive/util/Constraints.h>
+
+using jem::Ref;
+using jem::String;
+using jem::idx_t;
+using jem::util::Properties;
+using jive::Vector;
+using jive::Matrix;
+using jive::IdxVector;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+using jive::util::Constraints;
+
+
+//-----------------------------------------------------------------------
+//   class PararealModule
+//-----------------------------------------------------------------------
+
+
+class PararealModule : public Module
+{
+ public:
+
+  typedef PararealModule    Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        DTIME_PROP;
+  static const char*        SLICE_COUNT_PROP;
+  static const char*        SLICE_STEPS_PROP;
+  static const char*        COARSE_RATIO_PROP;
+  static const char*        SAFETY_PROP;
+  static const char*        MAX_ITER_PROP;
+  static const char*        PRECISION_PROP;
+  static const char*        PROC_COUNT_PROP;
+
+  explicit                  PararealModule
+
+    ( const String&           name = "parareal" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~PararealModule  ();
+
+
+ private:
+
+  void                      restart_
+
+    ( const Properties&       globdat );
+
+  void                      invalidate_     ();
+
+  void                      propagate_
+
+    ( const Vector&           u,
+      const Vector&           v,
+      double                  t,
+      double                  dt,
+      idx_t                   stepCount,
+      const Properties&       globdat );
+
+  void                      getForces_
+
+    ( double                  t,
+      const Properties&       globdat );
+
+  void                      getAccel_
+
+    ( const Vector&           a,
+      double                  t,
+      const Properties&       globdat );
+
+  void                      fineSweep_
+
+    ( const Matrix&           fu,
+      const Matrix&           fv,
+      const Matrix&           uu,
+      const Matrix&           uv,
+      idx_t                   first,
+      double                  t0,
+      const Properties&       globdat );
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<Constraints>          cons_;
+
+  Vector                    rmass_;
+  IdxVector                 slaveDofs_;
+  Vector                    fint_;
+  Vector                    fext_;
+  Properties                params_;
+
+  double                    dtime_;
+  double                    dtCoarse_;
+  double                    coarseRatio_;
+  double                    safety_;
+  double                    precision_;
+
+  idx_t                     sliceCount_;
+  idx_t                     sliceSteps_;
+  idx_t                     maxIter_;
+  idx_t                     procCount_;
+
+  bool                      valid_;
+
+};
+
+
+#endif
@@ -0,0 +1,593 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Probe monitoring. See ProbeModule.h for details.
+ *
+ */
+
+#include <stdint.h>
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/limits.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/io/IOException.h>
+#include <jive/util/Globdat.h>
+#include <jive/fem/NodeSet.h>
+#include <jive/fem/NodeGroup.h>
+#include <jive/fem/ElementSet.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "ProbeModule.h"
+#include "SolverNames.h"
+
+
+using jem::maxOf;
+using jem::newInstance;
+using jem::IllegalInputException;
+using jem::io::IOException;
+using jive::util::Globdat;
+using jive::fem::NodeSet;
+using jive::fem::NodeGroup;
+using jive::fem::ElementSet;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class ProbeModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  ProbeModule::TYPE_NAME        = "Probe";
+const char*  ProbeModule::FILE_PROP        = "file";
+const char*  ProbeModule::FORMAT_PROP      = "format";
+const char*  ProbeModule::INTERVAL_PROP    = "interval";
+const char*  ProbeModule::BUFFER_SIZE_PROP = "bufferSize";
+const char*  ProbeModule::ELEMENTS_PROP    = "elements";
+const char*  ProbeModule::IPOINTS_PROP     = "ipoints";
+const char*  ProbeModule::NODE_GROUPS_PROP = "nodeGroups";
+const char*  ProbeModule::DOFS_PROP        = "dofs";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+ProbeModule::ProbeModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  fileName_   = "probes.csv";
+  format_     = "csv";
+  interval_   = 1;
+  bufferSize_ = 256;
+  rowCount_   = 0;
+  runCount_   = 0;
+  file_       = 0;
+  binary_     = false;
+}
+
+
+ProbeModule::~ProbeModule ()
+{
+  close_ ();
+}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status ProbeModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  configure ( props, globdat );
+
+  model_ = Model   ::get ( globdat, context );
+  dofs_  = DofSpace::get ( globdat, context );
+
+  close_ ();
+
+  // Resolve the probes and set up the buffer.
+
+  Flex<String>  colNames;
+
+  colNames.pushBack ( "step" );
+  colNames.pushBack ( "time" );
+
+  initElemProbes_ ( colNames, globdat );
+  initNodeProbes_ ( colNames, globdat );
+
+  getConfig ( conf, globdat );
+
+  buffer_.resize ( colNames.size(), bufferSize_ );
+
+  rowCount_ = 0;
+  runCount_ = 0;
+  binary_   = ( format_ == "binary" );
+
+  file_ = std::fopen ( fileName_.addr(), binary_ ? "wb" : "w" );
+
+  if ( ! file_ )
+  {
+    throw IOException (
+      context,
+      String::format ( "can not open %s: %s", fileName_,
+                       std::strerror( errno ) )
+    );
+  }
+
+  writeHeader_ ( colNames );
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status ProbeModule::run ( const Properties& globdat )
+{
+  using jive::model::STATE0;
+
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  runCount_++;
+
+  if ( runCount_ % interval_ != 0 )
+  {
+    return OK;
+  }
+
+  double  time = 0.0;
+  int     step = 0;
+  Vector  state;
+
+  globdat.find ( time, Globdat::TIME );
+  globdat.find ( step, Globdat::TIME_STEP );
+
+  model_->takeAction ( SolverNames::GET_PROBES, params_, globdat );
+
+  StateVector::get ( state, STATE0, dofs_, globdat );
+
+  // Gather the row.
+
+  const Vector&  values = probes_->getRow ();
+  const idx_t    nv     = values.size ();
+  const idx_t    np     = groupOffsets_.size() - 1;
+  const idx_t    j      = rowCount_;
+
+  buffer_(0,j) = (double) step;
+  buffer_(1,j) = time;
+
+  for ( idx_t i = 0; i < nv; i++ )
+  {
+    buffer_(2 + i,j) = values[i];
+  }
+
+  for ( idx_t i = 0; i < np; i++ )
+  {
+    const idx_t  first = groupOffsets_[i];
+    const idx_t  last  = groupOffsets_[i + 1];
+
+    double       sum   = 0.0;
+
+    for ( idx_t k = first; k < last; k++ )
+    {
+      sum += state[groupDofs_[k]];
+    }
+
+    buffer_(2 + nv + i,j) = ( last > first ) ? sum / (double) (last - first)
+                                             : 0.0;
+  }
+
+  rowCount_++;
+
+  if ( rowCount_ == bufferSize_ )
+  {
+    flush_ ();
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void ProbeModule::shutdown ( const Properties& globdat )
+{
+  flush_ ();
+  close_ ();
+
+  model_ = NIL;
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void ProbeModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( fileName_,   FILE_PROP );
+    myProps.find ( format_,     FORMAT_PROP );
+    myProps.find ( interval_,   INTERVAL_PROP,
+                   1, maxOf( interval_ ) );
+    myProps.find ( bufferSize_, BUFFER_SIZE_PROP,
+                   1, maxOf( bufferSize_ ) );
+    myProps.find ( elemIDs_,    ELEMENTS_PROP );
+    myProps.find ( ipoints_,    IPOINTS_PROP );
+    myProps.find ( nodeGroups_, NODE_GROUPS_PROP );
+    myProps.find ( dofNames_,   DOFS_PROP );
+
+    if ( format_ != "csv" && format_ != "binary" )
+    {
+      myProps.propertyError (
+        FORMAT_PROP,
+        "invalid format; expected `csv\' or `binary\'"
+      );
+    }
+
+    if ( ipoints_.size() > 0 && ipoints_.size() != elemIDs_.size() )
+    {
+      myProps.propertyError (
+        IPOINTS_PROP,
+        String::format ( "expected %d points (one per element)",
+                         elemIDs_.size() )
+      );
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void ProbeModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( FILE_PROP,        fileName_   );
+  myConf.set ( FORMAT_PROP,      format_     );
+  myConf.set ( INTERVAL_PROP,    interval_   );
+  myConf.set ( BUFFER_SIZE_PROP, bufferSize_ );
+  myConf.set ( ELEMENTS_PROP,    elemIDs_    );
+  myConf.set ( IPOINTS_PROP,     ipoints_    );
+  myConf.set ( NODE_GROUPS_PROP, nodeGroups_ );
+  myConf.set ( DOFS_PROP,        dofNames_   );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> ProbeModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   initElemProbes_
+//-----------------------------------------------------------------------
+
+// Adds the element probes to the probe set and lets the models claim
+// them. Every probe must be claimed by a model.
+
+void ProbeModule::initElemProbes_
+
+  ( Flex<String>&      colNames,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+  const idx_t   n       = elemIDs_.size ();
+
+  probes_ = newInstance<ProbeSet> ();
+
+  params_.clear ();
+  params_.set   ( SolverNames::PROBE_SET, probes_ );
+
+  if ( n == 0 )
+  {
+    probes_->finish ();
+
+    return;
+  }
+
+  ElementSet  elems = ElementSet::get ( globdat, context );
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    const idx_t  ielem = elems.findElement ( elemIDs_[i] );
+
+    if ( ielem < 0 )
+    {
+      throw IllegalInputException (
+        context,
+        String::format ( "unknown element ID: %d", elemIDs_[i] )
+      );
+    }
+
+    probes_->addProbe ( ielem, ipoints_.size() ? ipoints_[i] : -1 );
+  }
+
+  model_->takeAction ( SolverNames::RESOLVE_PROBES, params_, globdat );
+
+  probes_->finish ();
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    if ( ! probes_->isClaimed( i ) )
+    {
+      throw IllegalInputException (
+        context,
+        String::format ( "element %d is not part of a model that "
+                         "supports probes", elemIDs_[i] )
+      );
+    }
+
+    String  prefix = String::format ( "e%d", elemIDs_[i] );
+
+    if ( probes_->getPoint( i ) >= 0 )
+    {
+      prefix = prefix + String::format ( ".ip%d", probes_->getPoint( i ) );
+    }
+
+    StringVector  names = probes_->getNames ( i );
+
+    for ( idx_t j = 0; j < names.size(); j++ )
+    {
+      colNames.pushBack ( prefix + "." + names[j] );
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   initNodeProbes_
+//-----------------------------------------------------------------------
+
+// Converts the node groups to lists of DOF indices, one list per group
+// and DOF type. Without dofs all DOF types are used.
+
+void ProbeModule::initNodeProbes_
+
+  ( Flex<String>&      colNames,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+  const idx_t   ng      = nodeGroups_.size ();
+
+  if ( ng > 0 && dofNames_.size() == 0 )
+  {
+    dofNames_.resize ( dofs_->typeCount() );
+
+    for ( idx_t it = 0; it < dofNames_.size(); it++ )
+    {
+      dofNames_[it] = dofs_->getTypeName ( it );
+    }
+  }
+
+  const idx_t   nt      = dofNames_.size ();
+
+  Flex<idx_t>   idofs;
+  IdxVector     itypes  ( nt );
+
+  for ( idx_t it = 0; it < nt; it++ )
+  {
+    itypes[it] = dofs_->getTypeIndex ( dofNames_[it] );
+  }
+
+  groupOffsets_.resize ( ng * nt + 1 );
+
+  groupOffsets_[0] = 0;
+
+  if ( ng == 0 )
+  {
+    groupDofs_.resize ( 0 );
+
+    return;
+  }
+
+  NodeSet  nodes = NodeSet::get ( globdat, context );
+
+  for ( idx_t ig = 0; ig < ng; ig++ )
+  {
+    NodeGroup  group  = NodeGroup::get ( nodeGroups_[ig], nodes,
+                                         globdat, context );
+    IdxVector  inodes = group.getIndices ();
+
+    for ( idx_t it = 0; it < nt; it++ )
+    {
+      for ( idx_t in = 0; in < inodes.size(); in++ )
+      {
+        const idx_t  idof = dofs_->findDofIndex ( inodes[in], itypes[it] );
+
+        if ( idof >= 0 )
+        {
+          idofs.pushBack ( idof );
+        }
+      }
+
+      groupOffsets_[ig * nt + it + 1] = idofs.size ();
+
+      colNames.pushBack ( nodeGroups_[ig] + "." + dofNames_[it] );
+    }
+  }
+
+  groupDofs_.resize ( idofs.size() );
+
+  for ( idx_t i = 0; i < idofs.size(); i++ )
+  {
+    groupDofs_[i] = idofs[i];
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   writeHeader_
+//-----------------------------------------------------------------------
+
+
+void ProbeModule::writeHeader_ ( const Flex<String>& colNames )
+{
+  static const char  MAGIC[8] = { 'J', 'J', 'P', 'R', 'O', 'B', 'E', 0 };
+
+  const idx_t  n = colNames.size ();
+
+  if ( binary_ )
+  {
+    int64_t  count = (int64_t) n;
+
+    std::fwrite ( MAGIC,  1, 8, file_ );
+    std::fwrite ( &count, sizeof(count), 1, file_ );
+
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      int64_t  len = (int64_t) colNames[j].size ();
+
+      std::fwrite ( &len, sizeof(len), 1, file_ );
+      std::fwrite ( colNames[j].addr(), 1, (size_t) len, file_ );
+    }
+  }
+  else
+  {
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      std::fprintf ( file_, "%s%.*s", j ? "," : "",
+                     (int) colNames[j].size(), colNames[j].addr() );
+    }
+
+    std::fprintf ( file_, "\n" );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   flush_
+//-----------------------------------------------------------------------
+
+// Writes the rows in the buffer to the file.
+
+void ProbeModule::flush_ ()
+{
+  if ( ! file_ || rowCount_ == 0 )
+  {
+    return;
+  }
+
+  const idx_t  width = buffer_.size (0);
+
+  if ( binary_ )
+  {
+    std::fwrite ( buffer_.addr(), sizeof(double),
+                  (size_t) (width * rowCount_), file_ );
+  }
+  else
+  {
+    for ( idx_t j = 0; j < rowCount_; j++ )
+    {
+      std::fprintf ( file_, "%d", (int) buffer_(0,j) );
+
+      for ( idx_t i = 1; i < width; i++ )
+      {
+        std::fprintf ( file_, ",%.10e", buffer_(i,j) );
+      }
+
+      std::fprintf ( file_, "\n" );
+    }
+  }
+
+  rowCount_ = 0;
+
+  if ( std::fflush( file_ ) != 0 || std::ferror( file_ ) )
+  {
+    throw IOException (
+      getContext (),
+      String::format ( "error writing %s", fileName_ )
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   close_
+//-----------------------------------------------------------------------
+
+
+void ProbeModule::close_ ()
+{
+  if ( file_ )
+  {
+    std::fclose ( file_ );
+  }
+
+  file_     = 0;
+  rowCount_ = 0;
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareProbeModule
+//-----------------------------------------------------------------------
+
+
+void declareProbeModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( ProbeModule::TYPE_NAME,
+                         & ProbeModule::makeNew );
+}
@@ -0,0 +1,177 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module monitors a list of probes every interval runs:
+ *
+ *    elements    element IDs; the history of the element (averaged
+ *                over its integration points) is recorded
+ *    ipoints     optional, one per element: record only this point
+ *                of the element (-1 for the average)
+ *    nodeGroups  node groups; the mean of each DOF type in dofs over
+ *                the nodes of the group is recorded
+ *
+ *  The probes are resolved once, in init: the models claim the element
+ *  probes (RESOLVE_PROBES, see ProbeSet.h) and the node groups are
+ *  turned into DOF indices. A run then gathers all values in one pass
+ *  into a preallocated buffer with bufferSize rows, which is written in
+ *  one go when it is full and when the module shuts down.
+ *
+ *  A row holds the step, the time and the probe values. With format
+ *  "csv" the file gets a header line with the column names and one
+ *  line per row. With format "binary" it gets
+ *
+ *    char[8]   magic "JJPROBE"
+ *    int64     number of columns
+ *    per column: int64 length of the name and the name
+ *
+ *  followed by the rows as doubles in the byte order of the machine.
+ *
+ */
+
+#ifndef PROBE_MODULE_H
+#define PROBE_MODULE_H
+
+#include <cstdio>
+
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+
+#include "ProbeSet.h"
+
+using jem::Ref;
+using jem::String;
+using jem::idx_t;
+using jem::util::Flex;
+using jem::util::Properties;
+using jive::Vector;
+using jive::Matrix;
+using jive::IdxVector;
+using jive::StringVector;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+
+
+//-----------------------------------------------------------------------
+//   class ProbeModule
+//-----------------------------------------------------------------------
+
+
+class ProbeModule : public Module
+{
+ public:
+
+  typedef ProbeModule       Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        FILE_PROP;
+  static const char*        FORMAT_PROP;
+  static const char*        INTERVAL_PROP;
+  static const char*        BUFFER_SIZE_PROP;
+  static const char*        ELEMENTS_PROP;
+  static const char*        IPOINTS_PROP;
+  static const char*        NODE_GROUPS_PROP;
+  static const char*        DOFS_PROP;
+
+  explicit                  ProbeModule
+
+    ( const String&           name = "probe" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~ProbeModule    ();
+
+
+ private:
+
+  void                      initElemProbes_
+
+    ( Flex<String>&           colNames,
+      const Properties&       globdat );
+
+  void                      initNodeProbes_
+
+    ( Flex<String>&           colNames,
+      const Properties&       globdat );
+
+  void                      writeHeader_
+
+    ( const Flex<String>&     colNames );
+
+  void                      flush_          ();
+
+  void                      close_          ();
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<ProbeSet>             probes_;
+  Properties                params_;
+
+  // DOF indices of the node probes: the DOFs of node probe i are
+  // groupDofs_[groupOffsets_[i]] to groupDofs_[groupOffsets_[i + 1]]
+
+  IdxVector                 groupDofs_;
+  IdxVector                 groupOffsets_;
+
+  // one row per column of buffer_, so that the rows are contiguous
+
+  Matrix                    buffer_;
+  idx_t                     rowCount_;
+
+  std::FILE*                file_;
+  bool                      binary_;
+
+  String                    fileName_;
+  String                    format_;
+  idx_t                     interval_;
+  idx_t                     bufferSize_;
+  IdxVector                 elemIDs_;
+  IdxVector                 ipoints_;
+  StringVector              nodeGroups_;
+  StringVector              dofNames_;
+  idx_t                     runCount_;
+
+};
+
+
+#endif
@@ -11,11 +11,14 @@
  */
 
 #include <jem/base/System.h>
+#include <jem/base/Float.h>
 #include <jem/base/limits.h>
 #include <jem/base/Array.h>
 #include <jem/base/ArithmeticException.h>
+#include <jem/base/IllegalInputException.h>
 #include <jem/util/Event.h>
 #include <jem/util/Properties.h>
+#include <jive/fem/ElementSet.h>
 #include <jive/util/Globdat.h>
 #include <jive/util/ItemSet.h>
 #include <jive/util/DofSpace.h>
@@ -30,6 +33,7 @@
 
 #include "Names.h"
 #include "TimeStepModule.h"
+#include "SolverNames.h"
 
 
 using namespace jem;
@@ -56,9 +60,22 @@ TimeStepModule::TimeStepModule ( const String& name ) :
 
 {
   dtime_  =  1.0;
+  dtOld_  =  1.0;
   istep_  = -1;
   nodeID_ =  0;
   inode_  = -1;
+
+  autoStep_       = false;
+  safety_         = 0.9;
+  updateInterval_ = 0;
+
+  subcycle_       = false;
+  maxLevel_       = 4;
+  levelCount_     = 1;
+
+  stepsPerRun_    = 1;
+  commitInterval_ = 1;
+  reportInterval_ = 1;
 }
 
 
@@ -143,9 +160,25 @@ Module::Status TimeStepModule::run ( const Properties& globdat )
     return DONE;
   }
 
+  bool  restarted = false;
+
   if ( istep_ < 0 )
   {
     restart_ ( globdat );
+
+    restarted = true;
+  }
+
+  if ( subcycle_ )
+  {
+    if ( ! restarted && updateDue_() )
+    {
+      updateTimeStep_ ( globdat );
+      initLevels_     ( globdat );
+      initHalfStep_   ( globdat );
+    }
+
+    return runSubcycled_ ( globdat );
   }
 
   //System::out() << "Time run start\n";
@@ -154,7 +187,6 @@ Module::Status TimeStepModule::run ( const Properties& globdat )
   Ref<SparseMatrixBuilder>  mbuilder;
 
   const int     dofCount = rmass_.size ();
-  const double  dt2      = dtime_ * dtime_;
 
   Vector        fint ( dofCount );
   Vector        fext ( dofCount );
@@ -167,58 +199,80 @@ Module::Status TimeStepModule::run ( const Properties& globdat )
   double        t;
   int           i;
 
-  // Get the internal and external force vectors.
-
-  fint = 0.0;
-  fext = 0.0;
+  StateVector::get    ( u0, STATE0, dofs_, globdat );
+  StateVector::getOld ( u1, STATE0, dofs_, globdat );
 
   params.set ( ActionParams::INT_VECTOR, fint );
+  params.set ( ActionParams::EXT_VECTOR, fext );
 
-  model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+  cons = Constraints::find ( dofs_, globdat );
 
-  //System::out()<<fint<<"\n";
+  if ( cons != NIL )
+  {
+    params.set ( ActionParams::CONSTRAINTS, cons );
+  }
 
-  params.set ( ActionParams::EXT_VECTOR, fext );
+  globdat.get ( t, Globdat::TIME );
+  globdat.get ( i, Globdat::TIME_STEP );
 
-  model_->takeAction ( Actions::GET_EXT_VECTOR, params, globdat );
+  // Advance stepsPerRun_ steps. The model is committed every
+  // commitInterval_ steps and always after the last step, so that the
+  // output modules see a committed state. The prescribed values are
+  // updated every step.
 
-  // Get the state vectors and compute the state vector at the next
-  // time step.
+  for ( int is = 0; is < stepsPerRun_; is++ )
+  {
+    const bool  last = ( is == stepsPerRun_ - 1 );
 
-  StateVector::get    ( u0, STATE0, dofs_, globdat );
-  StateVector::getOld ( u1, STATE0, dofs_, globdat );
+    if ( ( is > 0 || ! restarted ) && updateDue_() )
+    {
+      updateTimeStep_ ( globdat );
+    }
 
-  u  = (fext - fint) * dt2 * rmass_ + 2.0 * u0 - u1;
-  u1 = u0;
-  u0 = u;
+    // Get the internal and external force vectors.
 
-  // Update the simulation time and time step.
+    fint = 0.0;
+    fext = 0.0;
 
-  globdat.get ( t, Globdat::TIME );
-  globdat.get ( i, Globdat::TIME_STEP );
+    model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+    model_->takeAction ( Actions::GET_EXT_VECTOR, params, globdat );
 
-  globdat.set ( Globdat::OLD_TIME,      t );
-  globdat.set ( Globdat::OLD_TIME_STEP, i );
-  globdat.set ( Globdat::TIME,          t + dtime_ );
-  globdat.set ( Globdat::TIME_STEP,     i + 1 );
+    // Compute the state vector at the next time step.
 
-  istep_++;
+    centralStep ( u, u0, u1, fint, fext, rmass_, dtime_, dtOld_ );
 
-  model_->takeAction ( Actions::COMMIT, params, globdat );
+    dtOld_ = dtime_;
 
-  System::out() << "on time: " << t << " in step: " << i << "\n\n";
+    // Update the simulation time and time step.
 
-  // Set the prescribed values if necessary.
+    globdat.set ( Globdat::OLD_TIME,      t );
+    globdat.set ( Globdat::OLD_TIME_STEP, i );
+    globdat.set ( Globdat::TIME,          t + dtime_ );
+    globdat.set ( Globdat::TIME_STEP,     i + 1 );
 
-  cons = Constraints::find ( dofs_, globdat );
+    istep_++;
 
-  if ( cons != NIL )
-  {
-    params.set ( ActionParams::CONSTRAINTS, cons );
+    if ( last || istep_ % commitInterval_ == 0 )
+    {
+      model_->takeAction ( Actions::COMMIT, params, globdat );
+    }
 
-    model_->takeAction ( Actions::GET_CONSTRAINTS, params, globdat );
+    // Set the prescribed values if necessary.
 
-    setSlaveDofs ( u0, *cons );
+    if ( cons != NIL )
+    {
+      model_->takeAction ( Actions::GET_CONSTRAINTS, params, globdat );
+
+      setSlaveDofs ( u0, *cons );
+    }
+
+    if ( istep_ % reportInterval_ == 0 )
+    {
+      System::out() << "on time: " << t << " in step: " << i << "\n\n";
+    }
+
+    t += dtime_;
+    i += 1;
   }
 
   // Save the displacements in the selected node if it exists.
@@ -268,6 +322,21 @@ void TimeStepModule::configure
 
   myProps.find ( dtime_,  PropNames::DTIME, 1.0e-20, 1.0e20 );
   myProps.find ( nodeID_, PropNames::NODE );
+
+  myProps.find ( autoStep_,       PropNames::AUTO_STEP );
+  myProps.find ( safety_,         PropNames::SAFETY, 0.0, 1.0 );
+  myProps.find ( updateInterval_, PropNames::UPDATE_INTERVAL,
+                 0,               maxOf( updateInterval_ ) );
+
+  myProps.find ( subcycle_,       PropNames::SUBCYCLING );
+  myProps.find ( maxLevel_,       PropNames::MAX_LEVEL, 0, 20 );
+
+  myProps.find ( stepsPerRun_,    PropNames::STEPS_PER_RUN,
+                 1,               maxOf( stepsPerRun_ ) );
+  myProps.find ( commitInterval_, PropNames::COMMIT_INTERVAL,
+                 1,               maxOf( commitInterval_ ) );
+  myProps.find ( reportInterval_, PropNames::REPORT_INTERVAL,
+                 1,               maxOf( reportInterval_ ) );
 }
 
 
@@ -286,6 +355,48 @@ void TimeStepModule::getConfig
 
   myConf.set ( PropNames::DTIME, dtime_ );
   myConf.set ( PropNames::NODE,  nodeID_ );
+
+  myConf.set ( PropNames::AUTO_STEP,       autoStep_       );
+  myConf.set ( PropNames::SAFETY,          safety_         );
+  myConf.set ( PropNames::UPDATE_INTERVAL, updateInterval_ );
+
+  myConf.set ( PropNames::SUBCYCLING,      subcycle_       );
+  myConf.set ( PropNames::MAX_LEVEL,       maxLevel_       );
+
+  myConf.set ( PropNames::STEPS_PER_RUN,   stepsPerRun_    );
+  myConf.set ( PropNames::COMMIT_INTERVAL, commitInterval_ );
+  myConf.set ( PropNames::REPORT_INTERVAL, reportInterval_ );
+}
+
+
+//-----------------------------------------------------------------------
+//   centralStep
+//-----------------------------------------------------------------------
+
+// Advances the displacements u0 at the current time, and u1 at the
+// previous time, with one step of the central difference scheme with a
+// variable time step; dt2 and rdt reduce to dtime^2 and 1 for a
+// constant time step. The new displacements are also stored in u. The
+// prescribed values are not set.
+
+void TimeStepModule::centralStep
+
+  ( const Vector&  u,
+    const Vector&  u0,
+    const Vector&  u1,
+    const Vector&  fint,
+    const Vector&  fext,
+    const Vector&  rmass,
+    double         dtime,
+    double         dtOld )
+
+{
+  const double  rdt = dtime / dtOld;
+  const double  dt2 = 0.5 * dtime * (dtime + dtOld);
+
+  u  = (fext - fint) * dt2 * rmass + (1.0 + rdt) * u0 - rdt * u1;
+  u1 = u0;
+  u0 = u;
 }
 
 
@@ -312,6 +423,53 @@ void TimeStepModule::restart_ ( const Properties& globdat )
 
   Vector        fext(dofCount);
 
+  bool          linear = true;
+
+
+  // Without a commit the material of an element starts each step from
+  // the last committed history, so the commits may only be skipped for
+  // a model without history. Subcycling commits once per macro step,
+  // so it has the same restriction.
+
+  if ( commitInterval_ > 1 || ( subcycle_ && maxLevel_ > 0 ) )
+  {
+    params.set ( SolverNames::LINEAR, linear );
+
+    if ( ! model_->takeAction( SolverNames::CHECK_LINEAR, params,
+                               globdat ) )
+    {
+      linear = false;
+    }
+    else
+    {
+      params.get ( linear, SolverNames::LINEAR );
+    }
+
+    params.clear ();
+
+    if ( ! linear && commitInterval_ > 1 )
+    {
+      throw IllegalInputException (
+        context,
+        String::format (
+          "%s = %d requires a linear model",
+          PropNames::COMMIT_INTERVAL, commitInterval_
+        )
+      );
+    }
+
+    if ( ! linear )
+    {
+      throw IllegalInputException (
+        context,
+        String::format (
+          "%s requires a linear model",
+          PropNames::SUBCYCLING
+        )
+      );
+    }
+  }
+
   fext = 0.0;
 
   // Assemble the lumped mass matrix.
@@ -364,7 +522,390 @@ void TimeStepModule::restart_ ( const Properties& globdat )
 
   a0 = fext*rmass_;
 
+  if ( autoStep_ )
+  {
+    updateTimeStep_ ( globdat );
+  }
+
+  dtOld_ = dtime_;
+
   u1 = u0 - dtime_ * v0 + (0.5 * dtime_ * dtime_) * a0;
+
+  // With subcycling the first substep uses the accelerations in STATE2,
+  // so they must include the internal forces of all elements.
+
+  if ( subcycle_ )
+  {
+    Vector  fint ( dofCount );
+
+    fint = 0.0;
+
+    params.set ( ActionParams::INT_VECTOR, fint );
+
+    model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+
+    a0 = (fext - fint) * rmass_;
+
+    initLevels_   ( globdat );
+    initHalfStep_ ( globdat );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   updateDue_
+//-----------------------------------------------------------------------
+
+
+bool TimeStepModule::updateDue_ () const
+{
+  return ( autoStep_ && updateInterval_ > 0 &&
+           istep_ % updateInterval_ == 0 );
+}
+
+
+//-----------------------------------------------------------------------
+//   runSubcycled_
+//-----------------------------------------------------------------------
+
+// Advances one macro step of 2^(levelCount_-1) substeps of dtime. In
+// substep s the levels k with s % 2^k == 0 are active: the velocities
+// of their DOFs are updated with the time step dtime * 2^k, using the
+// internal forces of the elements attached to them only. All
+// displacements are advanced every substep with the current velocity,
+// which interpolates the inactive (coarser) nodes linearly in time at
+// the interfaces. The model is committed once per macro step.
+//
+// The staggered velocities are kept in vhalf_. At the end of the macro
+// step all levels are at the same time; the forces of all elements are
+// evaluated there, and the velocities are completed with half a step of
+// their level, so that STATE1 and STATE2 hold the synchronized
+// velocities and accelerations. All levels are active in the first
+// substep, which reuses these accelerations instead of evaluating the
+// same forces again.
+
+Module::Status TimeStepModule::runSubcycled_ ( const Properties& globdat )
+{
+  using jive::util::Constraints;
+  using jive::util::setSlaveDofs;
+  using jive::model::STATE0;
+  using jive::model::STATE1;
+  using jive::model::STATE2;
+
+  const int     dofCount  = rmass_.size ();
+  const int     elemCount = elemLevel_.size ();
+  const int     subCount  = 1 << (levelCount_ - 1);
+
+  Ref<Constraints>  cons  = Constraints::find ( dofs_, globdat );
+
+  Vector        fint ( dofCount );
+  Vector        fext ( dofCount );
+  Vector        u0, u1, v0, a0;
+
+  Properties    params;
+
+  double        t;
+  int           i;
+
+
+  StateVector::get    ( u0, STATE0, dofs_, globdat );
+  StateVector::getOld ( u1, STATE0, dofs_, globdat );
+  StateVector::get    ( v0, STATE1, dofs_, globdat );
+  StateVector::get    ( a0, STATE2, dofs_, globdat );
+
+  u1 = u0;
+
+  // The external forces are evaluated once per macro step.
+
+  fext = 0.0;
+
+  params.set ( ActionParams::EXT_VECTOR, fext );
+
+  model_->takeAction ( Actions::GET_EXT_VECTOR, params, globdat );
+
+  params.set ( ActionParams::INT_VECTOR,   fint    );
+  params.set ( SolverNames::ACTIVE_ELEMS,  active_ );
+
+  for ( int is = 0; is < subCount; is++ )
+  {
+    int  kmax = 0;
+
+    while ( kmax + 1 < levelCount_ && is % (2 << kmax) == 0 )
+    {
+      kmax++;
+    }
+
+    if ( is > 0 )
+    {
+      for ( int ie = 0; ie < elemCount; ie++ )
+      {
+        active_[ie] = ( elemLevel_[ie] <= kmax );
+      }
+
+      fint = 0.0;
+
+      model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+
+      for ( int j = 0; j < dofCount; j++ )
+      {
+        if ( dofLevel_[j] <= kmax )
+        {
+          a0[j] = (fext[j] - fint[j]) * rmass_[j];
+        }
+      }
+    }
+
+    for ( int j = 0; j < dofCount; j++ )
+    {
+      if ( dofLevel_[j] <= kmax )
+      {
+        vhalf_[j] += dtime_ * (double) (1 << dofLevel_[j]) * a0[j];
+      }
+
+      u0[j] += dtime_ * vhalf_[j];
+    }
+
+    if ( cons != NIL )
+    {
+      setSlaveDofs ( u0, *cons );
+    }
+  }
+
+  // Update the simulation time and time step.
+
+  globdat.get ( t, Globdat::TIME );
+  globdat.get ( i, Globdat::TIME_STEP );
+
+  globdat.set ( Globdat::OLD_TIME,      t );
+  globdat.set ( Globdat::OLD_TIME_STEP, i );
+  globdat.set ( Globdat::TIME,          t + subCount * dtime_ );
+  globdat.set ( Globdat::TIME_STEP,     i + 1 );
+
+  istep_++;
+
+  // Synchronize the velocities at the end of the macro step.
+
+  active_ = true;
+  fext    = 0.0;
+  fint    = 0.0;
+
+  model_->takeAction ( Actions::GET_EXT_VECTOR, params, globdat );
+  model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
+
+  for ( int j = 0; j < dofCount; j++ )
+  {
+    a0[j] = (fext[j] - fint[j]) * rmass_[j];
+    v0[j] = vhalf_[j] +
+            0.5 * dtime_ * (double) (1 << dofLevel_[j]) * a0[j];
+  }
+
+  model_->takeAction ( Actions::COMMIT, params, globdat );
+
+  System::out() << "on time: " << t << " in step: " << i << " ("
+                << subCount << " substeps)\n\n";
+
+  // Set the prescribed values if necessary.
+
+  if ( cons != NIL )
+  {
+    params.set ( ActionParams::CONSTRAINTS, cons );
+
+    model_->takeAction ( Actions::GET_CONSTRAINTS, params, globdat );
+
+    setSlaveDofs ( u0, *cons );
+  }
+
+  // Save the displacements in the selected node if it exists.
+
+  if ( inode_ >= 0 )
+  {
+    const int   typeCount = dofs_->typeCount      ();
+    Properties  myVars    = Globdat::getVariables ( myName_, globdat );
+
+    for ( i = 0; i < typeCount; i++ )
+    {
+      String  typeName = dofs_->getTypeName ( i );
+      int     idof     = dofs_->getDofIndex ( inode_, i );
+
+      myVars.set ( typeName, u0[idof] );
+    }
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   initLevels_
+//-----------------------------------------------------------------------
+
+// Bins the elements by their stable time step: level k if dtime * 2^k
+// does not exceed safety times the stable time step. A node gets the
+// smallest level of its elements, so that the interface nodes are
+// advanced with the smaller time step. An element is active whenever
+// one of its nodes is; its level is the smallest level of its nodes.
+// Elements without an estimate stay at level 0.
+
+void TimeStepModule::initLevels_ ( const Properties& globdat )
+{
+  using jive::fem::ElementSet;
+  using jive::util::Assignable;
+
+  Assignable<ElementSet>  elems = ElementSet::get ( globdat, getContext() );
+
+  const int     elemCount = elems.size ();
+  const int     nodeCount = dofs_->getItems()->size ();
+  const int     typeCount = dofs_->typeCount ();
+  const int     dofCount  = dofs_->dofCount  ();
+
+  IdxVector     inodes    ( elems.maxElemNodeCount() );
+  Vector        elemSteps ( elemCount );
+  IntVector     nodeLevel ( nodeCount );
+  IntVector     counts    ( maxLevel_ + 1 );
+
+  Properties    params;
+
+  int           top = 0;
+
+
+  elemSteps = Float::MAX_VALUE;
+
+  params.set ( SolverNames::CRIT_TIME_STEP, Float::MAX_VALUE );
+  params.set ( SolverNames::ELEM_CRIT_STEP, elemSteps );
+
+  model_->takeAction ( SolverNames::GET_CRIT_TIME_STEP, params, globdat );
+
+  nodeLevel = maxLevel_;
+
+  for ( int ie = 0; ie < elemCount; ie++ )
+  {
+    const int     n  = elems.getElemNodeCount ( ie );
+    const double  dt = safety_ * elemSteps[ie];
+
+    int           k  = 0;
+
+    while ( k < maxLevel_ && elemSteps[ie] < Float::MAX_VALUE &&
+            dtime_ * (double) (2 << k) <= dt )
+    {
+      k++;
+    }
+
+    elems.getElemNodes ( inodes[slice(BEGIN,n)], ie );
+
+    for ( int in = 0; in < n; in++ )
+    {
+      nodeLevel[inodes[in]] = min ( nodeLevel[inodes[in]], k );
+    }
+  }
+
+  elemLevel_.resize ( elemCount );
+  active_   .resize ( elemCount );
+  dofLevel_ .resize ( dofCount  );
+
+  for ( int ie = 0; ie < elemCount; ie++ )
+  {
+    const int  n = elems.getElemNodeCount ( ie );
+
+    elems.getElemNodes ( inodes[slice(BEGIN,n)], ie );
+
+    elemLevel_[ie] = maxLevel_;
+
+    for ( int in = 0; in < n; in++ )
+    {
+      elemLevel_[ie] = min ( elemLevel_[ie], nodeLevel[inodes[in]] );
+    }
+  }
+
+  dofLevel_ = 0;
+  counts    = 0;
+
+  for ( int in = 0; in < nodeCount; in++ )
+  {
+    for ( int it = 0; it < typeCount; it++ )
+    {
+      const int  idof = dofs_->findDofIndex ( in, it );
+
+      if ( idof >= 0 )
+      {
+        dofLevel_[idof] = nodeLevel[in];
+      }
+    }
+
+    counts[nodeLevel[in]]++;
+
+    top = max ( top, nodeLevel[in] );
+  }
+
+  levelCount_ = top + 1;
+
+  System::info( myName_ ) << myName_ << " : subcycling with "
+                          << levelCount_ << " levels, nodes per level: "
+                          << counts[slice(BEGIN,levelCount_)] << "\n";
+}
+
+
+//-----------------------------------------------------------------------
+//   initHalfStep_
+//-----------------------------------------------------------------------
+
+// Computes the staggered velocities of the subcycling scheme from the
+// synchronized velocities and accelerations, with the current time
+// step and levels. Must be called whenever the levels are changed, as
+// the offset of the velocity of a DOF depends on its level.
+
+void TimeStepModule::initHalfStep_ ( const Properties& globdat )
+{
+  using jive::model::STATE1;
+  using jive::model::STATE2;
+
+  const int  dofCount = dofLevel_.size ();
+
+  Vector     v0, a0;
+
+  StateVector::get ( v0, STATE1, dofs_, globdat );
+  StateVector::get ( a0, STATE2, dofs_, globdat );
+
+  vhalf_.resize ( dofCount );
+
+  for ( int j = 0; j < dofCount; j++ )
+  {
+    vhalf_[j] = v0[j] -
+                0.5 * dtime_ * (double) (1 << dofLevel_[j]) * a0[j];
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   updateTimeStep_
+//-----------------------------------------------------------------------
+
+// Sets the time step to a fraction safety of the critical time step of
+// the model (autoStep only). The time step is kept if the model gives
+// no estimate.
+
+void TimeStepModule::updateTimeStep_ ( const Properties& globdat )
+{
+  Properties  params;
+  double      dtcrit = Float::MAX_VALUE;
+
+  params.set ( SolverNames::CRIT_TIME_STEP, dtcrit );
+
+  model_->takeAction ( SolverNames::GET_CRIT_TIME_STEP, params, globdat );
+
+  params.get ( dtcrit, SolverNames::CRIT_TIME_STEP );
+
+  if ( dtcrit >= Float::MAX_VALUE )
+  {
+    System::warn() << myName_ << " : no critical time step available, "
+                   << "using dtime = " << dtime_ << "\n";
+
+    return;
+  }
+
+  dtime_ = safety_ * dtcrit;
+
+  System::info( myName_ ) << myName_ << " : critical time step = "
+                          << dtcrit << ", dtime = " << dtime_ << "\n";
 }
 
 
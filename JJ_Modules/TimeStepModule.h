@@ -56,6 +56,17 @@ class TimeStepModule : public Module
       const Properties&       props,
       const Properties&       globdat);
 
+  static void               centralStep
+
+    ( const Vector&           u,
+      const Vector&           u0,
+      const Vector&           u1,
+      const Vector&           fint,
+      const Vector&           fext,
+      const Vector&           rmass,
+      double                  dtime,
+      double                  dtOld );
+
  protected:
 
   virtual                  ~TimeStepModule  ();
@@ -69,6 +80,24 @@ class TimeStepModule : public Module
 
   void                      invalidate_     ();
 
+  void                      updateTimeStep_
+
+    ( const Properties&       globdat );
+
+  bool                      updateDue_      () const;
+
+  Status                    runSubcycled_
+
+    ( const Properties&       globdat );
+
+  void                      initLevels_
+
+    ( const Properties&       globdat );
+
+  void                      initHalfStep_
+
+    ( const Properties&       globdat );
+
 
  private:
 
@@ -76,6 +105,51 @@ class TimeStepModule : public Module
   Ref<DofSpace>             dofs_;
   Vector                    rmass_;
   double                    dtime_;
+  double                    dtOld_;
+
+  // automatic time step: safety_ times the critical time step of the
+  // model, updated every updateInterval_ steps (only at restart if 0);
+  // SolidModel only estimates it for 2D Triangle3 and Quad4 elements,
+  // otherwise the given time step is kept
+
+  bool                      autoStep_;
+  double                    safety_;
+  int                       updateInterval_;
+
+  // subcycling: the elements are binned in levels 0..maxLevel_ by their
+  // stable time step; a node advances with dtime * 2^k, with k the
+  // smallest level of its elements, and one run is a macro step of
+  // 2^(levelCount_-1) substeps of dtime. TIME_STEP is incremented once
+  // per macro step, so a condition like "i < 1000" on the step number
+  // counts macro steps, whose length changes when the levels are
+  // recomputed. vhalf_ holds the velocities at the half steps of the
+  // level of each DOF; STATE1 holds the synchronized velocities at the
+  // end of the macro step. The model is committed once per macro step,
+  // so subcycling with maxLevel_ > 0 is only accepted for a linear
+  // model (CHECK_LINEAR).
+
+  bool                      subcycle_;
+  int                       maxLevel_;
+  int                       levelCount_;
+  IntVector                 dofLevel_;
+  IntVector                 elemLevel_;
+  BoolVector                active_;
+  Vector                    vhalf_;
+
+  // batching: a run advances stepsPerRun_ steps; the model is committed
+  // every commitInterval_ steps and at the end of a run, and the time
+  // step is printed every reportInterval_ steps. A commitInterval_ > 1
+  // is only accepted for a linear model (CHECK_LINEAR), since an
+  // uncommitted material starts every step from the old history. The
+  // runWhile condition of the program is only tested between runs, so
+  // the step number may pass a bound like "i < 1000" by up to
+  // stepsPerRun_ - 1 steps; choose stepsPerRun_ as a divisor of the
+  // step count to stop exactly.
+
+  int                       stepsPerRun_;
+  int                       commitInterval_;
+  int                       reportInterval_;
+
   int                       istep_;
   int                       nodeID_;
   int                       inode_;
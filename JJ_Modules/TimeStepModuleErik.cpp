@@ -13,9 +13,11 @@
  */
 
 #include <jem/base/System.h>
+#include <jem/base/Float.h>
 #include <jem/base/limits.h>
 #include <jem/base/Array.h>
 #include <jem/base/ArithmeticException.h>
+#include <jem/base/PrecheckException.h>
 #include <jem/util/Event.h>
 #include <jem/util/Properties.h>
 #include <jive/util/Globdat.h>
@@ -32,6 +34,7 @@
 
 #include "Names.h"
 #include "TimeStepModuleErik.h"
+#include "SolverNames.h"
 
 
 using namespace jem;
@@ -58,8 +61,16 @@ TimeStepModuleErik::TimeStepModuleErik ( const String& name ) :
 
 {
   dtime_  =  1.0;
+  dtOld_  =  1.0;
   istep_  = -1;
   BCtype_ = 0; // default = displacement boundary conditions
+
+  newSlaves_      = true;
+  relCount_       = 0;
+
+  autoStep_       = false;
+  safety_         = 0.9;
+  updateInterval_ = 0;
 }
 
 
@@ -86,6 +97,11 @@ void TimeStepModuleErik::configure
   myProps.find ( TermGroups_ , "TermGroups" );
   myProps.find ( TermDofs_   , "TermDofs"   );
   myProps.find ( TermSteps_  , "TermSteps"  );
+
+  myProps.find ( autoStep_,       PropNames::AUTO_STEP );
+  myProps.find ( safety_,         PropNames::SAFETY, 0.0, 1.0 );
+  myProps.find ( updateInterval_, PropNames::UPDATE_INTERVAL,
+                 0,               maxOf( updateInterval_ ) );
 }
 
 
@@ -108,6 +124,10 @@ void TimeStepModuleErik::getConfig
   myConf.set ( "TermGroups", TermGroups_ );
   myConf.set ( "TermDofs"  , TermDofs_   );
   myConf.set ( "TermSteps" , TermSteps_  );
+
+  myConf.set ( PropNames::AUTO_STEP,       autoStep_       );
+  myConf.set ( PropNames::SAFETY,          safety_         );
+  myConf.set ( PropNames::UPDATE_INTERVAL, updateInterval_ );
 }
 
 
@@ -149,6 +169,15 @@ Module::Status TimeStepModuleErik::init
   connect ( dofs_->newSizeEvent,  this, &Self::invalidate_ );
   connect ( dofs_->newOrderEvent, this, &Self::invalidate_ );
 
+  // Keep track of the prescribed DOFs.
+
+  cons_      = Constraints::get ( dofs_, globdat );
+  newSlaves_ = true;
+
+  connect ( cons_->newStructEvent, this, &Self::slavesChanged_ );
+
+  params_.set ( ActionParams::CONSTRAINTS, cons_ );
+
 
   // Initialize the global simulation time and the time step number.
 
@@ -182,12 +211,10 @@ Module::Status TimeStepModuleErik::init
 Module::Status TimeStepModuleErik::run ( const Properties& globdat )
 {
   System::out() << "TimeStepModuleErik: run called!\n";
-  using jive::util::Constraints;
   using jive::util::setSlaveDofs;
   using jive::model::STATE0;
   using jive::model::STATE1;
   using jive::model::STATE2;
-  using jive::algebra::SparseMatrixBuilder;
 
   if ( model_ == NIL )
   {
@@ -198,47 +225,37 @@ Module::Status TimeStepModuleErik::run ( const Properties& globdat )
   {
     restart_ ( globdat );
   }
+  else if ( autoStep_ && updateInterval_ > 0 &&
+            istep_ % updateInterval_ == 0 )
+  {
+    updateTimeStep_ ( globdat );
+  }
 
-  //System::out() << "Time run start\n";
-
-  Ref<Constraints>  cons;
-  Ref<SparseMatrixBuilder>  mbuilder;
-
-  const int     dofCount = rmass_.size ();
-  const double  dt2      = dtime_ * dtime_;
-
-  Vector        fint ( dofCount );
-  Vector        fext ( dofCount );
-
-  Vector        u    ( dofCount );
-  Vector        u2   ( dofCount );
-  Vector        v    ( dofCount );
-  Vector        a    ( dofCount );
-  Vector        u0, u1, v0, v1, a0, a1;
+  const idx_t   dofCount = rmass_.size ();
+  const double  dtPrev   = dtOld_;
+  const double  rdt      = dtime_ / dtPrev;
+  const double  rdt1     = 1.0 + rdt;
+  const double  dt2      = 0.5 * dtime_ * (dtime_ + dtPrev);
+  const double  rdtv     = 1.0 / dtime_;
+  const double  rdta     = 1.0 / dt2;
 
-  Properties    params;
+  Vector        u0, u1, v0, a0;
 
   double        t;
   int           i;
 
   // Get the internal and external force vectors.
 
-  fint = 0.0;
-  fext = 0.0;
+  fint_ = 0.0;
+  fext_ = 0.0;
 
-  params.set ( ActionParams::INT_VECTOR, fint );
-  params.set ( PropertyNames::DTIME, dtime_ );
+  params_.set ( PropertyNames::DTIME, dtime_ );
   
-  model_->takeAction ( Actions::ADVANCE, params, globdat );
-
-  model_->takeAction ( Actions::GET_INT_VECTOR, params, globdat );
- 
+  model_->takeAction ( Actions::ADVANCE, params_, globdat );
 
-  //System::out()<<fint<<"\n";
+  model_->takeAction ( Actions::GET_INT_VECTOR, params_, globdat );
 
-  params.set ( ActionParams::EXT_VECTOR, fext );
-
-  model_->takeAction ( Actions::GET_EXT_VECTOR, params, globdat );
+  model_->takeAction ( Actions::GET_EXT_VECTOR, params_, globdat );
 
   // Get the state vectors and compute the state vector at the next
   // time step.
@@ -248,12 +265,37 @@ Module::Status TimeStepModuleErik::run ( const Properties& globdat )
   StateVector::get    ( v0, STATE1, dofs_, globdat );
   StateVector::get    ( a0, STATE2, dofs_, globdat );
 
-  u  = (fext - fint) * dt2 * rmass_ + 2.0 * u0 - u1;
-  //System::out() << u1 << "\n" << u0 << "\n" << u << "\n";
-  
-  u2 = u1;
-  u1 = u0;
-  u0 = u;
+  JEM_PRECHECK ( u0.isContiguous() && u1.isContiguous() &&
+                 v0.isContiguous() && a0.isContiguous() );
+
+  // Central differences with a variable time step; dt2 and rdt reduce
+  // to dtime^2 and 1 for a constant time step. The displacements,
+  // velocities and accelerations are updated in a single pass; the
+  // prescribed DOFs are corrected below.
+
+  {
+    const double*  fi = fint_ .addr ();
+    const double*  fe = fext_ .addr ();
+    const double*  rm = rmass_.addr ();
+
+    double*        pu0 = u0 .addr ();
+    double*        pu1 = u1 .addr ();
+    double*        pu2 = u2_.addr ();
+    double*        pv  = v0 .addr ();
+    double*        pa  = a0 .addr ();
+
+    for ( idx_t j = 0; j < dofCount; j++ )
+    {
+      const double  un = (fe[j] - fi[j]) * dt2 * rm[j] +
+                         rdt1 * pu0[j] - rdt * pu1[j];
+
+      pu2[j] = pu1[j];
+      pu1[j] = pu0[j];
+      pu0[j] = un;
+      pv[j]  = (un - pu1[j]) * rdtv;
+      pa[j]  = (un - rdt1 * pu1[j] + rdt * pu2[j]) * rdta;
+    }
+  }
 
   // Update the simulation time and time step.
 
@@ -267,97 +309,99 @@ Module::Status TimeStepModuleErik::run ( const Properties& globdat )
 
   istep_++;
 
-  model_->takeAction ( Actions::COMMIT, params, globdat );
+  model_->takeAction ( Actions::COMMIT, params_, globdat );
 
   System::out() << "on time: " << t << " in step: " << i << "\n\n";
 
-  
-
-  // Set the prescribed values if necessary.
-  cons = Constraints::find ( dofs_, globdat );
-  params.set ( ActionParams::CONSTRAINTS, cons );
-  
   // set the constraints given by the models. This includes LoadScaleModel etc.
-  model_->takeAction ( Actions::GET_CONSTRAINTS, params, globdat );
+  model_->takeAction ( Actions::GET_CONSTRAINTS, params_, globdat );
 
   
-  // Check if any constraints need to be removed for the current time step.
-  Assignable<NodeGroup> group;
-  IdxVector             inodes;
-  
-  for ( idx_t ig = 0; ig < TermSteps_.size(); ig++ )
+  // Release the constraints of the events that have been reached. The
+  // released DOFs are erased again only when the structure of the
+  // constraints has changed, that is, when a model has put them back.
+
+  const idx_t  eventCount = relSteps_.size ();
+  bool         release    = newSlaves_;
+
+  while ( relCount_ < eventCount && i >= relSteps_[relCount_] )
   {
-  
-      if ( i >= TermSteps_[ig] )
-      {
-      // find nodeGroups of which the BC has to be deleted at some point
-      group  = NodeGroup::get ( TermGroups_[ig], nodes_, globdat, getContext() );
-
-      // find node indices
-      idx_t nn = group.size();
-      inodes . resize ( nn );
-      inodes = group.getIndices ();
-    
-      // find dof types
-      idx_t itype  = dofs_->findType ( TermDofs_[ig] );
-    
-      for ( idx_t in = 0; in < nn; in++ )
-      {
-        // find dof index and remove from the constraints
-        idx_t idof = dofs_->getDofIndex ( inodes[in], itype );
-        cons->eraseConstraint(idof);
-      }
-    }
+    relCount_++;
+    release = true;
   }
 
-  
-  // Prescribe values on the remaining constraints
-  if ( cons != NIL )
+  if ( release )
   {
-  
-    if ( BCtype_ == 0 )
+    const idx_t  relDofCount = relOffsets_[relCount_];
+
+    for ( idx_t k = 0; k < relDofCount; k++ )
     {
-      // applied displacement
-      setSlaveDofs ( u0, *cons );
+      cons_->eraseConstraint ( relDofs_[k] );
     }
-    else if ( BCtype_ == 1 )
+  }
+
+  // Prescribe values on the remaining constraints, and correct the
+  // other two quantities at the prescribed DOFs only.
+
+  if ( newSlaves_ )
+  {
+    slaveDofs_.ref ( cons_->getSlaveDofs() );
+
+    newSlaves_ = false;
+  }
+
+  const idx_t  slaveCount = slaveDofs_.size ();
+
+  if ( BCtype_ == 0 )
+  {
+    // applied displacement
+    setSlaveDofs ( u0, *cons_ );
+
+    for ( idx_t k = 0; k < slaveCount; k++ )
     {
-      // applied velocity
-      
-      // compute current guess for velocity
-      v = 1./dtime_ * ( u0 - u1 );
-      setSlaveDofs ( v, *cons );
-    
-      // compute constrained displacement for new time step
-      u0 = v * dtime_ + u1;
+      const idx_t  j = slaveDofs_[k];
+
+      v0[j] = (u0[j] - u1[j]) * rdtv;
+      a0[j] = (u0[j] - rdt1 * u1[j] + rdt * u2_[j]) * rdta;
     }
-    else if ( BCtype_ == 2 )
+  }
+  else if ( BCtype_ == 1 )
+  {
+    // applied velocity
+    setSlaveDofs ( v0, *cons_ );
+
+    // compute constrained displacement for new time step
+    for ( idx_t k = 0; k < slaveCount; k++ )
     {
-      // applied acceleration
-      
-      // compute current guess for acceleration
-      a = 1./dt2 * ( u0 - 2*u1 + u2 );
-      setSlaveDofs ( a, *cons );
-      
-      // compute constrained displacement for new time step
-      u0 = dt2 * a + 2 * u1 - u2;
+      const idx_t  j = slaveDofs_[k];
+
+      u0[j] = v0[j] * dtime_ + u1[j];
+      a0[j] = (u0[j] - rdt1 * u1[j] + rdt * u2_[j]) * rdta;
     }
-    else
+  }
+  else if ( BCtype_ == 2 )
+  {
+    // applied acceleration
+    setSlaveDofs ( a0, *cons_ );
+      
+    // compute constrained displacement for new time step
+    for ( idx_t k = 0; k < slaveCount; k++ )
     {
-      throw IllegalInputException (
-        getContext (),
-        "Unknown prescribed boundary type! Please chose displacement (0), velocity (1) or acceleration (2)."
-        );
+      const idx_t  j = slaveDofs_[k];
+
+      u0[j] = dt2 * a0[j] + rdt1 * u1[j] - rdt * u2_[j];
+      v0[j] = (u0[j] - u1[j]) * rdtv;
     }
   }
+  else
+  {
+    throw IllegalInputException (
+      getContext (),
+      "Unknown prescribed boundary type! Please chose displacement (0), velocity (1) or acceleration (2)."
+      );
+  }
 
-  
-  // compute actual acceleration and velocity
-  v = 1./dtime_ * ( u0 - u1 );
-  a = 1./dt2 * ( u0 - 2*u1 + u2 );
-  
-  v0 = v;
-  a0 = a;
+  dtOld_ = dtime_;
 
   return OK;
 }
@@ -455,10 +499,159 @@ void TimeStepModuleErik::restart_ ( const Properties& globdat )
 
   a0 = fext*rmass_;
 
+  // Allocate the work vectors used by run.
+
+  fint_.resize ( dofCount );
+  fext_.resize ( dofCount );
+  u2_  .resize ( dofCount );
+
+  params_.set ( ActionParams::INT_VECTOR, fint_ );
+  params_.set ( ActionParams::EXT_VECTOR, fext_ );
+
+  newSlaves_ = true;
+
+  compileReleases_ ( globdat );
+
+  if ( autoStep_ )
+  {
+    updateTimeStep_ ( globdat );
+  }
+
+  dtOld_ = dtime_;
+
   u1 = u0 - dtime_ * v0 + (0.5 * dtime_ * dtime_) * a0;
 }
 
 
+//-----------------------------------------------------------------------
+//   updateTimeStep_
+//-----------------------------------------------------------------------
+
+// Sets the time step to a fraction safety of the critical time step of
+// the model (autoStep only). The time step is kept if the model gives
+// no estimate.
+
+void TimeStepModuleErik::updateTimeStep_ ( const Properties& globdat )
+{
+  Properties  params;
+  double      dtcrit = Float::MAX_VALUE;
+
+  params.set ( SolverNames::CRIT_TIME_STEP, dtcrit );
+
+  model_->takeAction ( SolverNames::GET_CRIT_TIME_STEP, params, globdat );
+
+  params.get ( dtcrit, SolverNames::CRIT_TIME_STEP );
+
+  if ( dtcrit >= Float::MAX_VALUE )
+  {
+    System::warn() << myName_ << " : no critical time step available, "
+                   << "using dtime = " << dtime_ << "\n";
+
+    return;
+  }
+
+  dtime_ = safety_ * dtcrit;
+
+  System::info( myName_ ) << myName_ << " : critical time step = "
+                          << dtcrit << ", dtime = " << dtime_ << "\n";
+}
+
+
+//-----------------------------------------------------------------------
+//   compileReleases_
+//-----------------------------------------------------------------------
+
+// Translates the release schedule (TermGroups, TermDofs, TermSteps) to
+// a list of events sorted by step, each with the indices of the DOFs to
+// be released. The events are applied in run as the steps are reached.
+
+void TimeStepModuleErik::compileReleases_ ( const Properties& globdat )
+{
+  const String  context    = getContext ();
+  const idx_t   eventCount = TermSteps_.size ();
+
+  Assignable<NodeGroup>  group;
+
+  IdxVector     order  ( eventCount );
+  IdxVector     itypes ( eventCount );
+  IdxVector     counts ( eventCount );
+
+
+  if ( TermGroups_.size() != eventCount ||
+       TermDofs_  .size() != eventCount )
+  {
+    throw IllegalInputException (
+      context,
+      "TermGroups, TermDofs and TermSteps must have the same length"
+    );
+  }
+
+  // Sort the events by step; the schedule is short, so insertion sort
+  // will do. Events with the same step keep their input order.
+
+  for ( idx_t ie = 0; ie < eventCount; ie++ )
+  {
+    idx_t  j = ie;
+
+    while ( j > 0 && TermSteps_[order[j - 1]] > TermSteps_[ie] )
+    {
+      order[j] = order[j - 1];
+      j--;
+    }
+
+    order[j] = ie;
+  }
+
+  // Count the DOFs of the events and check the input.
+
+  idx_t  relDofCount = 0;
+
+  for ( idx_t ie = 0; ie < eventCount; ie++ )
+  {
+    group      = NodeGroup::get ( TermGroups_[ie], nodes_,
+                                  globdat, context );
+    itypes[ie] = dofs_->findType ( TermDofs_[ie] );
+
+    if ( itypes[ie] < 0 )
+    {
+      throw IllegalInputException (
+        context,
+        String::format ( "undefined DOF type: %s", TermDofs_[ie] )
+      );
+    }
+
+    counts[ie]   = group.size ();
+    relDofCount += counts[ie];
+  }
+
+  relSteps_  .resize ( eventCount     );
+  relOffsets_.resize ( eventCount + 1 );
+  relDofs_   .resize ( relDofCount    );
+
+  relOffsets_[0] = 0;
+
+  for ( idx_t k = 0; k < eventCount; k++ )
+  {
+    const idx_t  ie    = order[k];
+    const idx_t  first = relOffsets_[k];
+
+    group = NodeGroup::get ( TermGroups_[ie], nodes_, globdat, context );
+
+    IdxVector    inodes = group.getIndices ();
+
+    for ( idx_t in = 0; in < counts[ie]; in++ )
+    {
+      relDofs_[first + in] = dofs_->getDofIndex ( inodes[in], itypes[ie] );
+    }
+
+    relSteps_  [k]     = TermSteps_[ie];
+    relOffsets_[k + 1] = first + counts[ie];
+  }
+
+  relCount_ = 0;
+}
+
+
 //-----------------------------------------------------------------------
 //   invalidate_
 //-----------------------------------------------------------------------
@@ -469,6 +662,17 @@ void TimeStepModuleErik::invalidate_ ()
   istep_ = -1;
 }
 
+
+//-----------------------------------------------------------------------
+//   slavesChanged_
+//-----------------------------------------------------------------------
+
+
+void TimeStepModuleErik::slavesChanged_ ()
+{
+  newSlaves_ = true;
+}
+
 //-----------------------------------------------------------------------
 //   makeNew
 //-----------------------------------------------------------------------
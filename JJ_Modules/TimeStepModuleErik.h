@@ -1,12 +1,14 @@
 #ifndef TIME_STEP_MODULE_ERIK_H
 #define TIME_STEP_MODULE_ERIK_H
 
+#include <jem/util/Properties.h>
 #include <jive/app/Module.h>
 #include <jive/fem/ElementGroup.h>
 #include <jive/fem/ElementSet.h>
 #include <jive/fem/NodeGroup.h>
 #include <jive/util/Assignable.h>
 #include <jive/util/DofSpace.h>
+#include <jive/util/Constraints.h>
 
 #include "import.h"
 #include "Array.h"
@@ -16,6 +18,7 @@ using jive::fem::ElementSet;
 using jive::fem::NodeGroup;
 using jive::fem::NodeSet;
 using jive::util::Assignable;
+using jive::util::Constraints;
 using jive::StringVector;
 
 //-----------------------------------------------------------------------
@@ -79,6 +82,16 @@ class TimeStepModuleErik : public Module
 
   void                      invalidate_     ();
 
+  void                      slavesChanged_  ();
+
+  void                      updateTimeStep_
+
+    ( const Properties&       globdat );
+
+  void                      compileReleases_
+
+    ( const Properties&       globdat );
+
 
  private:
 
@@ -89,13 +102,42 @@ class TimeStepModuleErik : public Module
   
   Vector                    rmass_;
   double                    dtime_;
+  double                    dtOld_;
+
+  // automatic time step: safety_ times the critical time step of the
+  // model, updated every updateInterval_ steps (only at restart if 0);
+  // SolidModel only estimates it for 2D Triangle3 and Quad4 elements,
+  // otherwise the given time step is kept
+
+  bool                      autoStep_;
+  double                    safety_;
+  int                       updateInterval_;
   int                       istep_;
+
+  // work data of run, kept across steps; resized by restart_
+
+  Ref<Constraints>          cons_;
+  Properties                params_;
+  Vector                    fint_;
+  Vector                    fext_;
+  Vector                    u2_;
+  IdxVector                 slaveDofs_;
+  bool                      newSlaves_;
   
   int                       BCtype_; // 0 = displacement, 1 = velocity, 2 = acceleration
   
   StringVector              TermGroups_;
   StringVector              TermDofs_;
   IntVector                 TermSteps_;
+
+  // compiled release schedule (see compileReleases_): event k releases
+  // relDofs_[relOffsets_[k]:relOffsets_[k+1]] at step relSteps_[k];
+  // the first relCount_ events have been applied
+
+  IntVector                 relSteps_;
+  IdxVector                 relOffsets_;
+  IdxVector                 relDofs_;
+  idx_t                     relCount_;
   
 };
 
@@ -0,0 +1,512 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  ParaView output module. See VtuOutputModule.h for details.
+ *
+ */
+
+#include <jem/base/limits.h>
+#include <jem/base/IllegalInputException.h>
+#include <jive/fem/NodeSet.h>
+#include <jive/fem/ElementSet.h>
+#include <jive/util/Globdat.h>
+#include <jive/model/StateVector.h>
+#include <jive/app/ModuleFactory.h>
+
+#include "VtuOutputModule.h"
+#include "OutputScheduleModule.h"
+#include "SolverNames.h"
+#include "Names.h"
+
+
+using jem::maxOf;
+using jem::ALL;
+using jem::END;
+using jem::BEGIN;
+using jem::slice;
+using jem::newInstance;
+using jem::IllegalInputException;
+using jive::util::Globdat;
+using jive::model::StateVector;
+
+
+//=======================================================================
+//   class VtuOutputModule
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const char*  VtuOutputModule::TYPE_NAME     = "VtuOutput";
+const char*  VtuOutputModule::PREFIX_PROP   = "prefix";
+const char*  VtuOutputModule::INTERVAL_PROP = "interval";
+const char*  VtuOutputModule::STRESS_PROP   = "stress";
+const char*  VtuOutputModule::IP_DATA_PROP  = "ipData";
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+VtuOutputModule::VtuOutputModule ( const String& name ) :
+
+  Super ( name )
+
+{
+  prefix_   = "output";
+  interval_ = 1;
+  stress_   = true;
+  ipData_   = true;
+  runCount_ = 0;
+}
+
+
+VtuOutputModule::~VtuOutputModule ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   init
+//-----------------------------------------------------------------------
+
+
+Module::Status VtuOutputModule::init
+
+  ( const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  const String  context = getContext ();
+
+  configure ( props, globdat );
+  getConfig ( conf,  globdat );
+
+  model_    = Model   ::get ( globdat, context );
+  dofs_     = DofSpace::get ( globdat, context );
+  frame_    = newInstance<OutputFrame> ();
+  runCount_ = 0;
+
+  times_.clear ();
+
+  initMesh_ ( globdat );
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   run
+//-----------------------------------------------------------------------
+
+
+Module::Status VtuOutputModule::run ( const Properties& globdat )
+{
+  if ( model_ == NIL )
+  {
+    return DONE;
+  }
+
+  runCount_++;
+
+  if ( ! OutputScheduleModule::isDue( runCount_, interval_, globdat ) )
+  {
+    return OK;
+  }
+
+  double  t = (double) times_.size ();
+
+  globdat.find ( t, Globdat::TIME );
+
+  frame_->clear ();
+
+  if ( stress_ || ipData_ )
+  {
+    Properties  params;
+
+    frame_->ipCoords     = ipData_;
+    frame_->nodalAverage = stress_;
+
+    params.set ( SolverNames::OUTPUT_FRAME, frame_ );
+
+    model_->takeAction ( SolverNames::GET_OUTPUT_FRAME, params, globdat );
+  }
+
+  times_.pushBack ( t );
+
+  writeMesh_ ( globdat );
+
+  if ( ipData_ )
+  {
+    for ( idx_t ib = 0; ib < frame_->blockCount(); ib++ )
+    {
+      const String&  name = frame_->getBlockName ( ib );
+
+      if ( frame_->findBlock( name + ".ipCoords" ) >= 0 )
+      {
+        writePoints_ ( ib );
+      }
+    }
+  }
+
+  return OK;
+}
+
+
+//-----------------------------------------------------------------------
+//   shutdown
+//-----------------------------------------------------------------------
+
+
+void VtuOutputModule::shutdown ( const Properties& globdat )
+{
+  model_ = NIL;
+  frame_ = NIL;
+
+  writer_.clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   configure
+//-----------------------------------------------------------------------
+
+
+void VtuOutputModule::configure
+
+  ( const Properties&  props,
+    const Properties&  globdat )
+
+{
+  if ( props.contains( myName_ ) )
+  {
+    Properties  myProps = props.findProps ( myName_ );
+
+    myProps.find ( prefix_,   PREFIX_PROP );
+    myProps.find ( interval_, INTERVAL_PROP, 1, maxOf( interval_ ) );
+    myProps.find ( stress_,   STRESS_PROP );
+    myProps.find ( ipData_,   IP_DATA_PROP );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   getConfig
+//-----------------------------------------------------------------------
+
+
+void VtuOutputModule::getConfig
+
+  ( const Properties&  conf,
+    const Properties&  globdat ) const
+
+{
+  Properties  myConf = conf.makeProps ( myName_ );
+
+  myConf.set ( PREFIX_PROP,   prefix_   );
+  myConf.set ( INTERVAL_PROP, interval_ );
+  myConf.set ( STRESS_PROP,   stress_   );
+  myConf.set ( IP_DATA_PROP,  ipData_   );
+}
+
+
+//-----------------------------------------------------------------------
+//   makeNew
+//-----------------------------------------------------------------------
+
+
+Ref<Module> VtuOutputModule::makeNew
+
+  ( const String&      name,
+    const Properties&  conf,
+    const Properties&  props,
+    const Properties&  globdat )
+
+{
+  return newInstance<Self> ( name );
+}
+
+
+//-----------------------------------------------------------------------
+//   initMesh_
+//-----------------------------------------------------------------------
+
+// Stores the node coordinates, converts the elements to VTK cells and
+// looks up the displacement DOFs of the nodes. The quadratic elements
+// of jive number the nodes along the boundary; VTK wants the corner
+// nodes first.
+
+void VtuOutputModule::initMesh_ ( const Properties& globdat )
+{
+  using jive::fem::NodeSet;
+  using jive::fem::ElementSet;
+
+  static const int  TRIANGLE6[6] = { 0, 2, 4, 1, 3, 5 };
+  static const int  QUAD8[8]     = { 0, 2, 4, 6, 1, 3, 5, 7 };
+
+  const String  context   = getContext ();
+
+  NodeSet       nodes     = NodeSet   ::get ( globdat, context );
+  ElementSet    elems     = ElementSet::get ( globdat, context );
+
+  const idx_t   rank      = nodes.rank ();
+  const idx_t   nodeCount = nodes.size ();
+  const idx_t   elemCount = elems.size ();
+
+  IdxVector     inodes    ( elems.maxElemNodeCount() );
+  idx_t         connSize  = 0;
+
+
+  coords_.resize ( rank, nodeCount );
+  nodes.getCoords ( coords_ );
+
+  for ( idx_t ie = 0; ie < elemCount; ie++ )
+  {
+    connSize += elems.getElemNodeCount ( ie );
+  }
+
+  cellOffsets_.resize ( elemCount + 1 );
+  cellTypes_  .resize ( elemCount );
+  cellNodes_  .resize ( connSize );
+
+  cellOffsets_[0] = 0;
+
+  for ( idx_t ie = 0; ie < elemCount; ie++ )
+  {
+    const idx_t  n     = elems.getElemNodeCount ( ie );
+    const idx_t  first = cellOffsets_[ie];
+    const int*   perm  = 0;
+    int          type  = -1;
+
+    elems.getElemNodes ( inodes[slice(BEGIN,n)], ie );
+
+    if ( rank == 2 )
+    {
+      switch ( n )
+      {
+      case 2:
+        type = VtuWriter::LINE;
+        break;
+      case 3:
+        type = VtuWriter::TRIANGLE;
+        break;
+      case 4:
+        type = VtuWriter::QUAD;
+        break;
+      case 6:
+        type = VtuWriter::QUADRATIC_TRIANGLE;
+        perm = TRIANGLE6;
+        break;
+      case 8:
+        type = VtuWriter::QUADRATIC_QUAD;
+        perm = QUAD8;
+        break;
+      }
+    }
+    else if ( rank == 3 )
+    {
+      switch ( n )
+      {
+      case 4:
+        type = VtuWriter::TETRA;
+        break;
+      case 8:
+        type = VtuWriter::HEXAHEDRON;
+        break;
+      }
+    }
+
+    if ( type < 0 )
+    {
+      throw IllegalInputException (
+        context,
+        String::format ( "element %d with %d nodes can not be written "
+                         "to a VTU file", (int) ie, (int) n )
+      );
+    }
+
+    for ( idx_t in = 0; in < n; in++ )
+    {
+      cellNodes_[first + in] = inodes[perm ? perm[in] : in];
+    }
+
+    cellTypes_  [ie]     = type;
+    cellOffsets_[ie + 1] = first + n;
+  }
+
+  // Displacements are written as three component vectors.
+
+  dispDofs_.resize ( rank, nodeCount );
+  disp_    .resize ( rank, nodeCount );
+
+  dispDofs_ = -1;
+
+  for ( idx_t i = 0; i < rank; i++ )
+  {
+    const idx_t  itype = dofs_->findType ( Names::DOFS[i] );
+
+    if ( itype < 0 )
+    {
+      continue;
+    }
+
+    for ( idx_t in = 0; in < nodeCount; in++ )
+    {
+      dispDofs_(i,in) = dofs_->findDofIndex ( in, itype );
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   writeMesh_
+//-----------------------------------------------------------------------
+
+
+void VtuOutputModule::writeMesh_ ( const Properties& globdat )
+{
+  using jive::model::STATE0;
+
+  const idx_t  k         = times_.size() - 1;
+  const idx_t  nodeCount = disp_.size(1);
+
+  Vector       state;
+
+  StateVector::get ( state, STATE0, dofs_, globdat );
+
+  for ( idx_t in = 0; in < nodeCount; in++ )
+  {
+    for ( idx_t i = 0; i < disp_.size(0); i++ )
+    {
+      const idx_t  idof = dispDofs_(i,in);
+
+      disp_(i,in) = ( idof >= 0 ) ? state[idof] : 0.0;
+    }
+  }
+
+  writer_.clear        ();
+  writer_.setPoints    ( coords_ );
+  writer_.setCells     ( cellOffsets_, cellNodes_, cellTypes_ );
+  writer_.addPointData ( "displacement", disp_ );
+
+  for ( idx_t ib = 0; ib < frame_->blockCount(); ib++ )
+  {
+    const String&  name = frame_->getBlockName ( ib );
+
+    if ( ! name.endsWith( ".nodal" ) )
+    {
+      continue;
+    }
+
+    const Matrix&        block = frame_->getBlock    ( ib );
+    const StringVector&  cols  = frame_->getColNames ( ib );
+
+    if ( block.size(0) != nodeCount )
+    {
+      continue;
+    }
+
+    for ( idx_t j = 0; j < cols.size(); j++ )
+    {
+      writer_.addPointData ( cols[j], block(ALL,j) );
+    }
+  }
+
+  writer_.write ( String::format( "%s_%d.vtu", prefix_, (int) k ) );
+  writer_.clear ();
+
+  writePvd_ ( prefix_ );
+}
+
+
+//-----------------------------------------------------------------------
+//   writePoints_
+//-----------------------------------------------------------------------
+
+// Writes the integration points of a model as a cloud of vertices.
+
+void VtuOutputModule::writePoints_ ( idx_t iblock )
+{
+  const idx_t          k      = times_.size() - 1;
+  const String&        name   = frame_->getBlockName ( iblock );
+  const Matrix&        block  = frame_->getBlock     ( iblock );
+  const StringVector&  cols   = frame_->getColNames  ( iblock );
+  const Matrix&        xblock =
+
+    frame_->getBlock ( frame_->findBlock( name + ".ipCoords" ) );
+
+  const String         base   = prefix_ + "_" + name + "_ip";
+
+  const idx_t          n      = xblock.size(0);
+  const idx_t          rank   = xblock.size(1);
+
+
+  if ( ipCoords_.size(0) != rank || ipCoords_.size(1) != n )
+  {
+    ipCoords_.resize ( rank, n );
+  }
+
+  for ( idx_t i = 0; i < rank; i++ )
+  {
+    ipCoords_(i,ALL) = xblock(ALL,i);
+  }
+
+  writer_.clear          ();
+  writer_.setPoints      ( ipCoords_ );
+  writer_.setVertexCells ();
+
+  for ( idx_t j = 0; j < cols.size(); j++ )
+  {
+    writer_.addPointData ( cols[j], block(ALL,j) );
+  }
+
+  writer_.write ( String::format( "%s_%d.vtu", base, (int) k ) );
+  writer_.clear ();
+
+  writePvd_ ( base );
+}
+
+
+//-----------------------------------------------------------------------
+//   writePvd_
+//-----------------------------------------------------------------------
+
+// Rewrites the collection of a series. The data files are referred to
+// relative to the directory of the collection file.
+
+void VtuOutputModule::writePvd_ ( const String& base )
+{
+  const idx_t   i     = base.rfind ( '/' );
+  const String  local = ( i < 0 ) ? base : base[slice(i + 1,END)];
+
+  Flex<String>  files;
+
+  for ( idx_t k = 0; k < times_.size(); k++ )
+  {
+    files.pushBack ( String::format( "%s_%d.vtu", local, (int) k ) );
+  }
+
+  VtuWriter::writePvd ( base + ".pvd", times_, files );
+}
+
+
+//=======================================================================
+//   related functions
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   declareVtuOutputModule
+//-----------------------------------------------------------------------
+
+
+void declareVtuOutputModule ()
+{
+  using jive::app::ModuleFactory;
+
+  ModuleFactory::declare ( VtuOutputModule::TYPE_NAME,
+                         & VtuOutputModule::makeNew );
+}
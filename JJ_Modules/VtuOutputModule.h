@@ -0,0 +1,149 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This module writes ParaView output: every interval runs a VTU file
+ *  with the mesh, the nodal displacements and the nodal averages of
+ *  the history, and for each model a VTU file with the integration
+ *  points as a point cloud with their history values. A PVD file per
+ *  series makes them a time series. The data are written in binary by
+ *  VtuWriter, without formatting any values as text.
+ *
+ *  The files are called <prefix>_<k>.vtu and <prefix>_<model>_ip_<k>.vtu
+ *  with the collections <prefix>.pvd and <prefix>_<model>_ip.pvd.
+ *
+ *  An OutputSchedule module, if present, replaces the interval.
+ *
+ */
+
+#ifndef VTU_OUTPUT_MODULE_H
+#define VTU_OUTPUT_MODULE_H
+
+#include <jem/util/Flex.h>
+#include <jive/app/Module.h>
+#include <jive/model/Model.h>
+#include <jive/util/DofSpace.h>
+
+#include "OutputFrame.h"
+#include "VtuWriter.h"
+
+using jem::Ref;
+using jem::String;
+using jem::util::Flex;
+using jem::util::Properties;
+using jive::IdxVector;
+using jive::IdxMatrix;
+using jive::app::Module;
+using jive::model::Model;
+using jive::util::DofSpace;
+
+
+//-----------------------------------------------------------------------
+//   class VtuOutputModule
+//-----------------------------------------------------------------------
+
+
+class VtuOutputModule : public Module
+{
+ public:
+
+  typedef VtuOutputModule   Self;
+  typedef Module            Super;
+
+  static const char*        TYPE_NAME;
+  static const char*        PREFIX_PROP;
+  static const char*        INTERVAL_PROP;
+  static const char*        STRESS_PROP;
+  static const char*        IP_DATA_PROP;
+
+  explicit                  VtuOutputModule
+
+    ( const String&           name = "vtuOutput" );
+
+  virtual Status            init
+
+    ( const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+  virtual Status            run
+
+    ( const Properties&       globdat );
+
+  virtual void              shutdown
+
+    ( const Properties&       globdat );
+
+  virtual void              configure
+
+    ( const Properties&       props,
+      const Properties&       globdat );
+
+  virtual void              getConfig
+
+    ( const Properties&       conf,
+      const Properties&       globdat )      const;
+
+  static Ref<Module>        makeNew
+
+    ( const String&           name,
+      const Properties&       conf,
+      const Properties&       props,
+      const Properties&       globdat );
+
+
+ protected:
+
+  virtual                  ~VtuOutputModule ();
+
+
+ private:
+
+  void                      initMesh_
+
+    ( const Properties&       globdat );
+
+  void                      writeMesh_
+
+    ( const Properties&       globdat );
+
+  void                      writePoints_
+
+    ( idx_t                   iblock );
+
+  void                      writePvd_
+
+    ( const String&           base );
+
+
+ private:
+
+  Ref<Model>                model_;
+  Ref<DofSpace>             dofs_;
+  Ref<OutputFrame>          frame_;
+  VtuWriter                 writer_;
+
+  // the mesh: node coordinates, the VTK cells and the DOF of each
+  // displacement component of each node (-1 if none)
+
+  Matrix                    coords_;
+  IdxVector                 cellOffsets_;
+  IdxVector                 cellNodes_;
+  IdxVector                 cellTypes_;
+  IdxMatrix                 dispDofs_;
+
+  Matrix                    disp_;
+  Matrix                    ipCoords_;
+
+  String                    prefix_;
+  idx_t                     interval_;
+  bool                      stress_;
+  bool                      ipData_;
+  idx_t                     runCount_;
+
+  Flex<double>              times_;
+
+};
+
+
+#endif
@@ -8,6 +8,18 @@ void declareModules ()
   declareTimeStepModuleErik ();
   declareStressStrainModule ();  
   declareAdaptiveStepGeneralModule ();
+  declareDissArclenModule   ();
+  declarePararealModule     ();
+  declareLinDynModule       ();
+  declareCheckpointModule   ();
+  declareAsyncOutputModule  ();
+  declareVtuOutputModule    ();
+  declareHistoryStoreModule ();
+  declareBinMeshModule      ();
+  declareProbeModule        ();
+  declareOutputScheduleModule ();
+  declareLowRankOutputModule ();
+  declareBenchModule        ();
 
 }
 
@@ -11,5 +11,17 @@ void  declareTimeStepModule     ();
 void  declareTimeStepModuleErik ();
 void  declareStressStrainModule ();
 void  declareAdaptiveStepGeneralModule ();
+void  declareDissArclenModule   ();
+void  declarePararealModule     ();
+void  declareLinDynModule       ();
+void  declareCheckpointModule   ();
+void  declareAsyncOutputModule  ();
+void  declareVtuOutputModule    ();
+void  declareHistoryStoreModule ();
+void  declareBinMeshModule      ();
+void  declareProbeModule        ();
+void  declareOutputScheduleModule ();
+void  declareLowRankOutputModule ();
+void  declareBenchModule        ();
 
 #endif
@@ -16,5 +16,6 @@ using jive::Cubix;
 using jive::IdxVector;
 using jive::IntMatrix;
 using jive::StringVector;
+using jive::BoolVector;
 
 #endif
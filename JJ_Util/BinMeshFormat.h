@@ -0,0 +1,86 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Layout of the binary mesh files written by tools/mesh2bin and read
+ *  by BinMeshModule. All fields are 8 byte aligned and in the byte
+ *  order of the machine that wrote the file:
+ *
+ *    char[8]   magic "JJMESH"
+ *    int32     format version
+ *    int32     rank (number of coordinates per node)
+ *    int64     number of nodes
+ *    int64     number of elements
+ *    int64     length of the connectivity array
+ *    int64     number of groups
+ *
+ *    int64     node IDs            [node count]
+ *    double    node coordinates    [node count * rank], node by node
+ *    int64     element IDs         [element count]
+ *    int64     element offsets     [element count + 1]
+ *    int64     element node indices[connectivity length]
+ *
+ *    per group:
+ *
+ *      int64   kind (NODE_GROUP or ELEM_GROUP)
+ *      int64   length of the name
+ *      int64   number of members
+ *      char[]  name, padded to 8 bytes
+ *      int64   member indices      [member count]
+ *
+ *  Element nodes and group members are stored as zero based indices,
+ *  not as IDs. This header does not depend on jem, so that the
+ *  conversion tool can be built on its own.
+ *
+ */
+
+#ifndef BIN_MESH_FORMAT_H
+#define BIN_MESH_FORMAT_H
+
+#include <stdint.h>
+
+
+//-----------------------------------------------------------------------
+//   struct BinMeshFormat
+//-----------------------------------------------------------------------
+
+
+struct BinMeshFormat
+{
+  static const int32_t  VERSION    = 1;
+  static const int64_t  NODE_GROUP = 0;
+  static const int64_t  ELEM_GROUP = 1;
+
+  struct                Header
+  {
+    char                  magic[8];
+    int32_t               version;
+    int32_t               rank;
+    int64_t               nodeCount;
+    int64_t               elemCount;
+    int64_t               connSize;
+    int64_t               groupCount;
+  };
+
+  struct                GroupHeader
+  {
+    int64_t               kind;
+    int64_t               nameLength;
+    int64_t               size;
+  };
+
+  // The eight bytes of the magic: "JJMESH" and two zero bytes
+
+  static inline const char* magic  ()
+  {
+    return "JJMESH\0";
+  }
+
+  static inline int64_t     padded ( int64_t n )
+  {
+    return (n + 7) & ~((int64_t) 7);
+  }
+};
+
+
+#endif
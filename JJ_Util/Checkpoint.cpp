@@ -0,0 +1,508 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Checkpoint files; see Checkpoint.h.
+ *
+ *  File layout (all fields 8 byte aligned):
+ *
+ *    char[8]   magic "JJCKPT"
+ *    int32     format version
+ *    int32     number of records
+ *
+ *    per record:
+ *
+ *      int64   length of the name
+ *      int64   size of the data in bytes
+ *      char[]  name, padded to 8 bytes
+ *      char[]  data, padded to 8 bytes
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <stdint.h>
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/IllegalInputException.h>
+#include <jem/io/IOException.h>
+
+#include "Checkpoint.h"
+
+
+using jem::IllegalInputException;
+using jem::io::IOException;
+
+
+//=======================================================================
+//   private helpers
+//=======================================================================
+
+
+static const char   MAGIC_[8] = { 'J', 'J', 'C', 'K', 'P', 'T', 0, 0 };
+
+static inline idx_t padded_ ( idx_t n )
+{
+  return (n + 7) & ~((idx_t) 7);
+}
+
+static void         writeAll_
+
+  ( int           fd,
+    const void*   buf,
+    idx_t         n,
+    const String& fileName )
+
+{
+  const char*  p = (const char*) buf;
+
+  while ( n > 0 )
+  {
+    ssize_t  k = ::write ( fd, p, (size_t) n );
+
+    if ( k < 0 )
+    {
+      if ( errno == EINTR )
+      {
+        continue;
+      }
+
+      throw IOException (
+        fileName,
+        String::format ( "write error: %s", ::strerror( errno ) )
+      );
+    }
+
+    p += k;
+    n -= (idx_t) k;
+  }
+}
+
+
+//=======================================================================
+//   class Checkpoint
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const int  Checkpoint::VERSION = 1;
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+Checkpoint::Checkpoint ()
+{
+  map_     = 0;
+  mapSize_ = 0;
+}
+
+
+Checkpoint::~Checkpoint ()
+{
+  close ();
+}
+
+
+//-----------------------------------------------------------------------
+//   clear
+//-----------------------------------------------------------------------
+
+
+void Checkpoint::clear ()
+{
+  names_  .clear ();
+  offsets_.clear ();
+  sizes_  .clear ();
+  data_   .clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   alloc
+//-----------------------------------------------------------------------
+
+// Adds a record of size bytes and returns its (8 byte aligned) memory,
+// to be filled by the caller. The pointer is valid until the next
+// record is added.
+
+void* Checkpoint::alloc
+
+  ( const String&  name,
+    idx_t          size )
+
+{
+  const idx_t  offset = data_.size ();
+
+  names_  .pushBack ( name   );
+  offsets_.pushBack ( offset );
+  sizes_  .pushBack ( size   );
+
+  data_.resize ( offset + padded_( size ) );
+
+  if ( size == 0 )
+  {
+    return 0;
+  }
+
+  return &data_[offset];
+}
+
+
+//-----------------------------------------------------------------------
+//   add
+//-----------------------------------------------------------------------
+
+
+void Checkpoint::add
+
+  ( const String&  name,
+    const void*    data,
+    idx_t          size )
+
+{
+  void*  dest = alloc ( name, size );
+
+  if ( size > 0 )
+  {
+    std::memcpy ( dest, data, (size_t) size );
+  }
+}
+
+
+void Checkpoint::add
+
+  ( const String&  name,
+    const Vector&  data )
+
+{
+  const idx_t  n    = data.size ();
+  double*      dest = (double*) alloc ( name, n * (idx_t) sizeof(double) );
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    dest[i] = data[i];
+  }
+}
+
+
+void Checkpoint::add
+
+  ( const String&  name,
+    double         value )
+
+{
+  add ( name, &value, (idx_t) sizeof(double) );
+}
+
+
+//-----------------------------------------------------------------------
+//   write
+//-----------------------------------------------------------------------
+
+
+void Checkpoint::write ( const String& fileName )
+{
+  const String  tmpName = fileName + ".tmp";
+  const idx_t   count   = names_.size ();
+  const char    zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  int           fd      = ::open ( tmpName.addr(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+  if ( fd < 0 )
+  {
+    throw IOException (
+      tmpName,
+      String::format ( "can not create file: %s", ::strerror( errno ) )
+    );
+  }
+
+  try
+  {
+    int32_t  head[2] = { (int32_t) VERSION, (int32_t) count };
+
+    writeAll_ ( fd, MAGIC_, 8,            tmpName );
+    writeAll_ ( fd, head,   sizeof(head), tmpName );
+
+    for ( idx_t i = 0; i < count; i++ )
+    {
+      const idx_t  len  = names_[i].size ();
+      int64_t      rec[2];
+
+      rec[0] = (int64_t) len;
+      rec[1] = (int64_t) sizes_[i];
+
+      writeAll_ ( fd, rec,              sizeof(rec),         tmpName );
+      writeAll_ ( fd, names_[i].addr(), len,                 tmpName );
+      writeAll_ ( fd, zeros,            padded_( len ) - len, tmpName );
+
+      if ( sizes_[i] > 0 )
+      {
+        writeAll_ ( fd, &data_[offsets_[i]], padded_( sizes_[i] ),
+                    tmpName );
+      }
+    }
+
+    if ( ::fsync( fd ) != 0 )
+    {
+      throw IOException (
+        tmpName,
+        String::format ( "sync failed: %s", ::strerror( errno ) )
+      );
+    }
+  }
+  catch ( ... )
+  {
+    ::close  ( fd );
+    ::unlink ( tmpName.addr() );
+    throw;
+  }
+
+  ::close ( fd );
+
+  if ( ::rename( tmpName.addr(), fileName.addr() ) != 0 )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not rename %s: %s",
+                       tmpName, ::strerror( errno ) )
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   open
+//-----------------------------------------------------------------------
+
+// Maps the file and reads the list of records. Returns false if the
+// file does not exist.
+
+bool Checkpoint::open ( const String& fileName )
+{
+  struct stat  st;
+
+  close ();
+
+  int  fd = ::open ( fileName.addr(), O_RDONLY );
+
+  if ( fd < 0 )
+  {
+    if ( errno == ENOENT )
+    {
+      return false;
+    }
+
+    throw IOException (
+      fileName,
+      String::format ( "can not open file: %s", ::strerror( errno ) )
+    );
+  }
+
+  if ( ::fstat( fd, &st ) != 0 || st.st_size < 16 )
+  {
+    ::close ( fd );
+
+    throw IllegalInputException (
+      fileName,
+      "not a checkpoint file"
+    );
+  }
+
+  void*  addr = ::mmap ( 0, (size_t) st.st_size, PROT_READ,
+                         MAP_PRIVATE, fd, 0 );
+
+  ::close ( fd );
+
+  if ( addr == MAP_FAILED )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not map file: %s", ::strerror( errno ) )
+    );
+  }
+
+  map_      = (const char*) addr;
+  mapSize_  = (idx_t) st.st_size;
+  fileName_ = fileName;
+
+  // Check the header and index the records.
+
+  const int32_t*  head = (const int32_t*) (map_ + 8);
+
+  if ( std::memcmp( map_, MAGIC_, 8 ) != 0 )
+  {
+    close ();
+
+    throw IllegalInputException (
+      fileName,
+      "not a checkpoint file"
+    );
+  }
+
+  if ( head[0] != VERSION )
+  {
+    const int  version = head[0];
+
+    close ();
+
+    throw IllegalInputException (
+      fileName,
+      String::format ( "unsupported checkpoint version %d "
+                       "(expected %d)", version, VERSION )
+    );
+  }
+
+  const idx_t  count = head[1];
+  idx_t        pos   = 16;
+
+  for ( idx_t i = 0; i < count; i++ )
+  {
+    if ( pos + 16 > mapSize_ )
+    {
+      break;
+    }
+
+    const int64_t*  rec  = (const int64_t*) (map_ + pos);
+    const idx_t     len  = (idx_t) rec[0];
+    const idx_t     size = (idx_t) rec[1];
+
+    pos += 16;
+
+    if ( len < 0 || size < 0 ||
+         pos + padded_( len ) + padded_( size ) > mapSize_ )
+    {
+      break;
+    }
+
+    rnames_  .pushBack ( String( map_ + pos, map_ + pos + len ) );
+    roffsets_.pushBack ( pos + padded_( len ) );
+    rsizes_  .pushBack ( size );
+
+    pos += padded_( len ) + padded_( size );
+  }
+
+  if ( rnames_.size() != count )
+  {
+    close ();
+
+    throw IllegalInputException (
+      fileName,
+      "truncated checkpoint file"
+    );
+  }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   close
+//-----------------------------------------------------------------------
+
+
+void Checkpoint::close ()
+{
+  if ( map_ )
+  {
+    ::munmap ( (void*) map_, (size_t) mapSize_ );
+  }
+
+  map_     = 0;
+  mapSize_ = 0;
+
+  rnames_  .clear ();
+  roffsets_.clear ();
+  rsizes_  .clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   find
+//-----------------------------------------------------------------------
+
+// Returns a pointer to the data of a record in the opened file and its
+// size in bytes, or zero if there is no such record.
+
+const void* Checkpoint::find
+
+  ( idx_t&         size,
+    const String&  name ) const
+
+{
+  for ( idx_t i = 0; i < rnames_.size(); i++ )
+  {
+    if ( rnames_[i] == name )
+    {
+      size = rsizes_[i];
+
+      return map_ + roffsets_[i];
+    }
+  }
+
+  size = 0;
+
+  return 0;
+}
+
+
+bool Checkpoint::find
+
+  ( const Vector&  data,
+    const String&  name ) const
+
+{
+  idx_t          size;
+  const double*  src = (const double*) find ( size, name );
+
+  if ( src == 0 )
+  {
+    return false;
+  }
+
+  if ( size != data.size() * (idx_t) sizeof(double) )
+  {
+    throw IllegalInputException (
+      fileName_,
+      String::format ( "record %s has %d values instead of %d", name,
+                       (int) (size / (idx_t) sizeof(double)),
+                       (int) data.size() )
+    );
+  }
+
+  for ( idx_t i = 0; i < data.size(); i++ )
+  {
+    data[i] = src[i];
+  }
+
+  return true;
+}
+
+
+bool Checkpoint::find
+
+  ( double&        value,
+    const String&  name ) const
+
+{
+  Vector  tmp ( 1 );
+
+  if ( ! find( tmp, name ) )
+  {
+    return false;
+  }
+
+  value = tmp[0];
+
+  return true;
+}
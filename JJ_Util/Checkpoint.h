@@ -0,0 +1,147 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class reads and writes checkpoint files: a versioned binary
+ *  file with a list of named records (raw bytes, vectors or scalars).
+ *
+ *  Records are collected in memory with add() or alloc() and written
+ *  with write(). The file is first written under a temporary name and
+ *  then renamed, so that an interrupted write never replaces a valid
+ *  checkpoint.
+ *
+ *  A file opened with open() is mapped into memory, so the pages of a
+ *  record are only read from disk when it is used. find() with a size
+ *  returns a pointer into the mapping without copying; the find()
+ *  functions for a vector or a scalar copy the record into the given
+ *  vector or value.
+ *
+ *  The data are stored in the byte order and layout of the machine,
+ *  so a checkpoint is meant to be read by the same build.
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+
+
+//-----------------------------------------------------------------------
+//   class Checkpoint
+//-----------------------------------------------------------------------
+
+
+class Checkpoint : public jem::Object
+{
+ public:
+
+  typedef Checkpoint        Self;
+  typedef jem::Object       Super;
+
+  static const int          VERSION;
+
+                            Checkpoint   ();
+
+  // writing
+
+  void                      clear        ();
+
+  void*                     alloc
+
+    ( const String&           name,
+      idx_t                   size );
+
+  void                      add
+
+    ( const String&           name,
+      const void*             data,
+      idx_t                   size );
+
+  void                      add
+
+    ( const String&           name,
+      const Vector&           data );
+
+  void                      add
+
+    ( const String&           name,
+      double                  value );
+
+  void                      write
+
+    ( const String&           fileName );
+
+  // reading
+
+  bool                      open
+
+    ( const String&           fileName );
+
+  void                      close        ();
+
+  const void*               find
+
+    ( idx_t&                  size,
+      const String&           name )       const;
+
+  bool                      find
+
+    ( const Vector&           data,
+      const String&           name )       const;
+
+  bool                      find
+
+    ( double&                 value,
+      const String&           name )       const;
+
+  inline bool               isOpen       () const;
+
+
+ protected:
+
+  virtual                  ~Checkpoint   ();
+
+
+ private:
+
+  // records to be written: name, offset in data_ and size in bytes
+
+  Flex<String>              names_;
+  Flex<idx_t>               offsets_;
+  Flex<idx_t>               sizes_;
+  Flex<char>                data_;
+
+  // the opened file: the mapping and the records in it
+
+  String                    fileName_;
+  const char*               map_;
+  idx_t                     mapSize_;
+
+  Flex<String>              rnames_;
+  Flex<idx_t>               roffsets_;
+  Flex<idx_t>               rsizes_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   isOpen
+//-----------------------------------------------------------------------
+
+
+inline bool Checkpoint::isOpen () const
+{
+  return ( map_ != 0 );
+}
+
+
+#endif
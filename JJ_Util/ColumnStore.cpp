@@ -0,0 +1,895 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Column store files; see ColumnStore.h.
+ *
+ *  File layout (all fields 8 byte aligned):
+ *
+ *    char[8]   magic "JJCOLS"
+ *    int32     format version
+ *    int32     number of fields
+ *    int64     number of points
+ *    int64     chunk size
+ *
+ *    per field:
+ *
+ *      int64   length of the name
+ *      char[]  name, padded to 8 bytes
+ *
+ *    the chunks, each padded to 8 bytes
+ *
+ *    index:
+ *
+ *      int64   number of frames
+ *      per frame: int64 step, double time
+ *      int64   number of chunks
+ *      per chunk: int64 frame, field, first point, point count,
+ *                 offset, size in bytes and codec
+ *
+ *    int64     offset of the index
+ *    char[8]   magic "JJCOLEND"
+ *
+ *  The chunks are written frame by frame, field by field, so chunk k
+ *  of field j in frame i has index (i * fieldCount + j) * chunksPerField
+ *  + k. Codec 0 is raw doubles; codec 1 is the bytes of the doubles
+ *  grouped by position (all first bytes, then all second bytes, ...)
+ *  and run length encoded: a control byte c < 128 is followed by c + 1
+ *  literal bytes, a control byte c >= 128 by one byte that is repeated
+ *  c - 125 times.
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/assert.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/base/IllegalArgumentException.h>
+#include <jem/io/IOException.h>
+
+#include "ColumnStore.h"
+
+
+using jem::IllegalInputException;
+using jem::IllegalArgumentException;
+using jem::io::IOException;
+
+
+//=======================================================================
+//   private helpers
+//=======================================================================
+
+
+static const char   HEAD_MAGIC_[8] = { 'J','J','C','O','L','S', 0, 0 };
+static const char   TAIL_MAGIC_[8] = { 'J','J','C','O','L','E','N','D' };
+
+static const int    RAW_           = 0;
+static const int    PACKED_        = 1;
+static const idx_t  INDEX_WIDTH_   = 7;
+
+
+static inline idx_t padded_ ( idx_t n )
+{
+  return (n + 7) & ~((idx_t) 7);
+}
+
+
+//-----------------------------------------------------------------------
+//   pack_
+//-----------------------------------------------------------------------
+
+// Groups the bytes of n doubles by position and run length encodes
+// them. Returns the encoded size.
+
+static idx_t        pack_
+
+  ( Flex<unsigned char>&  out,
+    const double*         values,
+    idx_t                 n )
+
+{
+  const idx_t           len   = n * 8;
+  const unsigned char*  bytes = (const unsigned char*) values;
+
+  Flex<unsigned char>   plane;
+  idx_t                 k     = 0;
+
+
+  plane.resize ( len );
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    for ( idx_t b = 0; b < 8; b++ )
+    {
+      plane[b * n + i] = bytes[i * 8 + b];
+    }
+  }
+
+  out.resize ( len + len / 128 + 8 );
+
+  for ( idx_t i = 0; i < len; )
+  {
+    idx_t  run = 1;
+
+    while ( i + run < len && run < 130 && plane[i + run] == plane[i] )
+    {
+      run++;
+    }
+
+    if ( run >= 3 )
+    {
+      out[k++] = (unsigned char) (125 + run);
+      out[k++] = plane[i];
+      i       += run;
+
+      continue;
+    }
+
+    idx_t  j = i;
+
+    while ( j < len && j - i < 128 )
+    {
+      if ( j + 2 < len && plane[j] == plane[j + 1] &&
+                          plane[j] == plane[j + 2] )
+      {
+        break;
+      }
+
+      j++;
+    }
+
+    out[k++] = (unsigned char) (j - i - 1);
+
+    std::memcpy ( &out[k], &plane[i], (size_t) (j - i) );
+
+    k += j - i;
+    i  = j;
+  }
+
+  return k;
+}
+
+
+//-----------------------------------------------------------------------
+//   unpack_
+//-----------------------------------------------------------------------
+
+
+static void         unpack_
+
+  ( double*               values,
+    idx_t                 n,
+    const unsigned char*  in,
+    idx_t                 size,
+    Flex<unsigned char>&  plane,
+    const String&         fileName )
+
+{
+  const idx_t  len = n * 8;
+
+  idx_t        p   = 0;
+  idx_t        o   = 0;
+
+
+  plane.resize ( len );
+
+  while ( o < len )
+  {
+    if ( p >= size )
+    {
+      break;
+    }
+
+    const int  c = in[p++];
+
+    if ( c < 128 )
+    {
+      const idx_t  k = c + 1;
+
+      if ( p + k > size || o + k > len )
+      {
+        break;
+      }
+
+      std::memcpy ( &plane[o], in + p, (size_t) k );
+
+      p += k;
+      o += k;
+    }
+    else
+    {
+      const idx_t  k = c - 125;
+
+      if ( p >= size || o + k > len )
+      {
+        break;
+      }
+
+      std::memset ( &plane[o], in[p++], (size_t) k );
+
+      o += k;
+    }
+  }
+
+  if ( o != len )
+  {
+    throw IllegalInputException (
+      fileName,
+      "corrupt chunk in column store"
+    );
+  }
+
+  unsigned char*  bytes = (unsigned char*) values;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    for ( idx_t b = 0; b < 8; b++ )
+    {
+      bytes[i * 8 + b] = plane[b * n + i];
+    }
+  }
+}
+
+
+//=======================================================================
+//   class ColumnWriter
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const int  ColumnWriter::VERSION = 1;
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+ColumnWriter::ColumnWriter ()
+{
+  file_       = 0;
+  fieldCount_ = 0;
+  pointCount_ = 0;
+  chunkSize_  = 0;
+  compress_   = false;
+  pos_        = 0;
+}
+
+
+ColumnWriter::~ColumnWriter ()
+{
+  if ( file_ )
+  {
+    std::fclose ( file_ );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   open
+//-----------------------------------------------------------------------
+
+
+void ColumnWriter::open
+
+  ( const String&        fileName,
+    const StringVector&  fieldNames,
+    idx_t                pointCount,
+    idx_t                chunkSize,
+    bool                 compress )
+
+{
+  const char  zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  if ( chunkSize < 1 || pointCount < 0 )
+  {
+    throw IllegalArgumentException (
+      JEM_FUNC,
+      "invalid point count or chunk size"
+    );
+  }
+
+  if ( file_ )
+  {
+    close ();
+  }
+
+  file_ = std::fopen ( fileName.addr(), "wb" );
+
+  if ( ! file_ )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not create file: %s", std::strerror( errno ) )
+    );
+  }
+
+  fileName_   = fileName;
+  fieldCount_ = fieldNames.size ();
+  pointCount_ = pointCount;
+  chunkSize_  = chunkSize;
+  compress_   = compress;
+  pos_        = 0;
+
+  steps_.clear ();
+  times_.clear ();
+  index_.clear ();
+
+  int32_t  head[2] = { (int32_t) VERSION, (int32_t) fieldCount_ };
+  int64_t  size[2] = { (int64_t) pointCount_, (int64_t) chunkSize_ };
+
+  put_ ( HEAD_MAGIC_, 8 );
+  put_ ( head,        sizeof(head) );
+  put_ ( size,        sizeof(size) );
+
+  for ( idx_t j = 0; j < fieldCount_; j++ )
+  {
+    const idx_t    len = fieldNames[j].size ();
+    const int64_t  n   = (int64_t) len;
+
+    put_ ( &n,                   sizeof(n) );
+    put_ ( fieldNames[j].addr(), len );
+    put_ ( zeros,                padded_( len ) - len );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   append
+//-----------------------------------------------------------------------
+
+
+void ColumnWriter::append
+
+  ( int            step,
+    double         time,
+    const Matrix&  values )
+
+{
+  JEM_PRECHECK ( isOpen() );
+
+  if ( values.size(0) != pointCount_ || values.size(1) != fieldCount_ )
+  {
+    throw IllegalArgumentException (
+      JEM_FUNC,
+      String::format ( "expected a %d x %d matrix",
+                       (int) pointCount_, (int) fieldCount_ )
+    );
+  }
+
+  column_.resize ( pointCount_ );
+
+  for ( idx_t j = 0; j < fieldCount_; j++ )
+  {
+    for ( idx_t i = 0; i < pointCount_; i++ )
+    {
+      column_[i] = values(i,j);
+    }
+
+    for ( idx_t first = 0; first < pointCount_; first += chunkSize_ )
+    {
+      const idx_t  count = ( pointCount_ - first < chunkSize_ ) ?
+                           pointCount_ - first : chunkSize_;
+
+      writeChunk_ ( j, first, count, column_.addr() + first );
+    }
+  }
+
+  steps_.pushBack ( step );
+  times_.pushBack ( time );
+
+  if ( std::ferror( file_ ) )
+  {
+    throw IOException (
+      fileName_,
+      String::format ( "write error: %s", std::strerror( errno ) )
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   close
+//-----------------------------------------------------------------------
+
+// Writes the index and closes the file.
+
+void ColumnWriter::close ()
+{
+  if ( ! file_ )
+  {
+    return;
+  }
+
+  const int64_t  indexPos   = (int64_t) pos_;
+  const int64_t  frameCount = (int64_t) steps_.size ();
+  const int64_t  chunkCount = (int64_t) (index_.size() / INDEX_WIDTH_);
+
+  put_ ( &frameCount, sizeof(frameCount) );
+
+  for ( idx_t i = 0; i < steps_.size(); i++ )
+  {
+    const int64_t  step = (int64_t) steps_[i];
+
+    put_ ( &step,      sizeof(step) );
+    put_ ( &times_[i], sizeof(double) );
+  }
+
+  put_ ( &chunkCount, sizeof(chunkCount) );
+
+  for ( idx_t i = 0; i < index_.size(); i++ )
+  {
+    const int64_t  k = (int64_t) index_[i];
+
+    put_ ( &k, sizeof(k) );
+  }
+
+  put_ ( &indexPos,   sizeof(indexPos) );
+  put_ ( TAIL_MAGIC_, 8 );
+
+  const bool  failed = ( std::ferror( file_ ) != 0 );
+
+  if ( std::fclose( file_ ) != 0 || failed )
+  {
+    file_ = 0;
+
+    throw IOException (
+      fileName_,
+      String::format ( "write error: %s", std::strerror( errno ) )
+    );
+  }
+
+  file_ = 0;
+}
+
+
+//-----------------------------------------------------------------------
+//   writeChunk_
+//-----------------------------------------------------------------------
+
+
+void ColumnWriter::writeChunk_
+
+  ( idx_t          field,
+    idx_t          first,
+    idx_t          count,
+    const double*  values )
+
+{
+  const char  zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  idx_t       bytes    = count * (idx_t) sizeof(double);
+  int         codec    = RAW_;
+
+  if ( compress_ )
+  {
+    const idx_t  n = pack_ ( packed_, values, count );
+
+    if ( n < bytes )
+    {
+      bytes = n;
+      codec = PACKED_;
+    }
+  }
+
+  index_.pushBack ( steps_.size() );
+  index_.pushBack ( field );
+  index_.pushBack ( first );
+  index_.pushBack ( count );
+  index_.pushBack ( pos_  );
+  index_.pushBack ( bytes );
+  index_.pushBack ( codec );
+
+  if ( codec == RAW_ )
+  {
+    put_ ( values, bytes );
+  }
+  else
+  {
+    put_ ( packed_.addr(), bytes );
+  }
+
+  put_ ( zeros, padded_( bytes ) - bytes );
+}
+
+
+//-----------------------------------------------------------------------
+//   put_
+//-----------------------------------------------------------------------
+
+
+void ColumnWriter::put_
+
+  ( const void*  data,
+    idx_t        size )
+
+{
+  if ( size > 0 )
+  {
+    std::fwrite ( data, 1, (size_t) size, file_ );
+
+    pos_ += size;
+  }
+}
+
+
+//=======================================================================
+//   class ColumnReader
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+ColumnReader::ColumnReader ()
+{
+  map_        = 0;
+  mapSize_    = 0;
+  pointCount_ = 0;
+  chunkSize_  = 1;
+  frameCount_ = 0;
+  chunkCount_ = 0;
+  frames_     = 0;
+  index_      = 0;
+}
+
+
+ColumnReader::~ColumnReader ()
+{
+  close ();
+}
+
+
+//-----------------------------------------------------------------------
+//   open
+//-----------------------------------------------------------------------
+
+
+void ColumnReader::open ( const String& fileName )
+{
+  struct stat  st;
+
+  close ();
+
+  int  fd = ::open ( fileName.addr(), O_RDONLY );
+
+  if ( fd < 0 )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not open file: %s", ::strerror( errno ) )
+    );
+  }
+
+  if ( ::fstat( fd, &st ) != 0 || st.st_size < 48 )
+  {
+    ::close ( fd );
+
+    throw IllegalInputException (
+      fileName,
+      "not a column store"
+    );
+  }
+
+  void*  addr = ::mmap ( 0, (size_t) st.st_size, PROT_READ,
+                         MAP_PRIVATE, fd, 0 );
+
+  ::close ( fd );
+
+  if ( addr == MAP_FAILED )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not map file: %s", ::strerror( errno ) )
+    );
+  }
+
+  map_      = (const char*) addr;
+  mapSize_  = (idx_t) st.st_size;
+  fileName_ = fileName;
+
+  const int32_t*  head = (const int32_t*) (map_ + 8);
+  const int64_t*  size = (const int64_t*) (map_ + 16);
+  const char*     tail = map_ + mapSize_ - 16;
+
+  const char*     error = 0;
+
+  if ( std::memcmp( map_, HEAD_MAGIC_, 8 ) != 0 )
+  {
+    error = "not a column store";
+  }
+  else if ( head[0] != ColumnWriter::VERSION )
+  {
+    error = "unsupported column store version";
+  }
+  else if ( std::memcmp( tail + 8, TAIL_MAGIC_, 8 ) != 0 )
+  {
+    error = "column store has no index (not closed?)";
+  }
+
+  if ( error )
+  {
+    close ();
+
+    throw IllegalInputException ( fileName, error );
+  }
+
+  const idx_t  fieldCount = head[1];
+  idx_t        pos        = 32;
+
+  pointCount_ = (idx_t) size[0];
+  chunkSize_  = (idx_t) size[1];
+
+  for ( idx_t j = 0; j < fieldCount && pos + 8 <= mapSize_; j++ )
+  {
+    const idx_t  len = (idx_t) *((const int64_t*) (map_ + pos));
+
+    pos += 8;
+
+    if ( len < 0 || pos + len > mapSize_ )
+    {
+      break;
+    }
+
+    names_.pushBack ( String( map_ + pos, map_ + pos + len ) );
+
+    pos += padded_( len );
+  }
+
+  // Read the index.
+
+  const idx_t  indexPos = (idx_t) *((const int64_t*) tail);
+
+  if ( names_.size() == fieldCount && chunkSize_ > 0 &&
+       indexPos >= pos && indexPos + 8 <= mapSize_ - 16 )
+  {
+    frameCount_ = (idx_t) *((const int64_t*) (map_ + indexPos));
+    frames_     = (const int64_t*) (map_ + indexPos + 8);
+    pos         = indexPos + 8 + 16 * frameCount_;
+
+    if ( frameCount_ >= 0 && pos + 8 <= mapSize_ - 16 )
+    {
+      chunkCount_ = (idx_t) *((const int64_t*) (map_ + pos));
+      index_      = (const int64_t*) (map_ + pos + 8);
+      pos        += 8 + 8 * INDEX_WIDTH_ * chunkCount_;
+    }
+  }
+
+  const idx_t  perField = (pointCount_ + chunkSize_ - 1) / chunkSize_;
+
+  if ( index_ == 0 || pos != mapSize_ - 16 ||
+       chunkCount_ != frameCount_ * fieldCount * perField )
+  {
+    close ();
+
+    throw IllegalInputException (
+      fileName,
+      "corrupt column store index"
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   close
+//-----------------------------------------------------------------------
+
+
+void ColumnReader::close ()
+{
+  if ( map_ )
+  {
+    ::munmap ( (void*) map_, (size_t) mapSize_ );
+  }
+
+  map_        = 0;
+  mapSize_    = 0;
+  pointCount_ = 0;
+  chunkSize_  = 1;
+  frameCount_ = 0;
+  chunkCount_ = 0;
+  frames_     = 0;
+  index_      = 0;
+
+  names_.clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getFieldName & findField
+//-----------------------------------------------------------------------
+
+
+const String& ColumnReader::getFieldName ( idx_t field ) const
+{
+  JEM_PRECHECK ( field >= 0 && field < names_.size() );
+
+  return names_[field];
+}
+
+
+idx_t ColumnReader::findField ( const String& name ) const
+{
+  for ( idx_t j = 0; j < names_.size(); j++ )
+  {
+    if ( names_[j] == name )
+    {
+      return j;
+    }
+  }
+
+  return -1;
+}
+
+
+//-----------------------------------------------------------------------
+//   getStep & getTime
+//-----------------------------------------------------------------------
+
+
+int ColumnReader::getStep ( idx_t frame ) const
+{
+  JEM_PRECHECK ( frame >= 0 && frame < frameCount_ );
+
+  return (int) frames_[2 * frame];
+}
+
+
+double ColumnReader::getTime ( idx_t frame ) const
+{
+  JEM_PRECHECK ( frame >= 0 && frame < frameCount_ );
+
+  double  t;
+
+  std::memcpy ( &t, frames_ + 2 * frame + 1, sizeof(t) );
+
+  return t;
+}
+
+
+//-----------------------------------------------------------------------
+//   read
+//-----------------------------------------------------------------------
+
+
+void ColumnReader::read
+
+  ( const Vector&  values,
+    idx_t          field,
+    idx_t          frame ) const
+
+{
+  JEM_PRECHECK ( values.size() == pointCount_ );
+
+  Vector  buf;
+
+  if ( values.isContiguous() )
+  {
+    buf.ref ( values );
+  }
+  else
+  {
+    buf.resize ( pointCount_ );
+  }
+
+  for ( idx_t first = 0; first < pointCount_; first += chunkSize_ )
+  {
+    const int64_t*  chunk = findChunk_ ( field, frame, first );
+
+    decode_ ( buf.addr() + first, chunk );
+  }
+
+  if ( ! values.isContiguous() )
+  {
+    values = buf;
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   readHistory
+//-----------------------------------------------------------------------
+
+// Raw chunks are read in place; packed chunks have to be decoded as a
+// whole.
+
+void ColumnReader::readHistory
+
+  ( const Vector&  values,
+    idx_t          field,
+    idx_t          point ) const
+
+{
+  JEM_PRECHECK ( values.size() == frameCount_ &&
+                 point >= 0 && point < pointCount_ );
+
+  Flex<double>  buf;
+
+  for ( idx_t i = 0; i < frameCount_; i++ )
+  {
+    const int64_t*  chunk = findChunk_ ( field, i, point );
+    const idx_t     k     = point - (idx_t) chunk[2];
+
+    if ( chunk[6] == RAW_ )
+    {
+      std::memcpy ( &values[i], map_ + chunk[4] + k * 8, sizeof(double) );
+    }
+    else
+    {
+      buf.resize ( (idx_t) chunk[3] );
+
+      decode_ ( buf.addr(), chunk );
+
+      values[i] = buf[k];
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   findChunk_
+//-----------------------------------------------------------------------
+
+
+const int64_t* ColumnReader::findChunk_
+
+  ( idx_t  field,
+    idx_t  frame,
+    idx_t  point ) const
+
+{
+  JEM_PRECHECK ( field >= 0 && field < names_.size() &&
+                 frame >= 0 && frame < frameCount_ );
+
+  const idx_t     perField = (pointCount_ + chunkSize_ - 1) / chunkSize_;
+  const idx_t     k        = (frame * names_.size() + field) * perField +
+                             point / chunkSize_;
+  const int64_t*  chunk    = index_ + INDEX_WIDTH_ * k;
+
+  if ( chunk[0] != frame || chunk[1] != field ||
+       chunk[4] < 0 || chunk[4] + chunk[5] > mapSize_ )
+  {
+    throw IllegalInputException (
+      fileName_,
+      "corrupt column store index"
+    );
+  }
+
+  return chunk;
+}
+
+
+//-----------------------------------------------------------------------
+//   decode_
+//-----------------------------------------------------------------------
+
+
+void ColumnReader::decode_
+
+  ( double*         dest,
+    const int64_t*  chunk ) const
+
+{
+  const idx_t  count = (idx_t) chunk[3];
+  const char*  data  = map_ + chunk[4];
+
+  if ( chunk[6] == RAW_ )
+  {
+    std::memcpy ( dest, data, (size_t) count * sizeof(double) );
+  }
+  else
+  {
+    unpack_ ( dest, count, (const unsigned char*) data,
+              (idx_t) chunk[5], work_, fileName_ );
+  }
+}
@@ -0,0 +1,254 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  These classes write and read column stores: binary files with the
+ *  values of a fixed set of fields (the history variables) at a fixed
+ *  set of points (the integration points) for a series of steps.
+ *
+ *  The values of one field in one step are stored together, split in
+ *  chunks of at most chunkSize points. A chunk is stored as raw
+ *  doubles or, if compression is enabled and it pays off, with the
+ *  bytes of the doubles grouped by significance and run length
+ *  encoded; that works well for fields that are mostly zero or change
+ *  little between points. An index at the end of the file gives the
+ *  location of every chunk.
+ *
+ *  The reader maps the file into memory and only touches the chunks
+ *  that are read, so one field can be read over all steps without
+ *  reading the others. A file that was not closed has no index and can
+ *  not be read.
+ *
+ */
+
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <stdint.h>
+#include <cstdio>
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+using jive::Matrix;
+using jive::StringVector;
+
+
+//-----------------------------------------------------------------------
+//   class ColumnWriter
+//-----------------------------------------------------------------------
+
+
+class ColumnWriter : public jem::Object
+{
+ public:
+
+  typedef ColumnWriter      Self;
+  typedef jem::Object       Super;
+
+  static const int          VERSION;
+
+                            ColumnWriter  ();
+
+  void                      open
+
+    ( const String&           fileName,
+      const StringVector&     fieldNames,
+      idx_t                   pointCount,
+      idx_t                   chunkSize = 1 << 20,
+      bool                    compress  = false );
+
+  // values(i,j) is field j at point i
+
+  void                      append
+
+    ( int                     step,
+      double                  time,
+      const Matrix&           values );
+
+  void                      close         ();
+
+  inline bool               isOpen        () const;
+
+
+ protected:
+
+  virtual                  ~ColumnWriter  ();
+
+
+ private:
+
+  void                      writeChunk_
+
+    ( idx_t                   field,
+      idx_t                   first,
+      idx_t                   count,
+      const double*           values );
+
+  void                      put_
+
+    ( const void*             data,
+      idx_t                   size );
+
+
+ private:
+
+  std::FILE*                file_;
+  String                    fileName_;
+  idx_t                     fieldCount_;
+  idx_t                     pointCount_;
+  idx_t                     chunkSize_;
+  bool                      compress_;
+  idx_t                     pos_;
+
+  // the steps and times and, per chunk, seven index entries (see the
+  // .cpp file)
+
+  Flex<idx_t>               steps_;
+  Flex<double>              times_;
+  Flex<idx_t>               index_;
+
+  Flex<double>              column_;
+  Flex<unsigned char>       packed_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   class ColumnReader
+//-----------------------------------------------------------------------
+
+
+class ColumnReader : public jem::Object
+{
+ public:
+
+  typedef ColumnReader      Self;
+  typedef jem::Object       Super;
+
+                            ColumnReader  ();
+
+  void                      open
+
+    ( const String&           fileName );
+
+  void                      close         ();
+
+  inline idx_t              fieldCount    () const;
+  inline idx_t              pointCount    () const;
+  inline idx_t              frameCount    () const;
+
+  const String&             getFieldName
+
+    ( idx_t                   field )      const;
+
+  idx_t                     findField
+
+    ( const String&           name )       const;
+
+  int                       getStep
+
+    ( idx_t                   frame )      const;
+
+  double                    getTime
+
+    ( idx_t                   frame )      const;
+
+  // Reads field at all points in one frame
+
+  void                      read
+
+    ( const Vector&           values,
+      idx_t                   field,
+      idx_t                   frame )      const;
+
+  // Reads field at one point in all frames
+
+  void                      readHistory
+
+    ( const Vector&           values,
+      idx_t                   field,
+      idx_t                   point )      const;
+
+
+ protected:
+
+  virtual                  ~ColumnReader  ();
+
+
+ private:
+
+  const int64_t*            findChunk_
+
+    ( idx_t                   field,
+      idx_t                   frame,
+      idx_t                   point )      const;
+
+  void                      decode_
+
+    ( double*                 dest,
+      const int64_t*          chunk )      const;
+
+
+ private:
+
+  String                    fileName_;
+  const char*               map_;
+  idx_t                     mapSize_;
+
+  Flex<String>              names_;
+  idx_t                     pointCount_;
+  idx_t                     chunkSize_;
+  idx_t                     frameCount_;
+  idx_t                     chunkCount_;
+
+  const int64_t*            frames_;
+  const int64_t*            index_;
+
+  mutable Flex<unsigned char>
+                            work_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   isOpen
+//-----------------------------------------------------------------------
+
+
+inline bool ColumnWriter::isOpen () const
+{
+  return ( file_ != 0 );
+}
+
+
+//-----------------------------------------------------------------------
+//   fieldCount, pointCount & frameCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t ColumnReader::fieldCount () const
+{
+  return names_.size ();
+}
+
+
+inline idx_t ColumnReader::pointCount () const
+{
+  return pointCount_;
+}
+
+
+inline idx_t ColumnReader::frameCount () const
+{
+  return frameCount_;
+}
+
+
+#endif
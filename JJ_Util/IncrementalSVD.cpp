@@ -0,0 +1,420 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Incremental truncated SVD; see IncrementalSVD.h.
+ *
+ *  Adding a column c to D = U S V^T gives
+ *
+ *    [D c] = [U r] K [V 0; 0 1]^T,  K = [S p; 0 rho]
+ *
+ *  with p = U^T c, r the normalized residual c - U p and rho its norm.
+ *  With K = Uk Sk Vk^T the new factors are [U r] Uk, Sk and
+ *  [V 0; 0 1] Vk, truncated to the significant singular values.
+ *
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include <jem/base/assert.h>
+
+#include "IncrementalSVD.h"
+
+
+//=======================================================================
+//   private helpers
+//=======================================================================
+
+
+// Compares indices by decreasing singular value.
+
+class ByValue_
+{
+ public:
+
+  explicit ByValue_ ( const double* s ) : s_ ( s ) {}
+
+  bool operator () ( idx_t i, idx_t j ) const
+  {
+    return s_[i] > s_[j];
+  }
+
+ private:
+
+  const double*  s_;
+};
+
+
+// Decomposes the n x n matrix a (column major) with one-sided Jacobi
+// rotations: on return a holds the columns U(:,j) * s[j] and v the
+// right singular vectors, so that the input equals a v^T.
+
+static void         jacobiSVD_
+
+  ( double*  a,
+    double*  v,
+    double*  s,
+    idx_t    n )
+
+{
+  const double  eps = 1.0e-15;
+
+  for ( idx_t i = 0; i < n * n; i++ )
+  {
+    v[i] = 0.0;
+  }
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    v[i * n + i] = 1.0;
+  }
+
+  for ( int sweep = 0; sweep < 60; sweep++ )
+  {
+    bool  done = true;
+
+    for ( idx_t i = 0; i < n - 1; i++ )
+    {
+      for ( idx_t j = i + 1; j < n; j++ )
+      {
+        double*  ai    = a + i * n;
+        double*  aj    = a + j * n;
+        double   alpha = 0.0;
+        double   beta  = 0.0;
+        double   gamma = 0.0;
+
+        for ( idx_t k = 0; k < n; k++ )
+        {
+          alpha += ai[k] * ai[k];
+          beta  += aj[k] * aj[k];
+          gamma += ai[k] * aj[k];
+        }
+
+        if ( gamma == 0.0 ||
+             std::fabs( gamma ) <= eps * std::sqrt( alpha * beta ) )
+        {
+          continue;
+        }
+
+        done = false;
+
+        const double  zeta = (beta - alpha) / (2.0 * gamma);
+        const double  t    = ( zeta >= 0.0 ? 1.0 : -1.0 ) /
+                             ( std::fabs( zeta ) +
+                               std::sqrt( 1.0 + zeta * zeta ) );
+        const double  c    = 1.0 / std::sqrt ( 1.0 + t * t );
+        const double  sn   = c * t;
+
+        double*       vi   = v + i * n;
+        double*       vj   = v + j * n;
+
+        for ( idx_t k = 0; k < n; k++ )
+        {
+          const double  x = ai[k];
+          const double  y = aj[k];
+
+          ai[k] = c * x - sn * y;
+          aj[k] = sn * x + c * y;
+        }
+
+        for ( idx_t k = 0; k < n; k++ )
+        {
+          const double  x = vi[k];
+          const double  y = vj[k];
+
+          vi[k] = c * x - sn * y;
+          vj[k] = sn * x + c * y;
+        }
+      }
+    }
+
+    if ( done )
+    {
+      break;
+    }
+  }
+
+  for ( idx_t j = 0; j < n; j++ )
+  {
+    double  sum = 0.0;
+
+    for ( idx_t k = 0; k < n; k++ )
+    {
+      sum += a[j * n + k] * a[j * n + k];
+    }
+
+    s[j] = std::sqrt ( sum );
+  }
+}
+
+
+//=======================================================================
+//   class IncrementalSVD
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+IncrementalSVD::IncrementalSVD
+
+  ( idx_t   rowCount,
+    double  tolerance,
+    idx_t   maxRank )
+
+{
+  JEM_PRECHECK ( rowCount >= 0 && maxRank > 0 );
+
+  rowCount_ = rowCount;
+  colCount_ = 0;
+  rank_     = 0;
+  tol_      = tolerance;
+  maxRank_  = maxRank;
+}
+
+
+IncrementalSVD::~IncrementalSVD ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   addColumn
+//-----------------------------------------------------------------------
+
+
+void IncrementalSVD::addColumn ( const Vector& column )
+{
+  JEM_PRECHECK ( column.size() == rowCount_ );
+
+  const idx_t  n = rowCount_;
+  const idx_t  m = colCount_;
+  const idx_t  k = rank_;
+  const idx_t  q = k + 1;
+
+  res_ .resize ( n );
+  proj_.resize ( q );
+  core_.resize ( q * q );
+  rot_ .resize ( q * q );
+  sval_.resize ( q );
+  order_.resize ( q );
+
+  double*  u = u_.addr ();
+  double*  r = res_.addr ();
+  double*  p = proj_.addr ();
+  double   cnorm = 0.0;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    r[i]    = column[i];
+    cnorm  += r[i] * r[i];
+  }
+
+  cnorm = std::sqrt ( cnorm );
+
+  // Project on the basis; the projection is done twice to keep the
+  // residual orthogonal to the basis in finite precision.
+
+  for ( idx_t j = 0; j < k; j++ )
+  {
+    p[j] = 0.0;
+  }
+
+  for ( int pass = 0; pass < 2; pass++ )
+  {
+    for ( idx_t j = 0; j < k; j++ )
+    {
+      const double*  uj = u + j * n;
+      double         d  = 0.0;
+
+      for ( idx_t i = 0; i < n; i++ )
+      {
+        d += uj[i] * r[i];
+      }
+
+      for ( idx_t i = 0; i < n; i++ )
+      {
+        r[i] -= d * uj[i];
+      }
+
+      p[j] += d;
+    }
+  }
+
+  double  rho = 0.0;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    rho += r[i] * r[i];
+  }
+
+  rho = std::sqrt ( rho );
+
+  if ( rho <= 1.0e-13 * cnorm || rho == 0.0 )
+  {
+    rho = 0.0;
+
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      r[i] = 0.0;
+    }
+  }
+  else
+  {
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      r[i] /= rho;
+    }
+  }
+
+  // Decompose the core matrix K = [S p; 0 rho].
+
+  double*  a = core_.addr ();
+  double*  w = rot_ .addr ();
+  double*  s = sval_.addr ();
+
+  for ( idx_t i = 0; i < q * q; i++ )
+  {
+    a[i] = 0.0;
+  }
+
+  for ( idx_t j = 0; j < k; j++ )
+  {
+    a[j * q + j] = s_[j];
+    a[k * q + j] = p[j];
+  }
+
+  a[k * q + k] = rho;
+
+  jacobiSVD_ ( a, w, s, q );
+
+  for ( idx_t j = 0; j < q; j++ )
+  {
+    order_[j] = j;
+  }
+
+  std::sort ( order_.addr(), order_.addr() + q, ByValue_( s ) );
+
+  // Truncate.
+
+  const double  smax  = s[order_[0]];
+  idx_t         knew  = 0;
+
+  while ( knew < q && knew < maxRank_ && smax > 0.0 &&
+          s[order_[knew]] > tol_ * smax )
+  {
+    knew++;
+  }
+
+  // U = [U r] Uk, where the columns of a are Uk(:,j) * s[j].
+
+  unew_.resize ( n * knew );
+
+  for ( idx_t jj = 0; jj < knew; jj++ )
+  {
+    const idx_t    j  = order_[jj];
+    const double*  aj = a + j * q;
+    double*        un = unew_.addr() + jj * n;
+
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      un[i] = r[i] * aj[k];
+    }
+
+    for ( idx_t l = 0; l < k; l++ )
+    {
+      const double*  ul = u + l * n;
+      const double   f  = aj[l];
+
+      if ( f == 0.0 )
+      {
+        continue;
+      }
+
+      for ( idx_t i = 0; i < n; i++ )
+      {
+        un[i] += f * ul[i];
+      }
+    }
+
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      un[i] /= s[j];
+    }
+  }
+
+  // V = [V 0; 0 1] Vk, stored row by row.
+
+  vnew_.resize ( (m + 1) * knew );
+
+  for ( idx_t t = 0; t < m; t++ )
+  {
+    const double*  vt = v_.addr() + t * k;
+    double*        vn = vnew_.addr() + t * knew;
+
+    for ( idx_t jj = 0; jj < knew; jj++ )
+    {
+      const double*  wj  = w + order_[jj] * q;
+      double         sum = 0.0;
+
+      for ( idx_t l = 0; l < k; l++ )
+      {
+        sum += vt[l] * wj[l];
+      }
+
+      vn[jj] = sum;
+    }
+  }
+
+  for ( idx_t jj = 0; jj < knew; jj++ )
+  {
+    vnew_[m * knew + jj] = w[order_[jj] * q + k];
+  }
+
+  s_.resize ( knew );
+
+  for ( idx_t jj = 0; jj < knew; jj++ )
+  {
+    s_[jj] = s[order_[jj]];
+  }
+
+  u_.swap ( unew_ );
+  v_.swap ( vnew_ );
+
+  rank_     = knew;
+  colCount_ = m + 1;
+}
+
+
+//-----------------------------------------------------------------------
+//   getColumn
+//-----------------------------------------------------------------------
+
+// Reconstructs column icol of D.
+
+void IncrementalSVD::getColumn
+
+  ( const Vector&  column,
+    idx_t          icol ) const
+
+{
+  JEM_PRECHECK ( column.size() == rowCount_ &&
+                 icol >= 0 && icol < colCount_ );
+
+  const idx_t  n = rowCount_;
+  const idx_t  k = rank_;
+
+  column = 0.0;
+
+  for ( idx_t j = 0; j < k; j++ )
+  {
+    const double   f  = s_[j] * v_[icol * k + j];
+    const double*  uj = u_.addr() + j * n;
+
+    for ( idx_t i = 0; i < n; i++ )
+    {
+      column[i] += f * uj[i];
+    }
+  }
+}
@@ -0,0 +1,167 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class maintains a truncated singular value decomposition
+ *
+ *    D = U S V^T
+ *
+ *  of a matrix D whose columns (snapshots of a field) are added one at
+ *  a time, without storing D (Brand's incremental SVD). A new column
+ *  is split into its projection on U and a residual; the small core
+ *  matrix of the update is decomposed with one-sided Jacobi rotations.
+ *  Singular values smaller than tolerance times the largest are
+ *  dropped, as are all but the first maxRank.
+ *
+ *  The data are kept as raw arrays: the basis U column by column
+ *  (rowCount values per column), the singular values S and the
+ *  coefficients V row by row (rank values per snapshot).
+ *
+ */
+
+#ifndef INCREMENTAL_SVD_H
+#define INCREMENTAL_SVD_H
+
+#include <jem/base/Object.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::idx_t;
+using jem::util::Flex;
+using jive::Vector;
+
+
+//-----------------------------------------------------------------------
+//   class IncrementalSVD
+//-----------------------------------------------------------------------
+
+
+class IncrementalSVD : public jem::Object
+{
+ public:
+
+  typedef IncrementalSVD    Self;
+  typedef jem::Object       Super;
+
+                            IncrementalSVD
+
+    ( idx_t                   rowCount,
+      double                  tolerance = 1.0e-6,
+      idx_t                   maxRank   = 100 );
+
+  void                      addColumn
+
+    ( const Vector&           column );
+
+  void                      getColumn
+
+    ( const Vector&           column,
+      idx_t                   icol )       const;
+
+  inline idx_t              rowCount      () const;
+  inline idx_t              columnCount   () const;
+  inline idx_t              rank          () const;
+
+  inline const double*      getBasis      () const;
+  inline const double*      getValues     () const;
+  inline const double*      getCoeffs     () const;
+
+
+ protected:
+
+  virtual                  ~IncrementalSVD ();
+
+
+ private:
+
+  idx_t                     rowCount_;
+  idx_t                     colCount_;
+  idx_t                     rank_;
+  double                    tol_;
+  idx_t                     maxRank_;
+
+  Flex<double>              u_;
+  Flex<double>              s_;
+  Flex<double>              v_;
+
+  // work arrays of addColumn
+
+  Flex<double>              res_;
+  Flex<double>              proj_;
+  Flex<double>              core_;
+  Flex<double>              rot_;
+  Flex<double>              sval_;
+  Flex<idx_t>               order_;
+  Flex<double>              unew_;
+  Flex<double>              vnew_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   rowCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t IncrementalSVD::rowCount () const
+{
+  return rowCount_;
+}
+
+
+//-----------------------------------------------------------------------
+//   columnCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t IncrementalSVD::columnCount () const
+{
+  return colCount_;
+}
+
+
+//-----------------------------------------------------------------------
+//   rank
+//-----------------------------------------------------------------------
+
+
+inline idx_t IncrementalSVD::rank () const
+{
+  return rank_;
+}
+
+
+//-----------------------------------------------------------------------
+//   getBasis
+//-----------------------------------------------------------------------
+
+
+inline const double* IncrementalSVD::getBasis () const
+{
+  return u_.addr ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getValues
+//-----------------------------------------------------------------------
+
+
+inline const double* IncrementalSVD::getValues () const
+{
+  return s_.addr ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getCoeffs
+//-----------------------------------------------------------------------
+
+
+inline const double* IncrementalSVD::getCoeffs () const
+{
+  return v_.addr ();
+}
+
+
+#endif
@@ -0,0 +1,566 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Low-rank snapshot files; see LowRankStore.h.
+ *
+ *  File layout (all fields 8 byte aligned):
+ *
+ *    char[8]   magic "JJLOWRK"
+ *    int32     format version
+ *    int32     number of fields
+ *    int64     number of frames
+ *
+ *    per frame: int64 step, double time
+ *
+ *    per field:
+ *
+ *      int64   length of the name
+ *      int64   number of rows
+ *      int64   number of columns of the field
+ *      int64   rank
+ *      char[]  name, padded to 8 bytes
+ *      double  singular values [rank]
+ *      double  basis, column by column [rank * rows]
+ *      double  coefficients, frame by frame [frames * rank]
+ *
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/assert.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/base/IllegalArgumentException.h>
+#include <jem/io/IOException.h>
+
+#include "LowRankStore.h"
+
+
+using jem::IllegalInputException;
+using jem::IllegalArgumentException;
+using jem::io::IOException;
+
+
+//=======================================================================
+//   private helpers
+//=======================================================================
+
+
+static const char   MAGIC_[8]    = { 'J','J','L','O','W','R','K', 0 };
+
+static const idx_t  HEAD_SIZE_   = 24;
+static const idx_t  FIELD_WIDTH_ = 4;
+
+
+static inline idx_t padded_ ( idx_t n )
+{
+  return (n + 7) & ~((idx_t) 7);
+}
+
+
+static void         writeAll_
+
+  ( int           fd,
+    const void*   buf,
+    idx_t         n,
+    const String& fileName )
+
+{
+  const char*  p = (const char*) buf;
+
+  while ( n > 0 )
+  {
+    ssize_t  k = ::write ( fd, p, (size_t) n );
+
+    if ( k < 0 )
+    {
+      if ( errno == EINTR )
+      {
+        continue;
+      }
+
+      throw IOException (
+        fileName,
+        String::format ( "write error: %s", ::strerror( errno ) )
+      );
+    }
+
+    p += k;
+    n -= (idx_t) k;
+  }
+}
+
+
+//=======================================================================
+//   class LowRankWriter
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const int  LowRankWriter::VERSION = 1;
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+LowRankWriter::LowRankWriter ()
+{}
+
+
+LowRankWriter::~LowRankWriter ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   clear
+//-----------------------------------------------------------------------
+
+
+void LowRankWriter::clear ()
+{
+  steps_    .clear ();
+  times_    .clear ();
+  names_    .clear ();
+  colCounts_.clear ();
+  fields_   .clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   addFrame
+//-----------------------------------------------------------------------
+
+
+void LowRankWriter::addFrame
+
+  ( int     step,
+    double  time )
+
+{
+  steps_.pushBack ( step );
+  times_.pushBack ( time );
+}
+
+
+//-----------------------------------------------------------------------
+//   addField
+//-----------------------------------------------------------------------
+
+// The decomposition is referenced, not copied; it is written in the
+// state it has when write is called.
+
+void LowRankWriter::addField
+
+  ( const String&               name,
+    idx_t                       colCount,
+    const Ref<IncrementalSVD>&  svd )
+
+{
+  JEM_PRECHECK ( svd != NIL && colCount > 0 );
+
+  if ( svd->rowCount() % colCount != 0 )
+  {
+    throw IllegalArgumentException (
+      JEM_FUNC,
+      String::format ( "field %s: %d rows do not fit %d columns",
+                       name, (int) svd->rowCount(), (int) colCount )
+    );
+  }
+
+  names_    .pushBack ( name     );
+  colCounts_.pushBack ( colCount );
+  fields_   .pushBack ( svd      );
+}
+
+
+//-----------------------------------------------------------------------
+//   write
+//-----------------------------------------------------------------------
+
+// Writes the file under a temporary name and renames it, so that an
+// existing file is only replaced by a complete one.
+
+void LowRankWriter::write ( const String& fileName ) const
+{
+  const String  tmpName    = fileName + ".tmp";
+  const idx_t   frameCount = steps_.size ();
+  const char    zeros[8]   = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  for ( idx_t j = 0; j < fields_.size(); j++ )
+  {
+    if ( fields_[j]->columnCount() != frameCount )
+    {
+      throw IllegalArgumentException (
+        JEM_FUNC,
+        String::format ( "field %s has %d snapshots but there are "
+                         "%d frames", names_[j],
+                         (int) fields_[j]->columnCount(),
+                         (int) frameCount )
+      );
+    }
+  }
+
+  int  fd = ::open ( tmpName.addr(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+  if ( fd < 0 )
+  {
+    throw IOException (
+      tmpName,
+      String::format ( "can not create file: %s", ::strerror( errno ) )
+    );
+  }
+
+  try
+  {
+    int32_t  head[2] = { (int32_t) VERSION, (int32_t) names_.size() };
+    int64_t  nf      = (int64_t) frameCount;
+
+    writeAll_ ( fd, MAGIC_, 8,            tmpName );
+    writeAll_ ( fd, head,   sizeof(head), tmpName );
+    writeAll_ ( fd, &nf,    sizeof(nf),   tmpName );
+
+    for ( idx_t i = 0; i < frameCount; i++ )
+    {
+      const int64_t  step = (int64_t) steps_[i];
+
+      writeAll_ ( fd, &step,      sizeof(step),   tmpName );
+      writeAll_ ( fd, &times_[i], sizeof(double), tmpName );
+    }
+
+    for ( idx_t j = 0; j < fields_.size(); j++ )
+    {
+      const IncrementalSVD&  svd  = *fields_[j];
+      const idx_t            len  = names_[j].size ();
+      const idx_t            rows = svd.rowCount ();
+      const idx_t            rank = svd.rank     ();
+      int64_t                rec[FIELD_WIDTH_];
+
+      rec[0] = (int64_t) len;
+      rec[1] = (int64_t) rows;
+      rec[2] = (int64_t) colCounts_[j];
+      rec[3] = (int64_t) rank;
+
+      writeAll_ ( fd, rec,              sizeof(rec),          tmpName );
+      writeAll_ ( fd, names_[j].addr(), len,                  tmpName );
+      writeAll_ ( fd, zeros,            padded_( len ) - len, tmpName );
+
+      writeAll_ ( fd, svd.getValues(), rank * 8,              tmpName );
+      writeAll_ ( fd, svd.getBasis(),  rank * rows * 8,       tmpName );
+      writeAll_ ( fd, svd.getCoeffs(), frameCount * rank * 8, tmpName );
+    }
+  }
+  catch ( ... )
+  {
+    ::close  ( fd );
+    ::unlink ( tmpName.addr() );
+    throw;
+  }
+
+  ::close ( fd );
+
+  if ( ::rename( tmpName.addr(), fileName.addr() ) != 0 )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not rename %s: %s",
+                       tmpName, ::strerror( errno ) )
+    );
+  }
+}
+
+
+//=======================================================================
+//   class LowRankReader
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+LowRankReader::LowRankReader ()
+{
+  map_        = 0;
+  mapSize_    = 0;
+  frameCount_ = 0;
+}
+
+
+LowRankReader::~LowRankReader ()
+{
+  close ();
+}
+
+
+//-----------------------------------------------------------------------
+//   open
+//-----------------------------------------------------------------------
+
+
+void LowRankReader::open ( const String& fileName )
+{
+  struct stat  st;
+
+  close ();
+
+  int  fd = ::open ( fileName.addr(), O_RDONLY );
+
+  if ( fd < 0 )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not open file: %s", ::strerror( errno ) )
+    );
+  }
+
+  if ( ::fstat( fd, &st ) != 0 || st.st_size < HEAD_SIZE_ )
+  {
+    ::close ( fd );
+
+    throw IllegalInputException (
+      fileName,
+      "not a low-rank snapshot file"
+    );
+  }
+
+  void*  addr = ::mmap ( 0, (size_t) st.st_size, PROT_READ,
+                         MAP_PRIVATE, fd, 0 );
+
+  ::close ( fd );
+
+  if ( addr == MAP_FAILED )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not map file: %s", ::strerror( errno ) )
+    );
+  }
+
+  map_      = (const char*) addr;
+  mapSize_  = (idx_t) st.st_size;
+  fileName_ = fileName;
+
+  const int32_t*  head  = (const int32_t*) (map_ + 8);
+  const char*     error = 0;
+
+  if ( std::memcmp( map_, MAGIC_, 8 ) != 0 )
+  {
+    error = "not a low-rank snapshot file";
+  }
+  else if ( head[0] != LowRankWriter::VERSION )
+  {
+    error = "unsupported low-rank snapshot file version";
+  }
+
+  if ( error )
+  {
+    close ();
+
+    throw IllegalInputException ( fileName, error );
+  }
+
+  const idx_t  fieldCount = head[1];
+
+  frameCount_ = (idx_t) *((const int64_t*) (map_ + 16));
+
+  idx_t  pos  = HEAD_SIZE_ + 16 * frameCount_;
+
+  for ( idx_t j = 0; j < fieldCount; j++ )
+  {
+    if ( frameCount_ < 0 || pos + 8 * FIELD_WIDTH_ > mapSize_ )
+    {
+      break;
+    }
+
+    const int64_t*  rec  = (const int64_t*) (map_ + pos);
+    const idx_t     len  = (idx_t) rec[0];
+    const idx_t     rows = (idx_t) rec[1];
+    const idx_t     rank = (idx_t) rec[3];
+    const idx_t     name = pos + 8 * FIELD_WIDTH_;
+
+    if ( len < 0 || rows < 0 || rank < 0 || rec[2] < 1 )
+    {
+      break;
+    }
+
+    const idx_t  next = name + padded_( len ) +
+                        8 * rank * (1 + rows + frameCount_);
+
+    if ( next > mapSize_ )
+    {
+      break;
+    }
+
+    names_ .pushBack ( String( map_ + name, map_ + name + len ) );
+    fields_.pushBack ( pos );
+
+    pos = next;
+  }
+
+  if ( names_.size() != fieldCount || pos != mapSize_ )
+  {
+    close ();
+
+    throw IllegalInputException (
+      fileName,
+      "corrupt low-rank snapshot file"
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   close
+//-----------------------------------------------------------------------
+
+
+void LowRankReader::close ()
+{
+  if ( map_ )
+  {
+    ::munmap ( (void*) map_, (size_t) mapSize_ );
+  }
+
+  map_        = 0;
+  mapSize_    = 0;
+  frameCount_ = 0;
+
+  names_ .clear ();
+  fields_.clear ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getFieldName & findField
+//-----------------------------------------------------------------------
+
+
+const String& LowRankReader::getFieldName ( idx_t field ) const
+{
+  JEM_PRECHECK ( field >= 0 && field < names_.size() );
+
+  return names_[field];
+}
+
+
+idx_t LowRankReader::findField ( const String& name ) const
+{
+  for ( idx_t j = 0; j < names_.size(); j++ )
+  {
+    if ( names_[j] == name )
+    {
+      return j;
+    }
+  }
+
+  return -1;
+}
+
+
+//-----------------------------------------------------------------------
+//   getRowCount, getColCount & getRank
+//-----------------------------------------------------------------------
+
+
+idx_t LowRankReader::getRowCount ( idx_t field ) const
+{
+  JEM_PRECHECK ( field >= 0 && field < fields_.size() );
+
+  return (idx_t) ((const int64_t*) (map_ + fields_[field]))[1];
+}
+
+
+idx_t LowRankReader::getColCount ( idx_t field ) const
+{
+  JEM_PRECHECK ( field >= 0 && field < fields_.size() );
+
+  return (idx_t) ((const int64_t*) (map_ + fields_[field]))[2];
+}
+
+
+idx_t LowRankReader::getRank ( idx_t field ) const
+{
+  JEM_PRECHECK ( field >= 0 && field < fields_.size() );
+
+  return (idx_t) ((const int64_t*) (map_ + fields_[field]))[3];
+}
+
+
+//-----------------------------------------------------------------------
+//   getStep & getTime
+//-----------------------------------------------------------------------
+
+
+int LowRankReader::getStep ( idx_t frame ) const
+{
+  JEM_PRECHECK ( frame >= 0 && frame < frameCount_ );
+
+  return (int) *((const int64_t*) (map_ + HEAD_SIZE_ + 16 * frame));
+}
+
+
+double LowRankReader::getTime ( idx_t frame ) const
+{
+  JEM_PRECHECK ( frame >= 0 && frame < frameCount_ );
+
+  double  t;
+
+  std::memcpy ( &t, map_ + HEAD_SIZE_ + 16 * frame + 8, sizeof(t) );
+
+  return t;
+}
+
+
+//-----------------------------------------------------------------------
+//   read
+//-----------------------------------------------------------------------
+
+// Computes sum_j U(:,j) * S[j] * V(frame,j); the basis is read in
+// place from the mapped file.
+
+void LowRankReader::read
+
+  ( const Vector&  values,
+    idx_t          field,
+    idx_t          frame ) const
+
+{
+  JEM_PRECHECK ( field >= 0 && field < fields_.size() &&
+                 frame >= 0 && frame < frameCount_ );
+
+  const int64_t*  rec  = (const int64_t*) (map_ + fields_[field]);
+  const idx_t     len  = (idx_t) rec[0];
+  const idx_t     rows = (idx_t) rec[1];
+  const idx_t     rank = (idx_t) rec[3];
+
+  JEM_PRECHECK ( values.size() == rows );
+
+  const double*   s    = (const double*)
+    (map_ + fields_[field] + 8 * FIELD_WIDTH_ + padded_( len ));
+  const double*   u    = s + rank;
+  const double*   v    = u + rank * rows + frame * rank;
+
+  values = 0.0;
+
+  for ( idx_t j = 0; j < rank; j++ )
+  {
+    const double   f  = s[j] * v[j];
+    const double*  uj = u + j * rows;
+
+    for ( idx_t i = 0; i < rows; i++ )
+    {
+      values[i] += f * uj[i];
+    }
+  }
+}
@@ -0,0 +1,187 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  These classes write and read low-rank snapshot files: a series of
+ *  frames (step and time) and for each field the truncated SVD of its
+ *  snapshots (see IncrementalSVD.h), so the file holds the basis,
+ *  the singular values and one small set of coefficients per frame
+ *  instead of all values of all frames.
+ *
+ *  The writer collects the frames and the decompositions and writes
+ *  the file in one go, first under a temporary name. The reader maps
+ *  the file into memory and reconstructs a field in any frame.
+ *
+ *  A field may be a matrix stored column by column; colCount records
+ *  the number of columns so that the reader can restore its shape.
+ *
+ */
+
+#ifndef LOW_RANK_STORE_H
+#define LOW_RANK_STORE_H
+
+#include <stdint.h>
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+#include "IncrementalSVD.h"
+
+using jem::Ref;
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+
+
+//-----------------------------------------------------------------------
+//   class LowRankWriter
+//-----------------------------------------------------------------------
+
+
+class LowRankWriter : public jem::Object
+{
+ public:
+
+  typedef LowRankWriter     Self;
+  typedef jem::Object       Super;
+
+  static const int          VERSION;
+
+                            LowRankWriter ();
+
+  void                      clear         ();
+
+  void                      addFrame
+
+    ( int                     step,
+      double                  time );
+
+  void                      addField
+
+    ( const String&           name,
+      idx_t                   colCount,
+      const Ref<IncrementalSVD>&  svd );
+
+  void                      write
+
+    ( const String&           fileName )   const;
+
+
+ protected:
+
+  virtual                  ~LowRankWriter ();
+
+
+ private:
+
+  Flex<int>                 steps_;
+  Flex<double>              times_;
+
+  Flex<String>              names_;
+  Flex<idx_t>               colCounts_;
+  Flex< Ref<IncrementalSVD> >  fields_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   class LowRankReader
+//-----------------------------------------------------------------------
+
+
+class LowRankReader : public jem::Object
+{
+ public:
+
+  typedef LowRankReader     Self;
+  typedef jem::Object       Super;
+
+                            LowRankReader ();
+
+  void                      open
+
+    ( const String&           fileName );
+
+  void                      close         ();
+
+  inline idx_t              fieldCount    () const;
+  inline idx_t              frameCount    () const;
+
+  const String&             getFieldName
+
+    ( idx_t                   field )      const;
+
+  idx_t                     findField
+
+    ( const String&           name )       const;
+
+  idx_t                     getRowCount
+
+    ( idx_t                   field )      const;
+
+  idx_t                     getColCount
+
+    ( idx_t                   field )      const;
+
+  idx_t                     getRank
+
+    ( idx_t                   field )      const;
+
+  int                       getStep
+
+    ( idx_t                   frame )      const;
+
+  double                    getTime
+
+    ( idx_t                   frame )      const;
+
+  // Reconstructs a field (getRowCount values) in one frame
+
+  void                      read
+
+    ( const Vector&           values,
+      idx_t                   field,
+      idx_t                   frame )      const;
+
+
+ protected:
+
+  virtual                  ~LowRankReader ();
+
+
+ private:
+
+  String                    fileName_;
+  const char*               map_;
+  idx_t                     mapSize_;
+  idx_t                     frameCount_;
+
+  // per field: the offset of its record in the file
+
+  Flex<String>              names_;
+  Flex<idx_t>               fields_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   fieldCount & frameCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t LowRankReader::fieldCount () const
+{
+  return names_.size ();
+}
+
+
+inline idx_t LowRankReader::frameCount () const
+{
+  return frameCount_;
+}
+
+
+#endif
@@ -25,3 +25,11 @@ const char*  PropertyNames::SAMPLE_ELEM = "sampleElem";
 const char*  PropertyNames::SHAPE       = "shape";
 const char*  PropertyNames::THICKNESS   = "thickness";
 const char*  PropertyNames::DT_ASSEMBLY  = "dtAssembly";
+const char*  PropertyNames::AUTO_STEP   = "autoStep";
+const char*  PropertyNames::SAFETY      = "safety";
+const char*  PropertyNames::UPDATE_INTERVAL = "updateInterval";
+const char*  PropertyNames::SUBCYCLING  = "subcycling";
+const char*  PropertyNames::MAX_LEVEL   = "maxLevel";
+const char*  PropertyNames::STEPS_PER_RUN   = "stepsPerRun";
+const char*  PropertyNames::COMMIT_INTERVAL = "commitInterval";
+const char*  PropertyNames::REPORT_INTERVAL = "reportInterval";
@@ -35,6 +35,14 @@ class PropertyNames
   static const char*    SHAPE;
   static const char*    THICKNESS;
   static const char*    DT_ASSEMBLY;
+  static const char*    AUTO_STEP;
+  static const char*    SAFETY;
+  static const char*    UPDATE_INTERVAL;
+  static const char*    SUBCYCLING;
+  static const char*    MAX_LEVEL;
+  static const char*    STEPS_PER_RUN;
+  static const char*    COMMIT_INTERVAL;
+  static const char*    REPORT_INTERVAL;
 };
 
 
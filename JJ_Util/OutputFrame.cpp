@@ -0,0 +1,163 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Output snapshot of one step; see OutputFrame.h.
+ *
+ */
+
+#include <jem/base/assert.h>
+
+#include "OutputFrame.h"
+
+
+using jem::newInstance;
+
+
+//=======================================================================
+//   class OutputFrame::Block_
+//=======================================================================
+
+
+class OutputFrame::Block_ : public jem::Object
+{
+ public:
+
+  String                    name;
+  StringVector              colNames;
+  Matrix                    data;
+
+};
+
+
+//=======================================================================
+//   class OutputFrame
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+OutputFrame::OutputFrame ()
+{
+  time  = 0.0;
+  step  = 0;
+  used_ = 0;
+
+  ipCoords     = false;
+  nodalAverage = false;
+}
+
+
+OutputFrame::~OutputFrame ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   clear
+//-----------------------------------------------------------------------
+
+// Marks all blocks as unused; their arrays are kept for the next
+// snapshot.
+
+void OutputFrame::clear ()
+{
+  used_ = 0;
+}
+
+
+//-----------------------------------------------------------------------
+//   getBlock
+//-----------------------------------------------------------------------
+
+// Returns the next block of the frame, to be filled by the caller.
+// The block is only reallocated if it was used for another model or if
+// its shape has changed.
+
+const Matrix& OutputFrame::getBlock
+
+  ( const String&        name,
+    idx_t                rowCount,
+    const StringVector&  colNames )
+
+{
+  const idx_t  colCount = colNames.size ();
+
+  if ( used_ == blocks_.size() )
+  {
+    blocks_.pushBack ( newInstance<Block_>() );
+  }
+
+  Block_&  b = * blocks_[used_++];
+
+  b.name = name;
+
+  if ( b.colNames.size() != colCount )
+  {
+    b.colNames.ref ( StringVector( colCount ) );
+  }
+
+  b.colNames = colNames;
+
+  if ( b.data.size(0) != rowCount || b.data.size(1) != colCount )
+  {
+    b.data.ref ( Matrix( rowCount, colCount ) );
+  }
+
+  return b.data;
+}
+
+
+const Matrix& OutputFrame::getBlock ( idx_t iblock ) const
+{
+  JEM_ASSERT ( iblock >= 0 && iblock < used_ );
+
+  return blocks_[iblock]->data;
+}
+
+
+//-----------------------------------------------------------------------
+//   findBlock
+//-----------------------------------------------------------------------
+
+// Returns the index of the block with the given name, or -1.
+
+idx_t OutputFrame::findBlock ( const String& name ) const
+{
+  for ( idx_t i = 0; i < used_; i++ )
+  {
+    if ( blocks_[i]->name == name )
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+
+//-----------------------------------------------------------------------
+//   getBlockName
+//-----------------------------------------------------------------------
+
+
+const String& OutputFrame::getBlockName ( idx_t iblock ) const
+{
+  JEM_ASSERT ( iblock >= 0 && iblock < used_ );
+
+  return blocks_[iblock]->name;
+}
+
+
+//-----------------------------------------------------------------------
+//   getColNames
+//-----------------------------------------------------------------------
+
+
+const StringVector& OutputFrame::getColNames ( idx_t iblock ) const
+{
+  JEM_ASSERT ( iblock >= 0 && iblock < used_ );
+
+  return blocks_[iblock]->colNames;
+}
@@ -0,0 +1,113 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class holds a snapshot of the output data of one step: the
+ *  time, the step number, the state vector and for each model a block
+ *  with the history values of all integration points (one row per
+ *  point, one column per history variable).
+ *
+ *  A model may add more blocks on request: with ipCoords set the
+ *  coordinates of the integration points (block <name>.ipCoords) and
+ *  with nodalAverage set the history averaged to the nodes (block
+ *  <name>.nodal, one row per node).
+ *
+ *  The arrays are kept between snapshots, so after the first one a
+ *  snapshot only copies data. A frame is filled in the solver thread
+ *  and may then be read by another thread, as long as it is not
+ *  filled again in the mean time.
+ *
+ */
+
+#ifndef OUTPUT_FRAME_H
+#define OUTPUT_FRAME_H
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::Ref;
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+using jive::Matrix;
+using jive::StringVector;
+
+
+//-----------------------------------------------------------------------
+//   class OutputFrame
+//-----------------------------------------------------------------------
+
+
+class OutputFrame : public jem::Object
+{
+ public:
+
+  typedef OutputFrame       Self;
+  typedef jem::Object       Super;
+
+                            OutputFrame   ();
+
+  void                      clear         ();
+
+  const Matrix&             getBlock
+
+    ( const String&           name,
+      idx_t                   rowCount,
+      const StringVector&     colNames );
+
+  inline idx_t              blockCount    () const;
+
+  idx_t                     findBlock
+
+    ( const String&           name )       const;
+
+  const String&             getBlockName
+
+    ( idx_t                   iblock )     const;
+
+  const StringVector&       getColNames
+
+    ( idx_t                   iblock )     const;
+
+  const Matrix&             getBlock
+
+    ( idx_t                   iblock )     const;
+
+  double                    time;
+  int                       step;
+  Vector                    state;
+
+  bool                      ipCoords;
+  bool                      nodalAverage;
+
+
+ protected:
+
+  virtual                  ~OutputFrame   ();
+
+
+ private:
+
+  class                     Block_;
+
+  Flex< Ref<Block_> >       blocks_;
+  idx_t                     used_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   blockCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t OutputFrame::blockCount () const
+{
+  return used_;
+}
+
+
+#endif
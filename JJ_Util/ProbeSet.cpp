@@ -0,0 +1,137 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Integration point probes; see ProbeSet.h.
+ *
+ */
+
+#include <jem/base/assert.h>
+#include <jem/base/Array.h>
+
+#include "ProbeSet.h"
+
+
+using jem::max;
+using jem::slice;
+
+
+//=======================================================================
+//   class ProbeSet
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+ProbeSet::ProbeSet ()
+{}
+
+
+ProbeSet::~ProbeSet ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   addProbe
+//-----------------------------------------------------------------------
+
+
+idx_t ProbeSet::addProbe
+
+  ( idx_t  ielem,
+    idx_t  ipoint )
+
+{
+  elems_    .pushBack ( ielem  );
+  points_   .pushBack ( ipoint );
+  nameStart_.pushBack ( 0      );
+  nameCount_.pushBack ( -1     );
+
+  return elems_.size() - 1;
+}
+
+
+//-----------------------------------------------------------------------
+//   claim
+//-----------------------------------------------------------------------
+
+
+void ProbeSet::claim
+
+  ( idx_t                iprobe,
+    const StringVector&  names )
+
+{
+  JEM_ASSERT ( ! isClaimed( iprobe ) );
+
+  nameStart_[iprobe] = names_.size ();
+  nameCount_[iprobe] = names .size ();
+
+  for ( idx_t j = 0; j < names.size(); j++ )
+  {
+    names_.pushBack ( names[j] );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   finish
+//-----------------------------------------------------------------------
+
+// Allocates the row with the values of all probes. Probes that have
+// not been claimed get no values.
+
+void ProbeSet::finish ()
+{
+  const idx_t  n = elems_.size ();
+
+  offsets_.resize ( n + 1 );
+
+  offsets_[0] = 0;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    offsets_[i + 1] = offsets_[i] + max ( nameCount_[i], (idx_t) 0 );
+  }
+
+  row_.resize ( offsets_[n] );
+
+  row_ = 0.0;
+}
+
+
+//-----------------------------------------------------------------------
+//   getNames
+//-----------------------------------------------------------------------
+
+
+StringVector ProbeSet::getNames ( idx_t iprobe ) const
+{
+  const idx_t   n = max ( nameCount_[iprobe], (idx_t) 0 );
+
+  StringVector  names ( n );
+
+  for ( idx_t j = 0; j < n; j++ )
+  {
+    names[j] = names_[nameStart_[iprobe] + j];
+  }
+
+  return names;
+}
+
+
+//-----------------------------------------------------------------------
+//   getValues
+//-----------------------------------------------------------------------
+
+// Returns the part of the row with the values of a probe; the returned
+// vector shares its data with the row.
+
+Vector ProbeSet::getValues ( idx_t iprobe ) const
+{
+  JEM_ASSERT ( offsets_.size() == elems_.size() + 1 );
+
+  return row_[slice(offsets_[iprobe],offsets_[iprobe + 1])];
+}
@@ -0,0 +1,167 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class holds a list of integration point probes: an element
+ *  (global index) and an integration point of that element, or -1 for
+ *  the average over all its points.
+ *
+ *  The probes are resolved once: a model that owns the element of a
+ *  probe claims it with the names of its values (RESOLVE_PROBES) and
+ *  remembers which of its points it needs. After finish() the values of
+ *  all probes are stored in one row vector, and each step the models
+ *  only write their values into it (GET_PROBES).
+ *
+ */
+
+#ifndef PROBE_SET_H
+#define PROBE_SET_H
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+using jive::StringVector;
+
+
+//-----------------------------------------------------------------------
+//   class ProbeSet
+//-----------------------------------------------------------------------
+
+
+class ProbeSet : public jem::Object
+{
+ public:
+
+  typedef ProbeSet          Self;
+  typedef jem::Object       Super;
+
+                            ProbeSet      ();
+
+  idx_t                     addProbe
+
+    ( idx_t                   ielem,
+      idx_t                   ipoint = -1 );
+
+  inline idx_t              probeCount    () const;
+  inline idx_t              getElement    ( idx_t iprobe ) const;
+  inline idx_t              getPoint      ( idx_t iprobe ) const;
+  inline bool               isClaimed     ( idx_t iprobe ) const;
+
+  void                      claim
+
+    ( idx_t                   iprobe,
+      const StringVector&     names );
+
+  void                      finish        ();
+
+  inline idx_t              valueCount    () const;
+
+  StringVector              getNames
+
+    ( idx_t                   iprobe )     const;
+
+  Vector                    getValues
+
+    ( idx_t                   iprobe )     const;
+
+  inline const Vector&      getRow        () const;
+
+
+ protected:
+
+  virtual                  ~ProbeSet      ();
+
+
+ private:
+
+  Flex<idx_t>               elems_;
+  Flex<idx_t>               points_;
+
+  // names of the values of each probe, stored after each other;
+  // nameCount_ is -1 for a probe that has not been claimed
+
+  Flex<idx_t>               nameStart_;
+  Flex<idx_t>               nameCount_;
+  Flex<String>              names_;
+
+  // offsets of the values of each probe in row_ (set by finish)
+
+  Flex<idx_t>               offsets_;
+  Vector                    row_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   probeCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t ProbeSet::probeCount () const
+{
+  return elems_.size ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getElement
+//-----------------------------------------------------------------------
+
+
+inline idx_t ProbeSet::getElement ( idx_t iprobe ) const
+{
+  return elems_[iprobe];
+}
+
+
+//-----------------------------------------------------------------------
+//   getPoint
+//-----------------------------------------------------------------------
+
+
+inline idx_t ProbeSet::getPoint ( idx_t iprobe ) const
+{
+  return points_[iprobe];
+}
+
+
+//-----------------------------------------------------------------------
+//   isClaimed
+//-----------------------------------------------------------------------
+
+
+inline bool ProbeSet::isClaimed ( idx_t iprobe ) const
+{
+  return ( nameCount_[iprobe] >= 0 );
+}
+
+
+//-----------------------------------------------------------------------
+//   valueCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t ProbeSet::valueCount () const
+{
+  return row_.size ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getRow
+//-----------------------------------------------------------------------
+
+
+inline const Vector& ProbeSet::getRow () const
+{
+  return row_;
+}
+
+
+#endif
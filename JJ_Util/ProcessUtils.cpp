@@ -0,0 +1,40 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Process utilities; see ProcessUtils.h.
+ *
+ */
+
+#include <dirent.h>
+
+#include "ProcessUtils.h"
+
+
+//-----------------------------------------------------------------------
+//   threadCount
+//-----------------------------------------------------------------------
+
+
+idx_t threadCount ()
+{
+  DIR*    dir   = ::opendir ( "/proc/self/task" );
+  idx_t   count = 0;
+
+  if ( ! dir )
+  {
+    return 1;
+  }
+
+  while ( struct dirent* ent = ::readdir( dir ) )
+  {
+    if ( ent->d_name[0] != '.' )
+    {
+      count++;
+    }
+  }
+
+  ::closedir ( dir );
+
+  return jem::max ( count, (idx_t) 1 );
+}
@@ -0,0 +1,31 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Utilities for modules that fork child processes.
+ *
+ *  Only the calling thread survives a fork, so a child can deadlock on
+ *  a lock held by another thread (the writer thread of AsyncOutput, for
+ *  instance). A module should therefore only fork when threadCount()
+ *  returns 1.
+ *
+ */
+
+#ifndef PROCESS_UTILS_H
+#define PROCESS_UTILS_H
+
+#include <jem/base/utilities.h>
+
+using jem::idx_t;
+
+
+//-----------------------------------------------------------------------
+//   public functions
+//-----------------------------------------------------------------------
+
+// Returns the number of threads of this process, or 1 if it can not
+// be determined.
+
+idx_t                   threadCount ();
+
+#endif
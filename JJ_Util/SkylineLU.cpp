@@ -0,0 +1,532 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class implements a skyline (profile) LU factorization without
+ *  pivoting for sparse matrices with a symmetric sparsity pattern. See
+ *  SkylineLU.h for details.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <jem/base/Array.h>
+#include <jem/base/PrecheckException.h>
+
+#include "SkylineLU.h"
+
+
+using jem::max;
+using jem::min;
+
+
+//-----------------------------------------------------------------------
+//   class DegreeLess_
+//-----------------------------------------------------------------------
+
+// Compares two DOFs by their number of neighbours; used to sort the
+// neighbours of a node in the Cuthill-McKee algorithm.
+
+class DegreeLess_
+{
+ public:
+
+  explicit inline DegreeLess_ ( const IdxVector& degree ) :
+
+    degree_ ( degree )
+
+  {}
+
+  inline bool operator () ( idx_t i, idx_t j ) const
+  {
+    return degree_[i] < degree_[j];
+  }
+
+ private:
+
+  const IdxVector&  degree_;
+
+};
+
+
+//=======================================================================
+//   class SkylineLU
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+SkylineLU<T>::SkylineLU ()
+{
+  valid_    = false;
+  dofCount_ = -1;
+}
+
+
+//-----------------------------------------------------------------------
+//   invalidate
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+void SkylineLU<T>::invalidate ()
+{
+  valid_    = false;
+  dofCount_ = -1;
+}
+
+
+//-----------------------------------------------------------------------
+//   factor
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+bool SkylineLU<T>::factor
+
+  ( const SparseMatrix&  matrix,
+    const BoolVector&    mask )
+
+{
+  JEM_PRECHECK ( matrix.size(0) == matrix.size(1) &&
+                 mask.size()    == matrix.size(0) );
+
+  const IdxVector  offsets = matrix.getRowOffsets    ();
+  const IdxVector  indices = matrix.getColumnIndices ();
+  const Vector     values  = matrix.getValues        ();
+
+  const double     eps     = std::numeric_limits<T>::epsilon ();
+
+  // The ordering and the profile only depend on the sparsity pattern
+  // and the set of masked DOFs; recompute them only when one of these
+  // has changed.
+
+  if ( ! sameStructure_( offsets, indices, mask ) )
+  {
+    initStructure_ ( matrix, mask );
+  }
+
+  const idx_t  n = perm_.size ();
+
+  Vector       adiag ( n );
+
+  lower_ = (T) 0;
+  upper_ = (T) 0;
+  diag_  = (T) 0;
+
+  // Scatter the matrix entries into the skyline arrays.
+
+  for ( idx_t irow = 0; irow < dofCount_; irow++ )
+  {
+    idx_t  i = iperm_[irow];
+
+    if ( i < 0 )
+    {
+      continue;
+    }
+
+    for ( idx_t k = offsets[irow]; k < offsets[irow + 1]; k++ )
+    {
+      idx_t  j = iperm_[indices[k]];
+
+      if      ( j < 0 )
+      {
+        continue;
+      }
+      else if ( j == i )
+      {
+        diag_[i] += (T) values[k];
+      }
+      else if ( j < i )
+      {
+        lower_[offsets_[i] + j - first_[i]] += (T) values[k];
+      }
+      else
+      {
+        upper_[offsets_[j] + i - first_[j]] += (T) values[k];
+      }
+    }
+  }
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    adiag[i] = std::fabs ( (double) diag_[i] );
+  }
+
+  // Crout factorization, column by column. The inner products are
+  // accumulated in double precision, whatever the storage type.
+
+  valid_ = false;
+
+  for ( idx_t j = 0; j < n; j++ )
+  {
+    const idx_t  fj = first_[j];
+    const idx_t  oj = offsets_[j] - fj;
+
+    for ( idx_t i = fj; i < j; i++ )
+    {
+      const idx_t  fi = first_[i];
+      const idx_t  oi = offsets_[i] - fi;
+
+      double       s  = upper_[oj + i];
+      double       t  = lower_[oj + i];
+
+      for ( idx_t k = max( fi, fj ); k < i; k++ )
+      {
+        s -= (double) lower_[oi + k] * (double) upper_[oj + k];
+        t -= (double) lower_[oj + k] * (double) upper_[oi + k];
+      }
+
+      upper_[oj + i] = (T) s;
+      lower_[oj + i] = (T) (t / (double) diag_[i]);
+    }
+
+    double  d = diag_[j];
+
+    for ( idx_t k = fj; k < j; k++ )
+    {
+      d -= (double) lower_[oj + k] * (double) upper_[oj + k];
+    }
+
+    // Give up on a (numerically) zero pivot; there is no pivoting.
+
+    if ( ! (std::fabs( d ) > eps * adiag[j]) )
+    {
+      return false;
+    }
+
+    diag_[j] = (T) d;
+  }
+
+  valid_ = true;
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   solve
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+void SkylineLU<T>::solve
+
+  ( const Vector&  lhs,
+    const Vector&  rhs ) const
+
+{
+  JEM_PRECHECK ( valid_ &&
+                 lhs.size() == dofCount_ &&
+                 rhs.size() == dofCount_ );
+
+  const idx_t  n = perm_.size ();
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    work_[i] = rhs[perm_[i]];
+  }
+
+  // Forward substitution with the unit lower triangle.
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    const idx_t  oi = offsets_[i] - first_[i];
+
+    double       s  = work_[i];
+
+    for ( idx_t k = first_[i]; k < i; k++ )
+    {
+      s -= (double) lower_[oi + k] * work_[k];
+    }
+
+    work_[i] = s;
+  }
+
+  // Backward substitution with the upper triangle, column by column.
+
+  for ( idx_t j = n - 1; j >= 0; j-- )
+  {
+    const idx_t  oj = offsets_[j] - first_[j];
+
+    double       x  = work_[j] / (double) diag_[j];
+
+    work_[j] = x;
+
+    for ( idx_t i = first_[j]; i < j; i++ )
+    {
+      work_[i] -= (double) upper_[oj + i] * x;
+    }
+  }
+
+  lhs = 0.0;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    lhs[perm_[i]] = work_[i];
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   sameStructure_
+//-----------------------------------------------------------------------
+
+// Returns true if the sparsity pattern and the mask are the same as in
+// the last call of initStructure_. Comparing the pattern itself costs
+// one pass over the indices, which is small compared to a factorization;
+// a matrix with the same size and number of non-zeros can still have a
+// different pattern.
+
+template <class T>
+
+bool SkylineLU<T>::sameStructure_
+
+  ( const IdxVector&   offsets,
+    const IdxVector&   indices,
+    const BoolVector&  mask ) const
+
+{
+  if ( dofCount_ < 0                          ||
+       offsets.size() != rowOffsets_.size()   ||
+       indices.size() != colIndices_.size()   ||
+       mask   .size() != mask_      .size() )
+  {
+    return false;
+  }
+
+  for ( idx_t i = 0; i < offsets.size(); i++ )
+  {
+    if ( offsets[i] != rowOffsets_[i] )
+    {
+      return false;
+    }
+  }
+
+  for ( idx_t i = 0; i < indices.size(); i++ )
+  {
+    if ( indices[i] != colIndices_[i] )
+    {
+      return false;
+    }
+  }
+
+  for ( idx_t i = 0; i < mask.size(); i++ )
+  {
+    if ( mask[i] != mask_[i] )
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   initStructure_
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+void SkylineLU<T>::initStructure_
+
+  ( const SparseMatrix&  matrix,
+    const BoolVector&    mask )
+
+{
+  const IdxVector  offsets = matrix.getRowOffsets    ();
+  const IdxVector  indices = matrix.getColumnIndices ();
+
+  dofCount_ = matrix.size (0);
+
+  rowOffsets_.resize ( offsets.size() );
+  colIndices_.resize ( indices.size() );
+  mask_      .resize ( dofCount_ );
+
+  rowOffsets_ = offsets;
+  colIndices_ = indices;
+  mask_       = mask;
+
+  renumber_ ( offsets, indices );
+
+  const idx_t  n = perm_.size ();
+
+  // Determine the envelope of the renumbered matrix. The profile is
+  // made symmetric so that L and U share the same offsets.
+
+  first_  .resize ( n );
+  offsets_.resize ( n + 1 );
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    first_[i] = i;
+  }
+
+  for ( idx_t irow = 0; irow < dofCount_; irow++ )
+  {
+    idx_t  i = iperm_[irow];
+
+    if ( i < 0 )
+    {
+      continue;
+    }
+
+    for ( idx_t k = offsets[irow]; k < offsets[irow + 1]; k++ )
+    {
+      idx_t  j = iperm_[indices[k]];
+
+      if ( j < 0 )
+      {
+        continue;
+      }
+
+      idx_t  lo = min ( i, j );
+      idx_t  hi = max ( i, j );
+
+      first_[hi] = min ( first_[hi], lo );
+    }
+  }
+
+  offsets_[0] = 0;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    offsets_[i + 1] = offsets_[i] + (i - first_[i]);
+  }
+
+  lower_.resize ( offsets_[n] );
+  upper_.resize ( offsets_[n] );
+  diag_ .resize ( n );
+  work_ .resize ( n );
+
+  valid_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   renumber_
+//-----------------------------------------------------------------------
+
+// Computes a reverse Cuthill-McKee ordering of the DOFs that are not
+// masked. Each connected component is started from a DOF with minimum
+// degree.
+
+template <class T>
+
+void SkylineLU<T>::renumber_
+
+  ( const IdxVector&  offsets,
+    const IdxVector&  indices )
+
+{
+  IdxVector  degree  ( dofCount_ );
+  IdxVector  byDeg;
+  IdxVector  order;
+
+  BoolVector visited ( dofCount_ );
+
+  idx_t      freeCount = 0;
+  idx_t      head, tail;
+
+
+  iperm_.resize ( dofCount_ );
+
+  iperm_  = -1;
+  degree  = 0;
+  visited = false;
+
+  for ( idx_t i = 0; i < dofCount_; i++ )
+  {
+    if ( mask_[i] )
+    {
+      continue;
+    }
+
+    freeCount++;
+
+    for ( idx_t k = offsets[i]; k < offsets[i + 1]; k++ )
+    {
+      idx_t  j = indices[k];
+
+      if ( j != i && ! mask_[j] )
+      {
+        degree[i]++;
+      }
+    }
+  }
+
+  byDeg.resize ( freeCount );
+  order.resize ( freeCount );
+
+  for ( idx_t i = 0, k = 0; i < dofCount_; i++ )
+  {
+    if ( ! mask_[i] )
+    {
+      byDeg[k++] = i;
+    }
+  }
+
+  std::stable_sort ( byDeg.addr(), byDeg.addr() + freeCount,
+                     DegreeLess_( degree ) );
+
+  head = tail = 0;
+
+  for ( idx_t s = 0; s < freeCount; s++ )
+  {
+    if ( visited[byDeg[s]] )
+    {
+      continue;
+    }
+
+    visited[byDeg[s]] = true;
+    order[tail++]     = byDeg[s];
+
+    while ( head < tail )
+    {
+      idx_t  i     = order[head++];
+      idx_t  first = tail;
+
+      for ( idx_t k = offsets[i]; k < offsets[i + 1]; k++ )
+      {
+        idx_t  j = indices[k];
+
+        if ( ! mask_[j] && ! visited[j] )
+        {
+          visited[j]    = true;
+          order[tail++] = j;
+        }
+      }
+
+      std::sort ( order.addr() + first, order.addr() + tail,
+                  DegreeLess_( degree ) );
+    }
+  }
+
+  perm_.resize ( freeCount );
+
+  for ( idx_t i = 0; i < freeCount; i++ )
+  {
+    perm_[i]         = order[freeCount - 1 - i];
+    iperm_[perm_[i]] = i;
+  }
+}
+
+
+//=======================================================================
+//   explicit instantiations
+//=======================================================================
+
+
+template class SkylineLU<float>;
+template class SkylineLU<double>;
@@ -0,0 +1,156 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class implements a skyline (profile) LU factorization without
+ *  pivoting for sparse matrices with a symmetric sparsity pattern, as
+ *  obtained from finite element assembly. The unknowns are renumbered
+ *  with the reverse Cuthill-McKee algorithm to keep the profile small.
+ *
+ *  The class is a template on the storage type of the factor. The float
+ *  version is used for mixed precision solves (the right hand side is
+ *  always handled in double precision), the double version for direct
+ *  solves with a factor that is reused over many steps.
+ *
+ *  DOFs that are marked in the mask (typically constrained DOFs) are
+ *  excluded from the factorization. The caller is responsible for moving
+ *  their contribution to the right hand side.
+ *
+ */
+
+#ifndef SKYLINE_LU_H
+#define SKYLINE_LU_H
+
+#include <jem/base/Array.h>
+#include <jive/Array.h>
+#include <jive/SparseMatrix.h>
+
+using jem::idx_t;
+using jive::Vector;
+using jive::IdxVector;
+using jive::BoolVector;
+using jive::SparseMatrix;
+
+
+//-----------------------------------------------------------------------
+//   class SkylineLU
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+class SkylineLU
+{
+ public:
+
+                            SkylineLU    ();
+
+  bool                      factor
+
+    ( const SparseMatrix&     matrix,
+      const BoolVector&       mask );
+
+  void                      solve
+
+    ( const Vector&           lhs,
+      const Vector&           rhs )        const;
+
+  void                      invalidate   ();
+
+  inline bool               isValid      () const;
+  inline idx_t              size         () const;
+  inline idx_t              profileSize  () const;
+
+
+ private:
+
+  bool                      sameStructure_
+
+    ( const IdxVector&        offsets,
+      const IdxVector&        indices,
+      const BoolVector&       mask )       const;
+
+  void                      initStructure_
+
+    ( const SparseMatrix&     matrix,
+      const BoolVector&       mask );
+
+  void                      renumber_
+
+    ( const IdxVector&        offsets,
+      const IdxVector&        indices );
+
+
+ private:
+
+  bool                      valid_;
+
+  // the sparsity pattern and the mask of the current structure
+
+  idx_t                     dofCount_;
+  IdxVector                 rowOffsets_;
+  IdxVector                 colIndices_;
+  BoolVector                mask_;
+
+  // perm_[i] is the DOF at position i; iperm_[idof] is the position of
+  // DOF idof, or -1 if the DOF is masked.
+
+  IdxVector                 perm_;
+  IdxVector                 iperm_;
+
+  // first_[i] is the first column in row i (and the first row in
+  // column i); the entries of row i of L and column i of U start at
+  // offsets_[i].
+
+  IdxVector                 first_;
+  IdxVector                 offsets_;
+
+  jem::Array<T>             lower_;
+  jem::Array<T>             upper_;
+  jem::Array<T>             diag_;
+
+  mutable Vector            work_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   isValid
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+inline bool SkylineLU<T>::isValid () const
+{
+  return valid_;
+}
+
+
+//-----------------------------------------------------------------------
+//   size
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+inline idx_t SkylineLU<T>::size () const
+{
+  return perm_.size ();
+}
+
+
+//-----------------------------------------------------------------------
+//   profileSize
+//-----------------------------------------------------------------------
+
+
+template <class T>
+
+inline idx_t SkylineLU<T>::profileSize () const
+{
+  return lower_.size ();
+}
+
+
+#endif
@@ -18,6 +18,23 @@ const char* SolverNames::N_CONTINUES       = "NContinues";
 const char* SolverNames::ADAPT_HOW         = "AdaptHow";
 const char* SolverNames::ADAPT_FROM        = "AdaptFrom";
 const char* SolverNames::CHANGE_COUNT      = "ChangeCount";
+const char* SolverNames::DIVERGED          = "Diverged";
+const char* SolverNames::DIV_REASON        = "DivergenceReason";
+const char* SolverNames::CONTRACTION       = "Contraction";
+const char* SolverNames::NEW_LOADING       = "NewLoading";
+const char* SolverNames::POINT_COUNT       = "PointCount";
+const char* SolverNames::UNIT_DISP         = "UnitDisp";
+const char* SolverNames::LOAD_SCALE_0      = "LoadScale0";
+const char* SolverNames::CRIT_TIME_STEP    = "CritTimeStep";
+const char* SolverNames::ELEM_CRIT_STEP    = "ElemCritStep";
+const char* SolverNames::ACTIVE_ELEMS      = "ActiveElems";
+const char* SolverNames::LINEAR            = "Linear";
+const char* SolverNames::CHECKPOINT        = "Checkpoint";
+const char* SolverNames::OUTPUT_FRAME      = "OutputFrame";
+const char* SolverNames::PROBE_SET         = "ProbeSet";
+const char* SolverNames::WRITE_OUTPUT      = "WriteOutput";
+const char* SolverNames::REPEAT_COUNT      = "RepeatCount";
+const char* SolverNames::ELAPSED_TIME      = "ElapsedTime";
 
 // actions
 const char* SolverNames::TO_ARCL           = "ToArclControl";
@@ -30,4 +47,17 @@ const char* SolverNames::SET_STEP_SIZE     = "SetStepSize";
 const char* SolverNames::CONTINUE          = "Continue";
 const char* SolverNames::BE_CAREFUL        = "BeCareful";
 const char* SolverNames::STOP_CAREFUL      = "StopCareful";
+const char* SolverNames::STORE_SNAPSHOT    = "StoreSnapshot";
+const char* SolverNames::RESTORE_SNAPSHOT  = "RestoreSnapshot";
+const char* SolverNames::GET_UNIT_DISP     = "GetUnitDisp";
+const char* SolverNames::GET_LOAD_SCALE    = "GetLoadScale";
+const char* SolverNames::SET_LOAD_SCALE    = "SetLoadScale";
+const char* SolverNames::GET_CRIT_TIME_STEP = "GetCritTimeStep";
+const char* SolverNames::CHECK_LINEAR      = "CheckLinear";
+const char* SolverNames::WRITE_CHECKPOINT  = "WriteCheckpoint";
+const char* SolverNames::READ_CHECKPOINT   = "ReadCheckpoint";
+const char* SolverNames::GET_OUTPUT_FRAME  = "GetOutputFrame";
+const char* SolverNames::RESOLVE_PROBES    = "ResolveProbes";
+const char* SolverNames::GET_PROBES        = "GetProbes";
+const char* SolverNames::TIME_MATERIAL     = "TimeMaterial";
 
@@ -21,6 +21,23 @@ struct SolverNames
   static const char*    ADAPT_HOW;
   static const char*    ADAPT_FROM;
   static const char*    CHANGE_COUNT;
+  static const char*    DIVERGED;
+  static const char*    DIV_REASON;
+  static const char*    CONTRACTION;
+  static const char*    NEW_LOADING;
+  static const char*    POINT_COUNT;
+  static const char*    UNIT_DISP;
+  static const char*    LOAD_SCALE_0;
+  static const char*    CRIT_TIME_STEP;
+  static const char*    ELEM_CRIT_STEP;
+  static const char*    ACTIVE_ELEMS;
+  static const char*    LINEAR;
+  static const char*    CHECKPOINT;
+  static const char*    OUTPUT_FRAME;
+  static const char*    PROBE_SET;
+  static const char*    WRITE_OUTPUT;
+  static const char*    REPEAT_COUNT;
+  static const char*    ELAPSED_TIME;
 
   // actions
   static const char*    TO_ARCL;
@@ -33,6 +50,19 @@ struct SolverNames
   static const char*    CONTINUE;
   static const char*    BE_CAREFUL;
   static const char*    STOP_CAREFUL;
+  static const char*    STORE_SNAPSHOT;
+  static const char*    RESTORE_SNAPSHOT;
+  static const char*    GET_UNIT_DISP;
+  static const char*    GET_LOAD_SCALE;
+  static const char*    SET_LOAD_SCALE;
+  static const char*    GET_CRIT_TIME_STEP;
+  static const char*    CHECK_LINEAR;
+  static const char*    WRITE_CHECKPOINT;
+  static const char*    READ_CHECKPOINT;
+  static const char*    GET_OUTPUT_FRAME;
+  static const char*    RESOLVE_PROBES;
+  static const char*    GET_PROBES;
+  static const char*    TIME_MATERIAL;
 };
 
 
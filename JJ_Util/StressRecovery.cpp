@@ -0,0 +1,709 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  Nodal recovery of integration point values; see StressRecovery.h.
+ *
+ *  All methods are linear in the point values, so each is stored as
+ *  the same operator: for node n the value is sum_k c_nk v_k over the
+ *  points k of its patch. For SPR with the basis P(x) = [1, x - x_n]
+ *  the fitted value at the node is e_0^T A^-1 sum_k P_k v_k with
+ *  A = sum_k P_k P_k^T, so c_nk = z^T P_k with A z = e_0.
+ *
+ */
+
+#include <pthread.h>
+
+#include <cmath>
+
+#include <jem/base/assert.h>
+#include <jem/base/IllegalInputException.h>
+
+#include "StressRecovery.h"
+
+
+using jem::IllegalInputException;
+
+
+//=======================================================================
+//   private helpers
+//=======================================================================
+
+
+static const idx_t  MAX_BASIS_ = 4;
+
+
+// Solves the symmetric n x n system a z = e_0 by Gaussian elimination
+// with partial pivoting. Returns false if the system is (nearly)
+// singular.
+
+static bool         solveUnit_
+
+  ( double*  z,
+    double*  a,
+    idx_t    n )
+
+{
+  double  scale = 0.0;
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    z[i]   = ( i == 0 ) ? 1.0 : 0.0;
+    scale += std::fabs ( a[i * n + i] );
+  }
+
+  for ( idx_t k = 0; k < n; k++ )
+  {
+    idx_t  p = k;
+
+    for ( idx_t i = k + 1; i < n; i++ )
+    {
+      if ( std::fabs( a[i * n + k] ) > std::fabs( a[p * n + k] ) )
+      {
+        p = i;
+      }
+    }
+
+    if ( std::fabs( a[p * n + k] ) <= 1.0e-10 * scale )
+    {
+      return false;
+    }
+
+    if ( p != k )
+    {
+      for ( idx_t j = 0; j < n; j++ )
+      {
+        const double  t = a[k * n + j];
+
+        a[k * n + j] = a[p * n + j];
+        a[p * n + j] = t;
+      }
+
+      const double  t = z[k];
+
+      z[k] = z[p];
+      z[p] = t;
+    }
+
+    for ( idx_t i = k + 1; i < n; i++ )
+    {
+      const double  f = a[i * n + k] / a[k * n + k];
+
+      for ( idx_t j = k; j < n; j++ )
+      {
+        a[i * n + j] -= f * a[k * n + j];
+      }
+
+      z[i] -= f * z[k];
+    }
+  }
+
+  for ( idx_t k = n - 1; k >= 0; k-- )
+  {
+    double  sum = z[k];
+
+    for ( idx_t j = k + 1; j < n; j++ )
+    {
+      sum -= a[k * n + j] * z[j];
+    }
+
+    z[k] = sum / a[k * n + k];
+  }
+
+  return true;
+}
+
+
+//=======================================================================
+//   class StressRecovery::Job_
+//=======================================================================
+
+// A range of nodes to be recovered by one thread.
+
+struct StressRecovery::Job_
+{
+  const StressRecovery*  self;
+
+  double*                dst;
+  idx_t                  dstRow;
+  idx_t                  dstCol;
+  const double*          src;
+  idx_t                  srcRow;
+  idx_t                  srcCol;
+  idx_t                  colCount;
+
+  idx_t                  first;
+  idx_t                  last;
+};
+
+
+//=======================================================================
+//   class StressRecovery
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+StressRecovery::StressRecovery
+
+  ( Method  method,
+    idx_t   ipCount )
+
+{
+  JEM_PRECHECK ( ipCount > 0 );
+
+  method_    = method;
+  ipCount_   = ipCount;
+  rank_      = 0;
+  elemCount_ = 0;
+
+  elemStart_.pushBack ( 0 );
+}
+
+
+StressRecovery::~StressRecovery ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   getMethod
+//-----------------------------------------------------------------------
+
+
+StressRecovery::Method StressRecovery::getMethod
+
+  ( const String&  name,
+    const String&  context )
+
+{
+  if ( name == "average" )
+  {
+    return AVERAGE;
+  }
+  else if ( name == "l2" )
+  {
+    return LUMPED_L2;
+  }
+  else if ( name == "spr" )
+  {
+    return SPR;
+  }
+
+  throw IllegalInputException (
+    context,
+    String::format ( "unknown recovery method: %s "
+                     "(expected average, l2 or spr)", name )
+  );
+
+  return AVERAGE;
+}
+
+
+//-----------------------------------------------------------------------
+//   getMethodName
+//-----------------------------------------------------------------------
+
+
+const char* StressRecovery::getMethodName ( Method method )
+{
+  switch ( method )
+  {
+  case LUMPED_L2:
+
+    return "l2";
+
+  case SPR:
+
+    return "spr";
+
+  default:
+
+    return "average";
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   addElement
+//-----------------------------------------------------------------------
+
+
+void StressRecovery::addElement
+
+  ( const IdxVector&  inodes,
+    const Matrix&     coords,
+    const Matrix&     ipCoords,
+    const Vector&     ipWeights,
+    const Matrix&     shapeFuncs )
+
+{
+  const idx_t  nn = inodes.size ();
+
+  JEM_PRECHECK ( ipCoords  .size(1) == ipCount_ &&
+                 ipWeights .size()  == ipCount_ &&
+                 shapeFuncs.size(0) == nn       &&
+                 shapeFuncs.size(1) == ipCount_ &&
+                 coords    .size(1) == nn );
+
+  if ( elemCount_ == 0 )
+  {
+    rank_ = coords.size (0);
+  }
+
+  JEM_PRECHECK ( coords.size(0) == rank_ && rank_ < MAX_BASIS_ );
+
+  for ( idx_t a = 0; a < nn; a++ )
+  {
+    conn_.pushBack ( inodes[a] );
+
+    for ( idx_t d = 0; d < rank_; d++ )
+    {
+      coords_.pushBack ( coords(d,a) );
+    }
+
+    for ( idx_t ip = 0; ip < ipCount_; ip++ )
+    {
+      shapes_.pushBack ( shapeFuncs(a,ip) );
+    }
+  }
+
+  for ( idx_t ip = 0; ip < ipCount_; ip++ )
+  {
+    for ( idx_t d = 0; d < rank_; d++ )
+    {
+      ipCoords_.pushBack ( ipCoords(d,ip) );
+    }
+
+    ipWeights_.pushBack ( ipWeights[ip] );
+  }
+
+  elemStart_.pushBack ( conn_.size() );
+
+  elemCount_++;
+}
+
+
+//-----------------------------------------------------------------------
+//   finish
+//-----------------------------------------------------------------------
+
+// Numbers the nodes of the elements, builds the node to element
+// adjacency and the recovery operator.
+
+void StressRecovery::finish ()
+{
+  idx_t  maxNode = -1;
+
+  for ( idx_t i = 0; i < conn_.size(); i++ )
+  {
+    if ( conn_[i] > maxNode )
+    {
+      maxNode = conn_[i];
+    }
+  }
+
+  IdxVector  local ( maxNode + 1 );
+  idx_t      n     = 0;
+
+  // Mark the nodes in use and number them in the order of their
+  // global indices.
+
+  local = -1;
+
+  for ( idx_t i = 0; i < conn_.size(); i++ )
+  {
+    local[conn_[i]] = 0;
+  }
+
+  for ( idx_t i = 0; i < local.size(); i++ )
+  {
+    if ( local[i] == 0 )
+    {
+      local[i] = n++;
+    }
+  }
+
+  inodes_.resize ( n );
+  counts_.resize ( n );
+
+  for ( idx_t i = 0; i < local.size(); i++ )
+  {
+    if ( local[i] >= 0 )
+    {
+      inodes_[local[i]] = i;
+    }
+  }
+
+  // Count the elements of each node and fill the adjacency lists.
+
+  adjStart_.resize ( n + 1 );
+
+  for ( idx_t i = 0; i <= n; i++ )
+  {
+    adjStart_[i] = 0;
+  }
+
+  for ( idx_t i = 0; i < conn_.size(); i++ )
+  {
+    adjStart_[local[conn_[i]] + 1]++;
+  }
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    counts_[i]       = (double) adjStart_[i + 1];
+    adjStart_[i + 1] += adjStart_[i];
+  }
+
+  adjElems_.resize ( conn_.size() );
+  adjPos_  .resize ( conn_.size() );
+
+  Flex<idx_t>  fill;
+
+  fill.resize ( n );
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    fill[i] = adjStart_[i];
+  }
+
+  for ( idx_t ie = 0; ie < elemCount_; ie++ )
+  {
+    for ( idx_t i = elemStart_[ie]; i < elemStart_[ie + 1]; i++ )
+    {
+      const idx_t  k = fill[local[conn_[i]]]++;
+
+      adjElems_[k] = ie;
+      adjPos_  [k] = i - elemStart_[ie];
+    }
+  }
+
+  // Build the operator.
+
+  opStart_  .clear ();
+  opPoints_ .clear ();
+  opWeights_.clear ();
+
+  opStart_.pushBack ( 0 );
+
+  for ( idx_t i = 0; i < n; i++ )
+  {
+    bool  done = false;
+
+    if ( method_ == SPR )
+    {
+      done = buildSPR_ ( i );
+    }
+
+    if ( ! done && method_ != AVERAGE )
+    {
+      done = buildLumped_ ( i );
+    }
+
+    if ( ! done )
+    {
+      buildAverage_ ( i );
+    }
+
+    opStart_.pushBack ( opPoints_.size() );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   recover
+//-----------------------------------------------------------------------
+
+
+void StressRecovery::recover
+
+  ( const Matrix&  nodal,
+    const Matrix&  ipValues,
+    idx_t          threadCount ) const
+
+{
+  const idx_t  n = inodes_.size ();
+
+  JEM_PRECHECK ( opStart_.size()  == n + 1 &&
+                 nodal.size(0)    == n     &&
+                 nodal.size(1)    == ipValues.size(1) &&
+                 ipValues.size(0) >= elemCount_ * ipCount_ );
+
+  Job_  base;
+
+  base.self     = this;
+  base.dst      = nodal.addr ();
+  base.dstRow   = nodal.stride (0);
+  base.dstCol   = nodal.stride (1);
+  base.src      = ipValues.addr ();
+  base.srcRow   = ipValues.stride (0);
+  base.srcCol   = ipValues.stride (1);
+  base.colCount = nodal.size (1);
+  base.first    = 0;
+  base.last     = n;
+
+  if ( threadCount > n / 64 )
+  {
+    threadCount = n / 64;
+  }
+
+  if ( threadCount <= 1 )
+  {
+    work_ ( &base );
+
+    return;
+  }
+
+  // The first range is done by the calling thread; a range whose
+  // thread can not be started is done here as well.
+
+  Flex<Job_>       jobs;
+  Flex<pthread_t>  threads;
+  Flex<bool>       started;
+
+  jobs   .resize ( threadCount );
+  threads.resize ( threadCount );
+  started.resize ( threadCount );
+
+  for ( idx_t t = 0; t < threadCount; t++ )
+  {
+    jobs[t]       = base;
+    jobs[t].first = (n * t)       / threadCount;
+    jobs[t].last  = (n * (t + 1)) / threadCount;
+    started[t]    = false;
+  }
+
+  for ( idx_t t = 1; t < threadCount; t++ )
+  {
+    started[t] = ( pthread_create( &threads[t], 0, & work_,
+                                   &jobs[t] ) == 0 );
+  }
+
+  work_ ( &jobs[0] );
+
+  for ( idx_t t = 1; t < threadCount; t++ )
+  {
+    if ( started[t] )
+    {
+      pthread_join ( threads[t], 0 );
+    }
+    else
+    {
+      work_ ( &jobs[t] );
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   work_
+//-----------------------------------------------------------------------
+
+
+void* StressRecovery::work_ ( void* arg )
+{
+  const Job_&            job  = * (const Job_*) arg;
+  const StressRecovery&  self = * job.self;
+
+  const idx_t*   points  = self.opPoints_ .addr ();
+  const double*  weights = self.opWeights_.addr ();
+
+  for ( idx_t i = job.first; i < job.last; i++ )
+  {
+    const idx_t  kb = self.opStart_[i];
+    const idx_t  ke = self.opStart_[i + 1];
+
+    for ( idx_t j = 0; j < job.colCount; j++ )
+    {
+      const double*  src = job.src + j * job.srcCol;
+      double         sum = 0.0;
+
+      for ( idx_t k = kb; k < ke; k++ )
+      {
+        sum += weights[k] * src[points[k] * job.srcRow];
+      }
+
+      job.dst[i * job.dstRow + j * job.dstCol] = sum;
+    }
+  }
+
+  return 0;
+}
+
+
+//-----------------------------------------------------------------------
+//   buildAverage_
+//-----------------------------------------------------------------------
+
+
+void StressRecovery::buildAverage_ ( idx_t inode )
+{
+  const idx_t   kb = adjStart_[inode];
+  const idx_t   ke = adjStart_[inode + 1];
+  const double  w  = 1.0 / (double) ((ke - kb) * ipCount_);
+
+  for ( idx_t k = kb; k < ke; k++ )
+  {
+    const idx_t  ie = adjElems_[k];
+
+    for ( idx_t ip = 0; ip < ipCount_; ip++ )
+    {
+      opPoints_ .pushBack ( ie * ipCount_ + ip );
+      opWeights_.pushBack ( w );
+    }
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   buildLumped_
+//-----------------------------------------------------------------------
+
+
+bool StressRecovery::buildLumped_ ( idx_t inode )
+{
+  const idx_t  kb    = adjStart_[inode];
+  const idx_t  ke    = adjStart_[inode + 1];
+  const idx_t  first = opPoints_.size ();
+
+  double       mass  = 0.0;
+  double       total = 0.0;
+
+  for ( idx_t k = kb; k < ke; k++ )
+  {
+    const idx_t    ie = adjElems_[k];
+    const double*  N  = shapes_.addr() +
+                        (elemStart_[ie] + adjPos_[k]) * ipCount_;
+
+    for ( idx_t ip = 0; ip < ipCount_; ip++ )
+    {
+      const double  m = N[ip] * ipWeights_[ie * ipCount_ + ip];
+
+      mass  += m;
+      total += std::fabs ( m );
+
+      opPoints_ .pushBack ( ie * ipCount_ + ip );
+      opWeights_.pushBack ( m );
+    }
+  }
+
+  if ( mass <= 1.0e-12 * total || total == 0.0 )
+  {
+    opPoints_ .resize ( first );
+    opWeights_.resize ( first );
+
+    return false;
+  }
+
+  for ( idx_t k = first; k < opWeights_.size(); k++ )
+  {
+    opWeights_[k] /= mass;
+  }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------
+//   buildSPR_
+//-----------------------------------------------------------------------
+
+
+bool StressRecovery::buildSPR_ ( idx_t inode )
+{
+  const idx_t  kb = adjStart_[inode];
+  const idx_t  ke = adjStart_[inode + 1];
+  const idx_t  q  = rank_ + 1;
+
+  if ( (ke - kb) * ipCount_ < q )
+  {
+    return false;
+  }
+
+  // The coordinates of the node and the size of the patch; the basis
+  // is scaled with the size for a well conditioned system.
+
+  const double*  xn = coords_.addr() +
+                      (elemStart_[adjElems_[kb]] + adjPos_[kb]) * rank_;
+
+  double         h  = 0.0;
+
+  for ( idx_t k = kb; k < ke; k++ )
+  {
+    const double*  xp = ipCoords_.addr() + adjElems_[k] * ipCount_ * rank_;
+
+    for ( idx_t i = 0; i < ipCount_ * rank_; i++ )
+    {
+      const double  d = std::fabs ( xp[i] - xn[i % rank_] );
+
+      if ( d > h )
+      {
+        h = d;
+      }
+    }
+  }
+
+  if ( h == 0.0 )
+  {
+    return false;
+  }
+
+  double  a[MAX_BASIS_ * MAX_BASIS_];
+  double  z[MAX_BASIS_];
+  double  p[MAX_BASIS_];
+
+  for ( idx_t i = 0; i < q * q; i++ )
+  {
+    a[i] = 0.0;
+  }
+
+  for ( idx_t k = kb; k < ke; k++ )
+  {
+    const double*  xp = ipCoords_.addr() + adjElems_[k] * ipCount_ * rank_;
+
+    for ( idx_t ip = 0; ip < ipCount_; ip++ )
+    {
+      p[0] = 1.0;
+
+      for ( idx_t d = 0; d < rank_; d++ )
+      {
+        p[d + 1] = (xp[ip * rank_ + d] - xn[d]) / h;
+      }
+
+      for ( idx_t i = 0; i < q; i++ )
+      {
+        for ( idx_t j = 0; j < q; j++ )
+        {
+          a[i * q + j] += p[i] * p[j];
+        }
+      }
+    }
+  }
+
+  if ( ! solveUnit_( z, a, q ) )
+  {
+    return false;
+  }
+
+  for ( idx_t k = kb; k < ke; k++ )
+  {
+    const idx_t    ie = adjElems_[k];
+    const double*  xp = ipCoords_.addr() + ie * ipCount_ * rank_;
+
+    for ( idx_t ip = 0; ip < ipCount_; ip++ )
+    {
+      double  c = z[0];
+
+      for ( idx_t d = 0; d < rank_; d++ )
+      {
+        c += z[d + 1] * (xp[ip * rank_ + d] - xn[d]) / h;
+      }
+
+      opPoints_ .pushBack ( ie * ipCount_ + ip );
+      opWeights_.pushBack ( c );
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,201 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class recovers nodal values from integration point values.
+ *  The elements are added once, with their nodes and the geometry of
+ *  their integration points; finish() builds the node to element
+ *  adjacency and, for each node, the weights of the integration
+ *  points of its patch (the elements around it). Recovering a set of
+ *  fields is then a plain weighted sum per node, which can be split
+ *  over several threads since every node only reads.
+ *
+ *  Methods:
+ *
+ *    average    the mean of the element averages of the patch
+ *    l2         lumped L2 projection: the integration point values
+ *               weighted with N(x) w over the patch, divided by the
+ *               lumped mass of the node
+ *    spr        superconvergent patch recovery: a linear polynomial is
+ *               fitted through the integration points of the patch
+ *               by least squares and evaluated at the node
+ *
+ *  A node where the lumped mass is not positive, or whose patch has
+ *  too few points for the fit, falls back to the next simpler method.
+ *
+ *  The integration points are numbered in the order of the elements:
+ *  point ip of the ie-th element added has index ie * ipCount + ip.
+ *
+ */
+
+#ifndef STRESS_RECOVERY_H
+#define STRESS_RECOVERY_H
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+using jive::Matrix;
+using jive::IdxVector;
+
+
+//-----------------------------------------------------------------------
+//   class StressRecovery
+//-----------------------------------------------------------------------
+
+
+class StressRecovery : public jem::Object
+{
+ public:
+
+  typedef StressRecovery    Self;
+  typedef jem::Object       Super;
+
+  enum                      Method
+  {
+                              AVERAGE,
+                              LUMPED_L2,
+                              SPR
+  };
+
+                            StressRecovery
+
+    ( Method                  method,
+      idx_t                   ipCount );
+
+  static Method             getMethod
+
+    ( const String&           name,
+      const String&           context );
+
+  static const char*        getMethodName
+
+    ( Method                  method );
+
+  // coords: rank x nodes, ipCoords: rank x ipCount, shapeFuncs:
+  // nodes x ipCount (the shape functions in the integration points)
+
+  void                      addElement
+
+    ( const IdxVector&        inodes,
+      const Matrix&           coords,
+      const Matrix&           ipCoords,
+      const Vector&           ipWeights,
+      const Matrix&           shapeFuncs );
+
+  void                      finish        ();
+
+  // nodal: nodeCount x fields, ipValues: points x fields
+
+  void                      recover
+
+    ( const Matrix&           nodal,
+      const Matrix&           ipValues,
+      idx_t                   threadCount = 1 ) const;
+
+  inline idx_t              nodeCount     () const;
+  inline const IdxVector&   getNodes      () const;
+  inline const Vector&      getCounts     () const;
+
+
+ protected:
+
+  virtual                  ~StressRecovery ();
+
+
+ private:
+
+  struct                    Job_;
+
+  static void*              work_
+
+    ( void*                   job );
+
+  void                      buildAverage_
+
+    ( idx_t                   inode );
+
+  bool                      buildLumped_
+
+    ( idx_t                   inode );
+
+  bool                      buildSPR_
+
+    ( idx_t                   inode );
+
+
+ private:
+
+  Method                    method_;
+  idx_t                     ipCount_;
+  idx_t                     rank_;
+  idx_t                     elemCount_;
+
+  // per element (filled by addElement): the global nodes, the node and
+  // point coordinates, the point weights and shape functions
+
+  Flex<idx_t>               elemStart_;
+  Flex<idx_t>               conn_;
+  Flex<double>              coords_;
+  Flex<double>              ipCoords_;
+  Flex<double>              ipWeights_;
+  Flex<double>              shapes_;
+
+  // the nodes of the elements and the elements of each node
+
+  IdxVector                 inodes_;
+  Vector                    counts_;
+  Flex<idx_t>               adjStart_;
+  Flex<idx_t>               adjElems_;
+  Flex<idx_t>               adjPos_;
+
+  // the recovery operator: per node a list of points and weights
+
+  Flex<idx_t>               opStart_;
+  Flex<idx_t>               opPoints_;
+  Flex<double>              opWeights_;
+
+};
+
+
+//-----------------------------------------------------------------------
+//   nodeCount
+//-----------------------------------------------------------------------
+
+
+inline idx_t StressRecovery::nodeCount () const
+{
+  return inodes_.size ();
+}
+
+
+//-----------------------------------------------------------------------
+//   getNodes
+//-----------------------------------------------------------------------
+
+// Returns the global indices of the rows of the recovered values.
+
+inline const IdxVector& StressRecovery::getNodes () const
+{
+  return inodes_;
+}
+
+
+//-----------------------------------------------------------------------
+//   getCounts
+//-----------------------------------------------------------------------
+
+// Returns the number of elements attached to each node.
+
+inline const Vector& StressRecovery::getCounts () const
+{
+  return counts_;
+}
+
+
+#endif
@@ -0,0 +1,578 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  VTU and PVD file writer; see VtuWriter.h.
+ *
+ */
+
+#include <stdint.h>
+#include <cerrno>
+#include <cstring>
+
+#include <jem/base/assert.h>
+#include <jem/base/IllegalInputException.h>
+#include <jem/io/IOException.h>
+
+#include "VtuWriter.h"
+
+
+using jem::newInstance;
+using jem::IllegalInputException;
+using jem::io::IOException;
+
+
+//=======================================================================
+//   class VtuWriter::Array_
+//=======================================================================
+
+// One data array of the file: where its values come from, its size and
+// its offset in the appended section.
+
+class VtuWriter::Array_ : public jem::Object
+{
+ public:
+
+  enum                      Kind
+  {
+                              MATRIX,
+                              VECTOR,
+                              CONNECTIVITY,
+                              OFFSETS,
+                              TYPES
+  };
+
+  Kind                      kind;
+  String                    name;
+  const char*               type;
+  idx_t                     compCount;
+  idx_t                     tupleCount;
+  idx_t                     offset;
+
+  Matrix                    mat;
+  Vector                    vec;
+
+
+  inline idx_t              byteCount () const
+  {
+    const idx_t  size = ( kind == TYPES ) ? 1 : 8;
+
+    return size * compCount * tupleCount;
+  }
+
+};
+
+
+//=======================================================================
+//   class VtuWriter::Stream_
+//=======================================================================
+
+// Collects the binary data in a fixed buffer and writes it to the file
+// in large blocks.
+
+class VtuWriter::Stream_
+{
+ public:
+
+  explicit                  Stream_
+
+    ( std::FILE*              f ) :
+
+      file ( f ),
+      used ( 0 )
+
+  {}
+
+  inline void               put
+
+    ( const void*             data,
+      size_t                  size )
+
+  {
+    if ( used + size > sizeof(buf) )
+    {
+      flush ();
+    }
+
+    std::memcpy ( buf + used, data, size );
+
+    used += size;
+  }
+
+  void                      flush ()
+  {
+    if ( used > 0 )
+    {
+      std::fwrite ( buf, 1, used, file );
+
+      used = 0;
+    }
+  }
+
+  std::FILE*                file;
+  size_t                    used;
+  char                      buf[1 << 16];
+
+};
+
+
+//=======================================================================
+//   class VtuWriter
+//=======================================================================
+
+//-----------------------------------------------------------------------
+//   static data
+//-----------------------------------------------------------------------
+
+
+const int  VtuWriter::VERTEX             = 1;
+const int  VtuWriter::LINE               = 3;
+const int  VtuWriter::TRIANGLE           = 5;
+const int  VtuWriter::QUAD               = 9;
+const int  VtuWriter::TETRA              = 10;
+const int  VtuWriter::HEXAHEDRON         = 12;
+const int  VtuWriter::QUADRATIC_TRIANGLE = 22;
+const int  VtuWriter::QUADRATIC_QUAD     = 23;
+
+
+//-----------------------------------------------------------------------
+//   constructor & destructor
+//-----------------------------------------------------------------------
+
+
+VtuWriter::VtuWriter ()
+{
+  vertexCells_ = false;
+}
+
+
+VtuWriter::~VtuWriter ()
+{}
+
+
+//-----------------------------------------------------------------------
+//   clear
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::clear ()
+{
+  data_.clear ();
+
+  coords_ .ref ( Matrix()    );
+  offsets_.ref ( IdxVector() );
+  conn_   .ref ( IdxVector() );
+  types_  .ref ( IdxVector() );
+
+  vertexCells_ = false;
+}
+
+
+//-----------------------------------------------------------------------
+//   setPoints
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::setPoints ( const Matrix& coords )
+{
+  coords_.ref ( coords );
+}
+
+
+//-----------------------------------------------------------------------
+//   setCells
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::setCells
+
+  ( const IdxVector&  offsets,
+    const IdxVector&  conn,
+    const IdxVector&  types )
+
+{
+  JEM_PRECHECK ( offsets.size() == types.size() + 1 );
+
+  offsets_.ref ( offsets );
+  conn_   .ref ( conn    );
+  types_  .ref ( types   );
+
+  vertexCells_ = false;
+}
+
+
+void VtuWriter::setVertexCells ()
+{
+  offsets_.ref ( IdxVector() );
+  conn_   .ref ( IdxVector() );
+  types_  .ref ( IdxVector() );
+
+  vertexCells_ = true;
+}
+
+
+//-----------------------------------------------------------------------
+//   addPointData
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::addPointData
+
+  ( const String&  name,
+    const Matrix&  data )
+
+{
+  Ref<Array_>  a = newInstance<Array_> ();
+
+  a->kind       = Array_::MATRIX;
+  a->name       = name;
+  a->type       = "Float64";
+  a->compCount  = ( data.size(0) < 3 ) ? 3 : data.size(0);
+  a->tupleCount = data.size(1);
+  a->offset     = 0;
+
+  a->mat.ref ( data );
+
+  data_.pushBack ( a );
+}
+
+
+void VtuWriter::addPointData
+
+  ( const String&  name,
+    const Vector&  data )
+
+{
+  Ref<Array_>  a = newInstance<Array_> ();
+
+  a->kind       = Array_::VECTOR;
+  a->name       = name;
+  a->type       = "Float64";
+  a->compCount  = 1;
+  a->tupleCount = data.size();
+  a->offset     = 0;
+
+  a->vec.ref ( data );
+
+  data_.pushBack ( a );
+}
+
+
+//-----------------------------------------------------------------------
+//   write
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::write ( const String& fileName )
+{
+  const idx_t  pointCount = coords_.size(1);
+  const idx_t  cellCount  = vertexCells_ ? pointCount : types_.size();
+  const int    one        = 1;
+  const char*  byteOrder  = ( *((const char*) &one) == 1 ) ?
+                            "LittleEndian" : "BigEndian";
+
+  Ref<Array_>  points     = newInstance<Array_> ();
+  Ref<Array_>  cells[3];
+
+  idx_t        offset     = 0;
+
+
+  for ( idx_t i = 0; i < data_.size(); i++ )
+  {
+    if ( data_[i]->tupleCount != pointCount )
+    {
+      throw IllegalInputException (
+        fileName,
+        String::format ( "point data %s has %d values instead of %d",
+                         data_[i]->name, (int) data_[i]->tupleCount,
+                         (int) pointCount )
+      );
+    }
+  }
+
+  points->kind       = Array_::MATRIX;
+  points->type       = "Float64";
+  points->compCount  = 3;
+  points->tupleCount = pointCount;
+  points->mat.ref ( coords_ );
+
+  for ( int i = 0; i < 3; i++ )
+  {
+    cells[i] = newInstance<Array_> ();
+
+    cells[i]->compCount  = 1;
+    cells[i]->tupleCount = cellCount;
+  }
+
+  cells[0]->kind = Array_::CONNECTIVITY;
+  cells[0]->name = "connectivity";
+  cells[0]->type = "Int64";
+  cells[1]->kind = Array_::OFFSETS;
+  cells[1]->name = "offsets";
+  cells[1]->type = "Int64";
+  cells[2]->kind = Array_::TYPES;
+  cells[2]->name = "types";
+  cells[2]->type = "UInt8";
+
+  if ( ! vertexCells_ )
+  {
+    cells[0]->tupleCount = conn_.size ();
+  }
+
+  // The offsets in the appended section; each array is preceded by
+  // its size in bytes.
+
+  for ( idx_t i = 0; i < data_.size(); i++ )
+  {
+    data_[i]->offset = offset;
+    offset          += 8 + data_[i]->byteCount ();
+  }
+
+  points->offset = offset;
+  offset        += 8 + points->byteCount ();
+
+  for ( int i = 0; i < 3; i++ )
+  {
+    cells[i]->offset = offset;
+    offset          += 8 + cells[i]->byteCount ();
+  }
+
+  std::FILE*  file = std::fopen ( fileName.addr(), "wb" );
+
+  if ( ! file )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not create file: %s", std::strerror( errno ) )
+    );
+  }
+
+  std::fprintf ( file,
+                 "<?xml version=\"1.0\"?>\n"
+                 "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+                 "byte_order=\"%s\" header_type=\"UInt64\">\n"
+                 "  <UnstructuredGrid>\n"
+                 "    <Piece NumberOfPoints=\"%ld\" NumberOfCells=\"%ld\">\n"
+                 "      <PointData>\n",
+                 byteOrder, (long) pointCount, (long) cellCount );
+
+  for ( idx_t i = 0; i < data_.size(); i++ )
+  {
+    writeHead_ ( file, *data_[i] );
+  }
+
+  std::fprintf ( file,
+                 "      </PointData>\n"
+                 "      <Points>\n" );
+
+  writeHead_ ( file, *points );
+
+  std::fprintf ( file,
+                 "      </Points>\n"
+                 "      <Cells>\n" );
+
+  for ( int i = 0; i < 3; i++ )
+  {
+    writeHead_ ( file, *cells[i] );
+  }
+
+  std::fprintf ( file,
+                 "      </Cells>\n"
+                 "    </Piece>\n"
+                 "  </UnstructuredGrid>\n"
+                 "  <AppendedData encoding=\"raw\">\n_" );
+
+  {
+    Stream_  out ( file );
+
+    for ( idx_t i = 0; i < data_.size(); i++ )
+    {
+      writeData_ ( out, *data_[i] );
+    }
+
+    writeData_ ( out, *points );
+
+    for ( int i = 0; i < 3; i++ )
+    {
+      writeData_ ( out, *cells[i] );
+    }
+
+    out.flush ();
+  }
+
+  std::fprintf ( file,
+                 "\n  </AppendedData>\n"
+                 "</VTKFile>\n" );
+
+  const bool  failed = ( std::ferror( file ) != 0 );
+
+  if ( std::fclose( file ) != 0 || failed )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "write error: %s", std::strerror( errno ) )
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   writePvd
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::writePvd
+
+  ( const String&        fileName,
+    const Flex<double>&  times,
+    const Flex<String>&  files )
+
+{
+  std::FILE*  file = std::fopen ( fileName.addr(), "w" );
+
+  if ( ! file )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "can not create file: %s", std::strerror( errno ) )
+    );
+  }
+
+  std::fprintf ( file,
+                 "<?xml version=\"1.0\"?>\n"
+                 "<VTKFile type=\"Collection\" version=\"0.1\">\n"
+                 "  <Collection>\n" );
+
+  for ( idx_t i = 0; i < files.size(); i++ )
+  {
+    std::fprintf ( file,
+                   "    <DataSet timestep=\"%.10e\" file=\"%.*s\"/>\n",
+                   times[i], (int) files[i].size(), files[i].addr() );
+  }
+
+  std::fprintf ( file,
+                 "  </Collection>\n"
+                 "</VTKFile>\n" );
+
+  const bool  failed = ( std::ferror( file ) != 0 );
+
+  if ( std::fclose( file ) != 0 || failed )
+  {
+    throw IOException (
+      fileName,
+      String::format ( "write error: %s", std::strerror( errno ) )
+    );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   writeHead_
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::writeHead_
+
+  ( std::FILE*     file,
+    const Array_&  a ) const
+
+{
+  std::fprintf ( file, "        <DataArray type=\"%s\"", a.type );
+
+  if ( a.name.size() > 0 )
+  {
+    std::fprintf ( file, " Name=\"%.*s\"",
+                   (int) a.name.size(), a.name.addr() );
+  }
+
+  std::fprintf ( file, " NumberOfComponents=\"%ld\" format=\"appended\""
+                 " offset=\"%ld\"/>\n",
+                 (long) a.compCount, (long) a.offset );
+}
+
+
+//-----------------------------------------------------------------------
+//   writeData_
+//-----------------------------------------------------------------------
+
+
+void VtuWriter::writeData_
+
+  ( Stream_&       out,
+    const Array_&  a ) const
+
+{
+  const uint64_t  size = (uint64_t) a.byteCount ();
+  const idx_t     n    = a.tupleCount;
+
+  out.put ( &size, sizeof(size) );
+
+  switch ( a.kind )
+  {
+  case Array_::MATRIX:
+    {
+      const idx_t   m    = a.mat.size(0);
+      const double  zero = 0.0;
+
+      for ( idx_t j = 0; j < n; j++ )
+      {
+        for ( idx_t i = 0; i < m; i++ )
+        {
+          const double  x = a.mat(i,j);
+
+          out.put ( &x, sizeof(x) );
+        }
+
+        for ( idx_t i = m; i < a.compCount; i++ )
+        {
+          out.put ( &zero, sizeof(zero) );
+        }
+      }
+    }
+    break;
+
+  case Array_::VECTOR:
+
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      const double  x = a.vec[j];
+
+      out.put ( &x, sizeof(x) );
+    }
+
+    break;
+
+  case Array_::CONNECTIVITY:
+
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      const int64_t  k = vertexCells_ ? j : conn_[j];
+
+      out.put ( &k, sizeof(k) );
+    }
+
+    break;
+
+  case Array_::OFFSETS:
+
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      const int64_t  k = vertexCells_ ? (j + 1) : offsets_[j + 1];
+
+      out.put ( &k, sizeof(k) );
+    }
+
+    break;
+
+  case Array_::TYPES:
+
+    for ( idx_t j = 0; j < n; j++ )
+    {
+      const uint8_t  k = (uint8_t) ( vertexCells_ ? VERTEX : types_[j] );
+
+      out.put ( &k, sizeof(k) );
+    }
+
+    break;
+  }
+}
@@ -0,0 +1,132 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  This class writes VTK unstructured grid files (.vtu) with the data
+ *  appended in raw binary form, and the ParaView collection files
+ *  (.pvd) that make a time series of them.
+ *
+ *  The points, cells and point data are registered first; the arrays
+ *  are not copied. write() then writes the XML header, with the offset
+ *  of each array in the appended section, and streams the arrays to
+ *  the file through a small buffer. Point coordinates and vectors with
+ *  less than three components are padded with zeros, as ParaView
+ *  expects three component vectors.
+ *
+ */
+
+#ifndef VTU_WRITER_H
+#define VTU_WRITER_H
+
+#include <cstdio>
+
+#include <jem/base/Object.h>
+#include <jem/base/String.h>
+#include <jem/util/Flex.h>
+#include <jive/Array.h>
+
+using jem::Ref;
+using jem::idx_t;
+using jem::String;
+using jem::util::Flex;
+using jive::Vector;
+using jive::Matrix;
+using jive::IdxVector;
+
+
+//-----------------------------------------------------------------------
+//   class VtuWriter
+//-----------------------------------------------------------------------
+
+
+class VtuWriter
+{
+ public:
+
+  // VTK cell types
+
+  static const int          VERTEX;
+  static const int          LINE;
+  static const int          TRIANGLE;
+  static const int          QUAD;
+  static const int          TETRA;
+  static const int          HEXAHEDRON;
+  static const int          QUADRATIC_TRIANGLE;
+  static const int          QUADRATIC_QUAD;
+
+                            VtuWriter       ();
+                           ~VtuWriter       ();
+
+  void                      clear           ();
+
+  // coords(i,j) is coordinate i of point j
+
+  void                      setPoints
+
+    ( const Matrix&           coords );
+
+  // The nodes of cell i are conn[offsets[i]:offsets[i+1]]
+
+  void                      setCells
+
+    ( const IdxVector&        offsets,
+      const IdxVector&        conn,
+      const IdxVector&        types );
+
+  // Makes each point a vertex cell (for point clouds)
+
+  void                      setVertexCells  ();
+
+  // data(i,j) is component i at point j
+
+  void                      addPointData
+
+    ( const String&           name,
+      const Matrix&           data );
+
+  void                      addPointData
+
+    ( const String&           name,
+      const Vector&           data );
+
+  void                      write
+
+    ( const String&           fileName );
+
+  static void               writePvd
+
+    ( const String&           fileName,
+      const Flex<double>&     times,
+      const Flex<String>&     files );
+
+
+ private:
+
+  class                     Array_;
+  class                     Stream_;
+
+  void                      writeHead_
+
+    ( std::FILE*              file,
+      const Array_&           a )          const;
+
+  void                      writeData_
+
+    ( Stream_&                out,
+      const Array_&           a )          const;
+
+
+ private:
+
+  Flex< Ref<Array_> >       data_;
+
+  Matrix                    coords_;
+  IdxVector                 offsets_;
+  IdxVector                 conn_;
+  IdxVector                 types_;
+  bool                      vertexCells_;
+
+};
+
+
+#endif
@@ -0,0 +1,63 @@
+// Common settings of the benchmark drivers: a rectangle that is fixed
+// on the left and bottom edges and pulled on the right edge. The mesh
+// and the integration schemes are set in mesh.pro, which is written by
+// the Makefile for every mesh.
+
+model =
+{
+  type = "Matrix";
+
+  matrix.type = "FEM";
+
+  model =
+  {
+    type   = "Multi";
+    models = [ "solid", "diri" ];
+
+    solid =
+    {
+      type     = "Solid";
+      elements = "all";
+
+      rho      = 7.85e-9;
+      young    = 200.0e3;
+      poisson  = 0.3;
+      state    = "PLANE_STRAIN";
+
+      material =
+      {
+        type = "Hooke";
+        dim  = 2;
+      };
+    };
+
+    diri =
+    {
+      type       = "Dirichlet";
+      nodeGroups = [ "left", "bottom", "right" ];
+      dofs       = [ "dx", "dy", "dx" ];
+      factors    = [ 0.0, 0.0, 1.0 ];
+      dispIncr   = 2.0e-3;
+    };
+  };
+};
+
+usermodules =
+{
+  modules = [ "solver", "bench" ];
+
+  solver =
+  {
+    type      = "Nonlin";
+    precision = 1.0e-6;
+    maxIter   = 20;
+    solver    = { type = "SkylineLU"; };
+  };
+
+  bench =
+  {
+    type    = "Bench";
+    repeat  = 5;
+    warmup  = 1;
+  };
+};
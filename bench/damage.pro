@@ -0,0 +1,8 @@
+// Kernel timings with the damage model for metals.
+
+include "common.pro";
+include "mesh.pro";
+
+model.model.solid.material.type = "DamageExpMetal";
+model.model.solid.kappa1        = 1.0e-3;
+model.model.solid.kappa2        = 1.0e-1;
@@ -0,0 +1,10 @@
+// Kernel timings with Drucker-Prager plasticity.
+
+include "common.pro";
+include "mesh.pro";
+
+model.model.solid.material.type = "Drucker";
+model.model.solid.c             = 50.0;
+model.model.solid.phi           = 30.0;
+model.model.solid.psi           = 10.0;
+model.model.solid.h             = 1000.0;
@@ -0,0 +1,18 @@
+// Explicit time steps with the critical time step. Only the step times
+// are recorded; the step module reports every step, so the runs are
+// long enough to average out its output.
+
+include "common.pro";
+include "mesh.pro";
+
+model.model.diri.dispIncr = 1.0e-7;
+
+usermodules.solver =
+{
+  type     = "step";
+  autoStep = true;
+  safety   = 0.9;
+};
+
+usermodules.bench.kernels = [];
+usermodules.bench.steps   = 100;
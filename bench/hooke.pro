@@ -0,0 +1,4 @@
+// Kernel timings with a linear elastic material.
+
+include "common.pro";
+include "mesh.pro";
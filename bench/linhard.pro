@@ -0,0 +1,8 @@
+// Kernel timings with von Mises plasticity and linear hardening. The
+// first step loads the material beyond the yield stress.
+
+include "common.pro";
+include "mesh.pro";
+
+model.model.solid.material.type = "LinHard";
+model.model.solid.sigmaC        = "250.0 + 1000.0 * x";
@@ -0,0 +1,12 @@
+// Full Newton steps (assembly, factorization and solve until
+// convergence) with a plastic material. Only the step times are
+// recorded.
+
+include "common.pro";
+include "mesh.pro";
+
+model.model.solid.material.type = "LinHard";
+model.model.solid.sigmaC        = "250.0 + 1000.0 * x";
+
+usermodules.bench.kernels = [];
+usermodules.bench.steps   = 3;
@@ -24,6 +24,7 @@
 #include "models.h"
 #include "modules.h"
 #include "TimeStepModule.h"
+#include "BinMeshModule.h"
 
 using namespace jem;
 
@@ -66,6 +67,7 @@ Ref<Module> mainModule ()
 
   // Define the main module chain.
 
+  chain->pushBack ( newInstance<BinMeshModule>  ( "binMesh"  ) );
   chain->pushBack ( newInstance<InputModule>    ( "input"    ) );
   chain->pushBack ( newInstance<ShapeModule>    ( "shape"    ) );
   chain->pushBack ( newInstance<InitModule>     ( "init"     ) );
@@ -0,0 +1,71 @@
+// Common settings of the regression tests: a unit square of 8 x 8
+// Quad4 elements, fixed on the left and bottom edges and pulled on the
+// right edge, with adaptive load steps and a Newton solver. The mesh
+// is written by the test script.
+
+log.pattern = "*.info";
+
+input.file = "mesh.data";
+
+control.runWhile = "i < 3";
+
+model =
+{
+  type = "Matrix";
+
+  matrix.type = "FEM";
+
+  model =
+  {
+    type   = "Multi";
+    models = [ "solid", "diri" ];
+
+    solid =
+    {
+      type     = "Solid";
+      elements = "all";
+
+      ischeme_element  = "Gauss2*Gauss2";
+      ischeme_boundary = "Gauss2";
+
+      rho      = 7.85e-9;
+      young    = 200.0e3;
+      poisson  = 0.3;
+      state    = "PLANE_STRAIN";
+
+      material =
+      {
+        type = "Hooke";
+        dim  = 2;
+      };
+    };
+
+    diri =
+    {
+      type       = "Dirichlet";
+      nodeGroups = [ "left", "bottom", "right" ];
+      dofs       = [ "dx", "dy", "dx" ];
+      factors    = [ 0.0, 0.0, 1.0 ];
+      dispIncr   = 1.0e-3;
+    };
+  };
+};
+
+usermodules =
+{
+  modules = [ "solver" ];
+
+  solver =
+  {
+    type      = "AdaptiveStepGeneral";
+    startIncr = 1.0;
+
+    solver =
+    {
+      type      = "MyNonlin";
+      precision = 1.0e-8;
+      maxIter   = 20;
+      solver    = { type = "SkylineLU"; };
+    };
+  };
+};
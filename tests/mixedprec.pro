@@ -0,0 +1,9 @@
+// Newton steps with the mixed precision solver. The matrix of a linear
+// elastic material is well-conditioned, so the iterative refinement
+// must converge without falling back to the double precision solver.
+
+include "common.pro";
+
+usermodules.solver.solver.mixedPrecision = true;
+usermodules.solver.solver.refineTol      = 1.0e-10;
+usermodules.solver.solver.maxRefine      = 10;
@@ -0,0 +1,24 @@
+#
+#  The mixed precision solver must converge on a well-conditioned
+#  matrix. Its failures are reported in the info log of the Newton
+#  solver, so the log must show the Newton iterations and no failure.
+#
+
+"$GENMESH" quad 8 8 mesh.data > /dev/null || exit 1
+
+"$SOLID" mixedprec.pro > run.log 2>&1 || exit 1
+
+if ! grep -q "scaled residual" run.log
+then
+  echo "no Newton iterations in run.log"
+  exit 1
+fi
+
+if grep -q "mixed precision solve failed" run.log
+then
+  echo "the mixed precision solve failed:"
+  grep "mixed precision solve failed" run.log
+  exit 1
+fi
+
+exit 0
@@ -0,0 +1,16 @@
+// First part of the restart test: four load steps with a checkpoint
+// at the start of every run. The script restarts from the checkpoint,
+// which holds step 3, and continues to step 6.
+
+include "common.pro";
+
+control.runWhile = "i < 4";
+
+usermodules.modules = [ "checkpoint", "solver" ];
+
+usermodules.checkpoint =
+{
+  type     = "Checkpoint";
+  file     = "ckpt.bin";
+  interval = 1;
+};
@@ -0,0 +1,42 @@
+#
+#  A restart from a checkpoint must continue with the step number in
+#  the checkpoint. The first run stops after step 4 and its last
+#  checkpoint holds step 3, so the restarted run to step 6 must solve
+#  three steps; six would mean that the step counter started from 0.
+#
+
+"$GENMESH" quad 8 8 mesh.data > /dev/null || exit 1
+
+"$SOLID" restart.pro > run1.log 2>&1 || exit 1
+
+if [ ! -f ckpt.bin ]
+then
+  echo "no checkpoint written"
+  exit 1
+fi
+
+cat > resume.pro << END
+include "restart.pro";
+
+control.runWhile = "i < 6";
+
+usermodules.checkpoint.restart = true;
+END
+
+"$SOLID" resume.pro > run2.log 2>&1 || exit 1
+
+if ! grep -q "restarted from" run2.log
+then
+  echo "the second run did not restart from the checkpoint"
+  exit 1
+fi
+
+n=`grep -c "Starting the Newton-Raphson solver" run2.log`
+
+if [ "$n" -ne 3 ]
+then
+  echo "the restarted run solved $n steps instead of 3"
+  exit 1
+fi
+
+exit 0
@@ -0,0 +1,165 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  genmesh: writes a structured mesh of a rectangle in the jive mesh
+ *  format, for the benchmarks in bench/.
+ *
+ *    usage: genmesh <quad|tri> <nx> <ny> <output file> [<lx> <ly>]
+ *
+ *  The rectangle [0,lx] x [0,ly] (default 1 x 1) is divided into
+ *  nx x ny cells, which are Quad4 elements or are split into two
+ *  Triangle3 elements along their diagonal. The nodes are numbered row
+ *  by row from 0; the node groups left, right, bottom and top contain
+ *  the nodes on the edges of the rectangle.
+ *
+ *  The tool only needs a C++11 compiler:
+ *
+ *    g++ -O2 -std=c++11 -o genmesh genmesh.cpp
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+//-----------------------------------------------------------------------
+//   writeGroup_
+//-----------------------------------------------------------------------
+
+// Writes the nodes first, first + stride, ..., count in all.
+
+static void writeGroup_
+
+  ( std::FILE*   out,
+    const char*  name,
+    long         first,
+    long         stride,
+    long         count )
+
+{
+  std::fprintf ( out, "<NodeGroup name=\"%s\">\n{", name );
+
+  for ( long i = 0; i < count; i++ )
+  {
+    std::fprintf ( out, "%s%ld", ( i == 0 ? "" : ", " ),
+                   first + i * stride );
+
+    if ( i % 10 == 9 && i + 1 < count )
+    {
+      std::fprintf ( out, "\n" );
+    }
+  }
+
+  std::fprintf ( out, "}\n</NodeGroup>\n\n" );
+}
+
+
+//-----------------------------------------------------------------------
+//   main
+//-----------------------------------------------------------------------
+
+
+int main ( int argc, char** argv )
+{
+  if ( argc != 5 && argc != 7 )
+  {
+    std::fprintf ( stderr, "usage: genmesh <quad|tri> <nx> <ny> "
+                           "<output file> [<lx> <ly>]\n" );
+
+    return 1;
+  }
+
+  const bool  tri = ( std::strcmp( argv[1], "tri" ) == 0 );
+
+  if ( ! tri && std::strcmp( argv[1], "quad" ) != 0 )
+  {
+    std::fprintf ( stderr, "genmesh: invalid element type: %s\n",
+                   argv[1] );
+
+    return 1;
+  }
+
+  const long    nx = std::atol ( argv[2] );
+  const long    ny = std::atol ( argv[3] );
+  const double  lx = ( argc == 7 ) ? std::atof ( argv[5] ) : 1.0;
+  const double  ly = ( argc == 7 ) ? std::atof ( argv[6] ) : 1.0;
+
+  if ( nx < 1 || ny < 1 || lx <= 0.0 || ly <= 0.0 )
+  {
+    std::fprintf ( stderr, "genmesh: invalid mesh size\n" );
+
+    return 1;
+  }
+
+  std::FILE*  out = std::fopen ( argv[4], "w" );
+
+  if ( ! out )
+  {
+    std::perror ( argv[4] );
+
+    return 1;
+  }
+
+  const long  rowSize = nx + 1;
+
+  std::fprintf ( out, "<Nodes>\n" );
+
+  for ( long j = 0; j <= ny; j++ )
+  {
+    for ( long i = 0; i <= nx; i++ )
+    {
+      std::fprintf ( out, "%ld %.12g %.12g;\n", j * rowSize + i,
+                     lx * (double) i / (double) nx,
+                     ly * (double) j / (double) ny );
+    }
+  }
+
+  std::fprintf ( out, "</Nodes>\n\n<Elements>\n" );
+
+  long  ie = 0;
+
+  for ( long j = 0; j < ny; j++ )
+  {
+    for ( long i = 0; i < nx; i++ )
+    {
+      // The corners of the cell, counter-clockwise.
+
+      const long  n0 = j * rowSize + i;
+      const long  n1 = n0 + 1;
+      const long  n2 = n1 + rowSize;
+      const long  n3 = n0 + rowSize;
+
+      if ( tri )
+      {
+        std::fprintf ( out, "%ld %ld %ld %ld;\n", ie++, n0, n1, n2 );
+        std::fprintf ( out, "%ld %ld %ld %ld;\n", ie++, n0, n2, n3 );
+      }
+      else
+      {
+        std::fprintf ( out, "%ld %ld %ld %ld %ld;\n", ie++,
+                       n0, n1, n2, n3 );
+      }
+    }
+  }
+
+  std::fprintf ( out, "</Elements>\n\n" );
+
+  writeGroup_ ( out, "left",   0,            rowSize, ny + 1 );
+  writeGroup_ ( out, "right",  nx,           rowSize, ny + 1 );
+  writeGroup_ ( out, "bottom", 0,            1,       nx + 1 );
+  writeGroup_ ( out, "top",    ny * rowSize, 1,       nx + 1 );
+
+  if ( std::ferror( out ) || std::fclose( out ) != 0 )
+  {
+    std::fprintf ( stderr, "genmesh: error writing %s\n", argv[4] );
+
+    return 1;
+  }
+
+  std::printf ( "genmesh: %ld nodes, %ld elements written to %s\n",
+                rowSize * (ny + 1), ie, argv[4] );
+
+  return 0;
+}
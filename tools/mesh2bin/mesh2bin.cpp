@@ -0,0 +1,650 @@
+/*
+ *
+ *  Copyright (C) 2018 TU Delft. All rights reserved.
+ *
+ *  mesh2bin: converts the nodes, elements and groups of a jive mesh
+ *  file to the binary mesh format read by BinMeshModule (see
+ *  JJ_Util/BinMeshFormat.h).
+ *
+ *    usage: mesh2bin <input mesh> <output file>
+ *
+ *  The sections <Nodes>, <Elements>, <NodeGroup> and <ElementGroup>
+ *  are converted; other sections (constraints, loads, ...) are skipped
+ *  with a warning and can stay in a text file for the input module.
+ *  In groups, a:b denotes the IDs a up to but not including b, as in
+ *  jem slices.
+ *
+ *  The tool only needs a C++11 compiler:
+ *
+ *    g++ -O2 -std=c++11 -I../../JJ_Util -o mesh2bin mesh2bin.cpp
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "BinMeshFormat.h"
+
+
+//-----------------------------------------------------------------------
+//   class Parser_
+//-----------------------------------------------------------------------
+
+// Reads the file in one go and scans it in place.
+
+class Parser_
+{
+ public:
+
+  explicit                  Parser_
+
+    ( const char*             fileName );
+
+  bool                      nextTag
+
+    ( std::string&            tag,
+      std::string&            attrs );
+
+  bool                      atEnd
+
+    ( const char*             endTag );
+
+  bool                      readNumber
+
+    ( double&                 x );
+
+  bool                      skipChar
+
+    ( char                    c );
+
+  void                      skipTo
+
+    ( const char*             endTag );
+
+  [[noreturn]] void         fail
+
+    ( const char*             what )       const;
+
+
+ private:
+
+  void                      skipSpace_    ();
+
+
+ private:
+
+  std::string               fileName_;
+  std::string               text_;
+  size_t                    pos_;
+
+};
+
+
+Parser_::Parser_ ( const char* fileName ) :
+
+  fileName_ ( fileName ),
+  pos_      ( 0 )
+
+{
+  std::FILE*  f = std::fopen ( fileName, "rb" );
+
+  if ( ! f )
+  {
+    std::fprintf ( stderr, "mesh2bin: can not open %s\n", fileName );
+    std::exit    ( 1 );
+  }
+
+  char    buf[1 << 16];
+  size_t  n;
+
+  while ( ( n = std::fread( buf, 1, sizeof(buf), f ) ) > 0 )
+  {
+    text_.append ( buf, n );
+  }
+
+  std::fclose ( f );
+}
+
+
+// Skips white space and comments (// and /* */).
+
+void Parser_::skipSpace_ ()
+{
+  const size_t  len = text_.size ();
+
+  while ( pos_ < len )
+  {
+    const char  c = text_[pos_];
+
+    if ( c == ' ' || c == '\t' || c == '\n' || c == '\r' )
+    {
+      pos_++;
+    }
+    else if ( c == '/' && pos_ + 1 < len && text_[pos_ + 1] == '/' )
+    {
+      while ( pos_ < len && text_[pos_] != '\n' )
+      {
+        pos_++;
+      }
+    }
+    else if ( c == '/' && pos_ + 1 < len && text_[pos_ + 1] == '*' )
+    {
+      size_t  end = text_.find ( "*/", pos_ + 2 );
+
+      pos_ = ( end == std::string::npos ) ? len : end + 2;
+    }
+    else
+    {
+      break;
+    }
+  }
+}
+
+
+// Reads the next opening tag; returns false at the end of the file.
+
+bool Parser_::nextTag
+
+  ( std::string&  tag,
+    std::string&  attrs )
+
+{
+  skipSpace_ ();
+
+  if ( pos_ >= text_.size() )
+  {
+    return false;
+  }
+
+  if ( text_[pos_] != '<' )
+  {
+    fail ( "expected a tag" );
+  }
+
+  size_t  end = text_.find ( '>', pos_ );
+
+  if ( end == std::string::npos )
+  {
+    fail ( "unterminated tag" );
+  }
+
+  size_t  i = pos_ + 1;
+
+  while ( i < end && text_[i] != ' ' && text_[i] != '\t' &&
+          text_[i] != '\n' && text_[i] != '/' )
+  {
+    i++;
+  }
+
+  tag   = text_.substr ( pos_ + 1, i - pos_ - 1 );
+  attrs = text_.substr ( i, end - i );
+  pos_  = end + 1;
+
+  return true;
+}
+
+
+bool Parser_::atEnd ( const char* endTag )
+{
+  skipSpace_ ();
+
+  const size_t  n = std::strlen ( endTag );
+
+  if ( text_.compare( pos_, n, endTag ) == 0 )
+  {
+    pos_ += n;
+
+    return true;
+  }
+
+  return false;
+}
+
+
+bool Parser_::readNumber ( double& x )
+{
+  skipSpace_ ();
+
+  if ( pos_ >= text_.size() )
+  {
+    return false;
+  }
+
+  const char*  start = text_.c_str() + pos_;
+  char*        end;
+
+  x = std::strtod ( start, &end );
+
+  if ( end == start )
+  {
+    return false;
+  }
+
+  pos_ += (size_t) (end - start);
+
+  return true;
+}
+
+
+bool Parser_::skipChar ( char c )
+{
+  skipSpace_ ();
+
+  if ( pos_ < text_.size() && text_[pos_] == c )
+  {
+    pos_++;
+
+    return true;
+  }
+
+  return false;
+}
+
+
+void Parser_::skipTo ( const char* endTag )
+{
+  size_t  end = text_.find ( endTag, pos_ );
+
+  if ( end == std::string::npos )
+  {
+    fail ( "missing end tag" );
+  }
+
+  pos_ = end + std::strlen ( endTag );
+}
+
+
+void Parser_::fail ( const char* what ) const
+{
+  size_t  line = 1;
+
+  for ( size_t i = 0; i < pos_ && i < text_.size(); i++ )
+  {
+    if ( text_[i] == '\n' )
+    {
+      line++;
+    }
+  }
+
+  std::fprintf ( stderr, "mesh2bin: %s, line %lu: %s\n",
+                 fileName_.c_str(), (unsigned long) line, what );
+  std::exit    ( 1 );
+}
+
+
+//-----------------------------------------------------------------------
+//   struct Mesh_
+//-----------------------------------------------------------------------
+
+
+struct Mesh_
+{
+  struct                    Group
+  {
+    int64_t                   kind;
+    std::string               name;
+    std::vector<int64_t>      members;
+  };
+
+  int                       rank;
+
+  std::vector<int64_t>      nodeIDs;
+  std::vector<double>       coords;
+  std::vector<int64_t>      elemIDs;
+  std::vector<int64_t>      elemOffsets;
+  std::vector<int64_t>      elemNodes;
+  std::vector<Group>        groups;
+
+  std::unordered_map<int64_t,int64_t>  nodeMap;
+  std::unordered_map<int64_t,int64_t>  elemMap;
+};
+
+
+//-----------------------------------------------------------------------
+//   readNodes_
+//-----------------------------------------------------------------------
+
+
+static void         readNodes_
+
+  ( Mesh_&    mesh,
+    Parser_&  in )
+
+{
+  std::vector<double>  row;
+  double               x;
+
+  while ( ! in.atEnd( "</Nodes>" ) )
+  {
+    row.clear ();
+
+    while ( ! in.skipChar( ';' ) )
+    {
+      if ( ! in.readNumber( x ) )
+      {
+        in.fail ( "invalid node" );
+      }
+
+      row.push_back ( x );
+    }
+
+    if ( row.size() < 2 || row.size() > 4 )
+    {
+      in.fail ( "a node needs an ID and one to three coordinates" );
+    }
+
+    if ( mesh.rank == 0 )
+    {
+      mesh.rank = (int) row.size() - 1;
+    }
+    else if ( mesh.rank != (int) row.size() - 1 )
+    {
+      in.fail ( "nodes with different numbers of coordinates" );
+    }
+
+    const int64_t  id = (int64_t) row[0];
+
+    if ( ! mesh.nodeMap.insert(
+           std::make_pair( id, (int64_t) mesh.nodeIDs.size() ) ).second )
+    {
+      in.fail ( "duplicate node ID" );
+    }
+
+    mesh.nodeIDs.push_back ( id );
+    mesh.coords .insert    ( mesh.coords.end(), row.begin() + 1,
+                             row.end() );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   readElements_
+//-----------------------------------------------------------------------
+
+
+static void         readElements_
+
+  ( Mesh_&    mesh,
+    Parser_&  in )
+
+{
+  double  x;
+
+  if ( mesh.elemOffsets.empty() )
+  {
+    mesh.elemOffsets.push_back ( 0 );
+  }
+
+  while ( ! in.atEnd( "</Elements>" ) )
+  {
+    if ( ! in.readNumber( x ) )
+    {
+      in.fail ( "invalid element" );
+    }
+
+    const int64_t  id = (int64_t) x;
+
+    if ( ! mesh.elemMap.insert(
+           std::make_pair( id, (int64_t) mesh.elemIDs.size() ) ).second )
+    {
+      in.fail ( "duplicate element ID" );
+    }
+
+    while ( ! in.skipChar( ';' ) )
+    {
+      if ( ! in.readNumber( x ) )
+      {
+        in.fail ( "invalid element" );
+      }
+
+      std::unordered_map<int64_t,int64_t>::const_iterator  it =
+
+        mesh.nodeMap.find ( (int64_t) x );
+
+      if ( it == mesh.nodeMap.end() )
+      {
+        in.fail ( "element refers to an unknown node" );
+      }
+
+      mesh.elemNodes.push_back ( it->second );
+    }
+
+    mesh.elemIDs    .push_back ( id );
+    mesh.elemOffsets.push_back ( (int64_t) mesh.elemNodes.size() );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   readGroup_
+//-----------------------------------------------------------------------
+
+
+static void         readGroup_
+
+  ( Mesh_&              mesh,
+    Parser_&            in,
+    int64_t             kind,
+    const std::string&  attrs,
+    const char*         endTag )
+
+{
+  const std::unordered_map<int64_t,int64_t>&  map =
+
+    ( kind == BinMeshFormat::NODE_GROUP ) ? mesh.nodeMap : mesh.elemMap;
+
+  Mesh_::Group  group;
+  size_t        i = attrs.find ( "name" );
+  double        x, y;
+
+  if ( i != std::string::npos )
+  {
+    size_t  a = attrs.find ( '"', i );
+    size_t  b = ( a == std::string::npos ) ?
+                a : attrs.find ( '"', a + 1 );
+
+    if ( b != std::string::npos )
+    {
+      group.name = attrs.substr ( a + 1, b - a - 1 );
+    }
+  }
+
+  if ( group.name.empty() )
+  {
+    in.fail ( "group without a name" );
+  }
+
+  group.kind = kind;
+
+  if ( ! in.skipChar( '{' ) )
+  {
+    in.fail ( "expected {" );
+  }
+
+  while ( ! in.skipChar( '}' ) )
+  {
+    if ( ! in.readNumber( x ) )
+    {
+      in.fail ( "invalid group member" );
+    }
+
+    y = x + 1.0;
+
+    if ( in.skipChar( ':' ) && ! in.readNumber( y ) )
+    {
+      in.fail ( "invalid range" );
+    }
+
+    for ( int64_t id = (int64_t) x; id < (int64_t) y; id++ )
+    {
+      std::unordered_map<int64_t,int64_t>::const_iterator  it =
+
+        map.find ( id );
+
+      if ( it == map.end() )
+      {
+        in.fail ( "group refers to an unknown ID" );
+      }
+
+      group.members.push_back ( it->second );
+    }
+
+    in.skipChar ( ',' );
+  }
+
+  if ( ! in.atEnd( endTag ) )
+  {
+    in.fail ( "expected the end of the group" );
+  }
+
+  mesh.groups.push_back ( group );
+}
+
+
+//-----------------------------------------------------------------------
+//   write_
+//-----------------------------------------------------------------------
+
+
+static void         put_
+
+  ( std::FILE*   f,
+    const void*  data,
+    size_t       size )
+
+{
+  if ( size > 0 && std::fwrite( data, 1, size, f ) != size )
+  {
+    std::fprintf ( stderr, "mesh2bin: write error\n" );
+    std::exit    ( 1 );
+  }
+}
+
+
+static void         write_
+
+  ( const Mesh_&  mesh,
+    const char*   fileName )
+
+{
+  const char     zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  std::FILE*     f        = std::fopen ( fileName, "wb" );
+
+  BinMeshFormat::Header  head;
+
+  if ( ! f )
+  {
+    std::fprintf ( stderr, "mesh2bin: can not create %s\n", fileName );
+    std::exit    ( 1 );
+  }
+
+  std::memcpy ( head.magic, BinMeshFormat::magic(), 8 );
+
+  head.version    = BinMeshFormat::VERSION;
+  head.rank       = mesh.rank;
+  head.nodeCount  = (int64_t) mesh.nodeIDs.size ();
+  head.elemCount  = (int64_t) mesh.elemIDs.size ();
+  head.connSize   = (int64_t) mesh.elemNodes.size ();
+  head.groupCount = (int64_t) mesh.groups.size ();
+
+  put_ ( f, &head,                  sizeof(head) );
+  put_ ( f, mesh.nodeIDs.data(),    mesh.nodeIDs.size()     * 8 );
+  put_ ( f, mesh.coords.data(),     mesh.coords.size()      * 8 );
+  put_ ( f, mesh.elemIDs.data(),    mesh.elemIDs.size()     * 8 );
+  put_ ( f, mesh.elemOffsets.data(), mesh.elemOffsets.size() * 8 );
+  put_ ( f, mesh.elemNodes.data(),  mesh.elemNodes.size()   * 8 );
+
+  for ( size_t i = 0; i < mesh.groups.size(); i++ )
+  {
+    const Mesh_::Group&         g   = mesh.groups[i];
+    BinMeshFormat::GroupHeader  gh;
+
+    gh.kind       = g.kind;
+    gh.nameLength = (int64_t) g.name.size ();
+    gh.size       = (int64_t) g.members.size ();
+
+    put_ ( f, &gh,              sizeof(gh) );
+    put_ ( f, g.name.data(),    g.name.size() );
+    put_ ( f, zeros,            (size_t) (BinMeshFormat::padded(
+                                  gh.nameLength ) - gh.nameLength) );
+    put_ ( f, g.members.data(), g.members.size() * 8 );
+  }
+
+  if ( std::fclose( f ) != 0 )
+  {
+    std::fprintf ( stderr, "mesh2bin: write error\n" );
+    std::exit    ( 1 );
+  }
+}
+
+
+//-----------------------------------------------------------------------
+//   main
+//-----------------------------------------------------------------------
+
+
+int main ( int argc, char** argv )
+{
+  if ( argc != 3 )
+  {
+    std::fprintf ( stderr, "usage: mesh2bin <input mesh> <output file>\n" );
+
+    return 1;
+  }
+
+  Parser_      in   ( argv[1] );
+  Mesh_        mesh;
+  std::string  tag, attrs;
+
+  mesh.rank = 0;
+
+  while ( in.nextTag( tag, attrs ) )
+  {
+    if ( tag == "Nodes" )
+    {
+      readNodes_ ( mesh, in );
+    }
+    else if ( tag == "Elements" )
+    {
+      readElements_ ( mesh, in );
+    }
+    else if ( tag == "NodeGroup" )
+    {
+      readGroup_ ( mesh, in, BinMeshFormat::NODE_GROUP, attrs,
+                   "</NodeGroup>" );
+    }
+    else if ( tag == "ElementGroup" )
+    {
+      readGroup_ ( mesh, in, BinMeshFormat::ELEM_GROUP, attrs,
+                   "</ElementGroup>" );
+    }
+    else
+    {
+      std::fprintf ( stderr, "mesh2bin: skipping <%s>\n", tag.c_str() );
+
+      if ( attrs.empty() || attrs[attrs.size() - 1] != '/' )
+      {
+        in.skipTo ( ( "</" + tag + ">" ).c_str() );
+      }
+    }
+  }
+
+  if ( mesh.elemOffsets.empty() )
+  {
+    mesh.elemOffsets.push_back ( 0 );
+  }
+
+  write_ ( mesh, argv[2] );
+
+  std::printf ( "mesh2bin: %lu nodes, %lu elements, %lu groups\n",
+                (unsigned long) mesh.nodeIDs.size(),
+                (unsigned long) mesh.elemIDs.size(),
+                (unsigned long) mesh.groups.size() );
+
+  return 0;
+}